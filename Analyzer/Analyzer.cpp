@@ -1301,7 +1301,14 @@ void InValues::group_predicates(std::list<const Expr*>& scan_predicates,
 InIntegerSet::InIntegerSet(const std::shared_ptr<const Analyzer::Expr> a,
                            const std::vector<int64_t>& l,
                            const bool not_null)
-    : Expr(kBOOLEAN, not_null), arg(a), value_list(l) {}
+    : Expr(kBOOLEAN, not_null), arg(a), value_list(std::make_shared<const std::vector<int64_t>>(l)) {}
+
+InIntegerSet::InIntegerSet(const std::shared_ptr<const Analyzer::Expr> a,
+                           const std::shared_ptr<const std::vector<int64_t>>& l,
+                           const bool not_null)
+    : Expr(kBOOLEAN, not_null), arg(a), value_list(l) {
+  CHECK(value_list);
+}
 
 void CharLengthExpr::group_predicates(std::list<const Expr*>& scan_predicates,
                                       std::list<const Expr*>& join_predicates,
@@ -2032,14 +2039,14 @@ bool InIntegerSet::operator==(const Expr& rhs) const {
     return false;
   }
   const auto& rhs_in_integer_set = static_cast<const InIntegerSet&>(rhs);
-  return *arg == *rhs_in_integer_set.arg && value_list == rhs_in_integer_set.value_list;
+  return *arg == *rhs_in_integer_set.arg && *value_list == *rhs_in_integer_set.value_list;
 }
 
 void InIntegerSet::print() const {
   std::cout << "(IN_INTEGER_SET ";
   arg->print();
   std::cout << "( ";
-  for (const auto e : value_list) {
+  for (const auto e : *value_list) {
     std::cout << e << " ";
   }
   std::cout << ") ";
@@ -545,9 +545,15 @@ class InIntegerSet : public Expr {
  public:
   InIntegerSet(const std::shared_ptr<const Analyzer::Expr> a, const std::vector<int64_t>& values, const bool not_null);
 
+  InIntegerSet(const std::shared_ptr<const Analyzer::Expr> a,
+               const std::shared_ptr<const std::vector<int64_t>>& values,
+               const bool not_null);
+
   const Expr* get_arg() const { return arg.get(); }
 
-  const std::vector<int64_t>& get_value_list() const { return value_list; }
+  const std::vector<int64_t>& get_value_list() const { return *value_list; }
+
+  const std::shared_ptr<const std::vector<int64_t>>& get_shared_value_list() const { return value_list; }
 
   std::shared_ptr<Analyzer::Expr> deep_copy() const override;
 
@@ -557,7 +563,7 @@ class InIntegerSet : public Expr {
 
  private:
   const std::shared_ptr<const Analyzer::Expr> arg;  // the argument left of IN
-  const std::vector<int64_t> value_list;            // the list of values right of IN
+  const std::shared_ptr<const std::vector<int64_t>> value_list;  // the list of values right of IN, can be shared
 };
 
 /*
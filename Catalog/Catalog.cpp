@@ -43,7 +43,9 @@
 
 #include "../Fragmenter/Fragmenter.h"
 #include "../Fragmenter/InsertOrderFragmenter.h"
+#include "../Fragmenter/InsertWal.h"
 #include "../Parser/ParserNode.h"
+#include "../Shared/PrewarmQueue.h"
 #include "../Shared/StringTransform.h"
 #include "../Shared/measure.h"
 #include "../StringDictionary/StringDictionaryClient.h"
@@ -52,6 +54,7 @@
 
 using Chunk_NS::Chunk;
 using Fragmenter_Namespace::InsertOrderFragmenter;
+using Fragmenter_Namespace::InsertWal;
 using std::list;
 using std::map;
 using std::pair;
@@ -60,6 +63,7 @@ using std::string;
 using std::vector;
 
 bool g_aggregator{false};
+bool g_leaf{false};
 
 namespace {
 
@@ -681,6 +685,10 @@ void SysCatalog::createDatabase(const string& name, int owner) {
       "CREATE TABLE mapd_dictionaries (dictid integer primary key, name text unique, nbits int, is_shared boolean, "
       "refcount int, version_num BIGINT DEFAULT 1)");
   dbConn.query("CREATE TABLE mapd_logical_to_physical(logical_table_id integer, physical_table_id integer)");
+  dbConn.query("CREATE TABLE mapd_table_access(tableid integer primary key, access_count bigint)");
+  dbConn.query(
+      "CREATE TABLE mapd_materialized_views(tableid integer primary key, source_tableid integer, sql text, ra text, "
+      "refreshed_rows bigint, needs_rebuild boolean)");
 }
 
 void SysCatalog::dropDatabase(const int32_t dbid, const std::string& name, Catalog* db_cat) {
@@ -1376,6 +1384,19 @@ Catalog::Catalog(const string& basePath,
 }
 
 Catalog::~Catalog() {
+  // the prewarm threads take the read lock
+  tablePrewarmQueue_.reset();
+  flushTableAccessCounts();
+  // the fragmenters leave the rows of their delta stores to their owner
+  for (const auto& table : tableDescriptorMapById_) {
+    if (table.second->fragmenter) {
+      try {
+        table.second->fragmenter->mergeDeltaStore();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Could not merge the delta store of table " << table.first << ": " << e.what();
+      }
+    }
+  }
   cat_write_lock write_lock(this);
   // must clean up heap-allocated TableDescriptor and ColumnDescriptor structs
   for (TableDescriptorMap::iterator tableDescIt = tableDescriptorMap_.begin(); tableDescIt != tableDescriptorMap_.end();
@@ -1429,6 +1450,10 @@ void Catalog::updateTableDescriptorSchema() {
       string queryString("ALTER TABLE mapd_tables ADD userid integer DEFAULT " + std::to_string(MAPD_ROOT_USER_ID));
       sqliteConnector_.query(queryString);
     }
+    if (std::find(cols.begin(), cols.end(), std::string("sort_column_id")) == cols.end()) {
+      string queryString("ALTER TABLE mapd_tables ADD sort_column_id integer DEFAULT " + std::to_string(0));
+      sqliteConnector_.query(queryString);
+    }
   } catch (std::exception& e) {
     sqliteConnector_.query("ROLLBACK TRANSACTION");
     throw;
@@ -1637,6 +1662,35 @@ void Catalog::updateLogicalToPhysicalTableLinkSchema() {
   sqliteConnector_.query("END TRANSACTION");
 }
 
+void Catalog::updateTableAccessSchema() {
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query("BEGIN TRANSACTION");
+  try {
+    sqliteConnector_.query(
+        "CREATE TABLE IF NOT EXISTS mapd_table_access("
+        "tableid integer primary key, access_count bigint)");
+  } catch (const std::exception& e) {
+    sqliteConnector_.query("ROLLBACK TRANSACTION");
+    throw;
+  }
+  sqliteConnector_.query("END TRANSACTION");
+}
+
+void Catalog::updateMaterializedViewSchema() {
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query("BEGIN TRANSACTION");
+  try {
+    sqliteConnector_.query(
+        "CREATE TABLE IF NOT EXISTS mapd_materialized_views("
+        "tableid integer primary key, source_tableid integer, sql text, ra text, refreshed_rows bigint, "
+        "needs_rebuild boolean)");
+  } catch (const std::exception& e) {
+    sqliteConnector_.query("ROLLBACK TRANSACTION");
+    throw;
+  }
+  sqliteConnector_.query("END TRANSACTION");
+}
+
 void Catalog::updateLogicalToPhysicalTableMap(const int32_t logical_tb_id) {
   /* this proc inserts/updates all pairs of (logical_tb_id, physical_tb_id) in
    * sqlite mapd_logical_to_physical table for given logical_tb_id as needed
@@ -1766,6 +1820,8 @@ void Catalog::CheckAndExecuteMigrations() {
   updateDeletedColumnIndicator();
   updateFrontendViewsToDashboards();
   recordOwnershipOfObjectsInObjectPermissions();
+  updateTableAccessSchema();
+  updateMaterializedViewSchema();
 }
 
 void SysCatalog::buildRoleMap() {
@@ -1929,7 +1985,8 @@ void Catalog::buildMaps() {
 
   string tableQuery(
       "SELECT tableid, name, ncolumns, isview, fragments, frag_type, max_frag_rows, max_chunk_size, frag_page_size, "
-      "max_rows, partitions, shard_column_id, shard, num_shards, key_metainfo, userid from mapd_tables");
+      "max_rows, partitions, shard_column_id, shard, num_shards, key_metainfo, userid, sort_column_id from "
+      "mapd_tables");
   sqliteConnector_.query(tableQuery);
   numRows = sqliteConnector_.getNumRows();
   for (size_t r = 0; r < numRows; ++r) {
@@ -1950,6 +2007,7 @@ void Catalog::buildMaps() {
     td->nShards = sqliteConnector_.getData<int>(r, 13);
     td->keyMetainfo = sqliteConnector_.getData<string>(r, 14);
     td->userId = sqliteConnector_.getData<int>(r, 15);
+    td->sortedColumnId = sqliteConnector_.getData<int>(r, 16);
     if (!td->isView) {
       td->fragmenter = nullptr;
     }
@@ -2058,6 +2116,31 @@ void Catalog::buildMaps() {
       physicalTableIt->second.push_back(physical_tb_id);
     }
   }
+
+  sqliteConnector_.query("SELECT tableid, access_count FROM mapd_table_access");
+  numRows = sqliteConnector_.getNumRows();
+  std::lock_guard<std::mutex> table_access_lock(tableAccessMutex_);
+  for (size_t r = 0; r < numRows; ++r) {
+    tableAccessCounts_[sqliteConnector_.getData<int>(r, 0)] = sqliteConnector_.getData<int64_t>(r, 1);
+  }
+  lastTableAccessFlush_ = std::chrono::steady_clock::now().time_since_epoch().count();
+
+  sqliteConnector_.query(
+      "SELECT tableid, source_tableid, sql, ra, refreshed_rows, needs_rebuild FROM mapd_materialized_views");
+  numRows = sqliteConnector_.getNumRows();
+  std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+  for (size_t r = 0; r < numRows; ++r) {
+    auto mvd = std::make_shared<MaterializedViewDescriptor>();
+    mvd->tableId = sqliteConnector_.getData<int>(r, 0);
+    mvd->sourceTableId = sqliteConnector_.getData<int>(r, 1);
+    mvd->viewSQL = sqliteConnector_.getData<string>(r, 2);
+    mvd->viewRA = sqliteConnector_.getData<string>(r, 3);
+    mvd->refreshedRows = sqliteConnector_.getData<int64_t>(r, 4);
+    mvd->needsRebuild = sqliteConnector_.getData<bool>(r, 5);
+    // rows appended before the restart are not known, let the first query on the source check
+    mvd->refreshPending = true;
+    materializedViews_[mvd->tableId] = mvd;
+  }
 }
 
 void Catalog::addTableToMap(TableDescriptor& td,
@@ -2125,8 +2208,7 @@ void Catalog::removeTableFromMap(const string& tableName, int tableId) {
   delete td;
 
   std::unique_ptr<StringDictionaryClient> client;
-  if (g_aggregator) {
-    CHECK(!string_dict_hosts_.empty());
+  if (g_aggregator && !string_dict_hosts_.empty()) {
     DictRef dict_ref(currentDB_.dbId, -1);
     client.reset(new StringDictionaryClient(string_dict_hosts_.front(), dict_ref, true));
   }
@@ -2182,7 +2264,12 @@ void Catalog::addLinkToMap(LinkDescriptor& ld) {
 }
 
 void Catalog::instantiateFragmenter(TableDescriptor* td) const {
-  cat_sqlite_lock sqlite_lock(this);
+  // Loading the chunk metadata of a table doesn't hold up the other tables, nor the sqlite catalog.
+  std::lock_guard<std::mutex> fragmenter_lock(fragmenterMutexes_[td->tableId % fragmenterMutexes_.size()]);
+  if (td->fragmenter) {
+    // instantiated by a concurrent query or by the prewarm queue
+    return;
+  }
   auto time_ms = measure<>::execution([&]() {
     // instanciate table fragmenter upon first use
     // assume only insert order fragmenter is supported
@@ -2202,7 +2289,8 @@ void Catalog::instantiateFragmenter(TableDescriptor* td) const {
                                                td->maxChunkSize,
                                                td->fragPageSize,
                                                td->maxRows,
-                                               td->persistenceLevel);
+                                               td->persistenceLevel,
+                                               td->sortedColumnId);
   });
   LOG(INFO) << "Instantiating Fragmenter for table " << td->tableName << " took " << time_ms << "ms";
 }
@@ -2215,9 +2303,8 @@ const TableDescriptor* Catalog::getMetadataForTable(const string& tableName, con
     return nullptr;
   }
   TableDescriptor* td = tableDescIt->second;
-  cat_sqlite_lock sqlite_lock(this);
-  if (populateFragmenter && td->fragmenter == nullptr && !td->isView) {
-    instantiateFragmenter(td);
+  if (populateFragmenter && !td->isView) {
+    accessTable(td);
   }
   return td;  // returns pointer to table descriptor
 }
@@ -2229,12 +2316,253 @@ const TableDescriptor* Catalog::getMetadataForTable(int tableId) const {
     return nullptr;
   }
   TableDescriptor* td = tableDescIt->second;
-  cat_sqlite_lock sqlite_lock(this);
-  if (td->fragmenter == nullptr && !td->isView)
-    instantiateFragmenter(td);
+  if (!td->isView) {
+    accessTable(td);
+  }
   return td;  // returns pointer to table descriptor
 }
 
+void Catalog::accessTable(TableDescriptor* td) const {
+  // Only the stripe lock of the table on the lookup path, the fragmenter is assigned under it too.
+  const auto stripe = td->tableId % fragmenterMutexes_.size();
+  bool activated{false};
+  {
+    std::lock_guard<std::mutex> fragmenter_lock(fragmenterMutexes_[stripe]);
+    ++unflushedTableAccess_[stripe][td->tableId];
+    activated = td->fragmenter != nullptr;
+  }
+  if (!activated) {
+    {
+      // Not activated yet, the query loads this table itself and the prewarm threads take care of the other shards.
+      std::lock_guard<std::mutex> table_access_lock(tableAccessMutex_);
+      if (tablePrewarmQueue_) {
+        const auto logical_table_id = td->shard >= 0 ? getLogicalTableId(td->tableId) : td->tableId;
+        const auto physical_tables_it = logicalToPhysicalTableMapById_.find(logical_table_id);
+        if (physical_tables_it != logicalToPhysicalTableMapById_.end()) {
+          tablePrewarmQueue_->promote(physical_tables_it->second);
+        }
+      }
+    }
+    instantiateFragmenter(td);
+  }
+  const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+  auto last_flush = lastTableAccessFlush_.load();
+  // Persisting the counts needs the sqlite catalog, which the callers may hold in the middle of a transaction.
+  if (std::chrono::steady_clock::duration(now - last_flush) < std::chrono::minutes(1) ||
+      thread_holding_sqlite_lock == std::this_thread::get_id()) {
+    return;
+  }
+  // one of the concurrent lookups flushes
+  if (lastTableAccessFlush_.compare_exchange_strong(last_flush, now)) {
+    flushTableAccessCounts();
+  }
+}
+
+void Catalog::flushTableAccessCounts() const {
+  std::unordered_map<int, int64_t> table_access;
+  for (size_t stripe = 0; stripe < fragmenterMutexes_.size(); ++stripe) {
+    std::lock_guard<std::mutex> fragmenter_lock(fragmenterMutexes_[stripe]);
+    for (const auto& table_access_count : unflushedTableAccess_[stripe]) {
+      table_access[table_access_count.first] += table_access_count.second;
+    }
+    unflushedTableAccess_[stripe].clear();
+  }
+  if (table_access.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> table_access_lock(tableAccessMutex_);
+    for (const auto& table_access_count : table_access) {
+      tableAccessCounts_[table_access_count.first] += table_access_count.second;
+    }
+  }
+  cat_sqlite_lock sqlite_lock(this);
+  // the access counts are bookkeeping, not part of the catalog state
+  auto& sqlite_connector = const_cast<SqliteConnector&>(sqliteConnector_);
+  try {
+    sqlite_connector.query("BEGIN TRANSACTION");
+    try {
+      for (const auto& table_access_count : table_access) {
+        const auto table_id = std::to_string(table_access_count.first);
+        // skips the tables dropped in the meantime
+        sqlite_connector.query_with_text_param(
+            "INSERT OR IGNORE INTO mapd_table_access (tableid, access_count) SELECT tableid, 0 FROM mapd_tables WHERE "
+            "tableid = ?",
+            table_id);
+        sqlite_connector.query_with_text_params(
+            "UPDATE mapd_table_access SET access_count = access_count + ? WHERE tableid = ?",
+            std::vector<std::string>{std::to_string(table_access_count.second), table_id});
+      }
+    } catch (const std::exception&) {
+      sqlite_connector.query("ROLLBACK TRANSACTION");
+      throw;
+    }
+    sqlite_connector.query("END TRANSACTION");
+  } catch (const std::exception& e) {
+    // only affects the prewarm order after a restart
+    LOG(WARNING) << "Could not persist table access counts of database " << currentDB_.dbName << ": " << e.what();
+  }
+}
+
+void Catalog::startTablePrewarm(const size_t num_threads) {
+  std::vector<std::pair<int64_t, int>> tables;
+  {
+    cat_read_lock read_lock(this);
+    std::lock_guard<std::mutex> table_access_lock(tableAccessMutex_);
+    CHECK(!tablePrewarmQueue_);
+    for (const auto& table_descriptor : tableDescriptorMapById_) {
+      const auto td = table_descriptor.second;
+      // the tables activated in the meantime are skipped by instantiateFragmenter
+      if (td->isView || td->persistenceLevel != Data_Namespace::MemoryLevel::DISK_LEVEL) {
+        continue;
+      }
+      const auto table_access_it = tableAccessCounts_.find(td->tableId);
+      tables.emplace_back(table_access_it != tableAccessCounts_.end() ? table_access_it->second : 0, td->tableId);
+    }
+  }
+  // most accessed first, then in creation order
+  std::sort(tables.begin(), tables.end(), [](const std::pair<int64_t, int>& lhs, const std::pair<int64_t, int>& rhs) {
+    return lhs.first != rhs.first ? lhs.first > rhs.first : lhs.second < rhs.second;
+  });
+  std::vector<int> table_ids;
+  for (const auto& table : tables) {
+    table_ids.push_back(table.second);
+  }
+  LOG(INFO) << "Prewarming " << table_ids.size() << " tables of database " << currentDB_.dbName << " on "
+            << num_threads << " threads";
+  auto prewarm_table = [this](const int table_id) {
+    try {
+      // not an access, unlike getMetadataForTable
+      cat_read_lock read_lock(this);
+      const auto table_descriptor_it = tableDescriptorMapById_.find(table_id);
+      if (table_descriptor_it != tableDescriptorMapById_.end()) {
+        instantiateFragmenter(table_descriptor_it->second);
+      }
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Could not prewarm table " << table_id << " of database " << currentDB_.dbName << ": "
+                 << e.what();
+    }
+  };
+  std::unique_ptr<PrewarmQueue> queue(new PrewarmQueue(prewarm_table, table_ids, num_threads));
+  std::lock_guard<std::mutex> table_access_lock(tableAccessMutex_);
+  tablePrewarmQueue_ = std::move(queue);
+}
+
+void Catalog::createMaterializedView(const MaterializedViewDescriptor& mvd) {
+  {
+    cat_sqlite_lock sqlite_lock(this);
+    sqliteConnector_.query_with_text_params(
+        "INSERT INTO mapd_materialized_views (tableid, source_tableid, sql, ra, refreshed_rows, needs_rebuild) VALUES "
+        "(?, ?, ?, ?, ?, ?)",
+        std::vector<std::string>{std::to_string(mvd.tableId),
+                                 std::to_string(mvd.sourceTableId),
+                                 mvd.viewSQL,
+                                 mvd.viewRA,
+                                 std::to_string(mvd.refreshedRows),
+                                 std::to_string(mvd.needsRebuild)});
+  }
+  std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+  materializedViews_[mvd.tableId] = std::make_shared<const MaterializedViewDescriptor>(mvd);
+}
+
+std::shared_ptr<const MaterializedViewDescriptor> Catalog::getMaterializedView(const int32_t tableId) const {
+  std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+  const auto it = materializedViews_.find(tableId);
+  return it != materializedViews_.end() ? it->second : nullptr;
+}
+
+std::vector<std::shared_ptr<const MaterializedViewDescriptor>> Catalog::getMaterializedViewsForTable(
+    const int32_t sourceTableId) const {
+  std::vector<std::shared_ptr<const MaterializedViewDescriptor>> views;
+  std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+  for (const auto& view : materializedViews_) {
+    if (view.second->sourceTableId == sourceTableId) {
+      views.push_back(view.second);
+    }
+  }
+  return views;
+}
+
+void Catalog::setMaterializedViewRefreshState(const int32_t tableId,
+                                              const int64_t refreshedRows,
+                                              const bool needsRebuild) const {
+  {
+    std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+    const auto it = materializedViews_.find(tableId);
+    CHECK(it != materializedViews_.end());
+    auto mvd = std::make_shared<MaterializedViewDescriptor>(*it->second);
+    mvd->refreshedRows = refreshedRows;
+    mvd->needsRebuild = needsRebuild;
+    it->second = mvd;
+  }
+  cat_sqlite_lock sqlite_lock(this);
+  // the refresh state is bookkeeping of the view table contents, not part of the catalog state
+  auto& sqlite_connector = const_cast<SqliteConnector&>(sqliteConnector_);
+  sqlite_connector.query_with_text_params(
+      "UPDATE mapd_materialized_views SET refreshed_rows = ?, needs_rebuild = ? WHERE tableid = ?",
+      std::vector<std::string>{std::to_string(refreshedRows), std::to_string(needsRebuild), std::to_string(tableId)});
+}
+
+void Catalog::setMaterializedViewRefreshPending(const int32_t tableId, const bool refreshPending) const {
+  std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+  const auto it = materializedViews_.find(tableId);
+  if (it == materializedViews_.end() || it->second->refreshPending == refreshPending) {
+    return;
+  }
+  auto mvd = std::make_shared<MaterializedViewDescriptor>(*it->second);
+  mvd->refreshPending = refreshPending;
+  it->second = mvd;
+}
+
+void Catalog::recordTableAppend(const int32_t tableId) const {
+  bumpTableDataVersion(getLogicalTableId(tableId));
+  std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+  for (auto& view : materializedViews_) {
+    if (view.second->sourceTableId == tableId && !view.second->refreshPending) {
+      auto mvd = std::make_shared<MaterializedViewDescriptor>(*view.second);
+      mvd->refreshPending = true;
+      view.second = mvd;
+    }
+  }
+}
+
+void Catalog::invalidateMaterializedViews(const int32_t sourceTableId) const {
+  bumpTableDataVersion(sourceTableId);
+  std::vector<int32_t> invalidated;
+  {
+    std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+    for (auto& view : materializedViews_) {
+      if (view.second->sourceTableId == sourceTableId) {
+        auto mvd = std::make_shared<MaterializedViewDescriptor>(*view.second);
+        mvd->needsRebuild = true;
+        mvd->refreshPending = true;
+        view.second = mvd;
+        invalidated.push_back(view.first);
+      }
+    }
+  }
+  if (invalidated.empty()) {
+    return;
+  }
+  cat_sqlite_lock sqlite_lock(this);
+  auto& sqlite_connector = const_cast<SqliteConnector&>(sqliteConnector_);
+  for (const auto table_id : invalidated) {
+    sqlite_connector.query_with_text_param("UPDATE mapd_materialized_views SET needs_rebuild = 1 WHERE tableid = ?",
+                                           std::to_string(table_id));
+  }
+}
+
+uint64_t Catalog::getTableDataVersion(const int32_t tableId) const {
+  std::lock_guard<std::mutex> data_version_lock(tableDataVersionMutex_);
+  const auto it = tableDataVersions_.find(tableId);
+  return it != tableDataVersions_.end() ? it->second : 0;
+}
+
+void Catalog::bumpTableDataVersion(const int32_t tableId) const {
+  std::lock_guard<std::mutex> data_version_lock(tableDataVersionMutex_);
+  ++tableDataVersions_[tableId];
+}
+
 const DictDescriptor* Catalog::getMetadataForDict(const int dictId, const bool loadDict) const {
   const DictRef dictRef(currentDB_.dbId, dictId);
   cat_read_lock read_lock(this);
@@ -2617,8 +2945,8 @@ void Catalog::createTable(TableDescriptor& td,
       sqliteConnector_.query_with_text_params(
           "INSERT INTO mapd_tables (name, userid, ncolumns, isview, fragments, frag_type, max_frag_rows, "
           "max_chunk_size, "
-          "frag_page_size, max_rows, partitions, shard_column_id, shard, num_shards, key_metainfo) VALUES (?, ?, ?, "
-          "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+          "frag_page_size, max_rows, partitions, shard_column_id, shard, num_shards, key_metainfo, sort_column_id) "
+          "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
 
           std::vector<std::string>{td.tableName,
                                    std::to_string(td.userId),
@@ -2634,7 +2962,8 @@ void Catalog::createTable(TableDescriptor& td,
                                    std::to_string(td.shardedColumnId),
                                    std::to_string(td.shard),
                                    std::to_string(td.nShards),
-                                   td.keyMetainfo});
+                                   td.keyMetainfo,
+                                   std::to_string(td.sortedColumnId)});
 
       // now get the auto generated tableid
       sqliteConnector_.query_with_text_param("SELECT tableid FROM mapd_tables WHERE name = ?", td.tableName);
@@ -2760,8 +3089,12 @@ int32_t Catalog::getTableEpoch(const int32_t db_id, const int32_t table_id) cons
 void Catalog::setTableEpoch(const int db_id, const int table_id, int new_epoch) {
   cat_read_lock read_lock(this);
   LOG(INFO) << "Set table epoch db:" << db_id << " Table ID  " << table_id << " back to new epoch " << new_epoch;
+  // the logged inserts since the last checkpoint were acknowledged, unlike the rows of a failed load which
+  // aren't logged: replay them on top of the rolled back table
+  auto wal_epoch = dataMgr_->getTableEpoch(db_id, table_id);
   removeChunks(table_id);
   dataMgr_->setTableEpoch(db_id, table_id, new_epoch);
+  InsertWal::rebase(dataMgr_->getTableDataPath(db_id, table_id), wal_epoch, new_epoch);
 
   // check if sharded
   const auto physicalTableIt = logicalToPhysicalTableMapById_.find(table_id);
@@ -2774,8 +3107,10 @@ void Catalog::setTableEpoch(const int db_id, const int table_id, int new_epoch)
       CHECK(phys_td);
       LOG(INFO) << "Set sharded table epoch db:" << db_id << " Table ID  " << physical_tb_id << " back to new epoch "
                 << new_epoch;
+      wal_epoch = dataMgr_->getTableEpoch(db_id, physical_tb_id);
       removeChunks(physical_tb_id);
       dataMgr_->setTableEpoch(db_id, physical_tb_id, new_epoch);
+      InsertWal::rebase(dataMgr_->getTableDataPath(db_id, physical_tb_id), wal_epoch, new_epoch);
     }
   }
 }
@@ -3013,6 +3348,7 @@ void Catalog::truncateTable(const TableDescriptor* td) {
     }
   }
   doTruncateTable(td);
+  invalidateMaterializedViews(td->tableId);
 }
 
 void Catalog::doTruncateTable(const TableDescriptor* td) {
@@ -3034,8 +3370,7 @@ void Catalog::doTruncateTable(const TableDescriptor* td) {
   dataMgr_->removeTableRelatedDS(currentDB_.dbId, tableId);
 
   std::unique_ptr<StringDictionaryClient> client;
-  if (g_aggregator) {
-    CHECK(!string_dict_hosts_.empty());
+  if (g_aggregator && !string_dict_hosts_.empty()) {
     DictRef dict_ref(currentDB_.dbId, -1);
     client.reset(new StringDictionaryClient(string_dict_hosts_.front(), dict_ref, true));
   }
@@ -3078,6 +3413,46 @@ void Catalog::doTruncateTable(const TableDescriptor* td) {
   }
 }
 
+// caller must hold the CheckpointLock and a write UpdateDeleteLock of the table
+size_t Catalog::vacuumDeletedRows(const TableDescriptor* td, const double minDeletedFraction) const {
+  UpdelRoll updelRoll;
+  size_t nrows_vacuumed = 0;
+  try {
+    for (const auto shard : getPhysicalTablesDescriptors(td)) {
+      CHECK(shard->fragmenter);
+      nrows_vacuumed += shard->fragmenter->vacuumDeletedRows(this, shard, minDeletedFraction, updelRoll);
+    }
+  } catch (...) {
+    updelRoll.cancelUpdate();
+    throw;
+  }
+  // a single checkpoint swaps the compacted fragments of all shards in under the next table epoch
+  updelRoll.commitUpdate();
+  if (nrows_vacuumed) {
+    LOG(INFO) << "Vacuumed " << nrows_vacuumed << " deleted rows from table " << td->tableName;
+  }
+  return nrows_vacuumed;
+}
+
+size_t Catalog::reclusterRows(const TableDescriptor* td) const {
+  UpdelRoll updelRoll;
+  size_t nrows_reclustered = 0;
+  try {
+    for (const auto shard : getPhysicalTablesDescriptors(td)) {
+      CHECK(shard->fragmenter);
+      nrows_reclustered += shard->fragmenter->reclusterRows(this, shard, updelRoll);
+    }
+  } catch (...) {
+    updelRoll.cancelUpdate();
+    throw;
+  }
+  updelRoll.commitUpdate();
+  if (nrows_reclustered) {
+    LOG(INFO) << "Reclustered " << nrows_reclustered << " rows of table " << td->tableName;
+  }
+  return nrows_reclustered;
+}
+
 // used by rollback_table_epoch to clean up in memory artifacts after a rollback
 void Catalog::removeChunks(const int table_id) {
   auto td = getMetadataForTable(table_id);
@@ -3096,6 +3471,8 @@ void Catalog::removeChunks(const int table_id) {
 
   dataMgr_->deleteChunksWithPrefix(chunkKey, MemoryLevel::CPU_LEVEL);
   dataMgr_->deleteChunksWithPrefix(chunkKey, MemoryLevel::GPU_LEVEL);
+  // the rolled back rows may already be folded into the views of this table
+  invalidateMaterializedViews(td->shard >= 0 ? getLogicalTableId(table_id) : table_id);
 }
 
 void Catalog::dropTable(const TableDescriptor* td) {
@@ -3152,6 +3529,21 @@ void Catalog::doDropTable(const TableDescriptor* td, SqliteConnector* conn) {
 
   const int tableId = td->tableId;
   conn->query_with_text_param("DELETE FROM mapd_tables WHERE tableid = ?", std::to_string(tableId));
+  conn->query_with_text_param("DELETE FROM mapd_table_access WHERE tableid = ?", std::to_string(tableId));
+  conn->query_with_text_params("DELETE FROM mapd_materialized_views WHERE tableid = ?1 OR source_tableid = ?1",
+                               std::vector<std::string>{std::to_string(tableId)});
+  {
+    std::lock_guard<std::mutex> materialized_view_lock(materializedViewMutex_);
+    for (auto it = materializedViews_.begin(); it != materializedViews_.end();) {
+      if (it->first == tableId || it->second->sourceTableId == tableId) {
+        it = materializedViews_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  // table ids can be reused, never hand out a data version seen with the dropped table
+  bumpTableDataVersion(tableId);
   conn->query_with_text_params("select comp_param from mapd_columns where compression = ? and tableid = ?",
                                std::vector<std::string>{std::to_string(kENCODING_DICT), std::to_string(tableId)});
   int numRows = conn->getNumRows();
@@ -29,13 +29,16 @@
 #ifndef CATALOG_H
 #define CATALOG_H
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <list>
 #include <map>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 
 #include "ColumnDescriptor.h"
@@ -44,6 +47,7 @@
 #include "LdapServer.h"
 #include "RestServer.h"
 #include "LinkDescriptor.h"
+#include "MaterializedViewDescriptor.h"
 #include "Role.h"
 #include "TableDescriptor.h"
 #include "ObjectRoleDescriptor.h"
@@ -56,6 +60,8 @@
 #include "../Calcite/Calcite.h"
 #include "../Shared/mapd_shared_mutex.h"
 
+class PrewarmQueue;
+
 struct Privileges {
   bool super_;
   bool select_;
@@ -161,6 +167,8 @@ class Catalog {
   std::string createLink(LinkDescriptor& ld, size_t min_length);
   void dropTable(const TableDescriptor* td);
   void truncateTable(const TableDescriptor* td);
+  size_t vacuumDeletedRows(const TableDescriptor* td, const double minDeletedFraction = 0) const;
+  size_t reclusterRows(const TableDescriptor* td) const;
   void renameTable(const TableDescriptor* td, const std::string& newTableName);
   void renameColumn(const TableDescriptor* td, const ColumnDescriptor* cd, const std::string& newColumnName);
 
@@ -234,6 +242,38 @@ class Catalog {
   int getLogicalTableId(const int physicalTableId) const;
   void checkpoint(const int logicalTableId) const;
 
+  /**
+   * @brief Loads the storage of all tables on background threads, most frequently accessed tables first.
+   *
+   * A query touching a table which is still waiting loads it right away, and the other shards of that
+   * table move to the front of the queue.
+   */
+  void startTablePrewarm(const size_t num_threads);
+
+  /**
+   * @brief Materialized views keep partial aggregates of a query over a single source table.
+   *
+   * Appends to the source only mark its views as pending; they are folded in by the next refresh. Updates,
+   * deletes and truncation of the source invalidate the partial aggregates and the next refresh rebuilds them.
+   */
+  void createMaterializedView(const MaterializedViewDescriptor& mvd);
+  std::shared_ptr<const MaterializedViewDescriptor> getMaterializedView(const int32_t tableId) const;
+  std::vector<std::shared_ptr<const MaterializedViewDescriptor>> getMaterializedViewsForTable(
+      const int32_t sourceTableId) const;
+  void setMaterializedViewRefreshState(const int32_t tableId,
+                                       const int64_t refreshedRows,
+                                       const bool needsRebuild) const;
+  void setMaterializedViewRefreshPending(const int32_t tableId, const bool refreshPending) const;
+  void recordTableAppend(const int32_t tableId) const;
+  void invalidateMaterializedViews(const int32_t sourceTableId) const;
+  /**
+   * @brief counter of the changes to the rows of a logical table since the catalog was loaded
+   *
+   * Bumped by appends, updates, deletes and truncation. Unlike the epoch it also moves for tables which are
+   * never checkpointed and never repeats after a truncate, so it can key cached query results.
+   */
+  uint64_t getTableDataVersion(const int32_t tableId) const;
+
  protected:
   typedef std::map<std::string, TableDescriptor*> TableDescriptorMap;
   typedef std::map<int, TableDescriptor*> TableDescriptorMapById;
@@ -261,6 +301,9 @@ class Catalog {
   void updateDeletedColumnIndicator();
   void updateFrontendViewsToDashboards();
   void recordOwnershipOfObjectsInObjectPermissions();
+  void updateTableAccessSchema();
+  void updateMaterializedViewSchema();
+  void bumpTableDataVersion(const int32_t tableId) const;
   void buildMaps();
   void addTableToMap(TableDescriptor& td,
                      const std::list<ColumnDescriptor>& columns,
@@ -283,6 +326,8 @@ class Catalog {
   void doTruncateTable(const TableDescriptor* td);
   void renamePhysicalTable(const TableDescriptor* td, const std::string& newTableName);
   void instantiateFragmenter(TableDescriptor* td) const;
+  void accessTable(TableDescriptor* td) const;
+  void flushTableAccessCounts() const;
   void getAllColumnMetadataForTable(const TableDescriptor* td,
                                     std::list<const ColumnDescriptor*>& colDescs,
                                     const bool fetchSystemColumns,
@@ -314,6 +359,21 @@ class Catalog {
   int nextTempTableId_;
   int nextTempDictId_;
 
+  // Fragmenters of tables in different stripes are instantiated concurrently. The fragmenter of a
+  // table is only assigned, and checked by the lookups, under the stripe lock of the table.
+  mutable std::array<std::mutex, 64> fragmenterMutexes_;
+  // accesses not yet added to mapd_table_access, under the stripe lock of the table
+  mutable std::array<std::unordered_map<int, int64_t>, 64> unflushedTableAccess_;
+  mutable std::atomic<std::chrono::steady_clock::rep> lastTableAccessFlush_;
+  mutable std::mutex tableAccessMutex_;
+  mutable std::unordered_map<int, int64_t> tableAccessCounts_;  // persisted and flushed accesses
+  std::unique_ptr<PrewarmQueue> tablePrewarmQueue_;
+  // copy on write, the descriptors handed out are never modified
+  mutable std::mutex materializedViewMutex_;
+  mutable std::map<int32_t, std::shared_ptr<const MaterializedViewDescriptor>> materializedViews_;
+  mutable std::mutex tableDataVersionMutex_;
+  mutable std::unordered_map<int32_t, uint64_t> tableDataVersions_;  // by logical table id
+
  private:
   static std::map<std::string, std::shared_ptr<Catalog>> mapd_cat_map_;
   DeletedColumnPerTableMap deletedColumnPerTable_;
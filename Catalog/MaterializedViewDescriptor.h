@@ -0,0 +1,41 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MATERIALIZED_VIEW_DESCRIPTOR_H
+#define MATERIALIZED_VIEW_DESCRIPTOR_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @type MaterializedViewDescriptor
+ * @brief specifies the content in-memory of a row in the materialized view metadata table
+ *
+ * The table identified by tableId holds partial aggregates of the view query, one set per refresh batch.
+ * refreshedRows is the number of source rows (in insertion order) already folded into the view.
+ */
+
+struct MaterializedViewDescriptor {
+  int32_t tableId;
+  int32_t sourceTableId;
+  std::string viewSQL;
+  std::string viewRA;
+  int64_t refreshedRows;
+  bool needsRebuild;    // source rows were updated or deleted, partial aggregates are stale
+  bool refreshPending;  // not persisted, rows were appended to the source since the last refresh
+};
+
+#endif  // MATERIALIZED_VIEW_DESCRIPTOR_H
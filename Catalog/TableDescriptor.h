@@ -50,6 +50,7 @@ struct TableDescriptor {
       fragmenter;       // point to fragmenter object for the table.  it's instantiated upon first use.
   int32_t nShards;      // # of shards, i.e. physical tables for this logical table (default: 0)
   int shardedColumnId;  // Id of the column to be sharded on
+  int sortedColumnId;   // Id of the column fragments are kept sorted on (default: 0, none)
   Data_Namespace::MemoryLevel persistenceLevel;
   bool hasDeletedCol;  // Does table has a delete col, Yes (VACUUM = DELAYED)
                        //                              No  (VACUUM = IMMEDIATE)
@@ -59,6 +60,7 @@ struct TableDescriptor {
         shard(-1),
         nShards(0),
         shardedColumnId(0),
+        sortedColumnId(0),
         persistenceLevel(Data_Namespace::MemoryLevel::DISK_LEVEL),
         hasDeletedCol(true) {}
 };
@@ -32,6 +32,7 @@
 #include "AbstractBuffer.h"
 #include "ChunkMetadata.h"
 #include "Encoder.h"
+#include "../Shared/geo_compression.h"
 #include <mutex>
 
 using Data_Namespace::AbstractBuffer;
@@ -39,7 +40,12 @@ using Data_Namespace::AbstractBuffer;
 class ArrayNoneEncoder : public Encoder {
  public:
   ArrayNoneEncoder(AbstractBuffer* buffer)
-      : Encoder(buffer), has_nulls(false), initialized(false), index_buf(nullptr), last_offset(-1) {}
+      : Encoder(buffer), has_nulls(false), initialized(false), index_buf(nullptr), last_offset(-1) {
+    const auto subtype = buffer_->sqlType.get_subtype();
+    if (subtype == kDOUBLE || subtype == kTINYINT) {
+      initSpatialExtent();
+    }
+  }
 
   size_t getNumElemsForBytesInsertData(const std::vector<ArrayDatum>* srcData,
                                        const int start_idx,
@@ -134,6 +140,7 @@ class ArrayNoneEncoder : public Encoder {
     // keep Chunk statistics with array elements
     for (size_t n = start_idx; n < start_idx + numAppendElems; n++) {
       update_elem_stats((*srcData)[n]);
+      update_spatial_extent((*srcData)[n]);
     }
     numElems += numAppendElems;
     ChunkMetadata chunkMetadata;
@@ -171,6 +178,9 @@ class ArrayNoneEncoder : public Encoder {
     elem_max = array_encoder->elem_max;
     has_nulls = array_encoder->has_nulls;
     initialized = array_encoder->initialized;
+    spatial_extent_ = array_encoder->spatial_extent_;
+    // the index buffer may have been rewritten (e.g. compacted), re-read the last offset on next append
+    last_offset = -1;
   }
 
   AbstractBuffer* get_index_buf() const { return index_buf; }
@@ -342,6 +352,28 @@ class ArrayNoneEncoder : public Encoder {
     }
   };
 
+  // The physical columns of the geo columns hold a box per row for the bounds and a point per row, plain or
+  // GEOINT32 compressed, for the coords of a POINT. The extent is only looked at for those, any other shape of
+  // array makes it unknown.
+  void update_spatial_extent(const ArrayDatum& array) {
+    if (spatial_extent_.empty() || array.is_null || array.length == 0) {
+      return;
+    }
+    const auto subtype = buffer_->sqlType.get_subtype();
+    if (subtype == kDOUBLE && array.length == 4 * sizeof(double)) {
+      const double* box = (double*)array.pointer;
+      addToSpatialExtent(box[0], box[1]);
+      addToSpatialExtent(box[2], box[3]);
+    } else if (subtype == kTINYINT &&
+               (array.length == 2 * sizeof(double) || array.length == 2 * sizeof(int32_t))) {
+      double x, y;
+      decompress_point(array.pointer, array.length, array.length == 2 * sizeof(int32_t), x, y);
+      addToSpatialExtent(x, y);
+    } else {
+      dropSpatialExtent();
+    }
+  }
+
 };  // class ArrayNoneEncoder
 
 #endif  // ARRAY_NONE_ENCODER_H
@@ -19,6 +19,11 @@
 
 #include "../Shared/sqltypes.h"
 #include <stddef.h>
+#include <cstdint>
+#include <vector>
+
+// Precision of the HyperLogLog sketch of the distinct values of integer, time and dictionary encoded chunks.
+#define CHUNK_SKETCH_BITS 8
 
 struct ChunkStats {
   Datum min;
@@ -31,6 +36,9 @@ struct ChunkMetadata {
   size_t numBytes;
   size_t numElements;
   ChunkStats chunkStats;
+  bool statsExact{false};  // chunkStats are those of the stored values, not bounds widened by in place updates
+  std::vector<uint8_t> distinctSketch;  // HyperLogLog registers of the non-null values, empty if unknown
+  std::vector<double> spatialExtent;    // x min, y min, x max, y max of the geo coords or boxes, empty if unknown
 
   template <typename T>
   void fillChunkStats(const T min, const T max, const bool has_nulls) {
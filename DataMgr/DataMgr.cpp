@@ -407,4 +407,8 @@ size_t DataMgr::getTableEpoch(const int db_id, const int tb_id) {
   return dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])->getTableEpoch(db_id, tb_id);
 }
 
+std::string DataMgr::getTableDataPath(const int db_id, const int tb_id) {
+  return dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])->getFileMgr(db_id, tb_id)->getFileMgrBasePath();
+}
+
 }  // Data_Namespace
@@ -104,6 +104,7 @@ class DataMgr {
   void removeTableRelatedDS(const int db_id, const int tb_id);
   void setTableEpoch(const int db_id, const int tb_id, const int start_epoch);
   size_t getTableEpoch(const int db_id, const int tb_id);
+  std::string getTableDataPath(const int db_id, const int tb_id);  // directory of the files of a disk table
 
   CudaMgr_Namespace::CudaMgr* cudaMgr_;
 
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DATE_DAYS_ENCODER_H
+#define DATE_DAYS_ENCODER_H
+#include "Encoder.h"
+#include "AbstractBuffer.h"
+#include <stdexcept>
+#include <iostream>
+#include <memory>
+#include <glog/logging.h>
+
+// Stores the dates of a DATE column, passed in as seconds since the epoch, as days since the epoch. The chunk
+// stats stay in seconds like for the other encodings of DATE, only the stored values change.
+template <typename T, typename V>
+class DateDaysEncoder : public Encoder {
+ public:
+  DateDaysEncoder(Data_Namespace::AbstractBuffer* buffer)
+      : Encoder(buffer),
+        dataMin(std::numeric_limits<T>::max()),
+        dataMax(std::numeric_limits<T>::min()),
+        has_nulls(false) {
+    initSketch();
+  }
+
+  ChunkMetadata appendData(int8_t*& srcData, const size_t numAppendElems) {
+    T* unencodedData = reinterpret_cast<T*>(srcData);
+    auto encodedData = std::unique_ptr<V[]>(new V[numAppendElems]);
+    for (size_t i = 0; i < numAppendElems; ++i) {
+      const T data = unencodedData[i];
+      // the loaders pass the null sentinel of the encoded column, the query results the one of DATE
+      if (data == std::numeric_limits<V>::min() || data == std::numeric_limits<T>::min()) {
+        encodedData.get()[i] = std::numeric_limits<V>::min();
+        has_nulls = true;
+        continue;
+      }
+      const auto days = get_epoch_days_from_seconds(data);
+      encodedData.get()[i] = static_cast<V>(days);
+      if (days != encodedData.get()[i] || encodedData.get()[i] == std::numeric_limits<V>::min()) {
+        // truncated, it would read back as another date
+        LOG(ERROR) << "Date encoding failed, Unencoded: " + std::to_string(data) + " stored as NULL";
+        encodedData.get()[i] = std::numeric_limits<V>::min();
+        has_nulls = true;
+      } else {
+        const T date = get_epoch_seconds_from_days(days);
+        dataMin = std::min(dataMin, date);
+        dataMax = std::max(dataMax, date);
+        addToSketch(static_cast<int64_t>(date));
+      }
+    }
+    numElems += numAppendElems;
+
+    buffer_->append((int8_t*)(encodedData.get()), numAppendElems * sizeof(V));
+    ChunkMetadata chunkMetadata;
+    getMetadata(chunkMetadata);
+    srcData += numAppendElems * sizeof(T);
+    return chunkMetadata;
+  }
+
+  void getMetadata(ChunkMetadata& chunkMetadata) {
+    Encoder::getMetadata(chunkMetadata);  // call on parent class
+    chunkMetadata.fillChunkStats(dataMin, dataMax, has_nulls);
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  ChunkMetadata getMetadata(const SQLTypeInfo& ti) {
+    ChunkMetadata chunk_metadata{ti, 0, 0, ChunkStats{}};
+    chunk_metadata.fillChunkStats(dataMin, dataMax, has_nulls);
+    return chunk_metadata;
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  void updateStats(const int64_t val, const bool is_null) {
+    dropSketch();
+    stats_exact_ = false;
+    if (is_null) {
+      has_nulls = true;
+    } else {
+      const auto data = static_cast<T>(val);
+      dataMin = std::min(dataMin, data);
+      dataMax = std::max(dataMax, data);
+    }
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  void updateStats(const double val, const bool is_null) {
+    dropSketch();
+    stats_exact_ = false;
+    if (is_null) {
+      has_nulls = true;
+    } else {
+      const auto data = static_cast<T>(val);
+      dataMin = std::min(dataMin, data);
+      dataMax = std::max(dataMax, data);
+    }
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  void reduceStats(const Encoder& that) {
+    const auto that_typed = static_cast<const DateDaysEncoder<T, V>&>(that);
+    if (that_typed.has_nulls) {
+      has_nulls = true;
+    }
+    dataMin = std::min(dataMin, that_typed.dataMin);
+    dataMax = std::max(dataMax, that_typed.dataMax);
+    mergeSketch(that);
+    stats_exact_ = stats_exact_ && that_typed.stats_exact_;
+  }
+
+  // Only called from the storage layer after rows were compacted out of a chunk.
+  void resetStats(const int8_t* encoded_data, const size_t num_elements) {
+    stats_exact_ = true;
+    dataMin = std::numeric_limits<T>::max();
+    dataMax = std::numeric_limits<T>::min();
+    has_nulls = false;
+    initSketch();
+    const V* data = reinterpret_cast<const V*>(encoded_data);
+    for (size_t i = 0; i < num_elements; ++i) {
+      if (data[i] == std::numeric_limits<V>::min())
+        has_nulls = true;
+      else {
+        const T date = get_epoch_seconds_from_days(data[i]);
+        dataMin = std::min(dataMin, date);
+        dataMax = std::max(dataMax, date);
+        addToSketch(static_cast<int64_t>(date));
+      }
+    }
+    numElems = num_elements;
+  }
+
+  void copyMetadata(const Encoder* copyFromEncoder) {
+    numElems = copyFromEncoder->numElems;
+    auto castedEncoder = reinterpret_cast<const DateDaysEncoder<T, V>*>(copyFromEncoder);
+    dataMin = castedEncoder->dataMin;
+    dataMax = castedEncoder->dataMax;
+    has_nulls = castedEncoder->has_nulls;
+    sketch_ = castedEncoder->sketch_;
+    stats_exact_ = castedEncoder->stats_exact_;
+  }
+
+  void writeMetadata(FILE* f) {
+    // assumes pointer is already in right place
+    fwrite((int8_t*)&numElems, sizeof(size_t), 1, f);
+    fwrite((int8_t*)&dataMin, sizeof(T), 1, f);
+    fwrite((int8_t*)&dataMax, sizeof(T), 1, f);
+    fwrite((int8_t*)&has_nulls, sizeof(bool), 1, f);
+  }
+
+  void readMetadata(FILE* f) {
+    // assumes pointer is already in right place
+    fread((int8_t*)&numElems, sizeof(size_t), 1, f);
+    fread((int8_t*)&dataMin, 1, sizeof(T), f);
+    fread((int8_t*)&dataMax, 1, sizeof(T), f);
+    fread((int8_t*)&has_nulls, 1, sizeof(bool), f);
+  }
+  T dataMin;
+  T dataMax;
+  bool has_nulls;
+
+};  // DateDaysEncoder
+
+#endif  // DATE_DAYS_ENCODER_H
@@ -17,10 +17,15 @@
 #include "Encoder.h"
 #include "NoneEncoder.h"
 #include "FixedLengthEncoder.h"
+#include "DateDaysEncoder.h"
 #include "StringNoneEncoder.h"
 #include "ArrayNoneEncoder.h"
+#include "../QueryEngine/MurmurHash1Inl.h"
+#include "../QueryEngine/HyperLogLogRank.h"
 #include <glog/logging.h>
 
+#include <algorithm>
+
 Encoder* Encoder::Create(Data_Namespace::AbstractBuffer* buffer, const SQLTypeInfo sqlType) {
   switch (sqlType.get_compression()) {
     case kENCODING_NONE: {
@@ -140,6 +145,21 @@ Encoder* Encoder::Create(Data_Namespace::AbstractBuffer* buffer, const SQLTypeIn
       }  // switch (sqlType)
       break;
     }  // Case: kENCODING_FIXED
+    case kENCODING_DATE_IN_DAYS: {
+      CHECK(sqlType.get_type() == kDATE);
+      switch (sqlType.get_comp_param()) {
+        case 16:
+          return new DateDaysEncoder<time_t, int16_t>(buffer);
+          break;
+        case 32:
+          return new DateDaysEncoder<time_t, int32_t>(buffer);
+          break;
+        default:
+          return 0;
+          break;
+      }
+      break;
+    }
     case kENCODING_DICT: {
       if (sqlType.get_type() == kARRAY) {
         CHECK(IS_STRING(sqlType.get_subtype()));
@@ -187,6 +207,109 @@ void Encoder::getMetadata(ChunkMetadata& chunkMetadata) {
   chunkMetadata.sqlType = buffer_->sqlType;
   chunkMetadata.numBytes = buffer_->size();
   chunkMetadata.numElements = numElems;
+  chunkMetadata.statsExact = stats_exact_;
+  chunkMetadata.distinctSketch = sketch_;
+  chunkMetadata.spatialExtent = spatial_extent_;
+}
+
+// Same hash and rank as agg_approximate_count_distinct, so the registers mean the same as the query ones.
+void Encoder::addToSketch(const int64_t val) {
+  if (sketch_.empty()) {
+    return;
+  }
+  const uint64_t hash = MurmurHash64AImpl(&val, sizeof(val), 0);
+  const uint32_t index = hash >> (64 - CHUNK_SKETCH_BITS);
+  const uint8_t rank = get_rank(hash << CHUNK_SKETCH_BITS, 64 - CHUNK_SKETCH_BITS);
+  sketch_[index] = std::max(sketch_[index], rank);
+}
+
+void Encoder::mergeSketch(const Encoder& that) {
+  if (sketch_.size() != that.sketch_.size()) {
+    dropSketch();
+    return;
+  }
+  for (size_t i = 0; i < sketch_.size(); ++i) {
+    sketch_[i] = std::max(sketch_[i], that.sketch_[i]);
+  }
+}
+
+void Encoder::writeSketch(FILE* f) const {
+  const int32_t sketch_size = sketch_.size();
+  fwrite(&sketch_size, sizeof(int32_t), 1, f);
+  if (sketch_size) {
+    fwrite(&sketch_[0], 1, sketch_.size(), f);
+  }
+}
+
+bool Encoder::readSketch(FILE* f) {
+  int32_t sketch_size{0};
+  if (fread(&sketch_size, sizeof(int32_t), 1, f) != 1 || sketch_size < 0 || sketch_size > (1 << 16)) {
+    dropSketch();
+    return false;
+  }
+  sketch_.resize(sketch_size);
+  if (sketch_size && fread(&sketch_[0], 1, sketch_.size(), f) != sketch_.size()) {
+    dropSketch();
+    return false;
+  }
+  if (sketch_size && sketch_size != (1 << CHUNK_SKETCH_BITS)) {
+    // written with another precision
+    dropSketch();
+  }
+  return true;
+}
+
+void Encoder::writeStatsExact(FILE* f) const {
+  const int8_t stats_exact = stats_exact_;
+  fwrite(&stats_exact, sizeof(int8_t), 1, f);
+}
+
+bool Encoder::readStatsExact(FILE* f) {
+  int8_t stats_exact{0};
+  if (fread(&stats_exact, sizeof(int8_t), 1, f) != 1) {
+    return false;
+  }
+  stats_exact_ = stats_exact;
+  return true;
+}
+
+void Encoder::initSpatialExtent() {
+  spatial_extent_ = {std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::max(),
+                     std::numeric_limits<double>::lowest(),
+                     std::numeric_limits<double>::lowest()};
+}
+
+void Encoder::addToSpatialExtent(const double x, const double y) {
+  if (spatial_extent_.empty()) {
+    return;
+  }
+  spatial_extent_[0] = std::min(spatial_extent_[0], x);
+  spatial_extent_[1] = std::min(spatial_extent_[1], y);
+  spatial_extent_[2] = std::max(spatial_extent_[2], x);
+  spatial_extent_[3] = std::max(spatial_extent_[3], y);
+}
+
+void Encoder::writeSpatialExtent(FILE* f) const {
+  const int32_t extent_size = spatial_extent_.size();
+  fwrite(&extent_size, sizeof(int32_t), 1, f);
+  if (extent_size) {
+    fwrite(&spatial_extent_[0], sizeof(double), spatial_extent_.size(), f);
+  }
+}
+
+bool Encoder::readSpatialExtent(FILE* f) {
+  int32_t extent_size{0};
+  if (fread(&extent_size, sizeof(int32_t), 1, f) != 1 || (extent_size != 0 && extent_size != 4)) {
+    dropSpatialExtent();
+    return false;
+  }
+  spatial_extent_.resize(extent_size);
+  if (extent_size && fread(&spatial_extent_[0], sizeof(double), spatial_extent_.size(), f) != spatial_extent_.size()) {
+    dropSpatialExtent();
+    return false;
+  }
+  return true;
 }
 
 ChunkMetadata Encoder::getMetadata(const SQLTypeInfo& ti) {
@@ -205,3 +328,7 @@ void Encoder::updateStats(const double, const bool) {
 void Encoder::reduceStats(const Encoder&) {
   CHECK(false);
 }
+
+void Encoder::resetStats(const int8_t*, const size_t) {
+  CHECK(false);
+}
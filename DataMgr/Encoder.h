@@ -36,7 +36,7 @@ class AbstractBuffer;
 class Encoder {
  public:
   static Encoder* Create(Data_Namespace::AbstractBuffer* buffer, const SQLTypeInfo sqlType);
-  Encoder(Data_Namespace::AbstractBuffer* buffer) : numElems(0), buffer_(buffer) {}
+  Encoder(Data_Namespace::AbstractBuffer* buffer) : numElems(0), buffer_(buffer), stats_exact_(true) {}
   virtual ChunkMetadata appendData(int8_t*& srcData, const size_t numAppendElems) = 0;
   virtual void getMetadata(ChunkMetadata& chunkMetadata);
   // Only called from the executor for synthesized meta-information.
@@ -44,14 +44,40 @@ class Encoder {
   virtual void updateStats(const int64_t val, const bool is_null);
   virtual void updateStats(const double val, const bool is_null);
   virtual void reduceStats(const Encoder&);
+  // Only called from the storage layer after rows were compacted out of a chunk.
+  virtual void resetStats(const int8_t* encoded_data, const size_t num_elements);
   virtual void copyMetadata(const Encoder* copyFromEncoder) = 0;
   virtual void writeMetadata(FILE* f /*, const size_t offset*/) = 0;
   virtual void readMetadata(FILE* f /*, const size_t offset*/) = 0;
+  // The distinct value sketch is stored after the encoder metadata.
+  void writeSketch(FILE* f) const;
+  bool readSketch(FILE* f);
+  // The sketch can't be maintained through in place updates, it's unknown from then on.
+  void dropSketch() { sketch_.clear(); }
+  // In place updates only widen the min / max, from then on they're bounds of the values rather than the
+  // values themselves. Rewriting the whole chunk makes them exact again.
+  void writeStatsExact(FILE* f) const;
+  bool readStatsExact(FILE* f);
+  // Metadata from before the flag was persisted, only an intact sketch proves there was no in place update.
+  void guessStatsExact() { stats_exact_ = !sketch_.empty(); }
+  // The spatial extent is stored after the sketch.
+  void writeSpatialExtent(FILE* f) const;
+  bool readSpatialExtent(FILE* f);
+  void dropSpatialExtent() { spatial_extent_.clear(); }
   size_t numElems;
   virtual ~Encoder() {}
 
  protected:
+  void initSketch() { sketch_.assign(size_t(1) << CHUNK_SKETCH_BITS, 0); }
+  void addToSketch(const int64_t val);
+  void mergeSketch(const Encoder& that);
+  void initSpatialExtent();
+  void addToSpatialExtent(const double x, const double y);
+
   Data_Namespace::AbstractBuffer* buffer_;
+  std::vector<uint8_t> sketch_;         // empty if the encoder doesn't keep one or it's unknown
+  std::vector<double> spatial_extent_;  // same, an empty box before the first coords
+  bool stats_exact_;
   // ChunkMetadata metadataTemplate_;
 };
 
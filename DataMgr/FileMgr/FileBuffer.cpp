@@ -368,7 +368,7 @@ void FileBuffer::readMetadata(const Page& page) {
       NUM_METADATA);  // assumes we will encode hasEncoder, bufferType, encodingType, encodingBits all as int
   fread((int8_t*)&(typeData[0]), sizeof(int), typeData.size(), f);
   int version = typeData[0];
-  CHECK(version == METADATA_VERSION);  // add backward compatibility code here
+  CHECK(version >= 0 && version <= METADATA_VERSION);  // add backward compatibility code here
   hasEncoder = static_cast<bool>(typeData[1]);
   if (hasEncoder) {
     sqlType.set_type(static_cast<SQLTypes>(typeData[2]));
@@ -379,8 +379,18 @@ void FileBuffer::readMetadata(const Page& page) {
     sqlType.set_compression(static_cast<EncodingType>(typeData[7]));
     sqlType.set_comp_param(typeData[8]);
     sqlType.set_size(typeData[9]);
+    CHECK(version >= 2 || sqlType.get_compression() != kENCODING_DATE_IN_DAYS);
     initEncoder(sqlType);
     encoder->readMetadata(f);
+    if (version < 1 || !encoder->readSketch(f)) {
+      encoder->dropSketch();
+    }
+    if (version < 3 || !encoder->readSpatialExtent(f)) {
+      encoder->dropSpatialExtent();
+    }
+    if (version < 4 || !encoder->readStatsExact(f)) {
+      encoder->guessStatsExact();
+    }
   }
 }
 
@@ -410,6 +420,9 @@ void FileBuffer::writeMetadata(const int epoch) {
   fwrite((int8_t*)&(typeData[0]), sizeof(int), typeData.size(), f);
   if (hasEncoder) {  // redundant
     encoder->writeMetadata(f);
+    encoder->writeSketch(f);
+    encoder->writeSpatialExtent(f);
+    encoder->writeStatsExact(f);
   }
   metadataPages_.epochs.push_back(epoch);
   metadataPages_.pageVersions.push_back(page);
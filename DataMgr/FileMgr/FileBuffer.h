@@ -32,7 +32,10 @@
 using namespace Data_Namespace;
 
 #define NUM_METADATA 10
-#define METADATA_VERSION 0
+#define METADATA_VERSION 4  // 1: the distinct value sketch follows the encoder metadata
+                            // 2: DATE chunks may be encoded as days
+                            // 3: the spatial extent follows the sketch
+                            // 4: the stats exact flag follows the spatial extent
 
 namespace File_Namespace {
 
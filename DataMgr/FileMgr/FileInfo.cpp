@@ -182,6 +182,8 @@ static void sighandler(int sig) {
 
 void FileInfo::freePage(int pageId) {
 #define RESILIENT_PAGE_HEADER
+  // the page directory of the last checkpoint may still reference this page
+  fileMgr->invalidatePageDirectory();
 #ifdef RESILIENT_PAGE_HEADER
   int epoch_freed_page[2] = {DELETE_CONTINGENT, fileMgr->epoch()};
   File_Namespace::write(f, pageId * pageSize + sizeof(int), sizeof(epoch_freed_page), (int8_t*)epoch_freed_page);
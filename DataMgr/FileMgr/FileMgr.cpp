@@ -71,7 +71,10 @@ FileMgr::FileMgr(const int deviceId,
       fileMgrKey_(fileMgrKey),
       defaultPageSize_(defaultPageSize),
       nextFileId_(0),
-      epoch_(epoch) {
+      epoch_(epoch),
+      pageDirectoryValid_(false),
+      pageDirectoryDirty_(true),
+      openedFromPageDirectory_(false) {
   init(num_reader_threads);
 }
 
@@ -82,7 +85,10 @@ FileMgr::FileMgr(GlobalFileMgr* gfm, const size_t defaultPageSize, std::string b
       fileMgrBasePath_(basePath),
       defaultPageSize_(defaultPageSize),
       nextFileId_(0),
-      epoch_(-1) {
+      epoch_(-1),
+      pageDirectoryValid_(false),
+      pageDirectoryDirty_(true),
+      openedFromPageDirectory_(false) {
   init(basePath);
 }
 
@@ -109,119 +115,28 @@ void FileMgr::init(const size_t num_reader_threads) {
   if (boost::filesystem::exists(path)) {
     if (!boost::filesystem::is_directory(path))
       LOG(FATAL) << "Specified path '" << fileMgrBasePath_ << "' for table data is not a directory.";
+    int diskEpoch;  // epoch of the last checkpoint
     if (epoch_ != -1) {  // if opening at previous epoch
       int epochCopy = epoch_;
       openEpochFile(EPOCH_FILENAME);
+      diskEpoch = epoch_ - 1;
       epoch_ = epochCopy;
     } else {
       openEpochFile(EPOCH_FILENAME);
+      diskEpoch = epoch_ - 1;
     }
 
     auto clock_begin = timer_start();
-
-    boost::filesystem::directory_iterator endItr;  // default construction yields past-the-end
-    int maxFileId = -1;
-    int fileCount = 0;
-    int threadCount = std::thread::hardware_concurrency();
-    std::vector<HeaderInfo> headerVec;
-    std::vector<std::future<std::vector<HeaderInfo>>> file_futures;
-    for (boost::filesystem::directory_iterator fileIt(path); fileIt != endItr; ++fileIt) {
-      if (boost::filesystem::is_regular_file(fileIt->status())) {
-        // note that boost::filesystem leaves preceding dot on
-        // extension - hence MAPD_FILE_EXT is ".mapd"
-        std::string extension(fileIt->path().extension().string());
-
-        if (extension == MAPD_FILE_EXT) {
-          std::string fileStem(fileIt->path().stem().string());
-          // remove trailing dot if any
-          if (fileStem.size() > 0 && fileStem.back() == '.') {
-            fileStem = fileStem.substr(0, fileStem.size() - 1);
-          }
-          size_t dotPos = fileStem.find_last_of(".");  // should only be one
-          if (dotPos == std::string::npos) {
-            LOG(FATAL) << "Filename does not carry page size information.";
-          }
-          int fileId = boost::lexical_cast<int>(fileStem.substr(0, dotPos));
-          if (fileId > maxFileId) {
-            maxFileId = fileId;
-          }
-          size_t pageSize = boost::lexical_cast<size_t>(fileStem.substr(dotPos + 1, fileStem.size()));
-          std::string filePath(fileIt->path().string());
-          size_t fileSize = boost::filesystem::file_size(filePath);
-          assert(fileSize % pageSize == 0);  // should be no partial pages
-          size_t numPages = fileSize / pageSize;
-
-          VLOG(1) << "File id: " << fileId << " Page size: " << pageSize << " Num pages: " << numPages;
-
-          file_futures.emplace_back(std::async(std::launch::async, [filePath, fileId, pageSize, numPages, this] {
-            std::vector<HeaderInfo> tempHeaderVec;
-            openExistingFile(filePath, fileId, pageSize, numPages, tempHeaderVec);
-            return tempHeaderVec;
-          }));
-          fileCount++;
-          if (fileCount % threadCount == 0) {
-            processFileFutures(file_futures, headerVec);
-          }
-        }
-      }
-    }
-
-    if (file_futures.size() > 0) {
-      processFileFutures(file_futures, headerVec);
-    }
-    int64_t queue_time_ms = timer_stop(clock_begin);
-
-    LOG(INFO) << "Completed Reading table's file metadata, Elapsed time : " << queue_time_ms << "ms Epoch: " << epoch_
-              << " files read: " << fileCount << " table location: '" << fileMgrBasePath_ << "'";
-
-    /* Sort headerVec so that all HeaderInfos
-     * from a chunk will be grouped together
-     * and in order of increasing PageId
-     * - Version Epoch */
-
-    std::sort(headerVec.begin(), headerVec.end(), headerCompare);
-
-    /* Goal of next section is to find sequences in the
-     * sorted headerVec of the same ChunkId, which we
-     * can then initiate a FileBuffer with */
-
-    VLOG(1) << "Number of Headers in Vector: " << headerVec.size();
-    if (headerVec.size() > 0) {
-      ChunkKey lastChunkKey = headerVec.begin()->chunkKey;
-      auto startIt = headerVec.begin();
-
-      for (auto headerIt = headerVec.begin() + 1; headerIt != headerVec.end(); ++headerIt) {
-        // for (auto chunkIt = headerIt->chunkKey.begin(); chunkIt != headerIt->chunkKey.end(); ++chunkIt) {
-        //    std::cout << *chunkIt << " ";
-        //}
-
-        if (headerIt->chunkKey != lastChunkKey) {
-          chunkIndex_[lastChunkKey] = new FileBuffer(this, /*pageSize,*/ lastChunkKey, startIt, headerIt);
-          /*
-          if (startIt->versionEpoch != -1) {
-              cout << "not skipping bc version != -1" << endl;
-              // -1 means that chunk was deleted
-              // lets not read it in
-              chunkIndex_[lastChunkKey] = new FileBuffer (this,/lastChunkKey,startIt,headerIt);
-
-          }
-          else {
-              cout << "Skipping bc version == -1" << endl;
-          }
-          */
-          lastChunkKey = headerIt->chunkKey;
-          startIt = headerIt;
-        }
-      }
-      // now need to insert last Chunk
-      // size_t pageSize = files_[startIt->page.fileId]->pageSize;
-      // cout << "Inserting last chunk" << endl;
-      // if (startIt->versionEpoch != -1) {
-      chunkIndex_[lastChunkKey] = new FileBuffer(this, /*pageSize,*/ lastChunkKey, startIt, headerVec.end());
-      //}
+    if (epoch_ == diskEpoch + 1 && openPageDirectory(diskEpoch)) {
+      LOG(INFO) << "Completed reading table's page directory, Elapsed time : " << timer_stop(clock_begin)
+                << "ms Epoch: " << epoch_ << " files: " << files_.size() << " chunks: " << chunkIndex_.size()
+                << " table location: '" << fileMgrBasePath_ << "'";
+      openedFromPageDirectory_ = true;
+    } else {
+      // the header scan rewrites the headers of pages which were not checkpointed
+      invalidatePageDirectory(true);
+      scanPageHeaders(path);
     }
-    nextFileId_ = maxFileId + 1;
-    // std::cout << "next file id: " << nextFileId_ << std::endl;
   } else {  // data directory does not exist
     // std::cout << basePath_ << " does not exist. Creating" << std::endl;
     if (!boost::filesystem::create_directory(path)) {
@@ -245,6 +160,114 @@ void FileMgr::init(const size_t num_reader_threads) {
   }
 }
 
+void FileMgr::scanPageHeaders(const boost::filesystem::path& path) {
+  auto clock_begin = timer_start();
+
+  boost::filesystem::directory_iterator endItr;  // default construction yields past-the-end
+  int maxFileId = -1;
+  int fileCount = 0;
+  int threadCount = std::thread::hardware_concurrency();
+  std::vector<HeaderInfo> headerVec;
+  std::vector<std::future<std::vector<HeaderInfo>>> file_futures;
+  for (boost::filesystem::directory_iterator fileIt(path); fileIt != endItr; ++fileIt) {
+    if (boost::filesystem::is_regular_file(fileIt->status())) {
+      // note that boost::filesystem leaves preceding dot on
+      // extension - hence MAPD_FILE_EXT is ".mapd"
+      std::string extension(fileIt->path().extension().string());
+
+      if (extension == MAPD_FILE_EXT) {
+        std::string fileStem(fileIt->path().stem().string());
+        // remove trailing dot if any
+        if (fileStem.size() > 0 && fileStem.back() == '.') {
+          fileStem = fileStem.substr(0, fileStem.size() - 1);
+        }
+        size_t dotPos = fileStem.find_last_of(".");  // should only be one
+        if (dotPos == std::string::npos) {
+          LOG(FATAL) << "Filename does not carry page size information.";
+        }
+        int fileId = boost::lexical_cast<int>(fileStem.substr(0, dotPos));
+        if (fileId > maxFileId) {
+          maxFileId = fileId;
+        }
+        size_t pageSize = boost::lexical_cast<size_t>(fileStem.substr(dotPos + 1, fileStem.size()));
+        std::string filePath(fileIt->path().string());
+        size_t fileSize = boost::filesystem::file_size(filePath);
+        assert(fileSize % pageSize == 0);  // should be no partial pages
+        size_t numPages = fileSize / pageSize;
+
+        VLOG(1) << "File id: " << fileId << " Page size: " << pageSize << " Num pages: " << numPages;
+
+        file_futures.emplace_back(std::async(std::launch::async, [filePath, fileId, pageSize, numPages, this] {
+          std::vector<HeaderInfo> tempHeaderVec;
+          openExistingFile(filePath, fileId, pageSize, numPages, tempHeaderVec);
+          return tempHeaderVec;
+        }));
+        fileCount++;
+        if (fileCount % threadCount == 0) {
+          processFileFutures(file_futures, headerVec);
+        }
+      }
+    }
+  }
+
+  if (file_futures.size() > 0) {
+    processFileFutures(file_futures, headerVec);
+  }
+  int64_t queue_time_ms = timer_stop(clock_begin);
+
+  LOG(INFO) << "Completed Reading table's file metadata, Elapsed time : " << queue_time_ms << "ms Epoch: " << epoch_
+            << " files read: " << fileCount << " table location: '" << fileMgrBasePath_ << "'";
+
+  /* Sort headerVec so that all HeaderInfos
+   * from a chunk will be grouped together
+   * and in order of increasing PageId
+   * - Version Epoch */
+
+  std::sort(headerVec.begin(), headerVec.end(), headerCompare);
+
+  /* Goal of next section is to find sequences in the
+   * sorted headerVec of the same ChunkId, which we
+   * can then initiate a FileBuffer with */
+
+  VLOG(1) << "Number of Headers in Vector: " << headerVec.size();
+  if (headerVec.size() > 0) {
+    ChunkKey lastChunkKey = headerVec.begin()->chunkKey;
+    auto startIt = headerVec.begin();
+
+    for (auto headerIt = headerVec.begin() + 1; headerIt != headerVec.end(); ++headerIt) {
+      // for (auto chunkIt = headerIt->chunkKey.begin(); chunkIt != headerIt->chunkKey.end(); ++chunkIt) {
+      //    std::cout << *chunkIt << " ";
+      //}
+
+      if (headerIt->chunkKey != lastChunkKey) {
+        chunkIndex_[lastChunkKey] = new FileBuffer(this, /*pageSize,*/ lastChunkKey, startIt, headerIt);
+        /*
+        if (startIt->versionEpoch != -1) {
+            cout << "not skipping bc version != -1" << endl;
+            // -1 means that chunk was deleted
+            // lets not read it in
+            chunkIndex_[lastChunkKey] = new FileBuffer (this,/lastChunkKey,startIt,headerIt);
+
+        }
+        else {
+            cout << "Skipping bc version == -1" << endl;
+        }
+        */
+        lastChunkKey = headerIt->chunkKey;
+        startIt = headerIt;
+      }
+    }
+    // now need to insert last Chunk
+    // size_t pageSize = files_[startIt->page.fileId]->pageSize;
+    // cout << "Inserting last chunk" << endl;
+    // if (startIt->versionEpoch != -1) {
+    chunkIndex_[lastChunkKey] = new FileBuffer(this, /*pageSize,*/ lastChunkKey, startIt, headerVec.end());
+    //}
+  }
+  nextFileId_ = maxFileId + 1;
+  // std::cout << "next file id: " << nextFileId_ << std::endl;
+}
+
 void FileMgr::processFileFutures(std::vector<std::future<std::vector<HeaderInfo>>>& file_futures,
                                  std::vector<HeaderInfo>& headerVec) {
   for (auto& file_future : file_futures) {
@@ -559,6 +582,9 @@ void FileMgr::checkpoint() {
   for (auto& free_page : free_pages)
     free_page.first->freePageDeferred(free_page.second);
   free_pages.clear();
+  freePagesWriteLock.unlock();
+
+  writePageDirectory();
 }
 
 AbstractBuffer* FileMgr::createBuffer(const ChunkKey& key, const size_t pageSize, const size_t numBytes) {
@@ -693,6 +719,10 @@ AbstractBuffer* FileMgr::putBuffer(const ChunkKey& key, AbstractBuffer* srcBuffe
     //@todo use dirty flags to only flush pages of chunk that need to
     // be flushed
     chunk->write((int8_t*)srcBuffer->getMemoryPtr(), newChunkSize, 0, srcBuffer->getType(), srcBuffer->getDeviceId());
+    // the source may have shrunk, e.g. after deleted rows were vacuumed out of it
+    if (newChunkSize < oldChunkSize) {
+      chunk->setSize(newChunkSize);
+    }
   } else if (srcBuffer->isAppended()) {
     assert(oldChunkSize < newChunkSize);
     chunk->append((int8_t*)srcBuffer->getMemoryPtr() + oldChunkSize,
@@ -722,6 +752,7 @@ void FileMgr::free(AbstractBuffer* buffer) {
 
 Page FileMgr::requestFreePage(size_t pageSize, const bool isMetadata) {
   std::lock_guard<std::mutex> lock(getPageMutex_);
+  pageDirectoryDirty_ = true;
 
   auto candidateFiles = fileIndex_.equal_range(pageSize);
   int pageNum = -1;
@@ -751,6 +782,7 @@ void FileMgr::requestFreePages(size_t numPagesRequested,
   // not used currently
   // @todo add method to FileInfo to get more than one page
   std::lock_guard<std::mutex> lock(getPageMutex_);
+  pageDirectoryDirty_ = true;
   auto candidateFiles = fileIndex_.equal_range(pageSize);
   size_t numPagesNeeded = numPagesRequested;
   for (auto fileIt = candidateFiles.first; fileIt != candidateFiles.second; ++fileIt) {
@@ -912,6 +944,7 @@ void FileMgr::setEpoch(int epoch) {
 
 void FileMgr::free_page(std::pair<FileInfo*, int>&& page) {
   std::unique_lock<mapd_shared_mutex> lock(mutex_free_page);
+  pageDirectoryDirty_ = true;
   free_pages.push_back(page);
 }
 
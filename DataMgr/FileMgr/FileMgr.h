@@ -26,6 +26,7 @@
 #ifndef DATAMGR_MEMORY_FILE_FILEMGR_H
 #define DATAMGR_MEMORY_FILE_FILEMGR_H
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <mutex>
@@ -40,6 +41,8 @@
 #include "FileInfo.h"
 #include "Page.h"
 
+#include <boost/filesystem/path.hpp>
+
 using namespace Data_Namespace;
 
 namespace File_Namespace {
@@ -216,6 +219,16 @@ class FileMgr : public AbstractBufferMgr {  // implements
   void free_page(std::pair<FileInfo*, int>&& page);
   const std::pair<const int, const int> get_fileMgrKey() const { return fileMgrKey_; }
 
+  /**
+   * @brief Marks the page directory written by the last checkpoint as stale, durably.
+   *
+   * Must be called before a page header which the page directory relies on gets rewritten,
+   * the next startup then reads all page headers. No-op if already invalidated, unless forced.
+   */
+  void invalidatePageDirectory(const bool force = false);
+  /// True if the chunk index was restored from the page directory rather than from the page headers
+  bool openedFromPageDirectory() const { return openedFromPageDirectory_; }
+
  private:
   GlobalFileMgr* gfm_;  /// Global FileMgr
   std::pair<const int, const int> fileMgrKey_;
@@ -237,6 +250,11 @@ class FileMgr : public AbstractBufferMgr {  // implements
   mutable mapd_shared_mutex mutex_free_page;
   std::vector<std::pair<FileInfo*, int>> free_pages;
 
+  std::mutex pageDirectoryMutex_;
+  std::atomic<bool> pageDirectoryValid_;  /// the page directory on disk matches the last checkpoint
+  std::atomic<bool> pageDirectoryDirty_;  /// pages were allocated or freed since the page directory was written
+  bool openedFromPageDirectory_;
+
   /**
    * @brief Adds a file to the file manager repository.
    *
@@ -267,6 +285,12 @@ class FileMgr : public AbstractBufferMgr {  // implements
   void setEpoch(int epoch);  // resets current value of epoch at startup
   void processFileFutures(std::vector<std::future<std::vector<HeaderInfo>>>& file_futures,
                           std::vector<HeaderInfo>& headerVec);
+  void scanPageHeaders(const boost::filesystem::path& path);  // rebuilds the chunk index from all page headers
+
+  // see PageDirectory.cpp
+  std::string getPageDirectoryPath() const;
+  bool openPageDirectory(const int checkpointEpoch);
+  void writePageDirectory();
 };
 
 }  // File_Namespace
@@ -0,0 +1,513 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file        PageDirectory.cpp
+ * @brief       Page directory snapshot of a FileMgr.
+ *
+ * Every checkpoint writes the chunk index (page versions and metadata of each chunk) and the free pages
+ * of each file to a checksummed snapshot, which replaces the scan of every page header at startup.
+ * Pages allocated after the checkpoint come from the pages which were free at the time or from new
+ * files, so only those headers are read back on startup. Freeing a page rewrites a checkpointed header
+ * though, hence the first free after a checkpoint invalidates the snapshot until the next checkpoint.
+ */
+
+#include "FileMgr.h"
+#include "File.h"
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+
+#define PAGE_DIRECTORY_FILENAME "page_directory"
+#define PAGE_DIRECTORY_VERSION 4  // 3: the spatial extent follows the sketch
+                                  // 4: the stats exact flag follows the spatial extent
+
+namespace File_Namespace {
+
+namespace {
+
+const char kPageDirectoryMagic[8] = {'M', 'A', 'P', 'D', 'P', 'D', 'I', 'R'};
+
+struct PageDirectoryHeader {
+  char magic[8];
+  int32_t version;
+  int32_t epoch;  // epoch of the checkpoint the snapshot describes
+  uint64_t bodySize;
+  uint32_t bodyCrc;
+  uint32_t headerCrc;  // of the fields above
+};
+static_assert(sizeof(PageDirectoryHeader) == 32, "Unexpected padding in PageDirectoryHeader");
+
+struct SnapshotFile {
+  int fileId;
+  size_t pageSize;
+  size_t numPages;
+  std::set<size_t> freePages;
+};
+
+template <typename T>
+void write_value(FILE* f, const T& value) {
+  fwrite(&value, sizeof(T), 1, f);
+}
+
+template <typename T>
+bool read_value(FILE* f, T& value) {
+  return fread(&value, sizeof(T), 1, f) == 1;
+}
+
+uint32_t header_crc(const PageDirectoryHeader& header) {
+  boost::crc_32_type crc;
+  crc.process_bytes(&header, offsetof(PageDirectoryHeader, headerCrc));
+  return crc.checksum();
+}
+
+bool sync_file(FILE* f) {
+  if (fflush(f) != 0) {
+    return false;
+  }
+#ifdef __APPLE__
+  return fcntl(fileno(f), 51) == 0;
+#else
+  return fsync(fileno(f)) == 0;
+#endif
+}
+
+bool read_header(FILE* f, PageDirectoryHeader& header) {
+  return read_value(f, header) && !memcmp(header.magic, kPageDirectoryMagic, sizeof(kPageDirectoryMagic)) &&
+         header.version == PAGE_DIRECTORY_VERSION && header.headerCrc == header_crc(header);
+}
+
+bool write_header(FILE* f, PageDirectoryHeader& header) {
+  header.headerCrc = header_crc(header);
+  fseek(f, 0, SEEK_SET);
+  write_value(f, header);
+  return !ferror(f) && sync_file(f);
+}
+
+// Checksum of everything following the header, reads up to the end of the file.
+uint32_t body_crc(FILE* f) {
+  boost::crc_32_type crc;
+  std::vector<char> buffer(1 << 20);
+  fseek(f, sizeof(PageDirectoryHeader), SEEK_SET);
+  size_t bytesRead;
+  while ((bytesRead = fread(&buffer[0], 1, buffer.size(), f)) > 0) {
+    crc.process_bytes(&buffer[0], bytesRead);
+  }
+  return crc.checksum();
+}
+
+void write_multi_page(FILE* f, const MultiPage& multiPage) {
+  write_value<uint64_t>(f, multiPage.pageVersions.size());
+  for (size_t i = 0; i < multiPage.pageVersions.size(); ++i) {
+    write_value<int32_t>(f, multiPage.epochs[i]);
+    write_value<int32_t>(f, multiPage.pageVersions[i].fileId);
+    write_value<uint64_t>(f, multiPage.pageVersions[i].pageNum);
+  }
+}
+
+bool read_multi_page(FILE* f, MultiPage& multiPage, const std::map<int, SnapshotFile>& files) {
+  uint64_t numVersions;
+  if (!read_value(f, numVersions)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < numVersions; ++i) {
+    int32_t epoch;
+    int32_t fileId;
+    uint64_t pageNum;
+    if (!read_value(f, epoch) || !read_value(f, fileId) || !read_value(f, pageNum)) {
+      return false;
+    }
+    const auto fileIt = files.find(fileId);
+    if (fileIt == files.end() || pageNum >= fileIt->second.numPages) {
+      return false;
+    }
+    Page page(fileId, pageNum);
+    multiPage.push(page, epoch);
+  }
+  return true;
+}
+
+// Data files are named <file id>.<page size>.mapd, see create() in File.cpp.
+bool parse_data_file_name(const boost::filesystem::path& filePath, int& fileId, size_t& pageSize) {
+  if (filePath.extension().string() != MAPD_FILE_EXT) {
+    return false;
+  }
+  auto fileStem = filePath.stem().string();
+  if (!fileStem.empty() && fileStem.back() == '.') {
+    fileStem.pop_back();
+  }
+  const auto dotPos = fileStem.find_last_of(".");
+  if (dotPos == std::string::npos) {
+    return false;
+  }
+  try {
+    fileId = boost::lexical_cast<int>(fileStem.substr(0, dotPos));
+    pageSize = boost::lexical_cast<size_t>(fileStem.substr(dotPos + 1));
+  } catch (const boost::bad_lexical_cast&) {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+std::string FileMgr::getPageDirectoryPath() const {
+  return fileMgrBasePath_ + PAGE_DIRECTORY_FILENAME;
+}
+
+void FileMgr::writePageDirectory() {
+  // lock order: chunkIndexMutex_ >> pageDirectoryMutex_ >> getPageMutex_ >> files_rw_mutex_
+  mapd_shared_lock<mapd_shared_mutex> chunkIndexReadLock(chunkIndexMutex_);
+  std::lock_guard<std::mutex> pageDirectoryLock(pageDirectoryMutex_);
+  std::lock_guard<std::mutex> getPageLock(getPageMutex_);
+  const int checkpointEpoch = epoch_ - 1;
+  const auto directoryPath = getPageDirectoryPath();
+  if (pageDirectoryValid_ && !pageDirectoryDirty_) {
+    // no page was allocated or freed since the snapshot, it only has to follow the epoch
+    FILE* f = fopen(directoryPath.c_str(), "r+b");
+    if (f) {
+      PageDirectoryHeader header;
+      const bool updated = read_header(f, header) && (header.epoch = checkpointEpoch, write_header(f, header));
+      fclose(f);
+      if (updated) {
+        return;
+      }
+    }
+  }
+  pageDirectoryValid_ = false;
+
+  const auto tmpPath = directoryPath + ".tmp";
+  FILE* f = fopen(tmpPath.c_str(), "w+b");
+  if (!f) {
+    LOG(WARNING) << "Could not create page directory '" << tmpPath << "', the errno is " << errno;
+    return;
+  }
+  PageDirectoryHeader header;
+  memset(&header, 0, sizeof(header));
+  write_value(f, header);
+
+  {
+    mapd_shared_lock<mapd_shared_mutex> filesReadLock(files_rw_mutex_);
+    write_value<int32_t>(f, nextFileId_);
+    const auto numFiles = std::count_if(files_.begin(), files_.end(), [](const FileInfo* fileInfo) { return fileInfo; });
+    write_value<uint64_t>(f, numFiles);
+    for (auto fileInfo : files_) {
+      if (!fileInfo) {
+        continue;
+      }
+      write_value<int32_t>(f, fileInfo->fileId);
+      write_value<uint64_t>(f, fileInfo->pageSize);
+      write_value<uint64_t>(f, fileInfo->numPages);
+      std::lock_guard<std::mutex> freePagesLock(fileInfo->freePagesMutex_);
+      write_value<uint64_t>(f, fileInfo->freePages.size());
+      for (const auto pageNum : fileInfo->freePages) {
+        write_value<uint64_t>(f, pageNum);
+      }
+    }
+  }
+
+  // chunks which never wrote a metadata page were not checkpointed and don't exist on disk
+  const auto numChunks = std::count_if(chunkIndex_.begin(), chunkIndex_.end(), [](const ChunkKeyToChunkMap::value_type& chunk) {
+    return !chunk.second->metadataPages_.pageVersions.empty();
+  });
+  write_value<uint64_t>(f, numChunks);
+  for (const auto& chunk : chunkIndex_) {
+    const auto buffer = chunk.second;
+    if (buffer->metadataPages_.pageVersions.empty()) {
+      continue;
+    }
+    write_value<uint64_t>(f, chunk.first.size());
+    fwrite(&chunk.first[0], sizeof(int), chunk.first.size(), f);
+    write_value<uint64_t>(f, buffer->pageSize_);
+    write_value<uint64_t>(f, buffer->size());
+    write_value<int32_t>(f, buffer->hasEncoder);
+    if (buffer->hasEncoder) {
+      // same type fields as the chunk metadata page, see FileBuffer::writeMetadata
+      const auto& ti = buffer->sqlType;
+      write_value<int32_t>(f, ti.get_type());
+      write_value<int32_t>(f, ti.get_subtype());
+      write_value<int32_t>(f, ti.get_dimension());
+      write_value<int32_t>(f, ti.get_scale());
+      write_value<int32_t>(f, ti.get_notnull());
+      write_value<int32_t>(f, ti.get_compression());
+      write_value<int32_t>(f, ti.get_comp_param());
+      write_value<int32_t>(f, ti.get_size());
+      buffer->encoder->writeMetadata(f);
+      buffer->encoder->writeSketch(f);
+      buffer->encoder->writeSpatialExtent(f);
+      buffer->encoder->writeStatsExact(f);
+    }
+    write_multi_page(f, buffer->metadataPages_);
+    write_value<uint64_t>(f, buffer->multiPages_.size());
+    for (const auto& multiPage : buffer->multiPages_) {
+      write_multi_page(f, multiPage);
+    }
+  }
+
+  bool written = fflush(f) == 0 && !ferror(f);
+  if (written) {
+    fseek(f, 0, SEEK_END);
+    memcpy(header.magic, kPageDirectoryMagic, sizeof(kPageDirectoryMagic));
+    header.version = PAGE_DIRECTORY_VERSION;
+    header.epoch = checkpointEpoch;
+    header.bodySize = ftell(f) - sizeof(PageDirectoryHeader);
+    header.bodyCrc = body_crc(f);
+    written = write_header(f, header);
+  }
+  fclose(f);
+  if (!written || rename(tmpPath.c_str(), directoryPath.c_str()) != 0) {
+    LOG(WARNING) << "Could not write page directory '" << directoryPath << "', the next startup reads all page headers";
+    boost::system::error_code ec;
+    boost::filesystem::remove(tmpPath, ec);
+    return;
+  }
+  pageDirectoryValid_ = true;
+  pageDirectoryDirty_ = false;
+}
+
+void FileMgr::invalidatePageDirectory(const bool force) {
+  if (!pageDirectoryValid_ && !force) {
+    return;
+  }
+  std::lock_guard<std::mutex> pageDirectoryLock(pageDirectoryMutex_);
+  if (!pageDirectoryValid_ && !force) {
+    return;
+  }
+  pageDirectoryValid_ = false;
+  const auto directoryPath = getPageDirectoryPath();
+  if (!boost::filesystem::exists(directoryPath)) {
+    return;
+  }
+  // Must be durable before the page header it protects gets rewritten.
+  FILE* f = fopen(directoryPath.c_str(), "r+b");
+  if (!f) {
+    LOG(FATAL) << "Could not invalidate page directory '" << directoryPath << "', the errno is " << errno;
+  }
+  const char zeros[sizeof(kPageDirectoryMagic)] = {};
+  fwrite(zeros, sizeof(zeros), 1, f);
+  if (ferror(f) || !sync_file(f)) {
+    LOG(FATAL) << "Could not invalidate page directory '" << directoryPath << "'";
+  }
+  fclose(f);
+}
+
+bool FileMgr::openPageDirectory(const int checkpointEpoch) {
+  const auto directoryPath = getPageDirectoryPath();
+  if (!boost::filesystem::exists(directoryPath)) {
+    return false;
+  }
+  std::unique_ptr<FILE, decltype(&fclose)> f(fopen(directoryPath.c_str(), "rb"), &fclose);
+  auto unusable = [this](const std::string& reason) {
+    LOG(INFO) << "Page directory of table location '" << fileMgrBasePath_ << "' not used: " << reason;
+    return false;
+  };
+  if (!f) {
+    return unusable("cannot be opened");
+  }
+  PageDirectoryHeader header;
+  if (!read_header(f.get(), header)) {
+    return unusable("invalid header");
+  }
+  if (header.epoch != checkpointEpoch) {
+    return unusable("written at epoch " + std::to_string(header.epoch) + ", last checkpoint at epoch " +
+                    std::to_string(checkpointEpoch));
+  }
+  if (fileSize(f.get()) != sizeof(PageDirectoryHeader) + header.bodySize || body_crc(f.get()) != header.bodyCrc) {
+    return unusable("checksum mismatch");
+  }
+  fseek(f.get(), sizeof(PageDirectoryHeader), SEEK_SET);
+
+  int32_t nextFileId;
+  uint64_t numFiles;
+  if (!read_value(f.get(), nextFileId) || !read_value(f.get(), numFiles)) {
+    return unusable("truncated");
+  }
+  std::map<int, SnapshotFile> snapshotFiles;
+  for (uint64_t i = 0; i < numFiles; ++i) {
+    SnapshotFile snapshotFile;
+    int32_t fileId;
+    uint64_t pageSize;
+    uint64_t numPages;
+    uint64_t numFreePages;
+    if (!read_value(f.get(), fileId) || !read_value(f.get(), pageSize) || !read_value(f.get(), numPages) ||
+        !read_value(f.get(), numFreePages)) {
+      return unusable("truncated");
+    }
+    snapshotFile.fileId = fileId;
+    snapshotFile.pageSize = pageSize;
+    snapshotFile.numPages = numPages;
+    for (uint64_t j = 0; j < numFreePages; ++j) {
+      uint64_t pageNum;
+      if (!read_value(f.get(), pageNum)) {
+        return unusable("truncated");
+      }
+      snapshotFile.freePages.insert(pageNum);
+    }
+    snapshotFiles.emplace(fileId, std::move(snapshotFile));
+  }
+
+  uint64_t numChunks;
+  if (!read_value(f.get(), numChunks)) {
+    return unusable("truncated");
+  }
+  std::map<ChunkKey, std::unique_ptr<FileBuffer>> chunks;
+  for (uint64_t i = 0; i < numChunks; ++i) {
+    uint64_t keySize;
+    if (!read_value(f.get(), keySize)) {
+      return unusable("truncated");
+    }
+    ChunkKey chunkKey(keySize);
+    uint64_t pageSize;
+    uint64_t size;
+    int32_t hasEncoder;
+    if (fread(&chunkKey[0], sizeof(int), keySize, f.get()) != keySize || !read_value(f.get(), pageSize) ||
+        !read_value(f.get(), size) || !read_value(f.get(), hasEncoder)) {
+      return unusable("truncated");
+    }
+    std::unique_ptr<FileBuffer> buffer(new FileBuffer(this, pageSize, chunkKey));
+    buffer->setSize(size);
+    if (hasEncoder) {
+      std::vector<int32_t> typeData(8);
+      if (fread(&typeData[0], sizeof(int32_t), typeData.size(), f.get()) != typeData.size()) {
+        return unusable("truncated");
+      }
+      SQLTypeInfo ti;
+      ti.set_type(static_cast<SQLTypes>(typeData[0]));
+      ti.set_subtype(static_cast<SQLTypes>(typeData[1]));
+      ti.set_dimension(typeData[2]);
+      ti.set_scale(typeData[3]);
+      ti.set_notnull(static_cast<bool>(typeData[4]));
+      ti.set_compression(static_cast<EncodingType>(typeData[5]));
+      ti.set_comp_param(typeData[6]);
+      ti.set_size(typeData[7]);
+      buffer->initEncoder(ti);
+      buffer->encoder->readMetadata(f.get());
+      if (!buffer->encoder->readSketch(f.get()) || !buffer->encoder->readSpatialExtent(f.get()) ||
+          !buffer->encoder->readStatsExact(f.get())) {
+        return unusable("truncated");
+      }
+    }
+    if (!read_multi_page(f.get(), buffer->metadataPages_, snapshotFiles)) {
+      return unusable("invalid metadata pages of chunk " + showChunk(chunkKey));
+    }
+    uint64_t numMultiPages;
+    if (!read_value(f.get(), numMultiPages)) {
+      return unusable("truncated");
+    }
+    for (uint64_t j = 0; j < numMultiPages; ++j) {
+      buffer->multiPages_.emplace_back(pageSize);
+      if (!read_multi_page(f.get(), buffer->multiPages_.back(), snapshotFiles)) {
+        return unusable("invalid pages of chunk " + showChunk(chunkKey));
+      }
+    }
+    chunks.emplace(chunkKey, std::move(buffer));
+  }
+  if (ftell(f.get()) != static_cast<long>(sizeof(PageDirectoryHeader) + header.bodySize)) {
+    return unusable("trailing data");
+  }
+  f.reset();
+
+  // Data files created after the checkpoint can only hold pages which were never checkpointed.
+  std::map<int, std::pair<std::string, size_t>> newFiles;
+  size_t snapshotFilesFound = 0;
+  boost::filesystem::directory_iterator endItr;
+  for (boost::filesystem::directory_iterator fileIt(fileMgrBasePath_); fileIt != endItr; ++fileIt) {
+    int fileId;
+    size_t pageSize;
+    if (!boost::filesystem::is_regular_file(fileIt->status()) ||
+        !parse_data_file_name(fileIt->path(), fileId, pageSize)) {
+      continue;
+    }
+    const auto fileSize = boost::filesystem::file_size(fileIt->path());
+    const auto snapshotFileIt = snapshotFiles.find(fileId);
+    if (snapshotFileIt == snapshotFiles.end()) {
+      if (fileId < nextFileId || fileSize % pageSize) {
+        return unusable("unexpected data file " + fileIt->path().string());
+      }
+      newFiles.emplace(fileId, std::make_pair(fileIt->path().string(), pageSize));
+      continue;
+    }
+    const auto& snapshotFile = snapshotFileIt->second;
+    if (snapshotFile.pageSize != pageSize || snapshotFile.numPages * pageSize != fileSize) {
+      return unusable("data file " + fileIt->path().string() + " changed");
+    }
+    ++snapshotFilesFound;
+  }
+  if (snapshotFilesFound != snapshotFiles.size()) {
+    return unusable("missing data files");
+  }
+
+  for (const auto& newFile : newFiles) {
+    const auto& filePath = newFile.second.first;
+    const auto pageSize = newFile.second.second;
+    std::vector<HeaderInfo> headerVec;
+    openExistingFile(
+        filePath, newFile.first, pageSize, boost::filesystem::file_size(filePath) / pageSize, headerVec);
+    if (!headerVec.empty()) {
+      for (auto& fileInfo : files_) {
+        delete fileInfo;
+      }
+      files_.clear();
+      fileIndex_.clear();
+      return unusable("data file " + filePath + " has checkpointed pages");
+    }
+    nextFileId = std::max(nextFileId, newFile.first + 1);
+  }
+
+  size_t pagesCleared = 0;
+  for (const auto& snapshotFileIt : snapshotFiles) {
+    const auto& snapshotFile = snapshotFileIt.second;
+    const std::string filePath(fileMgrBasePath_ + std::to_string(snapshotFile.fileId) + "." +
+                               std::to_string(snapshotFile.pageSize) + std::string(MAPD_FILE_EXT));
+    FileInfo* fileInfo =
+        new FileInfo(this, snapshotFile.fileId, open(filePath), snapshotFile.pageSize, snapshotFile.numPages, false);
+    // Pages written after the checkpoint, or freed before it, must read as free for the next full scan.
+    for (const auto pageNum : snapshotFile.freePages) {
+      int headerSize;
+      fileInfo->read(pageNum * fileInfo->pageSize, sizeof(int), reinterpret_cast<int8_t*>(&headerSize));
+      if (headerSize != 0) {
+        headerSize = 0;
+        fileInfo->write(pageNum * fileInfo->pageSize, sizeof(int), reinterpret_cast<int8_t*>(&headerSize));
+        ++pagesCleared;
+      }
+    }
+    fileInfo->freePages = snapshotFile.freePages;
+    if (snapshotFile.fileId >= static_cast<int>(files_.size())) {
+      files_.resize(snapshotFile.fileId + 1);
+    }
+    files_[snapshotFile.fileId] = fileInfo;
+    fileIndex_.insert(std::make_pair(snapshotFile.pageSize, snapshotFile.fileId));
+  }
+  VLOG(1) << "Cleared the headers of " << pagesCleared << " free pages, table location: '" << fileMgrBasePath_ << "'";
+
+  for (auto& chunk : chunks) {
+    chunkIndex_[chunk.first] = chunk.second.release();
+  }
+  nextFileId_ = nextFileId;
+  pageDirectoryValid_ = true;
+  pageDirectoryDirty_ = false;
+  return true;
+}
+
+}  // File_Namespace
@@ -30,7 +30,9 @@ class FixedLengthEncoder : public Encoder {
       : Encoder(buffer),
         dataMin(std::numeric_limits<T>::max()),
         dataMax(std::numeric_limits<T>::min()),
-        has_nulls(false) {}
+        has_nulls(false) {
+    initSketch();
+  }
 
   ChunkMetadata appendData(int8_t*& srcData, const size_t numAppendElems) {
     T* unencodedData = reinterpret_cast<T*>(srcData);
@@ -47,6 +49,7 @@ class FixedLengthEncoder : public Encoder {
         else {
           dataMin = std::min(dataMin, data);
           dataMax = std::max(dataMax, data);
+          addToSketch(static_cast<int64_t>(data));
         }
       }
     }
@@ -74,6 +77,8 @@ class FixedLengthEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const int64_t val, const bool is_null) {
+    dropSketch();
+    stats_exact_ = false;
     if (is_null) {
       has_nulls = true;
     } else {
@@ -85,6 +90,8 @@ class FixedLengthEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const double val, const bool is_null) {
+    dropSketch();
+    stats_exact_ = false;
     if (is_null) {
       has_nulls = true;
     } else {
@@ -102,6 +109,28 @@ class FixedLengthEncoder : public Encoder {
     }
     dataMin = std::min(dataMin, that_typed.dataMin);
     dataMax = std::max(dataMax, that_typed.dataMax);
+    mergeSketch(that);
+    stats_exact_ = stats_exact_ && that_typed.stats_exact_;
+  }
+
+  // Only called from the storage layer after rows were compacted out of a chunk.
+  void resetStats(const int8_t* encoded_data, const size_t num_elements) {
+    stats_exact_ = true;
+    dataMin = std::numeric_limits<T>::max();
+    dataMax = std::numeric_limits<T>::min();
+    has_nulls = false;
+    initSketch();
+    const V* data = reinterpret_cast<const V*>(encoded_data);
+    for (size_t i = 0; i < num_elements; ++i) {
+      if (data[i] == std::numeric_limits<V>::min())
+        has_nulls = true;
+      else {
+        dataMin = std::min(dataMin, static_cast<T>(data[i]));
+        dataMax = std::max(dataMax, static_cast<T>(data[i]));
+        addToSketch(static_cast<int64_t>(static_cast<T>(data[i])));
+      }
+    }
+    numElems = num_elements;
   }
 
   void copyMetadata(const Encoder* copyFromEncoder) {
@@ -110,6 +139,8 @@ class FixedLengthEncoder : public Encoder {
     dataMin = castedEncoder->dataMin;
     dataMax = castedEncoder->dataMax;
     has_nulls = castedEncoder->has_nulls;
+    sketch_ = castedEncoder->sketch_;
+    stats_exact_ = castedEncoder->stats_exact_;
   }
 
   void writeMetadata(FILE* f) {
@@ -32,7 +32,11 @@ class NoneEncoder : public Encoder {
       : Encoder(buffer),
         dataMin(std::numeric_limits<T>::max()),
         dataMax(std::numeric_limits<T>::lowest()),
-        has_nulls(false) {}
+        has_nulls(false) {
+    if (std::is_integral<T>::value) {
+      initSketch();
+    }
+  }
 
   ChunkMetadata appendData(int8_t*& srcData, const size_t numAppendElems) {
     T* unencodedData = reinterpret_cast<T*>(srcData);
@@ -43,6 +47,7 @@ class NoneEncoder : public Encoder {
       else {
         dataMin = std::min(dataMin, data);
         dataMax = std::max(dataMax, data);
+        addToSketch(static_cast<int64_t>(data));
       }
     }
     numElems += numAppendElems;
@@ -67,6 +72,8 @@ class NoneEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const int64_t val, const bool is_null) {
+    dropSketch();
+    stats_exact_ = false;
     if (is_null) {
       has_nulls = true;
     } else {
@@ -78,6 +85,8 @@ class NoneEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const double val, const bool is_null) {
+    dropSketch();
+    stats_exact_ = false;
     if (is_null) {
       has_nulls = true;
     } else {
@@ -95,6 +104,30 @@ class NoneEncoder : public Encoder {
     }
     dataMin = std::min(dataMin, that_typed.dataMin);
     dataMax = std::max(dataMax, that_typed.dataMax);
+    mergeSketch(that);
+    stats_exact_ = stats_exact_ && that_typed.stats_exact_;
+  }
+
+  // Only called from the storage layer after rows were compacted out of a chunk.
+  void resetStats(const int8_t* encoded_data, const size_t num_elements) {
+    stats_exact_ = true;
+    dataMin = std::numeric_limits<T>::max();
+    dataMax = std::numeric_limits<T>::lowest();
+    has_nulls = false;
+    if (std::is_integral<T>::value) {
+      initSketch();
+    }
+    const T* data = reinterpret_cast<const T*>(encoded_data);
+    for (size_t i = 0; i < num_elements; ++i) {
+      if (data[i] == none_encoded_null_value<T>())
+        has_nulls = true;
+      else {
+        dataMin = std::min(dataMin, data[i]);
+        dataMax = std::max(dataMax, data[i]);
+        addToSketch(static_cast<int64_t>(data[i]));
+      }
+    }
+    numElems = num_elements;
   }
 
   void writeMetadata(FILE* f) {
@@ -119,6 +152,8 @@ class NoneEncoder : public Encoder {
     dataMin = castedEncoder->dataMin;
     dataMax = castedEncoder->dataMax;
     has_nulls = castedEncoder->has_nulls;
+    sketch_ = castedEncoder->sketch_;
+    stats_exact_ = castedEncoder->stats_exact_;
   }
 
   T dataMin;
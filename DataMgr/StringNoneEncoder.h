@@ -74,6 +74,8 @@ class StringNoneEncoder : public Encoder {
   void copyMetadata(const Encoder* copyFromEncoder) {
     numElems = copyFromEncoder->numElems;
     has_nulls = static_cast<const StringNoneEncoder*>(copyFromEncoder)->has_nulls;
+    // the index buffer may have been rewritten (e.g. compacted), re-read the last offset on next append
+    last_offset = -1;
   }
 
   AbstractBuffer* get_index_buf() const { return index_buf; }
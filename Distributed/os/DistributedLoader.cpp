@@ -0,0 +1,157 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DistributedLoader.h"
+
+#include "QueryEngine/MurmurHash1Inl.h"
+#include "Shared/MapDException.h"
+
+DistributedLoader::DistributedLoader(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                     const TableDescriptor* t,
+                                     LeafAggregator* aggregator)
+    : Loader(parent_session_info.get_catalog(), t),
+      parent_session_info_(parent_session_info),
+      aggregator_(aggregator) {
+  CHECK(aggregator_);
+  CHECK_GT(aggregator_->leafCount(), size_t(0));
+}
+
+bool DistributedLoader::loadImpl(const std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>& import_buffers,
+                                 size_t row_count,
+                                 bool checkpoint) {
+  if (!row_count) {
+    return true;
+  }
+  const auto leaf_count = aggregator_->leafCount();
+  try {
+    if (table_desc->nShards) {
+      // Every leaf holds nShards physical tables, global shard g lives in the physical table
+      // g / leaf_count of leaf g % leaf_count. This keeps a single shard key residue per physical
+      // table, which the leaves rely on for sharded joins and group by.
+      const auto shard_tables = catalog.getPhysicalTablesDescriptors(table_desc);
+      std::vector<OneShardBuffers> all_shard_import_buffers;
+      std::vector<size_t> all_shard_row_counts;
+      distributeToShards(
+          all_shard_import_buffers, all_shard_row_counts, import_buffers, row_count, shard_tables.size() * leaf_count);
+      for (size_t shard_idx = 0; shard_idx < all_shard_import_buffers.size(); ++shard_idx) {
+        if (!all_shard_row_counts[shard_idx]) {
+          continue;
+        }
+        const auto shard_table = shard_tables[shard_idx / leaf_count];
+        aggregator_->insertDataToLeaf(
+            parent_session_info_,
+            shard_idx % leaf_count,
+            toThriftInsertData(all_shard_import_buffers[shard_idx], all_shard_row_counts[shard_idx], shard_table->tableId));
+      }
+    } else if (table_is_replicated(table_desc)) {
+      const auto thrift_insert_data = toThriftInsertData(import_buffers, row_count, table_desc->tableId);
+      for (size_t leaf_idx = 0; leaf_idx < leaf_count; ++leaf_idx) {
+        aggregator_->insertDataToLeaf(parent_session_info_, leaf_idx, thrift_insert_data);
+      }
+    } else {
+      aggregator_->insertDataToLeaf(parent_session_info_,
+                                    aggregator_->nextLeafForInsert(),
+                                    toThriftInsertData(import_buffers, row_count, table_desc->tableId));
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Distributed Insert Exception: " << e.what();
+    return false;
+  }
+  if (checkpoint) {
+    this->checkpoint();
+  }
+  return true;
+}
+
+std::vector<int64_t> DistributedLoader::getShardKeys(Importer_NS::TypedImportBuffer& shard_column_buffer,
+                                                     const size_t row_count) {
+  if (!shard_column_buffer.getTypeInfo().is_string()) {
+    return Loader::getShardKeys(shard_column_buffer, row_count);
+  }
+  // Every node encodes strings with its own dictionary, so the ids aren't a stable shard key.
+  // Hashing the string puts equal keys of all tables in the same shard, whatever their dictionary.
+  const auto payloads_ptr = shard_column_buffer.getStringBuffer();
+  CHECK(payloads_ptr);
+  CHECK_EQ(row_count, payloads_ptr->size());
+  std::vector<int64_t> shard_keys(row_count);
+  for (size_t i = 0; i < row_count; ++i) {
+    const auto& str = (*payloads_ptr)[i];
+    shard_keys[i] = static_cast<int64_t>(MurmurHash64AImpl(str.data(), static_cast<int>(str.size()), 0) >> 1);
+  }
+  return shard_keys;
+}
+
+void DistributedLoader::checkpoint() {
+  if (table_desc->persistenceLevel == Data_Namespace::MemoryLevel::DISK_LEVEL) {
+    aggregator_->checkpointLeaf(parent_session_info_, insert_data.databaseId, table_desc->tableId);
+  }
+}
+
+int32_t DistributedLoader::getTableEpoch() {
+  return aggregator_->get_table_epochLeaf(parent_session_info_, insert_data.databaseId, table_desc->tableId);
+}
+
+void DistributedLoader::setTableEpoch(const int32_t new_epoch) {
+  aggregator_->set_table_epochLeaf(parent_session_info_, insert_data.databaseId, table_desc->tableId, new_epoch);
+}
+
+TInsertData DistributedLoader::toThriftInsertData(
+    const std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>& import_buffers,
+    const size_t row_count,
+    const int32_t table_id) const {
+  TInsertData thrift_insert_data;
+  thrift_insert_data.db_id = insert_data.databaseId;
+  thrift_insert_data.table_id = table_id;
+  thrift_insert_data.column_ids = insert_data.columnIds;
+  thrift_insert_data.num_rows = row_count;
+  for (const auto& import_buffer : import_buffers) {
+    const auto& ti = import_buffer->getTypeInfo();
+    TDataBlockPtr data_block;
+    if (ti.is_number() || ti.is_time() || ti.is_boolean()) {
+      const auto values_buffer = reinterpret_cast<const char*>(import_buffer->getAsBytes());
+      data_block.__set_fixed_len_data(std::string(values_buffer, row_count * import_buffer->getElementSize()));
+    } else if (ti.is_string()) {
+      // Dictionary encoded strings are sent as strings as well, the ids are only meaningful
+      // for the dictionary of the node which encodes them.
+      const auto string_buffer = import_buffer->getStringBuffer();
+      CHECK(string_buffer);
+      CHECK_EQ(row_count, string_buffer->size());
+      std::vector<TVarLen> var_len_data(row_count);
+      for (size_t i = 0; i < row_count; ++i) {
+        var_len_data[i].payload = (*string_buffer)[i];
+        var_len_data[i].is_null = var_len_data[i].payload.empty();
+      }
+      data_block.__set_var_len_data(var_len_data);
+    } else if (ti.is_array() && !IS_STRING(ti.get_subtype())) {
+      const auto array_buffer = import_buffer->getArrayBuffer();
+      CHECK(array_buffer);
+      CHECK_EQ(row_count, array_buffer->size());
+      std::vector<TVarLen> var_len_data(row_count);
+      for (size_t i = 0; i < row_count; ++i) {
+        const auto& array_datum = (*array_buffer)[i];
+        var_len_data[i].is_null = array_datum.is_null;
+        if (!array_datum.is_null) {
+          var_len_data[i].payload = std::string(reinterpret_cast<const char*>(array_datum.pointer), array_datum.length);
+        }
+      }
+      data_block.__set_var_len_data(var_len_data);
+    } else {
+      THROW_MAPD_EXCEPTION("Distributed load of " + ti.get_type_name() + " columns not supported");
+    }
+    thrift_insert_data.data.push_back(data_block);
+  }
+  return thrift_insert_data;
+}
@@ -20,20 +20,36 @@
 #include "Import/Importer.h"
 #include "LeafAggregator.h"
 
+// Routes the rows loaded on the aggregator to the leaves. Rows of sharded tables go to the leaf
+// owning their shard, replicated tables are loaded on every leaf and all other tables are spread
+// across the leaves batch by batch.
 class DistributedLoader : public Importer_NS::Loader {
  public:
   DistributedLoader(const Catalog_Namespace::SessionInfo& parent_session_info,
                     const TableDescriptor* t,
-                    LeafAggregator* aggregator)
-      : Loader(parent_session_info.get_catalog(), t) {
-    CHECK(false);
-  }
-
-  bool load(const std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>& import_buffers,
-            size_t row_count) override {
-    CHECK(false);
-    return false;
-  }
+                    LeafAggregator* aggregator);
+
+  bool loadImpl(const std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>& import_buffers,
+                size_t row_count,
+                bool checkpoint) override;
+
+  void checkpoint() override;
+
+  int32_t getTableEpoch() override;
+
+  void setTableEpoch(const int32_t new_epoch) override;
+
+ protected:
+  std::vector<int64_t> getShardKeys(Importer_NS::TypedImportBuffer& shard_column_buffer,
+                                    const size_t row_count) override;
+
+ private:
+  TInsertData toThriftInsertData(const std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>& import_buffers,
+                                 const size_t row_count,
+                                 const int32_t table_id) const;
+
+  const Catalog_Namespace::SessionInfo parent_session_info_;
+  LeafAggregator* aggregator_;
 };
 
 #endif  // DISTRIBUTEDLOADER_H
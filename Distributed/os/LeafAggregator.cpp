@@ -0,0 +1,964 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LeafAggregator.h"
+
+#include "Catalog/Catalog.h"
+#include "QueryEngine/CalciteDeserializerUtils.h"
+#include "QueryEngine/JsonAccessors.h"
+#include "Shared/MapDException.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include <thrift/transport/TSocket.h>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <numeric>
+
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::transport;
+
+namespace {
+
+struct SortKey {
+  size_t field;
+  bool is_desc;
+  bool nulls_first;
+};
+
+// Describes how the partial results of the leaves are combined into the final result.
+struct MergePlan {
+  TMergeType::type merge_type{TMergeType::UNION};
+  size_t group_count{0};
+  std::vector<SQLAgg> agg_kinds;
+  std::vector<SortKey> collation;
+  int64_t limit{-1};
+  int64_t offset{0};
+  // Leaf result column for each result column and the names of the result columns,
+  // empty if the leaves return the final layout already.
+  std::vector<size_t> projection;
+  std::vector<std::string> names;
+  std::string leaf_query_ra;
+};
+
+bool has_member(const rapidjson::Value& value, const char* name) {
+  if (value.IsObject()) {
+    for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+      if (!strcmp(it->name.GetString(), name) || has_member(it->value, name)) {
+        return true;
+      }
+    }
+  } else if (value.IsArray()) {
+    for (auto it = value.Begin(); it != value.End(); ++it) {
+      if (has_member(*it, name)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool input_is_previous(const rapidjson::Value& node, const size_t node_idx) {
+  const auto inputs_it = node.FindMember("inputs");
+  if (inputs_it == node.MemberEnd()) {
+    return true;
+  }
+  const auto& inputs = inputs_it->value;
+  return inputs.IsArray() && inputs.Size() == 1 && inputs[0].IsString() &&
+         inputs[0].GetString() == std::to_string(node_idx - 1);
+}
+
+// Returns the input indices of a projection which only reorders or drops columns, empty otherwise.
+std::vector<size_t> input_ref_projection(const rapidjson::Value& node) {
+  std::vector<size_t> inputs;
+  if (json_str(field(node, "relOp")) != std::string("LogicalProject")) {
+    return {};
+  }
+  const auto& exprs = field(node, "exprs");
+  CHECK(exprs.IsArray());
+  for (auto it = exprs.Begin(); it != exprs.End(); ++it) {
+    if (!it->IsObject() || it->MemberCount() != 1 || !it->HasMember("input")) {
+      return {};
+    }
+    inputs.push_back(json_i64(field(*it, "input")));
+  }
+  return inputs;
+}
+
+int64_t get_literal_field(const rapidjson::Value& node, const char* name, const int64_t default_val) {
+  const auto it = node.FindMember(name);
+  if (it == node.MemberEnd()) {
+    return default_val;
+  }
+  return json_i64(field(it->value, "literal"));
+}
+
+std::vector<SortKey> get_collation(const rapidjson::Value& sort_node, const std::vector<size_t>& field_map) {
+  std::vector<SortKey> collation;
+  const auto& collation_arr = field(sort_node, "collation");
+  CHECK(collation_arr.IsArray());
+  for (auto it = collation_arr.Begin(); it != collation_arr.End(); ++it) {
+    const size_t field_idx = json_i64(field(*it, "field"));
+    CHECK_LT(field_idx, field_map.size());
+    collation.push_back({field_map[field_idx],
+                         json_str(field(*it, "direction")) == std::string("DESCENDING"),
+                         json_str(field(*it, "nulls")) == std::string("FIRST")});
+  }
+  return collation;
+}
+
+void check_supported_aggregates(const rapidjson::Value& agg_node, MergePlan& plan) {
+  const auto& aggs = field(agg_node, "aggs");
+  CHECK(aggs.IsArray());
+  for (auto it = aggs.Begin(); it != aggs.End(); ++it) {
+    const auto agg_name = json_str(field(*it, "agg"));
+    const auto agg_kind = to_agg_kind(agg_name);
+    if (json_bool(field(*it, "distinct"))) {
+      THROW_MAPD_EXCEPTION("Distinct aggregates not supported in distributed mode");
+    }
+    switch (agg_kind) {
+      case kCOUNT:
+      case kSUM:
+      case kMIN:
+      case kMAX:
+      case kLAST_SAMPLE:
+        break;
+      default: {
+        THROW_MAPD_EXCEPTION("Aggregate function " + agg_name + " not supported in distributed mode");
+      }
+    }
+    plan.agg_kinds.push_back(agg_kind);
+  }
+}
+
+// Splits the query in the part executed by the leaves and the steps the aggregator applies to the
+// merged result. The leaves run everything up to the final aggregate, the trailing sort and the
+// projections which only reorder columns are evaluated on the aggregator.
+MergePlan build_merge_plan(const std::string& query_ra) {
+  rapidjson::Document query_ast;
+  query_ast.Parse(query_ra.c_str());
+  CHECK(!query_ast.HasParseError());
+  auto& rels = query_ast["rels"];
+  CHECK(rels.IsArray() && rels.Size());
+  if (has_member(rels, "subquery")) {
+    THROW_MAPD_EXCEPTION("Subqueries not supported in distributed mode");
+  }
+  size_t tail_start = rels.Size();
+  while (tail_start > 1) {
+    const auto& node = rels[tail_start - 1];
+    const bool is_sort = json_str(field(node, "relOp")) == std::string("LogicalSort");
+    if ((!is_sort && input_ref_projection(node).empty()) || !input_is_previous(node, tail_start - 1)) {
+      break;
+    }
+    --tail_start;
+  }
+  size_t agg_count{0};
+  size_t sort_idx{rels.Size()};
+  for (size_t i = 0; i < rels.Size(); ++i) {
+    const auto rel_op = json_str(field(rels[i], "relOp"));
+    if (rel_op == std::string("LogicalAggregate")) {
+      ++agg_count;
+    } else if (rel_op == std::string("LogicalSort")) {
+      if (i < tail_start || sort_idx != rels.Size()) {
+        THROW_MAPD_EXCEPTION("ORDER BY and LIMIT only supported at the end of a distributed query");
+      }
+      sort_idx = i;
+    }
+  }
+  if (agg_count > 1) {
+    THROW_MAPD_EXCEPTION("Nested aggregates not supported in distributed mode");
+  }
+  const auto& base = rels[tail_start - 1];
+  const bool ends_with_agg = json_str(field(base, "relOp")) == std::string("LogicalAggregate");
+  if (agg_count && !ends_with_agg) {
+    THROW_MAPD_EXCEPTION("Only aggregates which are the last step of a query supported in distributed mode");
+  }
+  MergePlan plan;
+  if (ends_with_agg) {
+    plan.merge_type = TMergeType::REDUCE;
+    plan.group_count = field(base, "group").Size();
+    check_supported_aggregates(base, plan);
+    const auto& fields = field(base, "fields");
+    CHECK(fields.IsArray());
+    for (auto it = fields.Begin(); it != fields.End(); ++it) {
+      plan.names.emplace_back(json_str(*it));
+    }
+    plan.projection.resize(plan.names.size());
+    std::iota(plan.projection.begin(), plan.projection.end(), 0);
+    // Partial groups can't be sorted nor limited, the whole tail moves to the aggregator.
+    for (size_t i = tail_start; i < rels.Size(); ++i) {
+      const auto& node = rels[i];
+      if (i == sort_idx) {
+        plan.collation = get_collation(node, plan.projection);
+        plan.limit = get_literal_field(node, "fetch", -1);
+        plan.offset = get_literal_field(node, "offset", 0);
+        continue;
+      }
+      std::vector<size_t> projection;
+      for (const auto input_idx : input_ref_projection(node)) {
+        CHECK_LT(input_idx, plan.projection.size());
+        projection.push_back(plan.projection[input_idx]);
+      }
+      plan.projection.swap(projection);
+      plan.names.clear();
+      const auto& proj_fields = field(node, "fields");
+      for (auto it = proj_fields.Begin(); it != proj_fields.End(); ++it) {
+        plan.names.emplace_back(json_str(*it));
+      }
+    }
+    rels.Erase(rels.Begin() + tail_start, rels.End());
+  } else if (sort_idx < rels.Size()) {
+    // Each leaf returns its first offset + limit rows, the aggregator sorts the union
+    // and applies the offset. The collation is expressed in terms of the result columns.
+    auto& sort_node = rels[sort_idx];
+    std::vector<size_t> field_map;
+    bool has_projection{false};
+    for (size_t i = sort_idx + 1; i < rels.Size(); ++i) {
+      const auto inputs = input_ref_projection(rels[i]);
+      std::vector<size_t> projection;
+      for (const auto input_idx : inputs) {
+        CHECK(!has_projection || input_idx < field_map.size());
+        projection.push_back(has_projection ? field_map[input_idx] : input_idx);
+      }
+      field_map.swap(projection);
+      has_projection = true;
+    }
+    const auto& collation_arr = field(sort_node, "collation");
+    size_t sort_field_count{0};
+    for (auto it = collation_arr.Begin(); it != collation_arr.End(); ++it) {
+      sort_field_count = std::max(sort_field_count, static_cast<size_t>(json_i64(field(*it, "field"))) + 1);
+    }
+    std::vector<size_t> result_col_for_field(sort_field_count, std::numeric_limits<size_t>::max());
+    for (size_t i = 0; i < sort_field_count; ++i) {
+      if (!has_projection) {
+        result_col_for_field[i] = i;
+        continue;
+      }
+      const auto it = std::find(field_map.begin(), field_map.end(), i);
+      if (it != field_map.end()) {
+        result_col_for_field[i] = it - field_map.begin();
+      }
+    }
+    plan.collation = get_collation(sort_node, result_col_for_field);
+    for (const auto& sort_key : plan.collation) {
+      if (sort_key.field == std::numeric_limits<size_t>::max()) {
+        THROW_MAPD_EXCEPTION("ORDER BY on a column which isn't selected not supported in distributed mode");
+      }
+    }
+    plan.limit = get_literal_field(sort_node, "fetch", -1);
+    plan.offset = get_literal_field(sort_node, "offset", 0);
+    if (plan.limit > 0) {
+      sort_node["fetch"]["literal"].SetInt64(plan.limit + plan.offset);
+    }
+    sort_node.RemoveMember("offset");
+  }
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  query_ast.Accept(writer);
+  plan.leaf_query_ra = buffer.GetString();
+  return plan;
+}
+
+// Collects the tables scanned anywhere in the query, including the subqueries.
+void get_scanned_tables(const rapidjson::Value& value,
+                        const Catalog_Namespace::Catalog& cat,
+                        std::vector<const TableDescriptor*>& tables) {
+  if (value.IsObject()) {
+    const auto rel_op_it = value.FindMember("relOp");
+    if (rel_op_it != value.MemberEnd() && rel_op_it->value.IsString() &&
+        rel_op_it->value.GetString() == std::string("EnumerableTableScan")) {
+      const auto& table_json = field(value, "table");
+      CHECK(table_json.IsArray() && table_json.Size() == 2);
+      const auto td = cat.getMetadataForTable(table_json[1].GetString());
+      CHECK(td);
+      tables.push_back(td);
+    }
+    for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+      get_scanned_tables(it->value, cat, tables);
+    }
+  } else if (value.IsArray()) {
+    for (auto it = value.Begin(); it != value.End(); ++it) {
+      get_scanned_tables(*it, cat, tables);
+    }
+  }
+}
+
+// Every leaf holds a full copy of replicated tables, a query which only reads those runs on a single leaf.
+bool reads_only_replicated_tables(const std::string& query_ra, const Catalog_Namespace::Catalog& cat) {
+  rapidjson::Document query_ast;
+  query_ast.Parse(query_ra.c_str());
+  CHECK(!query_ast.HasParseError());
+  std::vector<const TableDescriptor*> tables;
+  get_scanned_tables(query_ast["rels"], cat, tables);
+  return !tables.empty() && std::all_of(tables.begin(), tables.end(), table_is_replicated);
+}
+
+// How the rows produced by a node are spread across the leaves. Rows of sharded nodes with the same
+// shard key value live on the same leaf, shard_key tells which output columns hold that value.
+struct NodeDistribution {
+  enum Kind { REPLICATED, SHARDED, ARBITRARY } kind;
+  size_t col_count;
+  int32_t shard_count;
+  SQLTypeInfo shard_key_type;
+  std::vector<bool> shard_key;
+};
+
+const NodeDistribution& get_input_distribution(const rapidjson::Value& node,
+                                               const size_t node_idx,
+                                               const std::vector<NodeDistribution>& distributions,
+                                               const size_t input_pos) {
+  const auto inputs_it = node.FindMember("inputs");
+  if (inputs_it == node.MemberEnd()) {
+    CHECK_EQ(size_t(0), input_pos);
+    CHECK_GT(node_idx, size_t(0));
+    return distributions[node_idx - 1];
+  }
+  const auto& inputs = inputs_it->value;
+  CHECK(inputs.IsArray() && input_pos < inputs.Size());
+  const size_t input_idx = std::stoi(json_str(inputs[input_pos]));
+  CHECK_LT(input_idx, distributions.size());
+  return distributions[input_idx];
+}
+
+NodeDistribution get_scan_distribution(const rapidjson::Value& scan_node, const Catalog_Namespace::Catalog& cat) {
+  const auto& table_json = field(scan_node, "table");
+  CHECK(table_json.IsArray() && table_json.Size() == 2);
+  const auto td = cat.getMetadataForTable(table_json[1].GetString());
+  CHECK(td);
+  const auto& field_names = field(scan_node, "fieldNames");
+  CHECK(field_names.IsArray());
+  NodeDistribution distribution{NodeDistribution::ARBITRARY, field_names.Size(), 0, SQLTypeInfo(), {}};
+  if (table_is_replicated(td)) {
+    distribution.kind = NodeDistribution::REPLICATED;
+  } else if (td->nShards) {
+    distribution.kind = NodeDistribution::SHARDED;
+    distribution.shard_count = td->nShards;
+    distribution.shard_key.resize(field_names.Size(), false);
+    for (size_t i = 0; i < field_names.Size(); ++i) {
+      const auto cd = cat.getMetadataForColumn(td->tableId, json_str(field_names[i]));
+      CHECK(cd);
+      if (cd->columnId == td->shardedColumnId) {
+        distribution.shard_key[i] = true;
+        distribution.shard_key_type = cd->columnType;
+      }
+    }
+  }
+  return distribution;
+}
+
+// Sharded nodes whose rows with equal join keys always meet on the same leaf. Dictionary encoded keys
+// are sharded on the string ids, they only line up when the dictionary is shared.
+bool co_located(const NodeDistribution& lhs, const NodeDistribution& rhs, const size_t lhs_col, const size_t rhs_col) {
+  if (lhs.kind != NodeDistribution::SHARDED || rhs.kind != NodeDistribution::SHARDED ||
+      lhs.shard_count != rhs.shard_count || !lhs.shard_key[lhs_col] || !rhs.shard_key[rhs_col]) {
+    return false;
+  }
+  if (lhs.shard_key_type.is_string() || rhs.shard_key_type.is_string()) {
+    return lhs.shard_key_type.get_compression() == kENCODING_DICT &&
+           rhs.shard_key_type.get_compression() == kENCODING_DICT &&
+           lhs.shard_key_type.get_comp_param() == rhs.shard_key_type.get_comp_param();
+  }
+  return true;
+}
+
+// Collects the column pairs of the equalities which are conjuncts of a join condition.
+void get_equijoin_cols(const rapidjson::Value& condition, std::vector<std::pair<size_t, size_t>>& col_pairs) {
+  if (!condition.IsObject() || !condition.HasMember("op")) {
+    return;
+  }
+  const auto op = json_str(field(condition, "op"));
+  const auto& operands = field(condition, "operands");
+  CHECK(operands.IsArray());
+  if (op == std::string("AND")) {
+    for (auto it = operands.Begin(); it != operands.End(); ++it) {
+      get_equijoin_cols(*it, col_pairs);
+    }
+    return;
+  }
+  if (op != std::string("=") || operands.Size() != 2) {
+    return;
+  }
+  const auto& lhs = operands[0];
+  const auto& rhs = operands[1];
+  if (lhs.IsObject() && lhs.HasMember("input") && rhs.IsObject() && rhs.HasMember("input")) {
+    col_pairs.emplace_back(json_i64(field(lhs, "input")), json_i64(field(rhs, "input")));
+  }
+}
+
+NodeDistribution get_join_distribution(const rapidjson::Value& join_node,
+                                       const NodeDistribution& lhs,
+                                       const NodeDistribution& rhs) {
+  const bool is_left_join = json_str(field(join_node, "joinType")) == std::string("left");
+  const auto col_count = lhs.col_count + rhs.col_count;
+  if (rhs.kind == NodeDistribution::REPLICATED) {
+    // Every leaf joins its rows of the left side with the whole right side.
+    auto distribution = lhs;
+    distribution.col_count = col_count;
+    if (distribution.kind == NodeDistribution::SHARDED) {
+      distribution.shard_key.resize(col_count, false);
+    }
+    return distribution;
+  }
+  if (lhs.kind == NodeDistribution::REPLICATED && !is_left_join) {
+    auto distribution = rhs;
+    distribution.col_count = col_count;
+    if (distribution.kind == NodeDistribution::SHARDED) {
+      distribution.shard_key.insert(distribution.shard_key.begin(), lhs.col_count, false);
+    }
+    return distribution;
+  }
+  std::vector<std::pair<size_t, size_t>> col_pairs;
+  get_equijoin_cols(field(join_node, "condition"), col_pairs);
+  for (auto col_pair : col_pairs) {
+    if (col_pair.first > col_pair.second) {
+      std::swap(col_pair.first, col_pair.second);
+    }
+    if (col_pair.first >= lhs.col_count || col_pair.second < lhs.col_count) {
+      continue;
+    }
+    if (co_located(lhs, rhs, col_pair.first, col_pair.second - lhs.col_count)) {
+      auto distribution = lhs;
+      distribution.col_count = col_count;
+      distribution.shard_key.insert(distribution.shard_key.end(), rhs.shard_key.begin(), rhs.shard_key.end());
+      return distribution;
+    }
+  }
+  THROW_MAPD_EXCEPTION(
+      "Joins in distributed mode are only supported with a replicated inner table or on the shard keys of tables "
+      "with the same shard count");
+}
+
+// Walks the query and rejects the joins the leaves can't answer on their own, i.e. the ones which
+// would need rows stored on different leaves.
+void check_join_distribution(const std::string& query_ra, const Catalog_Namespace::Catalog& cat) {
+  rapidjson::Document query_ast;
+  query_ast.Parse(query_ra.c_str());
+  CHECK(!query_ast.HasParseError());
+  const auto& rels = query_ast["rels"];
+  std::vector<NodeDistribution> distributions;
+  for (size_t node_idx = 0; node_idx < rels.Size(); ++node_idx) {
+    const auto& node = rels[node_idx];
+    const auto rel_op = json_str(field(node, "relOp"));
+    if (rel_op == std::string("EnumerableTableScan")) {
+      distributions.push_back(get_scan_distribution(node, cat));
+      continue;
+    }
+    if (rel_op == std::string("LogicalValues")) {
+      distributions.push_back({NodeDistribution::REPLICATED, field(node, "type").Size(), 0, SQLTypeInfo(), {}});
+      continue;
+    }
+    if (rel_op == std::string("LogicalJoin")) {
+      distributions.push_back(get_join_distribution(node,
+                                                    get_input_distribution(node, node_idx, distributions, 0),
+                                                    get_input_distribution(node, node_idx, distributions, 1)));
+      continue;
+    }
+    const auto input = get_input_distribution(node, node_idx, distributions, 0);
+    if (rel_op == std::string("LogicalFilter") || rel_op == std::string("LogicalSort")) {
+      distributions.push_back(input);
+      continue;
+    }
+    // Projections and aggregates keep the shard keys they pass through unchanged.
+    std::vector<int64_t> input_cols;
+    if (rel_op == std::string("LogicalProject")) {
+      const auto& exprs = field(node, "exprs");
+      for (auto it = exprs.Begin(); it != exprs.End(); ++it) {
+        input_cols.push_back(it->IsObject() && it->HasMember("input") ? json_i64(field(*it, "input")) : -1);
+      }
+    } else if (rel_op == std::string("LogicalAggregate")) {
+      const auto& group = field(node, "group");
+      for (auto it = group.Begin(); it != group.End(); ++it) {
+        input_cols.push_back(json_i64(*it));
+      }
+      input_cols.resize(field(node, "fields").Size(), -1);
+    } else {
+      THROW_MAPD_EXCEPTION("Relational operator " + rel_op + " not supported in distributed mode");
+    }
+    NodeDistribution distribution{input.kind, input_cols.size(), input.shard_count, input.shard_key_type, {}};
+    if (input.kind == NodeDistribution::SHARDED) {
+      for (const auto input_col : input_cols) {
+        distribution.shard_key.push_back(input_col >= 0 && input.shard_key[input_col]);
+      }
+      if (std::find(distribution.shard_key.begin(), distribution.shard_key.end(), true) ==
+          distribution.shard_key.end()) {
+        distribution.kind = NodeDistribution::ARBITRARY;
+      }
+    }
+    distributions.push_back(distribution);
+  }
+}
+
+TRowSet deserialize_row_set(const std::string& serialized_rows) {
+  auto buffer = mapd::make_shared<TMemoryBuffer>(reinterpret_cast<uint8_t*>(const_cast<char*>(serialized_rows.data())),
+                                                 serialized_rows.size());
+  TBinaryProtocol protocol(buffer);
+  TRowSet row_set;
+  row_set.read(&protocol);
+  return row_set;
+}
+
+void append_column(TColumn& dest, const TColumn& src) {
+  dest.data.int_col.insert(dest.data.int_col.end(), src.data.int_col.begin(), src.data.int_col.end());
+  dest.data.real_col.insert(dest.data.real_col.end(), src.data.real_col.begin(), src.data.real_col.end());
+  dest.data.str_col.insert(dest.data.str_col.end(), src.data.str_col.begin(), src.data.str_col.end());
+  dest.data.arr_col.insert(dest.data.arr_col.end(), src.data.arr_col.begin(), src.data.arr_col.end());
+  dest.nulls.insert(dest.nulls.end(), src.nulls.begin(), src.nulls.end());
+}
+
+void append_value(TColumn& dest, const TColumn& src, const size_t row) {
+  if (!src.data.int_col.empty()) {
+    dest.data.int_col.push_back(src.data.int_col[row]);
+  } else if (!src.data.real_col.empty()) {
+    dest.data.real_col.push_back(src.data.real_col[row]);
+  } else if (!src.data.str_col.empty()) {
+    dest.data.str_col.push_back(src.data.str_col[row]);
+  } else {
+    CHECK_LT(row, src.data.arr_col.size());
+    dest.data.arr_col.push_back(src.data.arr_col[row]);
+  }
+  dest.nulls.push_back(src.nulls[row]);
+}
+
+void append_key(std::string& key, const TColumn& column, const size_t row) {
+  key.push_back(column.nulls[row]);
+  if (column.nulls[row]) {
+    return;
+  }
+  if (!column.data.int_col.empty()) {
+    key.append(reinterpret_cast<const char*>(&column.data.int_col[row]), sizeof(int64_t));
+  } else if (!column.data.real_col.empty()) {
+    key.append(reinterpret_cast<const char*>(&column.data.real_col[row]), sizeof(double));
+  } else {
+    CHECK_LT(row, column.data.str_col.size());
+    const auto& str = column.data.str_col[row];
+    const auto str_len = str.size();
+    key.append(reinterpret_cast<const char*>(&str_len), sizeof(str_len));
+    key.append(str);
+  }
+}
+
+// Compares two non-null values of the same column.
+int compare_values(const TColumn& column, const size_t lhs, const size_t rhs) {
+  if (!column.data.int_col.empty()) {
+    const auto lhs_val = column.data.int_col[lhs];
+    const auto rhs_val = column.data.int_col[rhs];
+    return lhs_val < rhs_val ? -1 : (lhs_val > rhs_val ? 1 : 0);
+  }
+  if (!column.data.real_col.empty()) {
+    const auto lhs_val = column.data.real_col[lhs];
+    const auto rhs_val = column.data.real_col[rhs];
+    return lhs_val < rhs_val ? -1 : (lhs_val > rhs_val ? 1 : 0);
+  }
+  if (!column.data.str_col.empty()) {
+    return column.data.str_col[lhs].compare(column.data.str_col[rhs]);
+  }
+  THROW_MAPD_EXCEPTION("Sorting on arrays not supported in distributed mode");
+}
+
+void copy_value(TColumn& column, const size_t dest_row, const size_t src_row) {
+  if (!column.data.int_col.empty()) {
+    column.data.int_col[dest_row] = column.data.int_col[src_row];
+  } else if (!column.data.real_col.empty()) {
+    column.data.real_col[dest_row] = column.data.real_col[src_row];
+  } else {
+    CHECK_LT(src_row, column.data.str_col.size());
+    column.data.str_col[dest_row] = column.data.str_col[src_row];
+  }
+  column.nulls[dest_row] = column.nulls[src_row];
+}
+
+// Folds the value at src_row into the value at dest_row, both rows belong to the same group.
+void reduce_value(TColumn& column, const size_t dest_row, const size_t src_row, const SQLAgg agg_kind) {
+  if (column.nulls[src_row]) {
+    return;
+  }
+  if (column.nulls[dest_row]) {
+    copy_value(column, dest_row, src_row);
+    return;
+  }
+  switch (agg_kind) {
+    case kCOUNT:
+    case kSUM:
+      if (!column.data.int_col.empty()) {
+        column.data.int_col[dest_row] += column.data.int_col[src_row];
+      } else {
+        CHECK_LT(src_row, column.data.real_col.size());
+        column.data.real_col[dest_row] += column.data.real_col[src_row];
+      }
+      break;
+    case kMIN:
+      if (compare_values(column, src_row, dest_row) < 0) {
+        copy_value(column, dest_row, src_row);
+      }
+      break;
+    case kMAX:
+      if (compare_values(column, src_row, dest_row) > 0) {
+        copy_value(column, dest_row, src_row);
+      }
+      break;
+    case kLAST_SAMPLE:
+      break;
+    default:
+      CHECK(false);
+  }
+}
+
+TRowSet merge_results(const std::vector<TRowSet>& leaf_results, const MergePlan& plan) {
+  CHECK(!leaf_results.empty());
+  const auto col_count = leaf_results.front().row_desc.size();
+  std::vector<TColumn> columns(col_count);
+  for (const auto& leaf_result : leaf_results) {
+    CHECK(leaf_result.is_columnar);
+    CHECK_EQ(col_count, leaf_result.columns.size());
+    for (size_t col_idx = 0; col_idx < col_count; ++col_idx) {
+      append_column(columns[col_idx], leaf_result.columns[col_idx]);
+    }
+  }
+  const size_t row_count = col_count ? columns.front().nulls.size() : 0;
+  std::vector<size_t> rows;
+  if (plan.merge_type == TMergeType::REDUCE) {
+    CHECK_EQ(col_count, plan.group_count + plan.agg_kinds.size());
+    std::unordered_map<std::string, size_t> group_rows;
+    for (size_t row = 0; row < row_count; ++row) {
+      std::string key;
+      for (size_t col_idx = 0; col_idx < plan.group_count; ++col_idx) {
+        append_key(key, columns[col_idx], row);
+      }
+      const auto it_ok = group_rows.emplace(key, row);
+      if (it_ok.second) {
+        rows.push_back(row);
+        continue;
+      }
+      for (size_t agg_idx = 0; agg_idx < plan.agg_kinds.size(); ++agg_idx) {
+        reduce_value(columns[plan.group_count + agg_idx], it_ok.first->second, row, plan.agg_kinds[agg_idx]);
+      }
+    }
+  } else {
+    rows.resize(row_count);
+    std::iota(rows.begin(), rows.end(), 0);
+  }
+  if (!plan.collation.empty()) {
+    std::stable_sort(rows.begin(), rows.end(), [&columns, &plan](const size_t lhs, const size_t rhs) {
+      for (const auto& sort_key : plan.collation) {
+        const auto& column = columns[sort_key.field];
+        const bool lhs_null = column.nulls[lhs];
+        const bool rhs_null = column.nulls[rhs];
+        if (lhs_null != rhs_null) {
+          return sort_key.nulls_first ? lhs_null : rhs_null;
+        }
+        if (lhs_null) {
+          continue;
+        }
+        const auto cmp = compare_values(column, lhs, rhs);
+        if (cmp) {
+          return sort_key.is_desc ? cmp > 0 : cmp < 0;
+        }
+      }
+      return false;
+    });
+  }
+  const auto offset = std::min(static_cast<size_t>(plan.offset), rows.size());
+  rows.erase(rows.begin(), rows.begin() + offset);
+  if (plan.limit >= 0 && rows.size() > static_cast<size_t>(plan.limit)) {
+    rows.resize(plan.limit);
+  }
+  TRowSet row_set;
+  row_set.is_columnar = true;
+  const auto& leaf_row_desc = leaf_results.front().row_desc;
+  const auto result_col_count = plan.projection.empty() ? col_count : plan.projection.size();
+  for (size_t i = 0; i < result_col_count; ++i) {
+    const auto col_idx = plan.projection.empty() ? i : plan.projection[i];
+    CHECK_LT(col_idx, col_count);
+    row_set.row_desc.push_back(leaf_row_desc[col_idx]);
+    if (!plan.projection.empty()) {
+      row_set.row_desc.back().col_name = plan.names[i];
+    }
+    TColumn column;
+    for (const auto row : rows) {
+      append_value(column, columns[col_idx], row);
+    }
+    row_set.columns.push_back(column);
+  }
+  return row_set;
+}
+
+}  // namespace
+
+LeafAggregator::LeafAggregator(const std::vector<LeafHostInfo>& leaves)
+    : leaves_(leaves), idle_clients_(leaves.size()), next_insert_leaf_(0), next_replicated_leaf_(0) {}
+
+template <class F>
+void LeafAggregator::onLeaf(const size_t leaf_idx, F func) {
+  std::unique_ptr<LeafClient> leaf_client;
+  try {
+    leaf_client = acquireClient(leaf_idx);
+    func(*leaf_client->client);
+  } catch (const TMapDException& e) {
+    releaseClient(leaf_idx, std::move(leaf_client));
+    THROW_MAPD_EXCEPTION("Leaf " + leafName(leaf_idx) + ": " + e.error_msg);
+  } catch (const apache::thrift::TException& e) {
+    // The connection is in an unknown state, don't return it to the pool.
+    THROW_MAPD_EXCEPTION("Leaf " + leafName(leaf_idx) + ": " + std::string(e.what()));
+  }
+  releaseClient(leaf_idx, std::move(leaf_client));
+}
+
+template <class F>
+void LeafAggregator::onAllLeaves(F func) {
+  std::vector<std::future<void>> leaf_futures;
+  for (size_t leaf_idx = 0; leaf_idx < leaves_.size(); ++leaf_idx) {
+    leaf_futures.emplace_back(std::async(std::launch::async, [this, leaf_idx, &func] {
+      onLeaf(leaf_idx, [leaf_idx, &func](MapDClient& client) { func(leaf_idx, client); });
+    }));
+  }
+  for (auto& leaf_future : leaf_futures) {
+    leaf_future.wait();
+  }
+  for (auto& leaf_future : leaf_futures) {
+    leaf_future.get();
+  }
+}
+
+TRowSet LeafAggregator::execute(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                const std::string& query_ra,
+                                const bool just_explain) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  const auto& cat = parent_session_info.get_catalog();
+  std::vector<TRowSet> leaf_results(leaves_.size());
+  const auto run_on_leaf = [&](const size_t leaf_idx, MapDClient& client, const std::string& leaf_query_ra) {
+    TPendingQuery pending_query;
+    client.start_query(pending_query, leaf_sessions[leaf_idx], leaf_query_ra, just_explain);
+    TStepResult step_result;
+    client.execute_first_step(step_result, pending_query);
+    CHECK(step_result.execution_finished);
+    leaf_results[leaf_idx] = deserialize_row_set(step_result.serialized_rows);
+  };
+  if (reads_only_replicated_tables(query_ra, cat)) {
+    // Any leaf has the whole answer, merging the results of all of them would count every row once per leaf.
+    const auto leaf_idx = next_replicated_leaf_++ % leaves_.size();
+    onLeaf(leaf_idx, [&](MapDClient& client) { run_on_leaf(leaf_idx, client, query_ra); });
+    return leaf_results[leaf_idx];
+  }
+  const auto plan = build_merge_plan(query_ra);
+  check_join_distribution(query_ra, cat);
+  if (just_explain) {
+    // The leaves generate the same code, showing one of them is enough.
+    onLeaf(0, [&](MapDClient& client) { run_on_leaf(0, client, plan.leaf_query_ra); });
+    return leaf_results.front();
+  }
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) { run_on_leaf(leaf_idx, client, plan.leaf_query_ra); });
+  return merge_results(leaf_results, plan);
+}
+
+std::vector<TQueryResult> LeafAggregator::forwardQueryToLeaves(
+    const Catalog_Namespace::SessionInfo& parent_session_info,
+    const std::string& query_str) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  std::vector<TQueryResult> results(leaves_.size());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.sql_execute(results[leaf_idx], leaf_sessions[leaf_idx], query_str, true, "", -1, -1);
+  });
+  return results;
+}
+
+TQueryResult LeafAggregator::forwardQueryToLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                                const std::string& query_str,
+                                                const size_t leaf_idx) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  TQueryResult result;
+  onLeaf(leaf_idx, [&](MapDClient& client) {
+    client.sql_execute(result, leaf_sessions[leaf_idx], query_str, true, "", -1, -1);
+  });
+  return result;
+}
+
+void LeafAggregator::insertDataToLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                      const size_t leaf_idx,
+                                      const TInsertData& thrift_insert_data) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  onLeaf(leaf_idx,
+         [&](MapDClient& client) { client.insert_data(leaf_sessions[leaf_idx], thrift_insert_data); });
+}
+
+void LeafAggregator::checkpointLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                    const int32_t db_id,
+                                    const int32_t table_id) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.checkpoint(leaf_sessions[leaf_idx], db_id, table_id);
+  });
+}
+
+int32_t LeafAggregator::get_table_epochLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                            const int32_t db_id,
+                                            const int32_t table_id) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  std::vector<int32_t> epochs(leaves_.size());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    epochs[leaf_idx] = client.get_table_epoch(leaf_sessions[leaf_idx], db_id, table_id);
+  });
+  const auto min_max_epoch = std::minmax_element(epochs.begin(), epochs.end());
+  if (*min_max_epoch.first != *min_max_epoch.second) {
+    LOG(WARNING) << "Epochs on leaves do not all agree on table id " << table_id << " db id " << db_id
+                 << ", using the lowest one " << *min_max_epoch.first;
+  }
+  return *min_max_epoch.first;
+}
+
+void LeafAggregator::set_table_epochLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
+                                         const int32_t db_id,
+                                         const int32_t table_id,
+                                         const int32_t new_epoch) {
+  const auto leaf_sessions = getLeafSessions(parent_session_info.get_session_id());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.set_table_epoch(leaf_sessions[leaf_idx], db_id, table_id, new_epoch);
+  });
+}
+
+void LeafAggregator::connect(const Catalog_Namespace::SessionInfo& parent_session_info,
+                             const std::string& user,
+                             const std::string& passwd,
+                             const std::string& dbname) {
+  std::vector<TSessionId> leaf_sessions(leaves_.size());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.connect(leaf_sessions[leaf_idx], user, passwd, dbname);
+  });
+  mapd_unique_lock<mapd_shared_mutex> write_lock(leaf_sessions_mutex_);
+  leaf_sessions_[parent_session_info.get_session_id()] = leaf_sessions;
+}
+
+void LeafAggregator::disconnect(const TSessionId session) {
+  std::vector<TSessionId> leaf_sessions;
+  {
+    mapd_unique_lock<mapd_shared_mutex> write_lock(leaf_sessions_mutex_);
+    const auto it = leaf_sessions_.find(session);
+    if (it == leaf_sessions_.end()) {
+      return;
+    }
+    leaf_sessions.swap(it->second);
+    leaf_sessions_.erase(it);
+  }
+  try {
+    onAllLeaves(
+        [&](const size_t leaf_idx, MapDClient& client) { client.disconnect(leaf_sessions[leaf_idx]); });
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to disconnect session " << session << " from leaves: " << e.what();
+  }
+}
+
+void LeafAggregator::interrupt(const TSessionId session) {
+  const auto leaf_sessions = getLeafSessions(session);
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) { client.interrupt(leaf_sessions[leaf_idx]); });
+}
+
+void LeafAggregator::set_execution_mode(const TSessionId session, const TExecuteMode::type mode) {
+  const auto leaf_sessions = getLeafSessions(session);
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.set_execution_mode(leaf_sessions[leaf_idx], mode);
+  });
+}
+
+std::vector<TServerStatus> LeafAggregator::getLeafStatus(TSessionId session) {
+  const auto leaf_sessions = getLeafSessions(session);
+  std::vector<TServerStatus> leaf_status(leaves_.size());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.get_server_status(leaf_status[leaf_idx], leaf_sessions[leaf_idx]);
+    leaf_status[leaf_idx].host_name = leafName(leaf_idx);
+  });
+  return leaf_status;
+}
+
+std::vector<TNodeMemoryInfo> LeafAggregator::getLeafMemoryInfo(TSessionId session,
+                                                               Data_Namespace::MemoryLevel memory_level) {
+  const auto leaf_sessions = getLeafSessions(session);
+  const std::string memory_level_str{memory_level == Data_Namespace::MemoryLevel::GPU_LEVEL ? "gpu" : "cpu"};
+  std::vector<std::vector<TNodeMemoryInfo>> leaf_memory_info(leaves_.size());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.get_memory(leaf_memory_info[leaf_idx], leaf_sessions[leaf_idx], memory_level_str);
+    for (auto& node_memory_info : leaf_memory_info[leaf_idx]) {
+      node_memory_info.host_name = leafName(leaf_idx);
+    }
+  });
+  std::vector<TNodeMemoryInfo> memory_info;
+  for (const auto& crt_leaf_memory_info : leaf_memory_info) {
+    memory_info.insert(memory_info.end(), crt_leaf_memory_info.begin(), crt_leaf_memory_info.end());
+  }
+  return memory_info;
+}
+
+TClusterHardwareInfo LeafAggregator::getHardwareInfo(TSessionId session) {
+  const auto leaf_sessions = getLeafSessions(session);
+  std::vector<TClusterHardwareInfo> leaf_hardware_info(leaves_.size());
+  onAllLeaves([&](const size_t leaf_idx, MapDClient& client) {
+    client.get_hardware_info(leaf_hardware_info[leaf_idx], leaf_sessions[leaf_idx]);
+    for (auto& hardware_info : leaf_hardware_info[leaf_idx].hardware_info) {
+      hardware_info.host_name = leafName(leaf_idx);
+    }
+  });
+  TClusterHardwareInfo cluster_hardware_info;
+  for (const auto& crt_leaf_hardware_info : leaf_hardware_info) {
+    cluster_hardware_info.hardware_info.insert(cluster_hardware_info.hardware_info.end(),
+                                               crt_leaf_hardware_info.hardware_info.begin(),
+                                               crt_leaf_hardware_info.hardware_info.end());
+  }
+  return cluster_hardware_info;
+}
+
+std::unique_ptr<LeafAggregator::LeafClient> LeafAggregator::acquireClient(const size_t leaf_idx) {
+  CHECK_LT(leaf_idx, leaves_.size());
+  {
+    std::lock_guard<std::mutex> lock(idle_clients_mutex_);
+    auto& idle_clients = idle_clients_[leaf_idx];
+    if (!idle_clients.empty()) {
+      auto leaf_client = std::move(idle_clients.back());
+      idle_clients.pop_back();
+      return leaf_client;
+    }
+  }
+  const auto& leaf = leaves_[leaf_idx];
+  std::unique_ptr<LeafClient> leaf_client(new LeafClient());
+  mapd::shared_ptr<TTransport> socket(new TSocket(leaf.getHost(), leaf.getPort()));
+  leaf_client->transport.reset(new TBufferedTransport(socket));
+  mapd::shared_ptr<TProtocol> protocol(new TBinaryProtocol(leaf_client->transport));
+  leaf_client->client.reset(new MapDClient(protocol));
+  leaf_client->transport->open();
+  return leaf_client;
+}
+
+void LeafAggregator::releaseClient(const size_t leaf_idx, std::unique_ptr<LeafClient> leaf_client) {
+  std::lock_guard<std::mutex> lock(idle_clients_mutex_);
+  idle_clients_[leaf_idx].push_back(std::move(leaf_client));
+}
+
+std::vector<TSessionId> LeafAggregator::getLeafSessions(const TSessionId& parent_session) const {
+  mapd_shared_lock<mapd_shared_mutex> read_lock(leaf_sessions_mutex_);
+  const auto it = leaf_sessions_.find(parent_session);
+  if (it == leaf_sessions_.end()) {
+    THROW_MAPD_EXCEPTION("Session " + parent_session + " isn't connected to the leaves");
+  }
+  return it->second;
+}
+
+std::string LeafAggregator::leafName(const size_t leaf_idx) const {
+  CHECK_LT(leaf_idx, leaves_.size());
+  return leaves_[leaf_idx].getHost() + ":" + std::to_string(leaves_[leaf_idx].getPort());
+}
@@ -17,100 +17,115 @@
 #ifndef LEAFAGGREGATOR_H
 #define LEAFAGGREGATOR_H
 
-#include "../AggregatedResult.h"
 #include "LeafHostInfo.h"
 #include "gen-cpp/MapD.h"
 #include "DataMgr/MemoryLevel.h"
-#include "QueryEngine/CompilationOptions.h"
-#include "QueryEngine/TargetMetaInfo.h"
+#include "Shared/mapd_shared_mutex.h"
+#include "Shared/mapd_shared_ptr.h"
 
 #include <glog/logging.h>
+#include <thrift/transport/TTransport.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace Catalog_Namespace {
 class SessionInfo;
 }  // Catalog_Namespace
 
-class ResultSet;
-
+// Fans queries and inserts out to the leaves of a cluster over Thrift and merges
+// their partial results. Every session of the aggregator owns a session on each leaf.
 class LeafAggregator {
  public:
-  LeafAggregator(const std::vector<LeafHostInfo>& leaves) { CHECK(leaves.empty()); }
-
-  AggregatedResult execute(const Catalog_Namespace::SessionInfo& parent_session_info,
-                           const std::string& query_ra,
-                           const ExecutionOptions& eo) {
-    CHECK(false);
-    return {nullptr, {}};
-  }
+  LeafAggregator(const std::vector<LeafHostInfo>& leaves);
+
+  // Runs the relational algebra on all leaves and merges the columnar partial results.
+  // Queries ending with a (grouped) aggregate are reduced by group key, everything
+  // else is concatenated; ORDER BY, LIMIT and OFFSET are applied after the merge.
+  // Queries which only read replicated tables run unchanged on a single leaf. Joins
+  // must find all matching rows on the same leaf: the inner table is replicated or
+  // both tables are sharded on the join key with the same shard count.
+  TRowSet execute(const Catalog_Namespace::SessionInfo& parent_session_info,
+                  const std::string& query_ra,
+                  const bool just_explain);
 
   std::vector<TQueryResult> forwardQueryToLeaves(const Catalog_Namespace::SessionInfo& parent_session_info,
-                                                 const std::string& query_str) {
-    CHECK(false);
-    return {};
-  }
+                                                 const std::string& query_str);
 
   TQueryResult forwardQueryToLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
                                   const std::string& query_str,
-                                  const size_t leaf_idx) {
-    CHECK(false);
-    return {};
-  }
+                                  const size_t leaf_idx);
 
   void insertDataToLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
                         const size_t leaf_idx,
-                        const TInsertData& thrift_insert_data) {
-    CHECK(false);
-  }
+                        const TInsertData& thrift_insert_data);
 
   void checkpointLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
                       const int32_t db_id,
-                      const int32_t table_id) {
-    CHECK(false);
-  }
+                      const int32_t table_id);
 
   int32_t get_table_epochLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
                               const int32_t db_id,
-                              const int32_t table_id) {
-    CHECK(false);
-    return 0;
-  }
+                              const int32_t table_id);
 
   void set_table_epochLeaf(const Catalog_Namespace::SessionInfo& parent_session_info,
                            const int32_t db_id,
                            const int32_t table_id,
-                           const int32_t new_epoch) {
-    CHECK(false);
-  }
+                           const int32_t new_epoch);
 
   void connect(const Catalog_Namespace::SessionInfo& parent_session_info,
                const std::string& user,
                const std::string& passwd,
-               const std::string& dbname) {
-    CHECK(false);
-  }
+               const std::string& dbname);
+
+  void disconnect(const TSessionId session);
+
+  void interrupt(const TSessionId session);
+
+  void set_execution_mode(const TSessionId session, const TExecuteMode::type mode);
+
+  size_t leafCount() const { return leaves_.size(); }
+
+  // Spreads the batches of tables which are neither sharded nor replicated across the leaves.
+  // Shared by all loads, an INSERT statement is a batch of a single row.
+  size_t nextLeafForInsert() { return next_insert_leaf_++ % leaves_.size(); }
+
+  std::vector<TServerStatus> getLeafStatus(TSessionId session);
+
+  std::vector<TNodeMemoryInfo> getLeafMemoryInfo(TSessionId session, Data_Namespace::MemoryLevel memory_level);
+
+  TClusterHardwareInfo getHardwareInfo(TSessionId session);
+
+ private:
+  struct LeafClient {
+    mapd::shared_ptr<apache::thrift::transport::TTransport> transport;
+    std::unique_ptr<MapDClient> client;
+  };
 
-  void disconnect(const TSessionId session) { CHECK(false); }
+  // Thrift clients aren't thread-safe, concurrent requests to a leaf use separate connections.
+  std::unique_ptr<LeafClient> acquireClient(const size_t leaf_idx);
 
-  void interrupt(const TSessionId session) { CHECK(false); }
+  void releaseClient(const size_t leaf_idx, std::unique_ptr<LeafClient> leaf_client);
 
-  void set_execution_mode(const TSessionId session, const TExecuteMode::type mode) { CHECK(false); }
+  template <class F>
+  void onLeaf(const size_t leaf_idx, F func);
 
-  size_t leafCount() const { return 0; }
+  template <class F>
+  void onAllLeaves(F func);
 
-  std::vector<TServerStatus> getLeafStatus(TSessionId session) {
-    CHECK(false);
-    return {};
-  }
+  std::vector<TSessionId> getLeafSessions(const TSessionId& parent_session) const;
 
-  std::vector<TNodeMemoryInfo> getLeafMemoryInfo(TSessionId session, Data_Namespace::MemoryLevel memory_level) {
-    CHECK(false);
-    return {};
-  }
+  std::string leafName(const size_t leaf_idx) const;
 
-  TClusterHardwareInfo getHardwareInfo(TSessionId session) {
-    CHECK(false);
-    return {};
-  }
+  const std::vector<LeafHostInfo> leaves_;
+  std::vector<std::vector<std::unique_ptr<LeafClient>>> idle_clients_;
+  std::mutex idle_clients_mutex_;
+  std::unordered_map<TSessionId, std::vector<TSessionId>> leaf_sessions_;
+  mutable mapd_shared_mutex leaf_sessions_mutex_;
+  std::atomic<size_t> next_insert_leaf_;
+  std::atomic<size_t> next_replicated_leaf_;  // spreads the queries on replicated tables
 };
 
 #endif  // LEAFAGGREGATOR_H
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LeafHostInfo.h"
+
+#include <rapidjson/document.h>
+#include <rapidjson/error/en.h>
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+NodeRole to_node_role(const std::string& role) {
+  if (role == "dbleaf") {
+    return NodeRole::DbLeaf;
+  }
+  if (role == "string") {
+    return NodeRole::String;
+  }
+  throw std::runtime_error("Unknown node role " + role + ", should be dbleaf or string");
+}
+
+}  // namespace
+
+// The cluster configuration is a JSON array with an entry per node, e.g.
+// [ { "host": "localhost", "port": 16274, "role": "dbleaf" }, ... ]
+std::vector<LeafHostInfo> LeafHostInfo::parseClusterConfig(const std::string& file_path) {
+  std::ifstream config_file(file_path);
+  if (!config_file) {
+    throw std::runtime_error("Could not open cluster configuration " + file_path);
+  }
+  std::stringstream config_stream;
+  config_stream << config_file.rdbuf();
+  rapidjson::Document config;
+  config.Parse(config_stream.str().c_str());
+  if (config.HasParseError()) {
+    throw std::runtime_error("Could not parse cluster configuration " + file_path + ": " +
+                             rapidjson::GetParseError_En(config.GetParseError()));
+  }
+  if (!config.IsArray()) {
+    throw std::runtime_error("Cluster configuration " + file_path + " must be an array of nodes");
+  }
+  std::vector<LeafHostInfo> leaves;
+  for (auto node_it = config.Begin(); node_it != config.End(); ++node_it) {
+    const auto& node = *node_it;
+    if (!node.IsObject() || !node.HasMember("host") || !node["host"].IsString() || !node.HasMember("port") ||
+        !node["port"].IsUint() || !node.HasMember("role") || !node["role"].IsString()) {
+      throw std::runtime_error("Every node of cluster configuration " + file_path +
+                               " needs a string host, an integer port and a string role");
+    }
+    const auto port = node["port"].GetUint();
+    if (port > std::numeric_limits<uint16_t>::max()) {
+      throw std::runtime_error("Invalid port " + std::to_string(port) + " in cluster configuration " + file_path);
+    }
+    leaves.emplace_back(node["host"].GetString(), port, to_node_role(node["role"].GetString()));
+  }
+  return leaves;
+}
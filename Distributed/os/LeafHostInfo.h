@@ -41,9 +41,7 @@ class LeafHostInfo {
 
   NodeRole getRole() const { return role_; }
 
-  static std::vector<LeafHostInfo> parseClusterConfig(const std::string& file_path) {
-    return std::vector<LeafHostInfo>{};
-  };
+  static std::vector<LeafHostInfo> parseClusterConfig(const std::string& file_path);
 
  private:
   std::string host_;
@@ -95,6 +95,13 @@ class AbstractFragmenter {
 
   virtual void dropFragmentsToSize(const size_t maxRows) = 0;
 
+  /**
+   * @brief Moves the rows inserted into memory only, if any,
+   * into the fragments of the table and checkpoints them
+   */
+
+  virtual void mergeDeltaStore() = 0;
+
   /**
    * @brief Gets the id of the partitioner
    */
@@ -141,6 +148,30 @@ class AbstractFragmenter {
   virtual void updateMetadata(const Catalog_Namespace::Catalog* catalog,
                               const MetaDataKey& key,
                               UpdelRoll& updelRoll) = 0;
+
+  /**
+   * @brief Compacts the deleted rows out of every fragment
+   * in which at least minDeletedFraction of the rows are deleted.
+   * Changes become visible when updelRoll is committed.
+   * Returns the number of rows removed.
+   */
+
+  virtual size_t vacuumDeletedRows(const Catalog_Namespace::Catalog* catalog,
+                                   const TableDescriptor* td,
+                                   const double minDeletedFraction,
+                                   UpdelRoll& updelRoll) = 0;
+
+  /**
+   * @brief Merges the fragments which aren't full in the order
+   * of their sort column, a few fragments' worth of rows at a
+   * time, packing the sorted rows into full fragments.
+   * Changes become visible when updelRoll is committed.
+   * Returns the number of rows moved.
+   */
+
+  virtual size_t reclusterRows(const Catalog_Namespace::Catalog* catalog,
+                               const TableDescriptor* td,
+                               UpdelRoll& updelRoll) = 0;
 };
 
 }  // Fragmenter_Namespace
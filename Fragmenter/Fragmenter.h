@@ -77,6 +77,7 @@ class FragmentInfo {
         shadowNumTuples(0),
         physicalTableId(-1),
         shard(-1),
+        isDelta(false),
         resultSet(nullptr),
         numTuples(0),
         synthesizedNumTuplesIsValid(false),
@@ -108,6 +109,7 @@ class FragmentInfo {
   std::vector<int> deviceIds;
   int physicalTableId;
   int shard;
+  bool isDelta;  // of the delta store, UPDATE and DELETE don't see it
   std::map<int, ChunkMetadata> shadowChunkMetadataMap;
   mutable ResultSet* resultSet;
   mutable std::shared_ptr<std::mutex> resultSetMutex;
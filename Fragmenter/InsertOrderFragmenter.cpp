@@ -15,12 +15,19 @@
  */
 
 #include "InsertOrderFragmenter.h"
+#include "InsertWal.h"
 #include "../DataMgr/LockMgr.h"
 #include "../DataMgr/DataMgr.h"
 #include "../DataMgr/AbstractBuffer.h"
+#include "../Shared/checked_alloc.h"
+#include "../Shared/scope.h"
 #include <glog/logging.h>
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <list>
+#include <numeric>
 #include <thread>
 
 #include <assert.h>
@@ -28,6 +35,10 @@
 
 #define DROP_FRAGMENT_FACTOR 0.97  // drop to 97% of max so we don't keep adding and dropping fragments
 
+bool g_enable_delta_store{false};
+size_t g_delta_store_merge_rows{size_t(1) << 20};
+size_t g_delta_store_merge_ms{30000};
+
 using Data_Namespace::AbstractBuffer;
 using Data_Namespace::DataMgr;
 using Chunk_NS::Chunk;
@@ -36,6 +47,241 @@ using namespace std;
 
 namespace Fragmenter_Namespace {
 
+namespace {
+
+template <typename T>
+std::vector<size_t> sort_permutation(const int8_t* data, const size_t numRows) {
+  const auto vals = reinterpret_cast<const T*>(data);
+  std::vector<size_t> permutation;
+  if (std::is_sorted(vals, vals + numRows)) {
+    return permutation;
+  }
+  permutation.resize(numRows);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::stable_sort(permutation.begin(), permutation.end(), [vals](const size_t lhs, const size_t rhs) {
+    return vals[lhs] < vals[rhs];
+  });
+  return permutation;
+}
+
+// Width of a fixed length value in InsertData, which holds dictionary ids already narrowed
+// to the column but every other value at its logical width.
+size_t get_insert_element_size(const SQLTypeInfo& ti) {
+  return ti.is_string() ? ti.get_size() : ti.get_logical_size();
+}
+
+template <typename T>
+void append_to_record(std::vector<int8_t>& record, const T value) {
+  const auto bytes = reinterpret_cast<const int8_t*>(&value);
+  record.insert(record.end(), bytes, bytes + sizeof(T));
+}
+
+// A logged insert is its row count followed by the id and the values of each column: fixed length
+// values as they are in InsertData, strings and arrays prefixed with their length.
+std::vector<int8_t> serialize_insert_data(const InsertData& insertData, const std::map<int, Chunk>& columnMap) {
+  std::vector<int8_t> record;
+  append_to_record<uint64_t>(record, insertData.numRows);
+  append_to_record<uint32_t>(record, insertData.columnIds.size());
+  for (size_t i = 0; i < insertData.columnIds.size(); ++i) {
+    const auto columnId = insertData.columnIds[i];
+    const auto colMapIt = columnMap.find(columnId);
+    CHECK(colMapIt != columnMap.end());
+    const auto& ti = colMapIt->second.get_column_desc()->columnType;
+    append_to_record<int32_t>(record, columnId);
+    if (ti.is_array()) {
+      for (const auto& array : *insertData.data[i].arraysPtr) {
+        append_to_record<uint8_t>(record, array.is_null);
+        append_to_record<uint64_t>(record, array.length);
+        record.insert(record.end(), array.pointer, array.pointer + array.length);
+      }
+    } else if (ti.is_varlen()) {
+      for (const auto& str : *insertData.data[i].stringsPtr) {
+        append_to_record<uint64_t>(record, str.size());
+        record.insert(record.end(), str.begin(), str.end());
+      }
+    } else {
+      const auto numbers = insertData.data[i].numbersPtr;
+      record.insert(record.end(), numbers, numbers + insertData.numRows * get_insert_element_size(ti));
+    }
+  }
+  return record;
+}
+
+// Ids of the columns a logged insert has values for.
+std::vector<int> logged_column_ids(const std::vector<int8_t>& record, const std::map<int, Chunk>& columnMap) {
+  size_t pos = 0;
+  const auto read_value = [&record, &pos](auto& value) {
+    CHECK_LE(pos + sizeof(value), record.size());
+    std::memcpy(&value, &record[pos], sizeof(value));
+    pos += sizeof(value);
+  };
+  uint64_t numRows{0};
+  uint32_t numColumns{0};
+  read_value(numRows);
+  read_value(numColumns);
+  std::vector<int> columnIds;
+  for (uint32_t i = 0; i < numColumns; ++i) {
+    int32_t columnId{0};
+    read_value(columnId);
+    const auto colMapIt = columnMap.find(columnId);
+    if (colMapIt == columnMap.end()) {
+      throw std::runtime_error("Logged insert into missing column " + std::to_string(columnId));
+    }
+    columnIds.push_back(columnId);
+    const auto& ti = colMapIt->second.get_column_desc()->columnType;
+    if (ti.is_varlen()) {
+      for (size_t row = 0; row < numRows; ++row) {
+        uint8_t isNull{0};
+        uint64_t length{0};
+        if (ti.is_array()) {
+          read_value(isNull);
+        }
+        read_value(length);
+        pos += length;
+      }
+    } else {
+      pos += numRows * get_insert_element_size(ti);
+    }
+  }
+  CHECK_EQ(pos, record.size());
+  return columnIds;
+}
+
+// InsertData rebuilt from consecutive logged inserts into the same columns, along with the buffers it points to.
+// It takes inserts up to maxRows rows, but always the first one.
+struct LoggedInsert {
+  InsertData data;
+  size_t recordCount;  // logged inserts taken
+  std::list<std::vector<int8_t>> numbers;
+  std::list<std::vector<std::string>> strings;
+  std::list<std::vector<ArrayDatum>> arrays;
+
+  LoggedInsert(const std::vector<int>& chunkKeyPrefix,
+               const std::vector<std::vector<int8_t>>& records,
+               const size_t firstRecord,
+               const size_t maxRows,
+               const std::map<int, Chunk>& columnMap)
+      : recordCount(0) {
+    CHECK_LT(firstRecord, records.size());
+    data.databaseId = chunkKeyPrefix[0];
+    data.tableId = chunkKeyPrefix[1];
+    data.numRows = 0;
+    data.columnIds = logged_column_ids(records[firstRecord], columnMap);
+    std::vector<std::vector<int8_t>*> columnNumbers(data.columnIds.size(), nullptr);
+    std::vector<std::vector<std::string>*> columnStrings(data.columnIds.size(), nullptr);
+    std::vector<std::vector<ArrayDatum>*> columnArrays(data.columnIds.size(), nullptr);
+    for (size_t i = 0; i < data.columnIds.size(); ++i) {
+      const auto& ti = columnMap.find(data.columnIds[i])->second.get_column_desc()->columnType;
+      if (ti.is_array()) {
+        arrays.emplace_back();
+        columnArrays[i] = &arrays.back();
+      } else if (ti.is_varlen()) {
+        strings.emplace_back();
+        columnStrings[i] = &strings.back();
+      } else {
+        numbers.emplace_back();
+        columnNumbers[i] = &numbers.back();
+      }
+    }
+    for (size_t r = firstRecord; r < records.size(); ++r) {
+      const auto& record = records[r];
+      size_t pos = 0;
+      const auto read_bytes = [&record, &pos](const size_t size) {
+        CHECK_LE(pos + size, record.size());
+        const auto bytes = &record[pos];
+        pos += size;
+        return bytes;
+      };
+      const auto read_value = [&read_bytes](auto& value) {
+        std::memcpy(&value, read_bytes(sizeof(value)), sizeof(value));
+      };
+      uint64_t numRows{0};
+      uint32_t numColumns{0};
+      read_value(numRows);
+      read_value(numColumns);
+      if (recordCount &&
+          (data.numRows + numRows > maxRows || logged_column_ids(record, columnMap) != data.columnIds)) {
+        break;
+      }
+      for (uint32_t i = 0; i < numColumns; ++i) {
+        int32_t columnId{0};
+        read_value(columnId);
+        CHECK_EQ(columnId, data.columnIds[i]);
+        const auto& ti = columnMap.find(columnId)->second.get_column_desc()->columnType;
+        if (ti.is_array()) {
+          for (size_t row = 0; row < numRows; ++row) {
+            uint8_t isNull{0};
+            uint64_t length{0};
+            read_value(isNull);
+            read_value(length);
+            int8_t* buf = length ? reinterpret_cast<int8_t*>(checked_malloc(length)) : nullptr;
+            if (length) {
+              std::memcpy(buf, read_bytes(length), length);
+            }
+            columnArrays[i]->emplace_back(length, buf, isNull);
+          }
+        } else if (ti.is_varlen()) {
+          for (size_t row = 0; row < numRows; ++row) {
+            uint64_t length{0};
+            read_value(length);
+            const auto bytes = read_bytes(length);
+            columnStrings[i]->emplace_back(reinterpret_cast<const char*>(bytes), length);
+          }
+        } else {
+          const auto size = numRows * get_insert_element_size(ti);
+          const auto bytes = read_bytes(size);
+          columnNumbers[i]->insert(columnNumbers[i]->end(), bytes, bytes + size);
+        }
+      }
+      CHECK_EQ(pos, record.size());
+      data.numRows += numRows;
+      ++recordCount;
+    }
+    // the buffers are complete, point at them
+    for (size_t i = 0; i < data.columnIds.size(); ++i) {
+      DataBlockPtr p;
+      if (columnArrays[i]) {
+        p.arraysPtr = columnArrays[i];
+      } else if (columnStrings[i]) {
+        p.stringsPtr = columnStrings[i];
+      } else {
+        p.numbersPtr = columnNumbers[i]->data();
+      }
+      data.data.push_back(p);
+    }
+  }
+};
+
+}  // namespace
+
+std::vector<size_t> InsertOrderFragmenter::getSortPermutation(const int8_t* data,
+                                                              const size_t numRows,
+                                                              const SQLTypeInfo& ti,
+                                                              const size_t width) {
+  CHECK(!ti.is_varlen());
+  if (ti.is_fp()) {
+    return width == sizeof(float) ? sort_permutation<float>(data, numRows) : sort_permutation<double>(data, numRows);
+  }
+  // narrow dictionary ids are unsigned, everything else is a signed integer
+  if (ti.is_string() && width < sizeof(int32_t)) {
+    return width == sizeof(uint8_t) ? sort_permutation<uint8_t>(data, numRows)
+                                    : sort_permutation<uint16_t>(data, numRows);
+  }
+  switch (width) {
+    case 1:
+      return sort_permutation<int8_t>(data, numRows);
+    case 2:
+      return sort_permutation<int16_t>(data, numRows);
+    case 4:
+      return sort_permutation<int32_t>(data, numRows);
+    case 8:
+      return sort_permutation<int64_t>(data, numRows);
+    default:
+      CHECK(false);
+  }
+  return {};
+}
+
 InsertOrderFragmenter::InsertOrderFragmenter(const vector<int> chunkKeyPrefix,
                                              vector<Chunk>& chunkVec,
                                              Data_Namespace::DataMgr* dataMgr,
@@ -46,7 +292,8 @@ InsertOrderFragmenter::InsertOrderFragmenter(const vector<int> chunkKeyPrefix,
                                              const size_t maxChunkSize,
                                              const size_t pageSize,
                                              const size_t maxRows,
-                                             const Data_Namespace::MemoryLevel defaultInsertLevel)
+                                             const Data_Namespace::MemoryLevel defaultInsertLevel,
+                                             const int sortedColumnId)
     : chunkKeyPrefix_(chunkKeyPrefix),
       dataMgr_(dataMgr),
       catalog_(catalog),
@@ -60,7 +307,15 @@ InsertOrderFragmenter::InsertOrderFragmenter(const vector<int> chunkKeyPrefix,
       maxRows_(maxRows),
       fragmenterType_("insert_order"),
       defaultInsertLevel_(defaultInsertLevel),
-      hasMaterializedRowId_(false) {
+      hasMaterializedRowId_(false),
+      insertCount_(0),
+      checkpointedInsertCount_(0),
+      sortedColumnId_(sortedColumnId),
+      deltaRows_(0),
+      deltaAppends_(0),
+      regularAppends_(0),
+      lastDeltaMerge_(std::chrono::steady_clock::now()),
+      stopWalCheckpoint_(false) {
   // Note that Fragmenter is not passed virtual columns and so should only
   // find row id column if it is non virtual
 
@@ -73,9 +328,31 @@ InsertOrderFragmenter::InsertOrderFragmenter(const vector<int> chunkKeyPrefix,
     }
   }
   getChunkMetadata();
+  if (defaultInsertLevel_ == Data_Namespace::DISK_LEVEL) {
+    // replay a log left behind even if logging was turned off since
+    const auto tableDir = dataMgr_->getTableDataPath(chunkKeyPrefix_[0], chunkKeyPrefix_[1]);
+    if (g_enable_insert_wal || InsertWal::exists(tableDir)) {
+      wal_.reset(new InsertWal(tableDir));
+      replayWal();
+      if (!g_enable_insert_wal) {
+        wal_.reset();
+        InsertWal::remove(tableDir);
+      }
+    }
+  }
 }
 
-InsertOrderFragmenter::~InsertOrderFragmenter() {}
+InsertOrderFragmenter::~InsertOrderFragmenter() {
+  if (deltaMerge_.valid()) {
+    deltaMerge_.wait();
+  }
+  if (walCheckpoint_.valid()) {
+    stopWalCheckpoint_ = true;
+    walCheckpoint_.wait();
+  }
+  // no merge here: a rollback, drop or truncate discards the rows anyway, the owner merges on shutdown
+  // and deletes the chunks of the table from memory, delta ones included
+}
 
 void InsertOrderFragmenter::getChunkMetadata() {
   if (defaultInsertLevel_ ==
@@ -134,43 +411,67 @@ void InsertOrderFragmenter::getChunkMetadata() {
                maxChunkSize_ / maxFixedColSize);  // this is maximum number of rows assuming everything is fixed length
 
   if (fragmentInfoVec_.size() > 0) {
-    // Now need to get the insert buffers for each column - should be last
-    // fragment
-    int lastFragmentId = fragmentInfoVec_.back().fragmentId;
-    int deviceId = fragmentInfoVec_.back().deviceIds[static_cast<int>(defaultInsertLevel_)];
+    // reopen the last fragment for inserts
+    auto& lastFragment = fragmentInfoVec_.back();
+    int deviceId = lastFragment.deviceIds[static_cast<int>(defaultInsertLevel_)];
+    std::unique_ptr<OpenFragment> openFragment(new OpenFragment());
+    openFragment->fragmentInfo = &lastFragment;
+    openFragment->varLenBytes = varLenColInfo_;
     for (auto colIt = columnMap_.begin(); colIt != columnMap_.end(); ++colIt) {
-      ChunkKey insertKey = chunkKeyPrefix_;  // database_id and table_id
-      insertKey.push_back(colIt->first);     // column id
-      insertKey.push_back(lastFragmentId);   // fragment id
-      colIt->second.getChunkBuffer(dataMgr_, insertKey, defaultInsertLevel_, deviceId);
-      auto varLenColInfoIt = varLenColInfo_.find(colIt->first);
-      if (varLenColInfoIt != varLenColInfo_.end()) {
-        varLenColInfoIt->second = colIt->second.get_buffer()->size();
+      ChunkKey insertKey = chunkKeyPrefix_;          // database_id and table_id
+      insertKey.push_back(colIt->first);             // column id
+      insertKey.push_back(lastFragment.fragmentId);  // fragment id
+      auto& chunk = openFragment->chunks.emplace(colIt->first, Chunk(colIt->second.get_column_desc())).first->second;
+      chunk.getChunkBuffer(dataMgr_, insertKey, defaultInsertLevel_, deviceId);
+      auto varLenBytesIt = openFragment->varLenBytes.find(colIt->first);
+      if (varLenBytesIt != openFragment->varLenBytes.end()) {
+        varLenBytesIt->second = chunk.get_buffer()->size();
       }
     }
+    idleFragments_.push_back(std::move(openFragment));
   }
 }
 
 void InsertOrderFragmenter::dropFragmentsToSize(const size_t maxRows) {
-  // not safe to call from outside insertData
-  // b/c depends on insertLock around numTuples_
-
-  if (numTuples_ > maxRows) {
-    size_t preNumTuples = numTuples_;
-    vector<int> dropFragIds;
+  vector<int> dropFragIds;
+  std::vector<std::unique_ptr<OpenFragment>> droppedOpenFragments;
+  size_t preNumTuples = 0;
+  size_t postNumTuples = 0;
+  {
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    if (numTuples_ <= maxRows) {
+      return;
+    }
+    preNumTuples = numTuples_;
     size_t targetRows = maxRows * DROP_FRAGMENT_FACTOR;
-    while (numTuples_ > targetRows) {
-      assert(fragmentInfoVec_.size() > 0);
-      size_t numFragTuples = fragmentInfoVec_[0].getPhysicalNumTuples();
-      dropFragIds.push_back(fragmentInfoVec_[0].fragmentId);
+    mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+    // a fragment a writer holds stops the drop, its rows aren't published yet
+    while (numTuples_ > targetRows && !fragmentInfoVec_.empty() &&
+           !busyFragmentIds_.count(fragmentInfoVec_.front().fragmentId)) {
+      const auto fragmentId = fragmentInfoVec_.front().fragmentId;
+      size_t numFragTuples = fragmentInfoVec_.front().getPhysicalNumTuples();
+      dropFragIds.push_back(fragmentId);
+      for (auto it = idleFragments_.begin(); it != idleFragments_.end(); ++it) {
+        if ((*it)->fragmentInfo->fragmentId == fragmentId) {
+          droppedOpenFragments.push_back(std::move(*it));
+          idleFragments_.erase(it);
+          break;
+        }
+      }
       fragmentInfoVec_.pop_front();
       assert(numTuples_ >= numFragTuples);
       numTuples_ -= numFragTuples;
     }
-    deleteFragments(dropFragIds);
-    LOG(INFO) << "dropFragmentsToSize, numTuples pre: " << preNumTuples << " post: " << numTuples_
-              << " maxRows: " << maxRows;
+    postNumTuples = numTuples_;
   }
+  // unpin the buffers before they are deleted
+  droppedOpenFragments.clear();
+  if (dropFragIds.empty()) {
+    return;
+  }
+  deleteFragments(dropFragIds);
+  LOG(INFO) << "dropFragmentsToSize, numTuples pre: " << preNumTuples << " post: " << postNumTuples
+            << " maxRows: " << maxRows;
 }
 
 void InsertOrderFragmenter::deleteFragments(const vector<int>& dropFragIds) {
@@ -205,24 +506,384 @@ void InsertOrderFragmenter::deleteFragments(const vector<int>& dropFragIds) {
 }
 
 void InsertOrderFragmenter::insertData(InsertData& insertDataStruct) {
-  // TODO: this local lock will need to be centralized when ALTER COLUMN is added, bc
-  mapd_unique_lock<mapd_shared_mutex> insertLock(
-      insertMutex_);  // prevent two threads from trying to insert into the same table simultaneously
-  insertDataImpl(insertDataStruct);
+  if (g_enable_delta_store && defaultInsertLevel_ == Data_Namespace::DISK_LEVEL && insertDataDelta(insertDataStruct)) {
+    return;
+  }
+  beginRegularAppend();
+  ScopeGuard endAppend = [this] { endRegularAppend(); };
+  if (wal_) {
+    insertDataLogged(insertDataStruct);
+    return;
+  }
+  uint64_t insertCount{0};
+  {
+    // writers append to fragments of their own in parallel, a checkpoint waits for all of them
+    mapd_shared_lock<mapd_shared_mutex> insertLock(insertMutex_);
+    insertDataImpl(insertDataStruct);
+    insertCount = ++insertCount_;
+  }
   if (defaultInsertLevel_ == Data_Namespace::DISK_LEVEL) {  // only checkpoint if data is resident on disk
-    dataMgr_->checkpoint(chunkKeyPrefix_[0],
-                         chunkKeyPrefix_[1]);  // need to checkpoint here to remove window for corruption
+    mapd_unique_lock<mapd_shared_mutex> checkpointLock(insertMutex_);
+    // the checkpoint of a concurrent writer may have covered this insert already
+    if (checkpointedInsertCount_ < insertCount) {
+      checkpointedInsertCount_ = insertCount_;
+      dataMgr_->checkpoint(chunkKeyPrefix_[0],
+                           chunkKeyPrefix_[1]);  // need to checkpoint here to remove window for corruption
+    }
+  }
+  if (catalog_) {
+    // the views are refreshed lazily, refreshing here would run queries under the insert lock
+    catalog_->recordTableAppend(physicalTableId_);
+  }
+}
+
+void InsertOrderFragmenter::insertDataLogged(InsertData& insertDataStruct) {
+  // before insertDataImpl adds the deleted column to the struct
+  const auto record = serialize_insert_data(insertDataStruct, columnMap_);
+  uint64_t seq{0};
+  {
+    // a checkpoint takes the lock exclusively, so the epoch stays the one the rows went in
+    mapd_shared_lock<mapd_shared_mutex> insertLock(insertMutex_);
+    insertDataImpl(insertDataStruct);
+    try {
+      seq = wal_->append(dataMgr_->getTableEpoch(chunkKeyPrefix_[0], chunkKeyPrefix_[1]), record);
+    } catch (const std::runtime_error& e) {
+      LOG(ERROR) << e.what() << ", checkpointing table " << physicalTableId_ << " instead";
+    }
+  }
+  if (!seq) {
+    mapd_unique_lock<mapd_shared_mutex> checkpointLock(insertMutex_);
+    checkpointWal();
+  }
+  const auto now = std::chrono::steady_clock::now();
+  const auto walBytes = wal_->size();
+  {
+    std::lock_guard<std::mutex> walCheckpointLock(walCheckpointMutex_);
+    if (walBytes && (walBytes >= g_insert_wal_checkpoint_bytes ||
+                     now - lastWalCheckpoint_ >= std::chrono::milliseconds(g_insert_wal_checkpoint_ms))) {
+      // the inserts block on the lock meanwhile, but none of them waits for the checkpoint to commit
+      if (!walCheckpoint_.valid() || walCheckpoint_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        lastWalCheckpoint_ = now;
+        walCheckpoint_ = std::async(std::launch::async, [this] {
+          // like any other writer, so a checkpoint never lands in the middle of a statement's writes
+          auto chunkKeyPrefix = chunkKeyPrefix_;
+          if (shard_ >= 0) {
+            chunkKeyPrefix[1] = catalog_->getLogicalTableId(chunkKeyPrefix[1]);
+          }
+          using namespace Lock_Namespace;
+          auto& tableCheckpointMutex =
+              *LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(LockType::CheckpointLock, chunkKeyPrefix);
+          // the owner of the table may hold the lock while it destroys this fragmenter, the log keeps the rows
+          while (!tableCheckpointMutex.try_lock()) {
+            if (stopWalCheckpoint_) {
+              return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+          }
+          std::lock_guard<mapd_shared_mutex> tableCheckpointLock(tableCheckpointMutex, std::adopt_lock);
+          mapd_unique_lock<mapd_shared_mutex> checkpointLock(insertMutex_);
+          checkpointWal();
+        });
+      }
+    }
+  }
+  if (seq) {
+    wal_->sync(seq);
+  }
+  if (catalog_) {
+    catalog_->recordTableAppend(physicalTableId_);
+  }
+}
+
+void InsertOrderFragmenter::replayWal() {
+  const auto records = wal_->read(dataMgr_->getTableEpoch(chunkKeyPrefix_[0], chunkKeyPrefix_[1]));
+  for (size_t first = 0; first < records.size();) {
+    LoggedInsert loggedInsert(chunkKeyPrefix_, records, first, maxFragmentRows_, columnMap_);
+    insertDataImpl(loggedInsert.data);
+    first += loggedInsert.recordCount;
+  }
+  if (records.empty()) {
+    // records of epochs checkpointed before the log was truncated, if any
+    wal_->truncate();
+    std::lock_guard<std::mutex> walCheckpointLock(walCheckpointMutex_);
+    lastWalCheckpoint_ = std::chrono::steady_clock::now();
+    return;
+  }
+  LOG(INFO) << "Replayed " << records.size() << " logged inserts into table " << physicalTableId_;
+  checkpointWal();
+}
+
+void InsertOrderFragmenter::checkpointWal() {
+  dataMgr_->checkpoint(chunkKeyPrefix_[0], chunkKeyPrefix_[1]);
+  wal_->truncate();
+  std::lock_guard<std::mutex> walCheckpointLock(walCheckpointMutex_);
+  lastWalCheckpoint_ = std::chrono::steady_clock::now();
+}
+
+bool InsertOrderFragmenter::insertDataDelta(InsertData& insertDataStruct) {
+  // before insertDataImpl adds the deleted column to the struct
+  auto record = serialize_insert_data(insertDataStruct, columnMap_);
+  uint64_t seq{0};
+  size_t deltaRows{0};
+  {
+    // the merge takes the lock exclusively, it finds the rows of an insert in the store along with its record
+    mapd_shared_lock<mapd_shared_mutex> insertLock(insertMutex_);
+    {
+      std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+      if (regularAppends_) {
+        // rows appended to the fragments meanwhile would sort before these and shift their row ids
+        return false;
+      }
+      ++deltaAppends_;
+    }
+    try {
+      insertDataImpl(insertDataStruct, true);
+    } catch (...) {
+      std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+      --deltaAppends_;
+      throw;
+    }
+    if (wal_) {
+      try {
+        seq = wal_->append(dataMgr_->getTableEpoch(chunkKeyPrefix_[0], chunkKeyPrefix_[1]), record);
+      } catch (const std::runtime_error& e) {
+        LOG(ERROR) << e.what() << ", merging the delta store of table " << physicalTableId_ << " instead";
+      }
+    }
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    deltaInserts_.push_back(std::move(record));
+    deltaRows = deltaRows_;
+    --deltaAppends_;
+  }
+  if (catalog_) {
+    catalog_->recordTableAppend(physicalTableId_);
+  }
+  if (wal_ && !seq) {
+    mergeDeltaStore();
+    return true;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> deltaMergeLock(deltaMergeMutex_);
+    if (deltaRows >= g_delta_store_merge_rows ||
+        now - lastDeltaMerge_ >= std::chrono::milliseconds(g_delta_store_merge_ms)) {
+      // the inserts block on the lock meanwhile, but none of them waits for the merge to commit
+      if (!deltaMerge_.valid() || deltaMerge_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        lastDeltaMerge_ = now;
+        deltaMerge_ = std::async(std::launch::async, [this] {
+          try {
+            mergeDeltaStore();
+          } catch (const std::exception& e) {
+            LOG(ERROR) << "Could not merge the delta store of table " << physicalTableId_ << ": " << e.what();
+          }
+        });
+      }
+    }
+  }
+  if (seq) {
+    wal_->sync(seq);
+  }
+  return true;
+}
+
+void InsertOrderFragmenter::beginRegularAppend() {
+  bool merge{false};
+  {
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    ++regularAppends_;
+    merge = deltaAppends_ || !deltaInserts_.empty();
+  }
+  if (merge) {
+    // the merge waits for the delta inserts under way, none starts until the append ends
+    try {
+      mergeDeltaStore();
+    } catch (...) {
+      endRegularAppend();
+      throw;
+    }
+  }
+}
+
+void InsertOrderFragmenter::endRegularAppend() {
+  std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+  --regularAppends_;
+}
+
+void InsertOrderFragmenter::mergeDeltaStore() {
+  std::vector<std::unique_ptr<OpenFragment>> deltaFragments;
+  const auto deltaFragmentIds = mergeDeltaStoreImpl(deltaFragments);
+  if (deltaFragmentIds.empty()) {
+    return;
+  }
+  {
+    // queries which started before the merge may still read the delta fragments, which
+    // can't be evicted while pinned as there's no copy of them on disk
+    auto chunkKeyPrefix = chunkKeyPrefix_;
+    if (shard_ >= 0) {
+      chunkKeyPrefix[1] = catalog_->getLogicalTableId(chunkKeyPrefix[1]);
+    }
+    using namespace Lock_Namespace;
+    mapd_unique_lock<mapd_shared_mutex> deleteLock(
+        *LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(LockType::UpdateDeleteLock, chunkKeyPrefix));
+    deltaFragments.clear();
+  }
+  deleteFragments(deltaFragmentIds);
+  dropFragmentsToSize(maxRows_);
+  if (catalog_) {
+    if (sortedColumnId_) {
+      // the rows got sorted across inserts, the views may have folded in some of them
+      catalog_->invalidateMaterializedViews(shard_ >= 0 ? catalog_->getLogicalTableId(physicalTableId_)
+                                                        : physicalTableId_);
+    } else {
+      catalog_->recordTableAppend(physicalTableId_);
+    }
   }
 }
 
+std::vector<int> InsertOrderFragmenter::mergeDeltaStoreImpl(
+    std::vector<std::unique_ptr<OpenFragment>>& deltaFragments) {
+  // the inserts wait for the merge, the checkpoint at its end covers all of them
+  mapd_unique_lock<mapd_shared_mutex> mergeLock(insertMutex_);
+  if (deltaInserts_.empty()) {
+    return {};
+  }
+  // a fragment's worth of rows at a time, sorted as a whole on the sort column if any
+  std::vector<std::unique_ptr<OpenFragment>> openFragments;
+  size_t numRows = 0;
+  for (size_t first = 0; first < deltaInserts_.size();) {
+    LoggedInsert batch(chunkKeyPrefix_, deltaInserts_, first, maxFragmentRows_, columnMap_);
+    appendToOpenFragments(batch.data, openFragments, false);
+    numRows += batch.data.numRows;
+    first += batch.recordCount;
+  }
+  std::vector<int> deltaFragmentIds;
+  {
+    // queries find the rows either in the delta store or in the fragments, never in both
+    mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+    for (const auto& openFragment : openFragments) {
+      auto fragment = openFragment->fragmentInfo;
+      fragment->setPhysicalNumTuples(fragment->shadowNumTuples);
+      fragment->setChunkMetadataMap(fragment->shadowChunkMetadataMap);
+    }
+    for (const auto& fragment : deltaFragmentInfoVec_) {
+      deltaFragmentIds.push_back(fragment.fragmentId);
+    }
+    // the delta open fragments still point at them, but only get unpinned
+    deltaFragmentInfoVec_.clear();
+  }
+  releaseOpenFragments(openFragments, numRows, false);
+  {
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    for (auto& openFragment : idleDeltaFragments_) {
+      deltaFragments.push_back(std::move(openFragment));
+    }
+    for (auto& openFragment : fullDeltaFragments_) {
+      deltaFragments.push_back(std::move(openFragment));
+    }
+    idleDeltaFragments_.clear();
+    fullDeltaFragments_.clear();
+    deltaInserts_.clear();
+    deltaRows_ = 0;
+  }
+  checkpointedInsertCount_ = insertCount_;
+  if (wal_) {
+    checkpointWal();
+  } else {
+    dataMgr_->checkpoint(chunkKeyPrefix_[0], chunkKeyPrefix_[1]);
+  }
+  LOG(INFO) << "Merged " << numRows << " rows of the delta store into table " << physicalTableId_;
+  return deltaFragmentIds;
+}
+
 void InsertOrderFragmenter::insertDataNoCheckpoint(InsertData& insertDataStruct) {
-  // TODO: this local lock will need to be centralized when ALTER COLUMN is added, bc
-  mapd_unique_lock<mapd_shared_mutex> insertLock(
-      insertMutex_);  // prevent two threads from trying to insert into the same table simultaneously
+  // the delta store gets merged first, its rows sort after the fragments
+  beginRegularAppend();
+  ScopeGuard endAppend = [this] { endRegularAppend(); };
+  mapd_shared_lock<mapd_shared_mutex> insertLock(insertMutex_);
   insertDataImpl(insertDataStruct);
+  ++insertCount_;
+  insertLock.unlock();
+  if (catalog_) {
+    catalog_->recordTableAppend(physicalTableId_);
+  }
+}
+
+void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct, const bool delta) {
+  // fill the open fragments this writer holds, other writers fill theirs meanwhile
+  std::vector<std::unique_ptr<OpenFragment>> openFragments;
+  try {
+    appendToOpenFragments(insertDataStruct, openFragments, delta);
+  } catch (...) {
+    // the rows aren't published, but the writers publishing after these fragments mustn't wait for them
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    for (const auto& openFragment : openFragments) {
+      busyFragmentIds_.erase(openFragment->fragmentInfo->fragmentId);
+    }
+    fragmentReleased_.notify_all();
+    throw;
+  }
+  if (openFragments.empty()) {
+    return;
+  }
+  if (delta) {
+    // keep the delta fragments out of the checkpoints, the merge writes their rows
+    for (const auto& openFragment : openFragments) {
+      for (const auto& chunk : openFragment->chunks) {
+        chunk.second.get_buffer()->clearDirtyBits();
+        if (chunk.second.get_index_buf()) {
+          chunk.second.get_index_buf()->clearDirtyBits();
+        }
+      }
+    }
+  }
+  publishOpenFragments(openFragments, insertDataStruct.numRows, delta);
+  if (!delta) {
+    dropFragmentsToSize(maxRows_);
+  }
 }
 
-void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
+void InsertOrderFragmenter::publishOpenFragments(std::vector<std::unique_ptr<OpenFragment>>& openFragments,
+                                                 const size_t numRows,
+                                                 const bool delta) {
+  if (hasMaterializedRowId_) {
+    {  // Need to narrow scope of this lock, or SELECT and COPY_FROM enters a dead lock
+      // after SELECT has locked UpdateDeleteLock and COPY_FROM has locked fragmentInfoMutex_
+      // while SELECT waits for fragmentInfoMutex_ and COPY_FROM waits for UpdateDeleteLock
+
+      mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+      for (const auto& openFragment : openFragments) {
+        auto fragment = openFragment->fragmentInfo;
+        fragment->setPhysicalNumTuples(fragment->shadowNumTuples);
+        fragment->setChunkMetadataMap(fragment->shadowChunkMetadataMap);
+      }
+    }
+    releaseOpenFragments(openFragments, numRows, delta);
+    return;
+  }
+  // A virtual rowid is the offset of the row in the table, counted over the fragments in order (see
+  // get_table_id_to_frag_offsets in the executor). A fragment stops growing once a newer one exists, and its rows
+  // are published once the writers holding the fragments before it released them, so published rowids never shift.
+  std::unique_lock<std::mutex> openFragmentsLock(openFragmentsMutex_);
+  for (auto& openFragment : openFragments) {
+    // a writer holds fragments of increasing ids, the ones it still has to publish don't hold it back
+    const auto fragmentId = openFragment->fragmentInfo->fragmentId;
+    fragmentReleased_.wait(openFragmentsLock, [this, fragmentId] { return *busyFragmentIds_.begin() == fragmentId; });
+    {
+      mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+      auto fragment = openFragment->fragmentInfo;
+      fragment->setPhysicalNumTuples(fragment->shadowNumTuples);
+      fragment->setChunkMetadataMap(fragment->shadowChunkMetadataMap);
+    }
+    releaseOpenFragment(openFragment, delta);
+    fragmentReleased_.notify_all();
+  }
+  (delta ? deltaRows_ : numTuples_) += numRows;
+  openFragments.clear();
+}
+
+void InsertOrderFragmenter::appendToOpenFragments(InsertData& insertDataStruct,
+                                                  std::vector<std::unique_ptr<OpenFragment>>& openFragments,
+                                                  const bool delta) {
   // populate deleted system column of it exists, as it will not come from client
   std::unique_ptr<int8_t[]> data_for_deleted_column;
   for (const auto& cit : columnMap_)
@@ -249,52 +910,89 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
     return;
   }
 
-  FragmentInfo* currentFragment = 0;
+  // keep each batch ordered on the sort column so the fragments it fills get narrow
+  // min/max stats, permuting copies rather than the caller's buffers
+  std::vector<std::unique_ptr<int8_t[]>> sortedNumbers;
+  std::list<std::vector<std::string>> sortedStrings;
+  std::list<std::vector<ArrayDatum>> sortedArrays;
+  const auto sortColIt = inverseInsertDataColIdMap.find(sortedColumnId_);
+  if (sortedColumnId_ && sortColIt != inverseInsertDataColIdMap.end()) {
+    const auto& sortTi = columnMap_[sortedColumnId_].get_column_desc()->columnType;
+    const auto permutation = getSortPermutation(
+        dataCopy[sortColIt->second].numbersPtr, numRowsLeft, sortTi, get_insert_element_size(sortTi));
+    for (size_t i = 0; !permutation.empty() && i < insertDataStruct.columnIds.size(); ++i) {
+      const auto cd = columnMap_[insertDataStruct.columnIds[i]].get_column_desc();
+      const auto& ti = cd->columnType;
+      if (cd->isDeletedCol) {
+        continue;  // all zeroes
+      }
+      if (ti.is_array()) {
+        sortedArrays.emplace_back();
+        auto& arrays = sortedArrays.back();
+        arrays.reserve(numRowsLeft);
+        for (const auto row : permutation) {
+          arrays.push_back((*dataCopy[i].arraysPtr)[row]);
+        }
+        dataCopy[i].arraysPtr = &arrays;
+      } else if (ti.is_varlen()) {
+        sortedStrings.emplace_back();
+        auto& strings = sortedStrings.back();
+        strings.reserve(numRowsLeft);
+        for (const auto row : permutation) {
+          strings.push_back((*dataCopy[i].stringsPtr)[row]);
+        }
+        dataCopy[i].stringsPtr = &strings;
+      } else {
+        const auto width = get_insert_element_size(ti);
+        sortedNumbers.emplace_back(new int8_t[numRowsLeft * width]);
+        auto sorted = sortedNumbers.back().get();
+        for (size_t r = 0; r < numRowsLeft; ++r) {
+          std::memcpy(sorted + r * width, dataCopy[i].numbersPtr + permutation[r] * width, width);
+        }
+        dataCopy[i].numbersPtr = sorted;
+      }
+    }
+  }
 
-  if (fragmentInfoVec_.empty()) {  // if no fragments exist for table
-    currentFragment = createNewFragment(defaultInsertLevel_);
-  } else {
-    currentFragment = &(fragmentInfoVec_.back());
+  if (openFragments.empty()) {
+    openFragments.push_back(acquireOpenFragment(delta));
   }
-  size_t startFragment = fragmentInfoVec_.size() - 1;
 
   while (numRowsLeft > 0) {  // may have to create multiple fragments for bulk insert
     // loop until done inserting all rows
+    auto openFragment = openFragments.back().get();
+    auto currentFragment = openFragment->fragmentInfo;
     CHECK_LE(currentFragment->shadowNumTuples, maxFragmentRows_);
     size_t rowsLeftInCurrentFragment = maxFragmentRows_ - currentFragment->shadowNumTuples;
     size_t numRowsToInsert = min(rowsLeftInCurrentFragment, numRowsLeft);
     if (rowsLeftInCurrentFragment != 0) {
-      for (auto& varLenColInfoIt : varLenColInfo_) {
-        CHECK_LE(varLenColInfoIt.second, maxChunkSize_);
-        size_t bytesLeft = maxChunkSize_ - varLenColInfoIt.second;
-        auto insertIdIt = inverseInsertDataColIdMap.find(varLenColInfoIt.first);
+      for (auto& varLenBytesIt : openFragment->varLenBytes) {
+        CHECK_LE(varLenBytesIt.second, maxChunkSize_);
+        size_t bytesLeft = maxChunkSize_ - varLenBytesIt.second;
+        auto insertIdIt = inverseInsertDataColIdMap.find(varLenBytesIt.first);
         if (insertIdIt != inverseInsertDataColIdMap.end()) {
-          auto colMapIt = columnMap_.find(varLenColInfoIt.first);
+          auto& chunk = openFragment->chunks[varLenBytesIt.first];
           numRowsToInsert = std::min(numRowsToInsert,
-                                     colMapIt->second.getNumElemsForBytesInsertData(
+                                     chunk.getNumElemsForBytesInsertData(
                                          dataCopy[insertIdIt->second], numRowsToInsert, numRowsInserted, bytesLeft));
         }
       }
     }
 
     if (rowsLeftInCurrentFragment == 0 || numRowsToInsert == 0) {
-      currentFragment = createNewFragment(defaultInsertLevel_);
-      if (numRowsInserted == 0) {
-        startFragment++;
-      }
+      openFragments.push_back(createNewFragment(delta ? Data_Namespace::CPU_LEVEL : defaultInsertLevel_, delta));
+      openFragment = openFragments.back().get();
+      currentFragment = openFragment->fragmentInfo;
       rowsLeftInCurrentFragment = maxFragmentRows_;
-      for (auto& varLenColInfoIt : varLenColInfo_) {
-        varLenColInfoIt.second = 0;  // reset byte counter
-      }
       numRowsToInsert = min(rowsLeftInCurrentFragment, numRowsLeft);
-      for (auto& varLenColInfoIt : varLenColInfo_) {
-        CHECK_LE(varLenColInfoIt.second, maxChunkSize_);
-        size_t bytesLeft = maxChunkSize_ - varLenColInfoIt.second;
-        auto insertIdIt = inverseInsertDataColIdMap.find(varLenColInfoIt.first);
+      for (auto& varLenBytesIt : openFragment->varLenBytes) {
+        CHECK_LE(varLenBytesIt.second, maxChunkSize_);
+        size_t bytesLeft = maxChunkSize_ - varLenBytesIt.second;
+        auto insertIdIt = inverseInsertDataColIdMap.find(varLenBytesIt.first);
         if (insertIdIt != inverseInsertDataColIdMap.end()) {
-          auto colMapIt = columnMap_.find(varLenColInfoIt.first);
+          auto& chunk = openFragment->chunks[varLenBytesIt.first];
           numRowsToInsert = std::min(numRowsToInsert,
-                                     colMapIt->second.getNumElemsForBytesInsertData(
+                                     chunk.getNumElemsForBytesInsertData(
                                          dataCopy[insertIdIt->second], numRowsToInsert, numRowsInserted, bytesLeft));
         }
       }
@@ -305,13 +1003,13 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
     // for each column, append the data in the appropriate insert buffer
     for (size_t i = 0; i < insertDataStruct.columnIds.size(); ++i) {
       int columnId = insertDataStruct.columnIds[i];
-      auto colMapIt = columnMap_.find(columnId);
-      assert(colMapIt != columnMap_.end());
+      auto chunkIt = openFragment->chunks.find(columnId);
+      assert(chunkIt != openFragment->chunks.end());
       currentFragment->shadowChunkMetadataMap[columnId] =
-          colMapIt->second.appendData(dataCopy[i], numRowsToInsert, numRowsInserted);
-      auto varLenColInfoIt = varLenColInfo_.find(columnId);
-      if (varLenColInfoIt != varLenColInfo_.end()) {
-        varLenColInfoIt->second = colMapIt->second.get_buffer()->size();
+          chunkIt->second.appendData(dataCopy[i], numRowsToInsert, numRowsInserted);
+      auto varLenBytesIt = openFragment->varLenBytes.find(columnId);
+      if (varLenBytesIt != openFragment->varLenBytes.end()) {
+        varLenBytesIt->second = chunkIt->second.get_buffer()->size();
       }
     }
     if (hasMaterializedRowId_) {
@@ -322,33 +1020,75 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
       }
       DataBlockPtr rowIdBlock;
       rowIdBlock.numbersPtr = reinterpret_cast<int8_t*>(rowIdData);
-      auto colMapIt = columnMap_.find(rowIdColId_);
       currentFragment->shadowChunkMetadataMap[rowIdColId_] =
-          colMapIt->second.appendData(rowIdBlock, numRowsToInsert, numRowsInserted);
+          openFragment->chunks[rowIdColId_].appendData(rowIdBlock, numRowsToInsert, numRowsInserted);
       delete[] rowIdData;
     }
 
-    currentFragment->shadowNumTuples = fragmentInfoVec_.back().getPhysicalNumTuples() + numRowsToInsert;
+    currentFragment->shadowNumTuples += numRowsToInsert;
     numRowsLeft -= numRowsToInsert;
     numRowsInserted += numRowsToInsert;
   }
-  {  // Need to narrow scope of this lock, or SELECT and COPY_FROM enters a dead lock
-    // after SELECT has locked UpdateDeleteLock and COPY_FROM has locked fragmentInfoMutex_
-    // while SELECT waits for fragmentInfoMutex_ and COPY_FROM waits for UpdateDeleteLock
+}
 
-    mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
-    for (auto partIt = fragmentInfoVec_.begin() + startFragment; partIt != fragmentInfoVec_.end(); ++partIt) {
-      partIt->setPhysicalNumTuples(partIt->shadowNumTuples);
-      partIt->setChunkMetadataMap(partIt->shadowChunkMetadataMap);
-    }
+void InsertOrderFragmenter::releaseOpenFragments(std::vector<std::unique_ptr<OpenFragment>>& openFragments,
+                                                 const size_t numRows,
+                                                 const bool delta) {
+  std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+  (delta ? deltaRows_ : numTuples_) += numRows;
+  for (auto& openFragment : openFragments) {
+    releaseOpenFragment(openFragment, delta);
   }
-  numTuples_ += insertDataStruct.numRows;
-  dropFragmentsToSize(maxRows_);
+  openFragments.clear();
+  fragmentReleased_.notify_all();
 }
 
-FragmentInfo* InsertOrderFragmenter::createNewFragment(const Data_Namespace::MemoryLevel memoryLevel) {
-  // also sets the new fragment as the insertBuffer for each column
+void InsertOrderFragmenter::releaseOpenFragment(std::unique_ptr<OpenFragment>& openFragment, const bool delta) {
+  busyFragmentIds_.erase(openFragment->fragmentInfo->fragmentId);
+  auto& idleFragments = delta ? idleDeltaFragments_ : idleFragments_;
+  mapd_shared_lock<mapd_shared_mutex> readLock(fragmentInfoMutex_);
+  const auto& fragmentInfoVec = delta ? deltaFragmentInfoVec_ : fragmentInfoVec_;
+  // with virtual rowids, a fragment left behind by a newer one stays as it is, see publishOpenFragments
+  if (openFragment->fragmentInfo->shadowNumTuples < maxFragmentRows_ &&
+      (hasMaterializedRowId_ || openFragment->fragmentInfo == &fragmentInfoVec.back())) {
+    idleFragments.push_back(std::move(openFragment));
+  } else if (delta) {
+    // nothing but the pins keeps the buffers of a delta fragment in memory
+    fullDeltaFragments_.push_back(std::move(openFragment));
+  }
+  // the other ones unpin their buffers here
+  openFragment.reset();
+}
+
+std::unique_ptr<InsertOrderFragmenter::OpenFragment> InsertOrderFragmenter::acquireOpenFragment(const bool delta) {
+  {
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    auto& idleFragments = delta ? idleDeltaFragments_ : idleFragments_;
+    if (!idleFragments.empty()) {
+      auto openFragment = std::move(idleFragments.back());
+      idleFragments.pop_back();
+      busyFragmentIds_.insert(openFragment->fragmentInfo->fragmentId);
+      return openFragment;
+    }
+  }
+  return createNewFragment(delta ? Data_Namespace::CPU_LEVEL : defaultInsertLevel_, delta);
+}
 
+std::unique_ptr<InsertOrderFragmenter::OpenFragment> InsertOrderFragmenter::createNewFragment(
+    const Data_Namespace::MemoryLevel memoryLevel,
+    const bool delta) {
+  // fragment ids are handed out in the order the fragments are published
+  std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+  if (!hasMaterializedRowId_) {
+    // with virtual rowids, the idle fragments are left behind by the new one and never grow again
+    auto& idleFragments = delta ? idleDeltaFragments_ : idleFragments_;
+    if (delta) {
+      for (auto& openFragment : idleFragments) {
+        fullDeltaFragments_.push_back(std::move(openFragment));
+      }
+    }
+    idleFragments.clear();
+  }
   maxFragmentId_++;
   FragmentInfo newFragmentInfo;
   newFragmentInfo.fragmentId = maxFragmentId_;
@@ -359,20 +1099,26 @@ FragmentInfo* InsertOrderFragmenter::createNewFragment(const Data_Namespace::Mem
   }
   newFragmentInfo.physicalTableId = physicalTableId_;
   newFragmentInfo.shard = shard_;
+  newFragmentInfo.isDelta = delta;
 
-  for (map<int, Chunk>::iterator colMapIt = columnMap_.begin(); colMapIt != columnMap_.end(); ++colMapIt) {
-    // colMapIt->second.unpin_buffer();
+  std::unique_ptr<OpenFragment> openFragment(new OpenFragment());
+  openFragment->varLenBytes = varLenColInfo_;
+  for (const auto& col : columnMap_) {
     ChunkKey chunkKey = chunkKeyPrefix_;
-    chunkKey.push_back(colMapIt->second.get_column_desc()->columnId);
+    chunkKey.push_back(col.first);
     chunkKey.push_back(maxFragmentId_);
-    colMapIt->second.createChunkBuffer(
+    auto& chunk = openFragment->chunks.emplace(col.first, Chunk(col.second.get_column_desc())).first->second;
+    chunk.createChunkBuffer(
         dataMgr_, chunkKey, memoryLevel, newFragmentInfo.deviceIds[static_cast<int>(memoryLevel)], pageSize_);
-    colMapIt->second.init_encoder();
+    chunk.init_encoder();
   }
 
   mapd_lock_guard<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
-  fragmentInfoVec_.push_back(newFragmentInfo);
-  return &(fragmentInfoVec_.back());
+  auto& fragmentInfoVec = delta ? deltaFragmentInfoVec_ : fragmentInfoVec_;
+  fragmentInfoVec.push_back(newFragmentInfo);
+  openFragment->fragmentInfo = &(fragmentInfoVec.back());
+  busyFragmentIds_.insert(maxFragmentId_);
+  return openFragment;
 }
 
 TableInfo InsertOrderFragmenter::getFragmentsForQuery() {
@@ -381,7 +1127,7 @@ TableInfo InsertOrderFragmenter::getFragmentsForQuery() {
   queryInfo.chunkKeyPrefix = chunkKeyPrefix_;
   // right now we don't test predicate, so just return (copy of) all fragments
   bool fragmentsExist = false;
-  if (fragmentInfoVec_.empty()) {
+  if (fragmentInfoVec_.empty() && deltaFragmentInfoVec_.empty()) {
     // If we have no fragments add a dummy empty fragment to make the executor
     // not have separate logic for 0-row tables
     int maxFragmentId = 0;
@@ -396,6 +1142,8 @@ TableInfo InsertOrderFragmenter::getFragmentsForQuery() {
   } else {
     fragmentsExist = true;
     queryInfo.fragments = fragmentInfoVec_;  // makes a copy
+    // the rows in the delta store come last, as they would once merged
+    queryInfo.fragments.insert(queryInfo.fragments.end(), deltaFragmentInfoVec_.begin(), deltaFragmentInfoVec_.end());
   }
   readLock.unlock();
   queryInfo.setPhysicalNumTuples(0);
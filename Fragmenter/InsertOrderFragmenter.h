@@ -27,10 +27,16 @@
 #include "../DataMgr/MemoryLevel.h"
 #include "../Chunk/Chunk.h"
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <vector>
 #include <map>
+#include <memory>
+#include <set>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
 
 namespace Data_Namespace {
 class DataMgr;
@@ -41,7 +47,17 @@ class DataMgr;
 #define DEFAULT_MAX_ROWS (1L) << 62        // in rows
 #define DEFAULT_MAX_CHUNK_SIZE 1073741824  // in bytes
 
+// Keep the rows of inserts into disk tables in memory at first, merging them into the fragments in large batches.
+extern bool g_enable_delta_store;
+// Rows the delta store of a table holds before they're merged in the background.
+extern size_t g_delta_store_merge_rows;
+// Milliseconds after which the rows in a delta store are merged, however few.
+extern size_t g_delta_store_merge_ms;
+
 namespace Fragmenter_Namespace {
+
+class InsertWal;
+
 /**
  * @type InsertOrderFragmenter
  * @brief	The InsertOrderFragmenter is a child class of
@@ -63,7 +79,8 @@ class InsertOrderFragmenter : public AbstractFragmenter {
                         const size_t maxChunkSize = DEFAULT_MAX_CHUNK_SIZE,
                         const size_t pageSize = DEFAULT_PAGE_SIZE /*default 1MB*/,
                         const size_t maxRows = DEFAULT_MAX_ROWS,
-                        const Data_Namespace::MemoryLevel defaultInsertLevel = Data_Namespace::DISK_LEVEL);
+                        const Data_Namespace::MemoryLevel defaultInsertLevel = Data_Namespace::DISK_LEVEL,
+                        const int sortedColumnId = 0);
 
   virtual ~InsertOrderFragmenter();
   /**
@@ -87,6 +104,8 @@ class InsertOrderFragmenter : public AbstractFragmenter {
   virtual void insertDataNoCheckpoint(InsertData& insertDataStruct);
 
   virtual void dropFragmentsToSize(const size_t maxRows);
+
+  virtual void mergeDeltaStore();
   /**
    * @brief get fragmenter's id
    */
@@ -141,6 +160,36 @@ class InsertOrderFragmenter : public AbstractFragmenter {
 
   virtual void updateMetadata(const Catalog_Namespace::Catalog* catalog, const MetaDataKey& key, UpdelRoll& updelRoll);
 
+  virtual size_t vacuumDeletedRows(const Catalog_Namespace::Catalog* catalog,
+                                   const TableDescriptor* td,
+                                   const double minDeletedFraction,
+                                   UpdelRoll& updelRoll);
+
+  virtual size_t reclusterRows(const Catalog_Namespace::Catalog* catalog,
+                               const TableDescriptor* td,
+                               UpdelRoll& updelRoll);
+
+  /**
+   * @brief rewrites every physical column of a fragment
+   * without the rows at the given (ascending) offsets
+   */
+  void compactRows(const Catalog_Namespace::Catalog* catalog,
+                   const TableDescriptor* td,
+                   const int fragmentId,
+                   const std::vector<uint64_t>& fragOffsets,
+                   const Data_Namespace::MemoryLevel memoryLevel,
+                   UpdelRoll& updelRoll);
+
+  /**
+   * @brief rewrites the rows of the given fragments sorted
+   * on the sort column, packed into as few of them as they
+   * fill in fragment order, leaving the rest empty
+   */
+  void mergeFragments(const Catalog_Namespace::Catalog* catalog,
+                      const TableDescriptor* td,
+                      const std::vector<FragmentInfo*>& fragments,
+                      UpdelRoll& updelRoll);
+
  private:
   std::vector<int> chunkKeyPrefix_;
   std::map<int, Chunk_NS::Chunk> columnMap_; /**< stores a map of column id to metadata about that column */
@@ -158,28 +207,149 @@ class InsertOrderFragmenter : public AbstractFragmenter {
   size_t maxRows_;
   std::string fragmenterType_;
   mapd_shared_mutex fragmentInfoMutex_;  // to prevent read-write conflicts for fragmentInfoVec_
-  mapd_shared_mutex insertMutex_;  // to prevent race conditions on insert - only one insert statement should be going
-                                   // to a table at a time
+  mapd_shared_mutex insertMutex_;  // shared by the writers, exclusive for checkpoints and metadata updates
   Data_Namespace::MemoryLevel defaultInsertLevel_;
   bool hasMaterializedRowId_;
   int rowIdColId_;
-  std::unordered_map<int, size_t> varLenColInfo_;
+  std::unordered_map<int, size_t> varLenColInfo_;  // variable length columns, all with zero bytes
+
+  /**
+   * @brief a fragment which isn't full, with the insert
+   * buffers of its columns. Only the writer holding it
+   * appends to it.
+   */
+  struct OpenFragment {
+    FragmentInfo* fragmentInfo;
+    std::map<int, Chunk_NS::Chunk> chunks;
+    std::unordered_map<int, size_t> varLenBytes;  // bytes in the buffer of each variable length column
+  };
+  std::mutex openFragmentsMutex_;  // guards the open fragments, maxFragmentId_ and numTuples_
+  std::condition_variable fragmentReleased_;  // a writer released a fragment, for the ordered publishing
+  std::vector<std::unique_ptr<OpenFragment>> idleFragments_;
+  std::set<int> busyFragmentIds_;  // held by a writer, their rows aren't published yet
+  std::atomic<uint64_t> insertCount_;
+  uint64_t checkpointedInsertCount_;  // inserts covered by the last checkpoint, under the exclusive insert lock
+  const int sortedColumnId_;  // column inserted batches are sorted on, 0 if none
+  std::deque<FragmentInfo> deltaFragmentInfoVec_;  // of the delta store, scanned after the others
+  std::vector<std::unique_ptr<OpenFragment>> idleDeltaFragments_;
+  std::vector<std::unique_ptr<OpenFragment>> fullDeltaFragments_;  // full or left behind, pinned until the merge
+  std::vector<std::vector<int8_t>> deltaInserts_;  // the rows of the delta store as logged inserts, for the merge
+  size_t deltaRows_;                               // under openFragmentsMutex_
+  size_t deltaAppends_;    // delta inserts under way, under openFragmentsMutex_
+  size_t regularAppends_;  // appends to the fragments under way, the delta store stays empty meanwhile
+  std::mutex deltaMergeMutex_;
+  std::chrono::steady_clock::time_point lastDeltaMerge_;
+  std::future<void> deltaMerge_;  // background merge of the delta store
+  std::unique_ptr<InsertWal> wal_;  // inserts since the last checkpoint, set for disk tables when logging is enabled
+  std::mutex walCheckpointMutex_;
+  std::chrono::steady_clock::time_point lastWalCheckpoint_;
+  std::future<void> walCheckpoint_;  // background checkpoint which truncates the log
+  std::atomic<bool> stopWalCheckpoint_;  // the fragmenter is going away, a pending checkpoint gives up
 
   /**
    * @brief creates new fragment, calling createChunk()
    * method of BufferMgr to make a new chunk for each column
-   * of the table.
-   *
-   * Also unpins the chunks of the previous insert buffer
+   * of the table, and hands it to the calling writer
+   */
+
+  std::unique_ptr<OpenFragment> createNewFragment(
+      const Data_Namespace::MemoryLevel memoryLevel = Data_Namespace::DISK_LEVEL,
+      const bool delta = false);
+
+  /**
+   * @brief hands an idle open fragment to the calling
+   * writer, or a new one if all of them are held
+   */
+  std::unique_ptr<OpenFragment> acquireOpenFragment(const bool delta);
+
+  /**
+   * @brief appends the data to the last of the open fragments
+   * the writer holds, then to idle or new ones as they fill up
+   */
+  void appendToOpenFragments(InsertData& insertDataStruct,
+                             std::vector<std::unique_ptr<OpenFragment>>& openFragments,
+                             const bool delta);
+
+  /**
+   * @brief hands the open fragments a writer has published
+   * rows to back to the others, once their rows are counted
    */
+  void releaseOpenFragments(std::vector<std::unique_ptr<OpenFragment>>& openFragments,
+                            const size_t numRows,
+                            const bool delta);
 
-  FragmentInfo* createNewFragment(const Data_Namespace::MemoryLevel memoryLevel = Data_Namespace::DISK_LEVEL);
+  /**
+   * @brief hands an open fragment back to the others,
+   * called with openFragmentsMutex_ held
+   */
+  void releaseOpenFragment(std::unique_ptr<OpenFragment>& openFragment, const bool delta);
+
+  /**
+   * @brief publishes the rows of the open fragments a
+   * writer filled and releases them, each one once no
+   * earlier fragment is held by another writer if the
+   * rowids of the table are virtual
+   */
+  void publishOpenFragments(std::vector<std::unique_ptr<OpenFragment>>& openFragments,
+                            const size_t numRows,
+                            const bool delta);
   void deleteFragments(const std::vector<int>& dropFragIds);
 
   void getChunkMetadata();
 
+  FragmentInfo& getFragmentInfoFromId(const int fragmentId);
+  std::vector<uint64_t> getVacuumOffsets(const std::shared_ptr<Chunk_NS::Chunk>& chunk);
+
+  /**
+   * @brief returns the row order which stably sorts numRows
+   * values of the given type and width, or an empty vector
+   * if they are sorted already
+   */
+  static std::vector<size_t> getSortPermutation(const int8_t* data,
+                                                const size_t numRows,
+                                                const SQLTypeInfo& ti,
+                                                const size_t width);
+
   void lockInsertCheckpointData(const InsertData& insertDataStruct);
-  void insertDataImpl(InsertData& insertDataStruct);
+  void insertDataImpl(InsertData& insertDataStruct, const bool delta = false);
+
+  /**
+   * @brief inserts the data into the delta store, where
+   * queries see it right away, and merges the store in the
+   * background once it's large or old enough; returns false
+   * without inserting while the fragments are appended to
+   */
+  bool insertDataDelta(InsertData& insertDataStruct);
+
+  /**
+   * @brief merges the delta store before an append to the
+   * fragments, which would otherwise shift the row ids of
+   * the delta rows, and keeps it empty until endRegularAppend
+   */
+  void beginRegularAppend();
+  void endRegularAppend();
+
+  /**
+   * @brief inserts the rows of the delta store into the
+   * fragments and checkpoints them, returning the ids of
+   * the delta fragments left to delete and their buffers
+   */
+  std::vector<int> mergeDeltaStoreImpl(std::vector<std::unique_ptr<OpenFragment>>& deltaFragments);
+
+  /**
+   * @brief inserts and logs the data, returning once the
+   * log record is on disk rather than after a checkpoint
+   */
+  void insertDataLogged(InsertData& insertDataStruct);
+
+  /**
+   * @brief inserts the logged data the table lost since its
+   * last checkpoint, then checkpoints it and empties the log
+   */
+  void replayWal();
+
+  // the caller holds the insert lock
+  void checkpointWal();
 
   InsertOrderFragmenter(const InsertOrderFragmenter&);
   InsertOrderFragmenter& operator=(const InsertOrderFragmenter&);
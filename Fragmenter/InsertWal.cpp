@@ -0,0 +1,286 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InsertWal.h"
+
+#include <glog/logging.h>
+#include <boost/crc.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#define INSERT_WAL_FILENAME "insert_wal"
+
+bool g_enable_insert_wal{false};
+size_t g_insert_wal_checkpoint_bytes{size_t(256) << 20};
+size_t g_insert_wal_checkpoint_ms{10000};
+
+namespace Fragmenter_Namespace {
+
+namespace {
+
+const uint32_t kInsertWalMagic{0x4c415749};  // "IWAL"
+
+struct InsertWalRecordHeader {
+  uint32_t magic;
+  int32_t epoch;
+  uint64_t payloadSize;
+  uint32_t payloadCrc;
+  uint32_t headerCrc;  // of the fields above
+};
+static_assert(sizeof(InsertWalRecordHeader) == 24, "Unexpected padding in InsertWalRecordHeader");
+
+uint32_t header_crc(const InsertWalRecordHeader& header) {
+  boost::crc_32_type crc;
+  crc.process_bytes(&header, offsetof(InsertWalRecordHeader, headerCrc));
+  return crc.checksum();
+}
+
+uint32_t payload_crc(const int8_t* payload, const size_t size) {
+  boost::crc_32_type crc;
+  crc.process_bytes(payload, size);
+  return crc.checksum();
+}
+
+std::string wal_path(const std::string& table_dir) {
+  return table_dir + "/" + INSERT_WAL_FILENAME;
+}
+
+bool read_fully(const int fd, int8_t* buf, const size_t size, const off_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    const auto n = pread(fd, buf + done, size - done, offset + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+bool write_fully(const int fd, const int8_t* buf, const size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    const auto n = write(fd, buf + done, size - done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+std::vector<int8_t> make_record(const int32_t epoch, const std::vector<int8_t>& payload) {
+  InsertWalRecordHeader header;
+  header.magic = kInsertWalMagic;
+  header.epoch = epoch;
+  header.payloadSize = payload.size();
+  header.payloadCrc = payload_crc(payload.data(), payload.size());
+  header.headerCrc = header_crc(header);
+  std::vector<int8_t> record(sizeof(header) + payload.size());
+  memcpy(&record[0], &header, sizeof(header));
+  if (!payload.empty()) {
+    memcpy(&record[sizeof(header)], payload.data(), payload.size());
+  }
+  return record;
+}
+
+}  // namespace
+
+InsertWal::InsertWal(const std::string& table_dir)
+    : path_(wal_path(table_dir)), fd_(-1), size_(0), epoch_(-1), appended_seq_(0), durable_seq_(0), syncing_(false) {
+  fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd_ < 0) {
+    throw std::runtime_error("Could not open the insert log " + path_ + ": " + strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd_, &st)) {
+    close(fd_);
+    throw std::runtime_error("Could not stat the insert log " + path_ + ": " + strerror(errno));
+  }
+  size_ = st.st_size;
+}
+
+InsertWal::~InsertWal() {
+  close(fd_);
+}
+
+std::vector<std::vector<int8_t>> InsertWal::read(const int32_t epoch) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<int8_t>> payloads;
+  size_t offset = 0;
+  while (offset < size_) {
+    InsertWalRecordHeader header;
+    if (size_ - offset < sizeof(header) ||
+        !read_fully(fd_, reinterpret_cast<int8_t*>(&header), sizeof(header), offset) ||
+        header.magic != kInsertWalMagic || header.headerCrc != header_crc(header) ||
+        header.payloadSize > size_ - offset - sizeof(header)) {
+      break;
+    }
+    std::vector<int8_t> payload(header.payloadSize);
+    if (!read_fully(fd_, payload.data(), payload.size(), offset + sizeof(header)) ||
+        header.payloadCrc != payload_crc(payload.data(), payload.size())) {
+      break;
+    }
+    if (header.epoch == epoch) {
+      payloads.push_back(std::move(payload));
+    }
+    offset += sizeof(header) + header.payloadSize;
+  }
+  if (offset < size_) {
+    // an append interrupted by the crash, nothing after it was acknowledged
+    LOG(WARNING) << "Ignoring the last " << size_ - offset << " bytes of the insert log " << path_;
+  }
+  return payloads;
+}
+
+uint64_t InsertWal::append(const int32_t epoch, const std::vector<int8_t>& payload) {
+  const auto record = make_record(epoch, payload);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (epoch_ != epoch && size_) {
+    // somebody else checkpointed the table since, the records are in the chunks already
+    truncateLocked();
+  }
+  if (!write_fully(fd_, record.data(), record.size())) {
+    const std::string error = strerror(errno);
+    // don't leave a torn record in front of the next ones
+    if (ftruncate(fd_, size_)) {
+      LOG(FATAL) << "Could not roll back a partial append to the insert log " << path_;
+    }
+    throw std::runtime_error("Could not append to the insert log " + path_ + ": " + error);
+  }
+  size_ += record.size();
+  epoch_ = epoch;
+  return ++appended_seq_;
+}
+
+void InsertWal::sync(const uint64_t seq) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (durable_seq_ < seq) {
+    if (syncing_) {
+      durable_cv_.wait(lock);
+      continue;
+    }
+    syncing_ = true;
+    const auto target_seq = appended_seq_;
+    lock.unlock();
+#ifdef __APPLE__
+    const int status = fcntl(fd_, F_FULLFSYNC);
+#else
+    const int status = fdatasync(fd_);
+#endif
+    const int error = status ? errno : 0;
+    lock.lock();
+    syncing_ = false;
+    durable_cv_.notify_all();
+    if (status) {
+      throw std::runtime_error("Could not sync the insert log " + path_ + ": " + strerror(error));
+    }
+    durable_seq_ = std::max(durable_seq_, target_seq);
+  }
+}
+
+void InsertWal::truncate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  truncateLocked();
+}
+
+void InsertWal::truncateLocked() {
+  if (ftruncate(fd_, 0)) {
+    LOG(FATAL) << "Could not truncate the insert log " << path_ << ": " << strerror(errno);
+  }
+  size_ = 0;
+  epoch_ = -1;
+  // the checkpoint made every record appended so far durable
+  durable_seq_ = appended_seq_;
+  durable_cv_.notify_all();
+}
+
+size_t InsertWal::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return size_;
+}
+
+bool InsertWal::exists(const std::string& table_dir) {
+  struct stat st;
+  return !stat(wal_path(table_dir).c_str(), &st) && st.st_size > 0;
+}
+
+void InsertWal::remove(const std::string& table_dir) {
+  const auto path = wal_path(table_dir);
+  if (unlink(path.c_str()) && errno != ENOENT) {
+    LOG(WARNING) << "Could not remove the insert log " << path << ": " << strerror(errno);
+  }
+}
+
+void InsertWal::rebase(const std::string& table_dir, const int32_t from_epoch, const int32_t to_epoch) {
+  if (!exists(table_dir)) {
+    return;
+  }
+  std::vector<std::vector<int8_t>> payloads;
+  {
+    InsertWal wal(table_dir);
+    payloads = wal.read(from_epoch);
+  }
+  if (payloads.empty()) {
+    remove(table_dir);
+    return;
+  }
+  // the old log stays in place until the new one is complete and on disk
+  const auto path = wal_path(table_dir);
+  const auto tmp_path = path + ".tmp";
+  const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open the insert log " + tmp_path + ": " + strerror(errno));
+  }
+  bool ok = true;
+  for (const auto& payload : payloads) {
+    const auto record = make_record(to_epoch, payload);
+    if (!write_fully(fd, record.data(), record.size())) {
+      ok = false;
+      break;
+    }
+  }
+#ifdef __APPLE__
+  ok = ok && !fcntl(fd, F_FULLFSYNC);
+#else
+  ok = ok && !fdatasync(fd);
+#endif
+  const std::string error = ok ? "" : strerror(errno);
+  close(fd);
+  if (!ok || rename(tmp_path.c_str(), path.c_str())) {
+    unlink(tmp_path.c_str());
+    throw std::runtime_error("Could not rewrite the insert log " + path + ": " + (ok ? strerror(errno) : error));
+  }
+  LOG(INFO) << "Kept " << payloads.size() << " logged inserts of " << path << " across the rollback to epoch "
+            << to_epoch;
+}
+
+}  // namespace Fragmenter_Namespace
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    InsertWal.h
+ * @brief   Append-only log of the inserts into a disk table since its last checkpoint.
+ *
+ * Each record is tagged with the table epoch it was inserted in. The records of the epoch a table reopens
+ * at were never checkpointed into its chunks, so they are replayed; older ones are left behind by a crash
+ * between a checkpoint and the truncation of the log.
+ */
+
+#ifndef FRAGMENTER_INSERTWAL_H
+#define FRAGMENTER_INSERTWAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Log the inserts into disk tables and commit them with a shared fsync instead of a table checkpoint per insert.
+extern bool g_enable_insert_wal;
+// Bytes a table log grows to before it's checkpointed into the chunks of the table in the background.
+extern size_t g_insert_wal_checkpoint_bytes;
+// Milliseconds since the last checkpoint after which the next insert checkpoints the log in the background.
+extern size_t g_insert_wal_checkpoint_ms;
+
+namespace Fragmenter_Namespace {
+
+class InsertWal {
+ public:
+  // Opens the log in the directory of a table, creating it if needed.
+  InsertWal(const std::string& table_dir);
+
+  ~InsertWal();
+
+  // Payloads of the records of the given epoch, up to the first torn or corrupt record.
+  std::vector<std::vector<int8_t>> read(const int32_t epoch) const;
+
+  // Hands the record to the OS and returns its sequence number, sync() makes it durable.
+  uint64_t append(const int32_t epoch, const std::vector<int8_t>& payload);
+
+  // Waits until the record with the given sequence number is on disk. Every fsync covers all the records
+  // appended before it started, so the committers waiting meanwhile share the next one.
+  void sync(const uint64_t seq);
+
+  // Drops every record, the caller has checkpointed the table past them.
+  void truncate();
+
+  size_t size() const;
+
+  static bool exists(const std::string& table_dir);
+
+  static void remove(const std::string& table_dir);
+
+  // Keeps the records of from_epoch, restamped with to_epoch, and drops the others. When the table is rolled
+  // back to to_epoch, the inserts acknowledged since its last checkpoint get replayed instead of lost.
+  static void rebase(const std::string& table_dir, const int32_t from_epoch, const int32_t to_epoch);
+
+ private:
+  void truncateLocked();
+
+  std::string path_;
+  int fd_;
+  size_t size_;
+  int32_t epoch_;  // of the records in the log, -1 while it's empty
+  uint64_t appended_seq_;
+  uint64_t durable_seq_;
+  bool syncing_;
+  mutable std::mutex mutex_;
+  std::condition_variable durable_cv_;
+};
+
+}  // namespace Fragmenter_Namespace
+
+#endif  // FRAGMENTER_INSERTWAL_H
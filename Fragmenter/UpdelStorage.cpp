@@ -13,17 +13,24 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <cstring>
+#include <future>
 #include <mutex>
 #include <string>
 #include <vector>
 #include <limits>
 #include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <set>
 #include <boost/variant.hpp>
 #include <boost/variant/get.hpp>
 
 #include "Fragmenter/InsertOrderFragmenter.h"
 #include "Shared/TypedDataAccessors.h"
+#include "Shared/checked_alloc.h"
 #include "Shared/thread_count.h"
+#include "DataMgr/ArrayNoneEncoder.h"
 #include "DataMgr/DataMgr.h"
 #include "Catalog/Catalog.h"
 
@@ -45,6 +52,23 @@ void InsertOrderFragmenter::updateColumn(const Catalog_Namespace::Catalog* catal
   td->fragmenter->updateColumn(catalog, td, cd, fragmentId, fragOffsets, rhsValues, rhsType, memoryLevel, updelRoll);
 }
 
+FragmentInfo& InsertOrderFragmenter::getFragmentInfoFromId(const int fragmentId) {
+  auto fragment_it = std::find_if(fragmentInfoVec_.begin(), fragmentInfoVec_.end(), [=](FragmentInfo& f) -> bool {
+    return f.fragmentId == fragmentId;
+  });
+  if (fragment_it == fragmentInfoVec_.end()) {
+    mapd_shared_lock<mapd_shared_mutex> readLock(fragmentInfoMutex_);
+    if (std::any_of(deltaFragmentInfoVec_.begin(), deltaFragmentInfoVec_.end(), [=](const FragmentInfo& f) {
+          return f.fragmentId == fragmentId;
+        })) {
+      // inserted after the statement merged the delta store, Executor::executeUpdate doesn't scan them
+      throw std::runtime_error("Rows inserted during the update or delete can't be modified by it, please retry.");
+    }
+  }
+  CHECK(fragment_it != fragmentInfoVec_.end());
+  return *fragment_it;
+}
+
 inline bool is_integral(const SQLTypeInfo& t) {
   return t.is_integer() || t.is_boolean() || t.is_time() || t.is_timeinterval();
 }
@@ -88,11 +112,7 @@ void InsertOrderFragmenter::updateColumn(const Catalog_Namespace::Catalog* catal
     return;
   CHECK(nrow == nval || 1 == nval);
 
-  auto fragment_it = std::find_if(fragmentInfoVec_.begin(), fragmentInfoVec_.end(), [=](FragmentInfo& f) -> bool {
-    return f.fragmentId == fragmentId;
-  });
-  CHECK(fragment_it != fragmentInfoVec_.end());
-  auto& fragment = *fragment_it;
+  auto& fragment = getFragmentInfoFromId(fragmentId);
   auto chunk_meta_it = fragment.getChunkMetadataMapPhysical().find(cd->columnId);
   CHECK(chunk_meta_it != fragment.getChunkMetadataMapPhysical().end());
   ChunkKey chunk_key{catalog->get_currentDB().dbId, td->tableId, cd->columnId, fragment.fragmentId};
@@ -333,23 +353,502 @@ void InsertOrderFragmenter::updateColumnMetadata(const ColumnDescriptor* cd,
 void InsertOrderFragmenter::updateMetadata(const Catalog_Namespace::Catalog* catalog,
                                            const MetaDataKey& key,
                                            UpdelRoll& updelRoll) {
+  // numTuples_ and varLenColInfo_ shrink when a fragment was vacuumed
+  mapd_unique_lock<mapd_shared_mutex> insertLock(insertMutex_);
   mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
   if (updelRoll.chunkMetadata.count(key)) {
     auto& fragmentInfo = *key.second;
     const auto& chunkMetadata = updelRoll.chunkMetadata[key];
     fragmentInfo.shadowChunkMetadataMap = chunkMetadata;
     fragmentInfo.setChunkMetadataMap(chunkMetadata);
+    // merged fragments can grow, the table as a whole only shrinks
+    numTuples_ = numTuples_ + updelRoll.numTuples[key] - fragmentInfo.shadowNumTuples;
     fragmentInfo.shadowNumTuples = updelRoll.numTuples[key];
     fragmentInfo.setPhysicalNumTuples(fragmentInfo.shadowNumTuples);
-    // TODO(ppan): When fragment-level compaction is enable, the following code should suffice.
-    // When not (ie. existing code), we'll revert to update InsertOrderFragmenter::varLenColInfo_
-    /*
-    for (const auto cit : chunkMetadata) {
-      const auto& cd = *catalog->getMetadataForColumn(td->tableId, cit.first);
-      if (cd.columnType.get_size() < 0)
-        fragmentInfo.varLenColInfox[cd.columnId] = cit.second.numBytes;
+    // no writer holds an open fragment under the exclusive lock, the idle ones have stale byte counters
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    for (auto& openFragment : idleFragments_) {
+      if (openFragment->fragmentInfo != &fragmentInfo)
+        continue;
+      for (auto& varLenBytesIt : openFragment->varLenBytes) {
+        const auto cit = chunkMetadata.find(varLenBytesIt.first);
+        if (cit != chunkMetadata.end())
+          varLenBytesIt.second = cit->second.numBytes;
+      }
+    }
+  }
+}
+
+std::vector<uint64_t> InsertOrderFragmenter::getVacuumOffsets(const std::shared_ptr<Chunk_NS::Chunk>& chunk) {
+  const auto data_buffer = chunk->get_buffer();
+  const auto data_addr = data_buffer->getMemoryPtr();
+  // the deleted column is a boolean, one byte per row
+  const size_t nrows_in_chunk = data_buffer->size();
+  const size_t ncore = cpu_threads();
+  const size_t segsz = (nrows_in_chunk + ncore - 1) / ncore;
+  std::vector<std::vector<uint64_t>> deleted_offsets(ncore);
+  std::vector<std::future<void>> threads;
+  for (size_t rbegin = 0, c = 0; rbegin < nrows_in_chunk; ++c, rbegin += segsz) {
+    threads.emplace_back(std::async(std::launch::async, [=, &deleted_offsets] {
+      const auto rend = std::min<size_t>(rbegin + segsz, nrows_in_chunk);
+      for (size_t r = rbegin; r < rend; ++r)
+        if (data_addr[r])
+          deleted_offsets[c].push_back(r);
+    }));
+  }
+  for (auto& t : threads)
+    t.get();
+  std::vector<uint64_t> all_deleted_offsets;
+  for (const auto& offsets : deleted_offsets)
+    all_deleted_offsets.insert(all_deleted_offsets.end(), offsets.begin(), offsets.end());
+  return all_deleted_offsets;
+}
+
+// Moves the blocks of rows surviving between the vacuumed offsets to the front of the
+// buffer and returns the number of bytes kept.
+static size_t vacuum_fixlen_rows(const size_t nrows_in_fragment,
+                                 const std::shared_ptr<Chunk_NS::Chunk>& chunk,
+                                 const std::vector<uint64_t>& frag_offsets) {
+  const auto element_size = chunk->get_column_desc()->columnType.get_size();
+  auto data_addr = chunk->get_buffer()->getMemoryPtr();
+  size_t irow_of_blk_to_keep = 0;  // head of the next block of rows to keep
+  size_t irow_of_blk_to_fill = 0;  // where that block moves to
+  for (size_t i = 0; i <= frag_offsets.size(); ++i) {
+    const size_t irow_to_vacuum = i == frag_offsets.size() ? nrows_in_fragment : frag_offsets[i];
+    CHECK_GE(irow_to_vacuum, irow_of_blk_to_keep);
+    const size_t nrows_to_keep = irow_to_vacuum - irow_of_blk_to_keep;
+    if (nrows_to_keep > 0 && irow_of_blk_to_fill != irow_of_blk_to_keep)
+      std::memmove(data_addr + irow_of_blk_to_fill * element_size,
+                   data_addr + irow_of_blk_to_keep * element_size,
+                   nrows_to_keep * element_size);
+    irow_of_blk_to_fill += nrows_to_keep;
+    irow_of_blk_to_keep = irow_to_vacuum + 1;
+  }
+  return irow_of_blk_to_fill * element_size;
+}
+
+// Same as above for a varlen column, whose index buffer is rebased on the moved payload.
+// Returns the number of payload bytes kept.
+static size_t vacuum_varlen_rows(const size_t nrows_in_fragment,
+                                 const std::shared_ptr<Chunk_NS::Chunk>& chunk,
+                                 const std::vector<uint64_t>& frag_offsets) {
+  auto data_addr = chunk->get_buffer()->getMemoryPtr();
+  auto index_array = reinterpret_cast<StringOffsetT*>(chunk->get_index_buf()->getMemoryPtr());
+  size_t irow_of_blk_to_keep = 0;
+  size_t irow_of_blk_to_fill = 0;
+  size_t nbytes_var_data_to_keep = 0;
+  for (size_t i = 0; i <= frag_offsets.size(); ++i) {
+    const size_t irow_to_vacuum = i == frag_offsets.size() ? nrows_in_fragment : frag_offsets[i];
+    CHECK_GE(irow_to_vacuum, irow_of_blk_to_keep);
+    const size_t nrows_to_keep = irow_to_vacuum - irow_of_blk_to_keep;
+    if (nrows_to_keep > 0) {
+      const auto ibyte_var_data_to_keep = index_array[irow_of_blk_to_keep];
+      const auto nbytes_to_keep = index_array[irow_to_vacuum] - ibyte_var_data_to_keep;
+      if (irow_of_blk_to_fill != irow_of_blk_to_keep) {
+        std::memmove(data_addr + nbytes_var_data_to_keep, data_addr + ibyte_var_data_to_keep, nbytes_to_keep);
+        // offsets are moved forward only, so none is overwritten before it is read
+        for (size_t r = 1; r <= nrows_to_keep; ++r)
+          index_array[irow_of_blk_to_fill + r] =
+              index_array[irow_of_blk_to_keep + r] - ibyte_var_data_to_keep + nbytes_var_data_to_keep;
+      }
+      nbytes_var_data_to_keep += nbytes_to_keep;
+    }
+    irow_of_blk_to_fill += nrows_to_keep;
+    irow_of_blk_to_keep = irow_to_vacuum + 1;
+  }
+  // an empty chunk has no initial 0 offset either, or the next append would add a second one
+  chunk->get_index_buf()->setSize(irow_of_blk_to_fill ? (irow_of_blk_to_fill + 1) * sizeof(StringOffsetT) : 0);
+  return nbytes_var_data_to_keep;
+}
+
+void InsertOrderFragmenter::compactRows(const Catalog_Namespace::Catalog* catalog,
+                                        const TableDescriptor* td,
+                                        const int fragmentId,
+                                        const std::vector<uint64_t>& fragOffsets,
+                                        const Data_Namespace::MemoryLevel memoryLevel,
+                                        UpdelRoll& updelRoll) {
+  auto& fragment = getFragmentInfoFromId(fragmentId);
+  const auto nrows_in_fragment = fragment.getPhysicalNumTuples();
+  CHECK_LE(fragOffsets.size(), nrows_in_fragment);
+  if (fragOffsets.empty())
+    return;
+
+  updelRoll.catalog = catalog;
+  updelRoll.logicalTableId = catalog->getLogicalTableId(td->tableId);
+  updelRoll.memoryLevel = memoryLevel;
+
+  std::vector<std::shared_ptr<Chunk_NS::Chunk>> chunks;
+  for (const auto& cm : fragment.getChunkMetadataMapPhysical()) {
+    const auto cd = catalog->getMetadataForColumn(td->tableId, cm.first);
+    CHECK(cd);
+    ChunkKey chunk_key{catalog->get_currentDB().dbId, td->tableId, cd->columnId, fragment.fragmentId};
+    chunks.push_back(Chunk_NS::Chunk::getChunk(cd,
+                                               &catalog->get_dataMgr(),
+                                               chunk_key,
+                                               Data_Namespace::CPU_LEVEL,
+                                               0,
+                                               cm.second.numBytes,
+                                               cm.second.numElements));
+  }
+
+  // each column is compacted independently
+  const auto nrows_to_keep = nrows_in_fragment - fragOffsets.size();
+  std::vector<std::future<void>> threads;
+  std::exception_ptr failed_any_chunk;
+  auto wait_cleanup_threads = [&] {
+    try {
+      for (auto& t : threads)
+        t.wait();
+      for (auto& t : threads)
+        t.get();
+    } catch (...) {
+      failed_any_chunk = std::current_exception();
     }
-    */
+    threads.clear();
+  };
+  for (const auto& chunk : chunks) {
+    threads.emplace_back(std::async(std::launch::async, [=, &fragOffsets, &updelRoll] {
+      const auto cd = chunk->get_column_desc();
+      auto data_buffer = chunk->get_buffer();
+      if (cd->columnType.is_varlen()) {
+        data_buffer->setSize(vacuum_varlen_rows(nrows_in_fragment, chunk, fragOffsets));
+        chunk->get_index_buf()->setUpdated();
+        // no cheap way to tighten varlen stats, the old ones still hold for the surviving rows
+        data_buffer->encoder->numElems = nrows_to_keep;
+      } else {
+        data_buffer->setSize(vacuum_fixlen_rows(nrows_in_fragment, chunk, fragOffsets));
+        data_buffer->encoder->resetStats(data_buffer->getMemoryPtr(), nrows_to_keep);
+      }
+      data_buffer->setUpdated();
+
+      std::lock_guard<std::mutex> lck(updelRoll.mutex);
+      if (updelRoll.dirtyChunks.count(chunk.get()) == 0)
+        updelRoll.dirtyChunks.emplace(chunk.get(), chunk);
+      ChunkKey chunkey{catalog->get_currentDB().dbId, cd->tableId, cd->columnId, fragmentId};
+      updelRoll.dirtyChunkeys.insert(chunkey);
+    }));
+    if (threads.size() >= (size_t)cpu_threads())
+      wait_cleanup_threads();
+    if (failed_any_chunk)
+      break;
+  }
+  wait_cleanup_threads();
+  if (failed_any_chunk)
+    std::rethrow_exception(failed_any_chunk);
+
+  auto key = std::make_pair(td, &fragment);
+  std::lock_guard<std::mutex> lck(updelRoll.mutex);
+  if (0 == updelRoll.chunkMetadata.count(key))
+    updelRoll.chunkMetadata[key] = fragment.getChunkMetadataMapPhysical();
+  auto& chunkMetadata = updelRoll.chunkMetadata[key];
+  for (const auto& chunk : chunks)
+    chunk->get_buffer()->encoder->getMetadata(chunkMetadata[chunk->get_column_desc()->columnId]);
+  updelRoll.numTuples[key] = nrows_to_keep;
+}
+
+size_t InsertOrderFragmenter::vacuumDeletedRows(const Catalog_Namespace::Catalog* catalog,
+                                                const TableDescriptor* td,
+                                                const double minDeletedFraction,
+                                                UpdelRoll& updelRoll) {
+  const auto cd = catalog->getDeletedColumn(td);
+  if (!cd)
+    return 0;
+  std::vector<int> fragmentIds;
+  {
+    mapd_shared_lock<mapd_shared_mutex> readLock(fragmentInfoMutex_);
+    for (const auto& fragment : fragmentInfoVec_) {
+      const auto& chunkMetadataMap = fragment.getChunkMetadataMapPhysical();
+      const auto chunk_meta_it = chunkMetadataMap.find(cd->columnId);
+      // the max of the deleted column tells fragments with no deleted rows without reading them
+      if (chunk_meta_it != chunkMetadataMap.end() && chunk_meta_it->second.chunkStats.max.tinyintval > 0)
+        fragmentIds.push_back(fragment.fragmentId);
+    }
+  }
+
+  size_t nrows_vacuumed = 0;
+  for (const auto fragmentId : fragmentIds) {
+    auto& fragment = getFragmentInfoFromId(fragmentId);
+    const auto nrows_in_fragment = fragment.getPhysicalNumTuples();
+    const auto& chunk_meta = fragment.getChunkMetadataMapPhysical().find(cd->columnId)->second;
+    ChunkKey chunk_key{catalog->get_currentDB().dbId, td->tableId, cd->columnId, fragmentId};
+    auto chunk = Chunk_NS::Chunk::getChunk(cd,
+                                           &catalog->get_dataMgr(),
+                                           chunk_key,
+                                           Data_Namespace::CPU_LEVEL,
+                                           0,
+                                           chunk_meta.numBytes,
+                                           chunk_meta.numElements);
+    const auto fragOffsets = getVacuumOffsets(chunk);
+    if (fragOffsets.empty() || fragOffsets.size() < minDeletedFraction * nrows_in_fragment)
+      continue;
+    compactRows(catalog, td, fragmentId, fragOffsets, Data_Namespace::CPU_LEVEL, updelRoll);
+    nrows_vacuumed += fragOffsets.size();
+  }
+  return nrows_vacuumed;
+}
+
+namespace {
+
+// Fragments hold at most this many fragments' worth of rows when merged, which bounds what a merge loads at once.
+const size_t kMaxMergeFragments{4};
+
+// The min of a chunk on the sort column, to put fragments in the order of their keys.
+double min_sort_key(const ChunkStats& stats, const SQLTypeInfo& ti) {
+  switch (ti.get_type()) {
+    case kBOOLEAN:
+    case kTINYINT:
+      return stats.min.tinyintval;
+    case kSMALLINT:
+      return stats.min.smallintval;
+    case kBIGINT:
+    case kNUMERIC:
+    case kDECIMAL:
+      return stats.min.bigintval;
+    case kTIME:
+    case kTIMESTAMP:
+    case kDATE:
+      return stats.min.timeval;
+    case kFLOAT:
+      return stats.min.floatval;
+    case kDOUBLE:
+      return stats.min.doubleval;
+    default:
+      // integers and dictionary ids
+      return stats.min.intval;
+  }
+}
+
+// The payloads of the first nrows rows of a variable length chunk.
+std::vector<std::string> get_varlen_rows(const Chunk_NS::Chunk& chunk, const size_t nrows) {
+  const auto data_addr = reinterpret_cast<const char*>(chunk.get_buffer()->getMemoryPtr());
+  const auto index_array = reinterpret_cast<const StringOffsetT*>(chunk.get_index_buf()->getMemoryPtr());
+  std::vector<std::string> rows;
+  rows.reserve(nrows);
+  for (size_t r = 0; r < nrows; ++r)
+    rows.emplace_back(data_addr + index_array[r], index_array[r + 1] - index_array[r]);
+  return rows;
+}
+
+}  // namespace
+
+size_t InsertOrderFragmenter::reclusterRows(const Catalog_Namespace::Catalog* catalog,
+                                            const TableDescriptor* td,
+                                            UpdelRoll& updelRoll) {
+  if (!sortedColumnId_)
+    return 0;
+  const auto& sort_ti = columnMap_[sortedColumnId_].get_column_desc()->columnType;
+  // full fragments are left alone, and so are the ones writers append to
+  std::set<int> openFragmentIds;
+  {
+    std::lock_guard<std::mutex> openFragmentsLock(openFragmentsMutex_);
+    openFragmentIds = busyFragmentIds_;
+    for (const auto& openFragment : idleFragments_)
+      openFragmentIds.insert(openFragment->fragmentInfo->fragmentId);
+  }
+  std::vector<std::pair<double, FragmentInfo*>> candidates;
+  {
+    mapd_shared_lock<mapd_shared_mutex> readLock(fragmentInfoMutex_);
+    for (auto& fragment : fragmentInfoVec_) {
+      const auto nrows = fragment.getPhysicalNumTuples();
+      if (!nrows || nrows >= maxFragmentRows_ || openFragmentIds.count(fragment.fragmentId))
+        continue;
+      const auto& chunk_meta = fragment.getChunkMetadataMapPhysical().find(sortedColumnId_)->second;
+      candidates.emplace_back(min_sort_key(chunk_meta.chunkStats, sort_ti), &fragment);
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.first < rhs.first;
+  });
+
+  updelRoll.catalog = catalog;
+  updelRoll.logicalTableId = catalog->getLogicalTableId(td->tableId);
+  updelRoll.memoryLevel = Data_Namespace::CPU_LEVEL;
+
+  // fragments next to each other in key order are merged together, one group at a time
+  size_t nrows_merged = 0;
+  for (size_t first = 0; first < candidates.size();) {
+    std::vector<FragmentInfo*> fragments;
+    size_t nrows = 0;
+    for (; first < candidates.size(); ++first) {
+      const auto fragment_rows = candidates[first].second->getPhysicalNumTuples();
+      if (!fragments.empty() && nrows + fragment_rows > kMaxMergeFragments * maxFragmentRows_)
+        break;
+      fragments.push_back(candidates[first].second);
+      nrows += fragment_rows;
+    }
+    if (fragments.size() < 2)
+      continue;
+    // the rows go to the earliest fragments of the group
+    std::sort(fragments.begin(), fragments.end(), [](const FragmentInfo* lhs, const FragmentInfo* rhs) {
+      return lhs->fragmentId < rhs->fragmentId;
+    });
+    mergeFragments(catalog, td, fragments, updelRoll);
+    nrows_merged += nrows;
+  }
+  return nrows_merged;
+}
+
+void InsertOrderFragmenter::mergeFragments(const Catalog_Namespace::Catalog* catalog,
+                                           const TableDescriptor* td,
+                                           const std::vector<FragmentInfo*>& fragments,
+                                           UpdelRoll& updelRoll) {
+  std::vector<const ColumnDescriptor*> cds;
+  size_t sort_col_idx = 0;
+  for (const auto& cit : columnMap_) {
+    if (cit.first == sortedColumnId_)
+      sort_col_idx = cds.size();
+    cds.push_back(cit.second.get_column_desc());
+  }
+  size_t nrows = 0;
+  for (const auto fragment : fragments)
+    nrows += fragment->getPhysicalNumTuples();
+  // the sorted rows fill the fragments in order
+  std::vector<size_t> merged_rows;
+  for (size_t f = 0, nrows_left = nrows; f < fragments.size(); ++f) {
+    merged_rows.push_back(std::min(nrows_left, maxFragmentRows_));
+    nrows_left -= merged_rows.back();
+  }
+
+  // chunks[c][f] is the chunk of column cds[c] in fragment fragments[f]
+  std::vector<std::vector<std::shared_ptr<Chunk_NS::Chunk>>> chunks(cds.size());
+  for (size_t c = 0; c < cds.size(); ++c) {
+    for (const auto fragment : fragments) {
+      const auto& chunk_meta = fragment->getChunkMetadataMapPhysical().find(cds[c]->columnId)->second;
+      ChunkKey chunk_key{catalog->get_currentDB().dbId, td->tableId, cds[c]->columnId, fragment->fragmentId};
+      chunks[c].push_back(Chunk_NS::Chunk::getChunk(cds[c],
+                                                    &catalog->get_dataMgr(),
+                                                    chunk_key,
+                                                    Data_Namespace::CPU_LEVEL,
+                                                    0,
+                                                    chunk_meta.numBytes,
+                                                    chunk_meta.numElements));
+    }
+  }
+
+  // stitch the fragments of a fixed length column together, in fragment order
+  auto gather_rows = [&](const size_t c) {
+    const size_t element_size = cds[c]->columnType.get_size();
+    std::vector<int8_t> rows;
+    for (size_t f = 0; f < fragments.size(); ++f) {
+      const auto data_addr = chunks[c][f]->get_buffer()->getMemoryPtr();
+      rows.insert(rows.end(), data_addr, data_addr + fragments[f]->getPhysicalNumTuples() * element_size);
+    }
+    return rows;
+  };
+  const auto& sort_ti = cds[sort_col_idx]->columnType;
+  auto permutation = getSortPermutation(gather_rows(sort_col_idx).data(), nrows, sort_ti, sort_ti.get_size());
+  if (permutation.empty()) {
+    // in order already, the rows still get packed
+    permutation.resize(nrows);
+    std::iota(permutation.begin(), permutation.end(), 0);
+  }
+
+  // each column is rewritten independently
+  std::vector<std::future<void>> threads;
+  std::exception_ptr failed_any_column;
+  auto wait_cleanup_threads = [&] {
+    try {
+      for (auto& t : threads)
+        t.wait();
+      for (auto& t : threads)
+        t.get();
+    } catch (...) {
+      failed_any_column = std::current_exception();
+    }
+    threads.clear();
+  };
+  for (size_t c = 0; c < cds.size(); ++c) {
+    threads.emplace_back(std::async(std::launch::async, [&, c] {
+      const auto& ti = cds[c]->columnType;
+      std::vector<int8_t> fixlen_rows;
+      std::vector<std::string> varlen_rows;
+      bool has_nulls = false;
+      if (ti.is_varlen()) {
+        for (size_t f = 0; f < fragments.size(); ++f) {
+          auto rows = get_varlen_rows(*chunks[c][f], fragments[f]->getPhysicalNumTuples());
+          std::move(rows.begin(), rows.end(), std::back_inserter(varlen_rows));
+          has_nulls |= fragments[f]->getChunkMetadataMapPhysical().find(cds[c]->columnId)->second.chunkStats.has_nulls;
+        }
+      } else {
+        fixlen_rows = gather_rows(c);
+      }
+      const size_t element_size = ti.get_size();
+      size_t irow = 0;
+      for (size_t f = 0; f < fragments.size(); ++f) {
+        const auto& chunk = chunks[c][f];
+        auto data_buffer = chunk->get_buffer();
+        const auto nrows_in_fragment = merged_rows[f];
+        if (ti.is_varlen()) {
+          // the payloads are appended anew, which also recomputes the stats
+          data_buffer->setSize(0);
+          chunk->get_index_buf()->setSize(0);
+          chunk->init_encoder();
+          DataBlockPtr block;
+          std::vector<std::string> strings;
+          std::vector<ArrayDatum> arrays;
+          for (size_t r = 0; r < nrows_in_fragment; ++r, ++irow) {
+            auto& payload = varlen_rows[permutation[irow]];
+            if (ti.is_array()) {
+              int8_t* array_data = nullptr;
+              if (!payload.empty()) {
+                array_data = reinterpret_cast<int8_t*>(checked_malloc(payload.size()));
+                std::memcpy(array_data, payload.data(), payload.size());
+              }
+              arrays.emplace_back(payload.size(), array_data, false);
+            } else {
+              strings.push_back(std::move(payload));
+            }
+          }
+          if (ti.is_array()) {
+            block.arraysPtr = &arrays;
+          } else {
+            block.stringsPtr = &strings;
+          }
+          if (nrows_in_fragment)
+            chunk->appendData(block, nrows_in_fragment, 0);
+          if (ti.is_array()) {
+            // a null array has no payload to tell it from an empty one
+            dynamic_cast<ArrayNoneEncoder*>(data_buffer->encoder.get())->has_nulls |= has_nulls;
+          }
+          chunk->get_index_buf()->setUpdated();
+        } else {
+          std::vector<int8_t> sorted_rows(nrows_in_fragment * element_size);
+          for (size_t r = 0; r < nrows_in_fragment; ++r, ++irow)
+            std::memcpy(&sorted_rows[r * element_size],
+                        &fixlen_rows[permutation[irow] * element_size],
+                        element_size);
+          if (nrows_in_fragment)
+            data_buffer->write(sorted_rows.data(), sorted_rows.size(), 0);
+          data_buffer->setSize(sorted_rows.size());
+          data_buffer->encoder->resetStats(data_buffer->getMemoryPtr(), nrows_in_fragment);
+        }
+        data_buffer->setUpdated();
+
+        std::lock_guard<std::mutex> lck(updelRoll.mutex);
+        if (updelRoll.dirtyChunks.count(chunk.get()) == 0)
+          updelRoll.dirtyChunks.emplace(chunk.get(), chunk);
+        ChunkKey chunkey{catalog->get_currentDB().dbId, td->tableId, cds[c]->columnId, fragments[f]->fragmentId};
+        updelRoll.dirtyChunkeys.insert(chunkey);
+      }
+    }));
+    if (threads.size() >= (size_t)cpu_threads())
+      wait_cleanup_threads();
+    if (failed_any_column)
+      break;
+  }
+  wait_cleanup_threads();
+  if (failed_any_column)
+    std::rethrow_exception(failed_any_column);
+
+  std::lock_guard<std::mutex> lck(updelRoll.mutex);
+  for (size_t f = 0; f < fragments.size(); ++f) {
+    auto key = std::make_pair(td, fragments[f]);
+    if (0 == updelRoll.chunkMetadata.count(key))
+      updelRoll.chunkMetadata[key] = fragments[f]->getChunkMetadataMapPhysical();
+    auto& chunkMetadata = updelRoll.chunkMetadata[key];
+    for (size_t c = 0; c < cds.size(); ++c)
+      chunks[c][f]->get_buffer()->encoder->getMetadata(chunkMetadata[cds[c]->columnId]);
+    updelRoll.numTuples[key] = merged_rows[f];
   }
 }
 
@@ -367,6 +866,8 @@ void UpdelRoll::commitUpdate() {
   for (auto& cm : chunkMetadata)
     cm.first.first->fragmenter->updateMetadata(catalog, cm.first, *this);
   dirtyChunks.clear();
+  // updated, deleted or moved rows may already be folded into the partial aggregates
+  catalog->invalidateMaterializedViews(logicalTableId);
   // flush gpu dirty chunks if update was not on gpu
   if (memoryLevel != Data_Namespace::MemoryLevel::GPU_LEVEL)
     for (const auto& chunkey : dirtyChunkeys)
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    ArrowStreamReader.h
+ * @brief   Reads the record batches of an Arrow IPC stream off a file descriptor and re-serializes them into streams
+ *          of their own, each of them loaded with one call to the server.
+ *
+ */
+
+#ifndef IMPORT_ARROWSTREAMREADER_H
+#define IMPORT_ARROWSTREAMREADER_H
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/ipc/api.h>
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+inline void arrow_stream_throw_not_ok(const arrow::Status& status) {
+  if (!status.ok()) {
+    throw std::runtime_error("Malformed Arrow stream: " + status.ToString());
+  }
+}
+
+// reads up to size bytes, fewer only at the end of the input
+inline size_t read_fully(const int fd, char* buf, const size_t size) {
+  size_t done = 0;
+  while (done < size) {
+    const auto n = read(fd, buf + done, size - done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      throw std::runtime_error(std::string("Could not read the input: ") + strerror(errno));
+    }
+    if (n == 0) {
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+// The input of the stream reader, a pipe or a socket which can't seek.
+class FdInputStream : public arrow::io::InputStream {
+ public:
+  explicit FdInputStream(const int fd) : fd_(fd), position_(0) { set_mode(arrow::io::FileMode::READ); }
+
+  arrow::Status Close() override { return arrow::Status::OK(); }
+
+  arrow::Status Tell(int64_t* position) const override {
+    *position = position_;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Read(int64_t nbytes, int64_t* bytes_read, uint8_t* out) override {
+    try {
+      *bytes_read = read_fully(fd_, reinterpret_cast<char*>(out), nbytes);
+    } catch (const std::runtime_error& e) {
+      return arrow::Status::IOError(e.what());
+    }
+    position_ += *bytes_read;
+    return arrow::Status::OK();
+  }
+
+  arrow::Status Read(int64_t nbytes, std::shared_ptr<arrow::Buffer>* out) override {
+    auto buffer = std::make_shared<arrow::PoolBuffer>(arrow::default_memory_pool());
+    RETURN_NOT_OK(buffer->Resize(nbytes));
+    int64_t bytes_read = 0;
+    RETURN_NOT_OK(Read(nbytes, &bytes_read, buffer->mutable_data()));
+    RETURN_NOT_OK(buffer->Resize(bytes_read));
+    *out = buffer;
+    return arrow::Status::OK();
+  }
+
+ private:
+  const int fd_;
+  int64_t position_;
+};
+
+// Serializes batches as a stream of their own, schema and dictionaries included.
+inline std::string serialize_arrow_stream(const std::shared_ptr<arrow::Schema>& schema,
+                                          const std::vector<std::shared_ptr<arrow::RecordBatch>>& batches) {
+  std::shared_ptr<arrow::io::BufferOutputStream> sink;
+  arrow_stream_throw_not_ok(arrow::io::BufferOutputStream::Create(1 << 16, arrow::default_memory_pool(), &sink));
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  arrow_stream_throw_not_ok(arrow::ipc::RecordBatchStreamWriter::Open(sink.get(), schema, &writer));
+  for (const auto& batch : batches) {
+    arrow_stream_throw_not_ok(writer->WriteRecordBatch(*batch));
+  }
+  arrow_stream_throw_not_ok(writer->Close());
+  std::shared_ptr<arrow::Buffer> buffer;
+  arrow_stream_throw_not_ok(sink->Finish(&buffer));
+  return std::string(reinterpret_cast<const char*>(buffer->data()), buffer->size());
+}
+
+// Reads the Arrow IPC stream on fd and hands its record batches to load as streams of at least min_rows rows, but
+// for the last one. The batches loaded before a truncated or malformed message stay loaded, the reader throws then.
+inline void read_arrow_stream(const int fd,
+                              const size_t min_rows,
+                              const std::function<void(const std::string& stream, const size_t rows)>& load) {
+  FdInputStream input(fd);
+  std::shared_ptr<arrow::RecordBatchReader> reader;
+  arrow_stream_throw_not_ok(arrow::ipc::RecordBatchStreamReader::Open(&input, &reader));
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  size_t rows = 0;
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    arrow_stream_throw_not_ok(reader->ReadNext(&batch));
+    if (!batch) {
+      break;
+    }
+    rows += batch->num_rows();
+    batches.push_back(std::move(batch));
+    if (rows >= min_rows) {
+      load(serialize_arrow_stream(reader->schema(), batches), rows);
+      batches.clear();
+      rows = 0;
+    }
+  }
+  if (!batches.empty()) {
+    load(serialize_arrow_stream(reader->schema(), batches), rows);
+  }
+}
+
+#endif  // IMPORT_ARROWSTREAMREADER_H
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    BatchPipeline.h
+ * @brief   Building blocks of the streaming importers: bounded queues between their stages and the ordering of
+ *          batch completions into offset commits.
+ *
+ */
+
+#ifndef IMPORT_BATCHPIPELINE_H
+#define IMPORT_BATCHPIPELINE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Blocking queue between the stages of the import. Pushing into a full queue waits, so a stage falling behind holds
+// back the ones feeding it, up to the consumer which then stops polling the brokers.
+template <typename T>
+class BoundedQueue {
+ public:
+  BoundedQueue(const size_t capacity) : capacity_(capacity), closed_(false) {}
+
+  void push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+  }
+
+  // returns false once the queue is closed and drained
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if (items_.empty()) {
+      return false;
+    }
+    item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+  }
+
+ private:
+  const size_t capacity_;
+  bool closed_;
+  std::deque<T> items_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+};
+
+// Batches of a worker are numbered from 0 in the order it filled them, but several loaders send them to the server
+// and they can finish in any order. A later batch finishing first must not commit its offsets, they would also cover
+// an earlier batch still in flight, so a batch is only released together with every earlier batch of its worker.
+// Not thread-safe.
+class BatchCommitTracker {
+ public:
+  typedef std::map<int32_t, int64_t> PartitionOffsets;  // last offset of each partition
+
+  BatchCommitTracker(const size_t num_workers) : next_seq_(num_workers, 0), completed_(num_workers) {}
+
+  // Records a loaded batch. Returns the offsets which can be committed now, merged over the released batches, and
+  // the number of messages they cover. Both are empty while an earlier batch of the worker is still in flight.
+  std::pair<PartitionOffsets, size_t> complete(const size_t worker,
+                                               const uint64_t seq,
+                                               PartitionOffsets offsets,
+                                               const size_t messages) {
+    auto& completed = completed_[worker];
+    completed.emplace(seq, std::make_pair(std::move(offsets), messages));
+    PartitionOffsets released_offsets;
+    size_t released_messages = 0;
+    auto& next_seq = next_seq_[worker];
+    for (auto it = completed.begin(); it != completed.end() && it->first == next_seq;
+         it = completed.erase(it), ++next_seq) {
+      for (const auto& offset : it->second.first) {
+        released_offsets[offset.first] = offset.second;
+      }
+      released_messages += it->second.second;
+    }
+    return std::make_pair(released_offsets, released_messages);
+  }
+
+ private:
+  std::vector<uint64_t> next_seq_;  // per worker, of its first batch not released yet
+  std::vector<std::map<uint64_t, std::pair<PartitionOffsets, size_t>>> completed_;
+};
+
+#endif  // IMPORT_BATCHPIPELINE_H
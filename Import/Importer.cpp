@@ -2197,6 +2197,19 @@ double double_value_at(const TypedImportBuffer& import_buffer, const size_t inde
 
 }  // namespace
 
+std::vector<int64_t> Loader::getShardKeys(TypedImportBuffer& shard_column_buffer, const size_t row_count) {
+  if (shard_column_buffer.getTypeInfo().is_string()) {
+    const auto payloads_ptr = shard_column_buffer.getStringBuffer();
+    CHECK(payloads_ptr);
+    shard_column_buffer.addDictEncodedString(*payloads_ptr);
+  }
+  std::vector<int64_t> shard_keys(row_count);
+  for (size_t i = 0; i < row_count; ++i) {
+    shard_keys[i] = int_value_at(shard_column_buffer, i);
+  }
+  return shard_keys;
+}
+
 void Loader::distributeToShards(std::vector<OneShardBuffers>& all_shard_import_buffers,
                                 std::vector<size_t>& all_shard_row_counts,
                                 const OneShardBuffers& import_buffers,
@@ -2208,6 +2221,8 @@ void Loader::distributeToShards(std::vector<OneShardBuffers>& all_shard_import_b
     for (const auto& typed_import_buffer : import_buffers) {
       all_shard_import_buffers.back().emplace_back(
           new TypedImportBuffer(typed_import_buffer->getColumnDesc(), typed_import_buffer->getStringDictionary()));
+      // the shards share the dictionary, the ids cached by the loader thread's buffers hit for all of them
+      all_shard_import_buffers.back().back()->shareStringDictCache(*typed_import_buffer);
     }
   }
   CHECK_GT(table_desc->shardedColumnId, 0);
@@ -2225,14 +2240,10 @@ void Loader::distributeToShards(std::vector<OneShardBuffers>& all_shard_import_b
   auto& shard_column_input_buffer = import_buffers[table_desc->shardedColumnId - 1];
   const auto& shard_col_ti = shard_col_desc->columnType;
   CHECK(shard_col_ti.is_integer() || (shard_col_ti.is_string() && shard_col_ti.get_compression() == kENCODING_DICT));
-  if (shard_col_ti.is_string()) {
-    const auto payloads_ptr = shard_column_input_buffer->getStringBuffer();
-    CHECK(payloads_ptr);
-    shard_column_input_buffer->addDictEncodedString(*payloads_ptr);
-  }
+  const auto shard_keys = getShardKeys(*shard_column_input_buffer, row_count);
+  CHECK_EQ(row_count, shard_keys.size());
   for (size_t i = 0; i < row_count; ++i) {
-    const auto val = int_value_at(*shard_column_input_buffer, i);
-    const size_t shard = SHARD_FOR_KEY(val, shard_count);
+    const size_t shard = SHARD_FOR_KEY(shard_keys[i], shard_count);
     auto& shard_output_buffers = all_shard_import_buffers[shard];
     for (size_t col_idx = 0; col_idx < import_buffers.size(); ++col_idx) {
       const auto& input_buffer = import_buffers[col_idx];
@@ -2324,8 +2335,8 @@ bool Loader::loadToShard(const std::vector<std::unique_ptr<TypedImportBuffer>>&
                          size_t row_count,
                          const TableDescriptor* shard_table,
                          bool checkpoint) {
-  std::lock_guard<std::mutex> loader_lock(loader_mutex_);
-
+  // the buffers belong to the calling thread and the dictionaries lock themselves, so the strings are encoded
+  // before taking the loader lock and the import threads encode concurrently
   Fragmenter_Namespace::InsertData ins_data(insert_data);
   ins_data.numRows = row_count;
   bool success = true;
@@ -2357,7 +2368,17 @@ bool Loader::loadToShard(const std::vector<std::unique_ptr<TypedImportBuffer>>&
     }
     ins_data.data.push_back(p);
   }
+  if (checkpoint) {
+    // a logged insert is durable once the log is synced, the ids it holds must be durable before
+    for (const auto& import_buff : import_buffers) {
+      if (import_buff->getTypeInfo().get_compression() == kENCODING_DICT && !import_buff->stringDictCheckpoint()) {
+        LOG(ERROR) << "Failed to checkpoint dictionary for column " << import_buff->getColumnDesc()->columnName;
+        return false;
+      }
+    }
+  }
   {
+    std::lock_guard<std::mutex> loader_lock(loader_mutex_);
     try {
       if (checkpoint)
         shard_table->fragmenter->insertData(ins_data);
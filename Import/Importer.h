@@ -28,6 +28,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <boost/noncopyable.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/tokenizer.hpp>
@@ -142,7 +143,9 @@ struct CopyParams {
 class TypedImportBuffer : boost::noncopyable {
  public:
   TypedImportBuffer(const ColumnDescriptor* col_desc, StringDictionary* string_dict)
-      : column_desc_(col_desc), string_dict_(string_dict) {
+      : column_desc_(col_desc),
+        string_dict_(string_dict),
+        string_dict_cache_(std::make_shared<std::unordered_map<std::string, int32_t>>()) {
     switch (col_desc->columnType.get_type()) {
       case kBOOLEAN:
         bool_buffer_ = new std::vector<int8_t>();
@@ -315,16 +318,13 @@ class TypedImportBuffer : boost::noncopyable {
     }
     switch (column_desc_->columnType.get_size()) {
       case 1:
-        string_dict_i8_buffer_->resize(string_vec.size());
-        string_dict_->getOrAddBulk(string_vec, string_dict_i8_buffer_->data());
+        addDictEncodedStringCached(string_vec, *string_dict_i8_buffer_);
         break;
       case 2:
-        string_dict_i16_buffer_->resize(string_vec.size());
-        string_dict_->getOrAddBulk(string_vec, string_dict_i16_buffer_->data());
+        addDictEncodedStringCached(string_vec, *string_dict_i16_buffer_);
         break;
       case 4:
-        string_dict_i32_buffer_->resize(string_vec.size());
-        string_dict_->getOrAddBulk(string_vec, string_dict_i32_buffer_->data());
+        addDictEncodedStringCached(string_vec, *string_dict_i32_buffer_);
         break;
       default:
         CHECK(false);
@@ -513,6 +513,9 @@ class TypedImportBuffer : boost::noncopyable {
     }
   }
 
+  // the buffers of one shard get filled from the buffers of the whole batch
+  void shareStringDictCache(const TypedImportBuffer& other) { string_dict_cache_ = other.string_dict_cache_; }
+
   size_t add_values(const ColumnDescriptor* cd, const TColumn& data);
 
   size_t add_arrow_values(const ColumnDescriptor* cd, const arrow::Array& data);
@@ -522,6 +525,50 @@ class TypedImportBuffer : boost::noncopyable {
   void pop_value();
 
  private:
+  // Low cardinality columns send the same strings batch after batch. Every import thread has buffers of its own,
+  // so each keeps the ids it got back and only goes to the shared dictionary for the strings it hasn't seen.
+  template <typename T>
+  void addDictEncodedStringCached(const std::vector<std::string>& string_vec, std::vector<T>& encoded_vec) {
+    encoded_vec.resize(string_vec.size());
+    std::vector<size_t> missed_rows;
+    for (size_t i = 0; i < string_vec.size(); ++i) {
+      const auto it = string_dict_cache_->find(string_vec[i]);
+      if (it != string_dict_cache_->end()) {
+        encoded_vec[i] = it->second;
+      } else {
+        missed_rows.push_back(i);
+      }
+    }
+    if (missed_rows.empty()) {
+      return;
+    }
+    if (missed_rows.size() == string_vec.size()) {
+      string_dict_->getOrAddBulk(string_vec, encoded_vec.data());
+    } else {
+      std::vector<std::string> missed_strings;
+      missed_strings.reserve(missed_rows.size());
+      for (const auto i : missed_rows) {
+        missed_strings.push_back(string_vec[i]);
+      }
+      std::vector<T> missed_ids(missed_rows.size());
+      string_dict_->getOrAddBulk(missed_strings, missed_ids.data());
+      for (size_t j = 0; j < missed_rows.size(); ++j) {
+        encoded_vec[missed_rows[j]] = missed_ids[j];
+      }
+    }
+    for (const auto i : missed_rows) {
+      if (string_dict_cache_->size() >= kMaxStringDictCacheEntries) {
+        break;
+      }
+      if (string_vec[i].size() <= kMaxStringDictCacheStrlen) {
+        string_dict_cache_->emplace(string_vec[i], encoded_vec[i]);
+      }
+    }
+  }
+
+  static const size_t kMaxStringDictCacheEntries = 1 << 14;
+  static const size_t kMaxStringDictCacheStrlen = 256;
+
   union {
     std::vector<int8_t>* bool_buffer_;
     std::vector<int8_t>* tinyint_buffer_;
@@ -544,6 +591,8 @@ class TypedImportBuffer : boost::noncopyable {
   };
   const ColumnDescriptor* column_desc_;
   StringDictionary* string_dict_;
+  // encoded as stored, NULL included; shared with the per shard buffers filled from this one, on the same thread
+  std::shared_ptr<std::unordered_map<std::string, int32_t>> string_dict_cache_;
 };
 
 class Loader {
@@ -585,6 +634,8 @@ class Loader {
                           const OneShardBuffers& import_buffers,
                           const size_t row_count,
                           const size_t shard_count);
+  // Dictionary encoded shard keys are sharded by their id in the dictionary of this node.
+  virtual std::vector<int64_t> getShardKeys(TypedImportBuffer& shard_column_buffer, const size_t row_count);
 
  private:
   bool loadToShard(const std::vector<std::unique_ptr<TypedImportBuffer>>& import_buffers,
@@ -33,10 +33,18 @@
 #include <glog/logging.h>
 
 #include "../Shared/sqltypes.h"
+#include "BatchPipeline.h"
 #include "RowToColumnLoader.h"
 
-#include <thread>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
 
 #include <boost/program_options.hpp>
 
@@ -47,21 +55,283 @@
 bool print_error_data = false;
 bool print_transformation = false;
 
-static bool run = true;
+static std::atomic<bool> run{true};
 static bool exit_eof = false;
 static int eof_cnt = 0;
 static int partition_cnt = 0;
 static long msg_cnt = 0;
 static int64_t msg_bytes = 0;
 
+typedef std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>> Transformation;
+
+// splits a message into the fields of a row, applying the column transformations
+bool parse_message(const char* payload,
+                   const size_t len,
+                   const TRowDescriptor& row_desc,
+                   const std::vector<const Transformation*>& xforms,
+                   const Importer_NS::CopyParams& copy_params,
+                   const bool remove_quotes,
+                   std::vector<TStringValue>& row) {
+  char field[MAX_FIELD_LEN];
+  size_t field_i = 0;
+
+  bool backEscape = false;
+
+  // the message is a single row, terminate it like a line of a file
+  for (size_t i = 0; i <= len; i++) {
+    const char iit = i < len ? payload[i] : copy_params.line_delim;
+    if (iit == copy_params.delimiter || iit == copy_params.line_delim) {
+      bool end_of_field = (iit == copy_params.delimiter);
+      bool end_of_row;
+      if (end_of_field)
+        end_of_row = false;
+      else {
+        end_of_row = (row.size() + 1 >= row_desc.size()) || (row_desc[row.size()].col_type.type != TDatumType::STR);
+        if (!end_of_row) {
+          size_t l = copy_params.null_str.size();
+          if (field_i >= l && strncmp(field + field_i - l, copy_params.null_str.c_str(), l) == 0) {
+            end_of_row = true;
+          }
+        }
+      }
+      if (!end_of_field && !end_of_row) {
+        // not enough columns yet and it is a string column
+        // treat the line delimiter as part of the string
+        field[field_i++] = iit;
+      } else {
+        field[field_i] = '\0';
+        field_i = 0;
+        TStringValue ts;
+        ts.str_val = std::string(field);
+        ts.is_null = (ts.str_val.empty() || ts.str_val == copy_params.null_str);
+        auto xform = row.size() < row_desc.size() ? xforms[row.size()] : nullptr;
+        if (!ts.is_null && xform != nullptr) {
+          if (print_transformation)
+            std::cout << "\ntransforming\n" << ts.str_val << "\nto\n";
+          ts.str_val = boost::regex_replace(ts.str_val, *xform->first, *xform->second);
+          if (ts.str_val.empty())
+            ts.is_null = true;
+          if (print_transformation)
+            std::cout << ts.str_val << std::endl;
+        }
+
+        row.push_back(ts);  // add column value to row
+        if (end_of_row || (row.size() > row_desc.size())) {
+          break;  // found row
+        }
+      }
+    } else {
+      if (iit == '\\') {
+        backEscape = true;
+      } else if (backEscape || !remove_quotes || iit != '\"') {
+        field[field_i++] = iit;
+        backEscape = false;
+      }
+      // else if unescaped double-quote, continue without adding the
+      // character to the field string.
+    }
+    if (field_i >= MAX_FIELD_LEN) {
+      field[MAX_FIELD_LEN - 1] = '\0';
+      std::cerr << "String too long for buffer." << std::endl;
+      if (print_error_data)
+        std::cerr << field << std::endl;
+      field_i = 0;
+      break;
+    }
+  }
+  return row.size() == row_desc.size();
+}
+
+// Rows of the messages a parse worker converted, handed over to the loaders in the order the worker filled them.
+struct LoadBatch {
+  size_t worker;
+  uint64_t seq;
+  std::vector<TColumn> columns;
+  size_t rows;
+  size_t messages;                     // including the skipped ones, their offsets get committed all the same
+  std::map<int32_t, int64_t> offsets;  // of the last message of each partition in the batch
+};
+
+// Consumes the messages of a topic in three stages. Every partition is parsed by one of the parse workers, so the
+// messages of a partition keep their order while partitions are converted in parallel. The workers fill columnar
+// batches which the loaders send to the server while the next ones fill. The offsets of a batch are committed once
+// the server has acknowledged its load and those of every earlier batch of the same worker, so a restart consumes
+// nothing the table doesn't have but may consume again rows loaded just before it.
+class ImportPipeline {
+ public:
+  ImportPipeline(RdKafka::KafkaConsumer* consumer,
+                 const std::string& topic,
+                 std::vector<std::unique_ptr<RowToColumnLoader>>& loaders,
+                 const std::map<std::string, Transformation>& transformations,
+                 const Importer_NS::CopyParams& copy_params,
+                 const bool remove_quotes,
+                 const size_t num_workers)
+      : consumer_(consumer),
+        topic_(topic),
+        row_loader_(*loaders.front()),
+        copy_params_(copy_params),
+        remove_quotes_(remove_quotes),
+        load_queue_(loaders.size()),
+        commit_tracker_(num_workers),
+        handed_over_(0),
+        committed_(0) {
+    const auto row_desc = row_loader_.get_row_descriptor();
+    for (const auto& column : row_desc) {
+      auto it = transformations.find(column.col_name);
+      xforms_.push_back(it != transformations.end() ? &it->second : nullptr);
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
+      parse_queues_.emplace_back(new BoundedQueue<std::unique_ptr<RdKafka::Message>>(copy_params_.batch_size));
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
+      parse_threads_.emplace_back([this, i] { parse(i); });
+    }
+    for (auto& loader : loaders) {
+      auto loader_ptr = loader.get();
+      load_threads_.emplace_back([this, loader_ptr] { load(*loader_ptr); });
+    }
+  }
+
+  ~ImportPipeline() { stop(); }
+
+  // blocks while the worker of the partition is behind
+  void consume(std::unique_ptr<RdKafka::Message> message) {
+    const size_t worker = message->partition() % parse_queues_.size();
+    // not under the commit lock, the consumer would wait for the broker acknowledging a commit
+    ++handed_over_;
+    parse_queues_[worker]->push(std::move(message));
+  }
+
+  // has the workers hand over their partial batches, so rows of a quiet topic get loaded too
+  void flush() {
+    for (auto& queue : parse_queues_) {
+      queue->push(nullptr);
+    }
+  }
+
+  // waits until every message handed over so far is loaded and committed
+  void drain() {
+    flush();
+    std::unique_lock<std::mutex> lock(commit_mutex_);
+    committed_cv_.wait(lock, [this] { return committed_ == handed_over_; });
+  }
+
+  void stop() {
+    for (auto& queue : parse_queues_) {
+      queue->close();
+    }
+    for (auto& t : parse_threads_) {
+      t.join();
+    }
+    parse_threads_.clear();
+    load_queue_.close();
+    for (auto& t : load_threads_) {
+      t.join();
+    }
+    load_threads_.clear();
+  }
+
+ private:
+  void parse(const size_t worker) {
+    const auto row_desc = row_loader_.get_row_descriptor();
+    uint64_t seq = 0;
+    LoadBatch batch{worker, seq, row_loader_.create_input_columns(), 0, 0, {}};
+    std::unique_ptr<RdKafka::Message> message;
+    while (parse_queues_[worker]->pop(message)) {
+      if (message) {
+        VLOG(1) << "Read msg at offset " << message->offset() << " of partition " << message->partition();
+        std::vector<TStringValue> row;  // used to store each row as we move through the stream
+        const auto payload = static_cast<const char*>(message->payload());
+        if (parse_message(payload, message->len(), row_desc, xforms_, copy_params_, remove_quotes_, row)) {
+          if (row_loader_.convert_string_to_column(std::move(row), copy_params_, batch.columns)) {
+            ++batch.rows;
+          }
+        } else if (print_error_data) {
+          std::cerr << "Incorrect number of columns for row: ";
+          std::cerr << row_loader_.print_row_with_delim(row, copy_params_) << std::endl;
+        }
+        ++batch.messages;
+        batch.offsets[message->partition()] = message->offset();
+        message.reset();
+        if (batch.rows < copy_params_.batch_size) {
+          continue;
+        }
+      } else if (!batch.messages) {
+        continue;
+      }
+      load_queue_.push(std::move(batch));
+      batch = LoadBatch{worker, ++seq, row_loader_.create_input_columns(), 0, 0, {}};
+    }
+  }
+
+  void load(RowToColumnLoader& loader) {
+    int rows_loaded = 0;
+    int skipped = 0;
+    LoadBatch batch;
+    while (load_queue_.pop(batch)) {
+      skipped += batch.messages - batch.rows;
+      if (batch.rows) {
+        // returns once the server has made the rows durable, exits the importer when out of retries
+        loader.do_load(rows_loaded, skipped, batch.columns, copy_params_);
+      }
+      commit(batch);
+    }
+  }
+
+  void commit(LoadBatch& batch) {
+    std::lock_guard<std::mutex> lock(commit_mutex_);
+    BatchCommitTracker::PartitionOffsets offsets;
+    size_t messages = 0;
+    std::tie(offsets, messages) =
+        commit_tracker_.complete(batch.worker, batch.seq, std::move(batch.offsets), batch.messages);
+    if (!offsets.empty()) {
+      std::vector<RdKafka::TopicPartition*> partitions;
+      for (const auto& offset : offsets) {
+        // the committed offset is the one of the next message to consume
+        partitions.push_back(RdKafka::TopicPartition::create(topic_, offset.first, offset.second + 1));
+      }
+      const auto err = consumer_->commitSync(partitions);
+      if (err) {
+        LOG(ERROR) << "Could not commit the offsets of loaded rows, they will be consumed again: "
+                   << RdKafka::err2str(err);
+      }
+      RdKafka::TopicPartition::destroy(partitions);
+    }
+    committed_ += messages;
+    committed_cv_.notify_all();
+  }
+
+  RdKafka::KafkaConsumer* consumer_;
+  const std::string topic_;
+  RowToColumnLoader& row_loader_;  // only converts, its connection belongs to a load thread
+  const Importer_NS::CopyParams copy_params_;
+  const bool remove_quotes_;
+  std::vector<const Transformation*> xforms_;  // per column, null when not transformed
+  std::vector<std::unique_ptr<BoundedQueue<std::unique_ptr<RdKafka::Message>>>> parse_queues_;
+  BoundedQueue<LoadBatch> load_queue_;
+
+  std::mutex commit_mutex_;
+  std::condition_variable committed_cv_;
+  BatchCommitTracker commit_tracker_;
+  std::atomic<size_t> handed_over_;  // only the consumer adds to it, drain() is called from there too
+  size_t committed_;
+
+  std::vector<std::thread> parse_threads_;
+  std::vector<std::thread> load_threads_;
+};
+
 class RebalanceCb : public RdKafka::RebalanceCb {
  private:
+  ImportPipeline* pipeline_{nullptr};
+
   static void part_list_print(const std::vector<RdKafka::TopicPartition*>& partitions) {
     for (unsigned int i = 0; i < partitions.size(); i++)
       LOG(INFO) << "\t" << partitions[i]->topic() << "[" << partitions[i]->partition() << "]";
   }
 
  public:
+  void set_pipeline(ImportPipeline* pipeline) { pipeline_ = pipeline; }
+
   void rebalance_cb(RdKafka::KafkaConsumer* consumer,
                     RdKafka::ErrorCode err,
                     std::vector<RdKafka::TopicPartition*>& partitions) {
@@ -73,6 +343,10 @@ class RebalanceCb : public RdKafka::RebalanceCb {
       consumer->assign(partitions);
       partition_cnt = (int)partitions.size();
     } else {
+      // load and commit what was consumed before the partitions go to another consumer
+      if (pipeline_) {
+        pipeline_->drain();
+      }
       consumer->unassign();
       partition_cnt = 0;
     }
@@ -80,12 +354,8 @@ class RebalanceCb : public RdKafka::RebalanceCb {
   }
 };
 
-bool msg_consume(RdKafka::Message* message,
-                 RowToColumnLoader& row_loader,
-                 Importer_NS::CopyParams copy_params,
-                 const std::map<std::string, std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>>>&
-                     transformations,
-                 const bool remove_quotes) {
+// handles the events and errors polled with the messages, returns true for a real message
+bool msg_consume(RdKafka::Message* message) {
   switch (message->err()) {
     case RdKafka::ERR__TIMED_OUT:
       VLOG(1) << " Timed out";
@@ -94,7 +364,6 @@ bool msg_consume(RdKafka::Message* message,
     case RdKafka::ERR_NO_ERROR: { /* Real message */
       msg_cnt++;
       msg_bytes += message->len();
-      VLOG(1) << "Read msg at offset " << message->offset();
       RdKafka::MessageTimestamp ts;
       ts = message->timestamp();
       if (ts.type != RdKafka::MessageTimestamp::MSG_TIMESTAMP_NOT_AVAILABLE) {
@@ -105,105 +374,7 @@ bool msg_consume(RdKafka::Message* message,
           tsname = "log append time";
         VLOG(1) << "Timestamp: " << tsname << " " << ts.timestamp << std::endl;
       }
-
-      char buffer[message->len() + 1];
-      sprintf(buffer, "%.*s\n", static_cast<int>(message->len()), static_cast<const char*>(message->payload()));
-      VLOG(1) << "Full Message received is :'" << buffer << "'";
-
-      char field[MAX_FIELD_LEN];
-      size_t field_i = 0;
-
-      bool backEscape = false;
-
-      auto row_desc = row_loader.get_row_descriptor();
-
-      const std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>>* xforms[row_desc.size()];
-      for (size_t i = 0; i < row_desc.size(); i++) {
-        auto it = transformations.find(row_desc[i].col_name);
-        if (it != transformations.end())
-          xforms[i] = &(it->second);
-        else
-          xforms[i] = nullptr;
-      }
-
-      std::vector<TStringValue> row;  // used to store each row as we move through the stream
-
-      for (auto iit : buffer) {
-        if (iit == copy_params.delimiter || iit == copy_params.line_delim) {
-          bool end_of_field = (iit == copy_params.delimiter);
-          bool end_of_row;
-          if (end_of_field)
-            end_of_row = false;
-          else {
-            end_of_row = (row_desc[row.size()].col_type.type != TDatumType::STR) || (row.size() == row_desc.size() - 1);
-            if (!end_of_row) {
-              size_t l = copy_params.null_str.size();
-              if (field_i >= l && strncmp(field + field_i - l, copy_params.null_str.c_str(), l) == 0) {
-                end_of_row = true;
-              }
-            }
-          }
-          if (!end_of_field && !end_of_row) {
-            // not enough columns yet and it is a string column
-            // treat the line delimiter as part of the string
-            field[field_i++] = iit;
-          } else {
-            field[field_i] = '\0';
-            field_i = 0;
-            TStringValue ts;
-            ts.str_val = std::string(field);
-            ts.is_null = (ts.str_val.empty() || ts.str_val == copy_params.null_str);
-            auto xform = row.size() < row_desc.size() ? xforms[row.size()] : nullptr;
-            if (!ts.is_null && xform != nullptr) {
-              if (print_transformation)
-                std::cout << "\ntransforming\n" << ts.str_val << "\nto\n";
-              ts.str_val = boost::regex_replace(ts.str_val, *xform->first, *xform->second);
-              if (ts.str_val.empty())
-                ts.is_null = true;
-              if (print_transformation)
-                std::cout << ts.str_val << std::endl;
-            }
-
-            row.push_back(ts);  // add column value to row
-            if (end_of_row || (row.size() > row_desc.size())) {
-              break;  // found row
-            }
-          }
-        } else {
-          if (iit == '\\') {
-            backEscape = true;
-          } else if (backEscape || !remove_quotes || iit != '\"') {
-            field[field_i++] = iit;
-            backEscape = false;
-          }
-          // else if unescaped double-quote, continue without adding the
-          // character to the field string.
-        }
-        if (field_i >= MAX_FIELD_LEN) {
-          field[MAX_FIELD_LEN - 1] = '\0';
-          std::cerr << "String too long for buffer." << std::endl;
-          if (print_error_data)
-            std::cerr << field << std::endl;
-          field_i = 0;
-          break;
-        }
-      }
-      if (row.size() == row_desc.size()) {
-        // add the new data in the column format
-        bool record_loaded = row_loader.convert_string_to_column(row, copy_params);
-        if (!record_loaded) {
-          // record could not be parsed correctly consider it skipped
-          return false;
-        } else {
-          return true;
-        }
-      } else {
-        if (print_error_data) {
-          std::cerr << "Incorrect number of columns for row: ";
-          std::cerr << row_loader.print_row_with_delim(row, copy_params) << std::endl;
-          return false;
-        }
-      }
+      return true;
     }
 
     case RdKafka::ERR__PARTITION_EOF:
@@ -269,11 +440,13 @@ class EventCb : public RdKafka::EventCb {
 };
 
 // reads from a kafka topic (expects delimited string input)
-void kafka_insert(RowToColumnLoader& row_loader,
+void kafka_insert(std::vector<std::unique_ptr<RowToColumnLoader>>& loaders,
                   const std::map<std::string, std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>>>&
                       transformations,
                   const Importer_NS::CopyParams& copy_params,
                   const bool remove_quotes,
+                  const size_t num_workers,
+                  const size_t flush_wait,
                   std::string group_id,
                   std::string topic,
                   std::string brokers) {
@@ -406,34 +579,30 @@ void kafka_insert(RowToColumnLoader& row_loader,
   /*
    * Consume messages
    */
-  size_t recv_rows = 0;
-  int skipped = 0;
-  int rows_loaded = 0;
+  ImportPipeline pipeline(consumer, topic, loaders, transformations, copy_params, remove_quotes, num_workers);
+  ex_rebalance_cb.set_pipeline(&pipeline);
+  auto last_flush = std::chrono::steady_clock::now();
   while (run) {
-    RdKafka::Message* msg = consumer->consume(10000);
+    std::unique_ptr<RdKafka::Message> msg(consumer->consume(1000));
     if (msg->err() == RdKafka::ERR_NO_ERROR) {
-      if (!use_ccb) {
-        bool added = msg_consume(msg, row_loader, copy_params, transformations, remove_quotes);
-        if (added) {
-          recv_rows++;
-          if (recv_rows == copy_params.batch_size) {
-            recv_rows = 0;
-            row_loader.do_load(rows_loaded, skipped, copy_params);
-            // make sure we now commit that we are up to here to cover the mesages we just loaded
-            consumer->commitSync();
-          }
-        } else {
-          // LOG(ERROR) << " messsage was skipped ";
-          skipped++;
-        }
+      if (!use_ccb && msg_consume(msg.get())) {
+        // parsing and loading happen on the pipeline threads, this one only keeps polling
+        pipeline.consume(std::move(msg));
       }
     }
-    delete msg;
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_flush >= std::chrono::seconds(flush_wait)) {
+      pipeline.flush();
+      last_flush = now;
+    }
   }
 
   /*
    * Stop consumer
    */
+  pipeline.drain();
+  pipeline.stop();
+  ex_rebalance_cb.set_pipeline(nullptr);
   consumer->close();
   delete consumer;
 
@@ -460,6 +629,9 @@ int main(int argc, char** argv) {
   std::string brokers;
   std::string delim_str(","), nulls("\\N"), line_delim_str("\n"), quoted("false");
   size_t batch_size = 10000;
+  size_t num_workers = std::max(std::thread::hardware_concurrency(), 1u);
+  size_t num_loaders = 2;
+  size_t flush_wait = 5;
   size_t retry_count = 10;
   size_t retry_wait = 5;
   bool remove_quotes = false;
@@ -485,6 +657,14 @@ int main(int argc, char** argv) {
                      po::value<std::string>(&quoted),
                      "Whether the source contains quoted fields (true/false, default false)");
   desc.add_options()("batch", po::value<size_t>(&batch_size)->default_value(batch_size), "Insert batch size");
+  desc.add_options()("workers",
+                     po::value<size_t>(&num_workers)->default_value(num_workers),
+                     "Number of threads parsing the messages, each partition is parsed by one of them");
+  desc.add_options()(
+      "loaders", po::value<size_t>(&num_loaders)->default_value(num_loaders), "Number of concurrent insert batches");
+  desc.add_options()("flush_wait",
+                     po::value<size_t>(&flush_wait)->default_value(flush_wait),
+                     "max secs consumed rows wait for their batch to fill before they're inserted");
   desc.add_options()(
       "retry_count", po::value<size_t>(&retry_count)->default_value(retry_count), "Number of time to retry an insert");
   desc.add_options()(
@@ -510,8 +690,11 @@ int main(int argc, char** argv) {
           << "Usage: <table name> <database name> {-u|--user} <user> {-p|--passwd} <password> [{--host} "
              "<hostname>][--port <port number>][--delim <delimiter>][--null <null string>][--line <line "
              "delimiter>][--batch <batch size>][{-t|--transform} transformation [--quoted <true|false>] "
-             "...][--retry_count <num_of_retries>] [--retry_wait <wait in secs>][--print_error][--print_transform]\n\n";
+             "...][--retry_count <num_of_retries>] [--retry_wait <wait in secs>][--workers <num_of_threads>][--loaders "
+             "<num_of_batches>][--flush_wait <wait in secs>][--print_error][--print_transform]\n\n";
       std::cout << desc << std::endl;
+      std::cout << "Delivery is at least once: the offsets of a batch are committed after its rows are loaded, the "
+                   "rows loaded since the last commit are loaded again after a restart.\n";
       return 0;
     }
     if (vm.count("print_error"))
@@ -618,8 +801,17 @@ int main(int argc, char** argv) {
   }
 
   Importer_NS::CopyParams copy_params(delim, nulls, line_delim, batch_size, retry_count, retry_wait);
-  RowToColumnLoader row_loader(server_host, port, db_name, user_name, passwd, table_name);
+  if (!num_workers || !num_loaders || !batch_size) {
+    std::cerr << "The number of workers and loaders and the batch size must be positive" << std::endl;
+    return 1;
+  }
+  // one connection per loader, the first one also holds the row descriptor the workers convert with
+  std::vector<std::unique_ptr<RowToColumnLoader>> loaders;
+  for (size_t i = 0; i < num_loaders; ++i) {
+    loaders.emplace_back(new RowToColumnLoader(server_host, port, db_name, user_name, passwd, table_name));
+  }
 
-  kafka_insert(row_loader, transformations, copy_params, remove_quotes, group_id, topic, brokers);
+  kafka_insert(
+      loaders, transformations, copy_params, remove_quotes, num_workers, flush_wait, group_id, topic, brokers);
   return 0;
 }
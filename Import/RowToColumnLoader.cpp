@@ -121,7 +121,7 @@ SQLTypeInfo create_array_sql_type_info_from_col_type(const TColumnType& ct) {
 }
 
 std::string RowToColumnLoader::print_row_with_delim(std::vector<TStringValue> row,
-                                                    const Importer_NS::CopyParams& copy_params) {
+                                                    const Importer_NS::CopyParams& copy_params) const {
   std::ostringstream out;
   bool first = true;
   for (TStringValue ts : row) {
@@ -278,6 +278,12 @@ TRowDescriptor RowToColumnLoader::get_row_descriptor() {
 
 bool RowToColumnLoader::convert_string_to_column(std::vector<TStringValue> row,
                                                  const Importer_NS::CopyParams& copy_params) {
+  return convert_string_to_column(std::move(row), copy_params, input_columns_);
+}
+
+bool RowToColumnLoader::convert_string_to_column(std::vector<TStringValue> row,
+                                                 const Importer_NS::CopyParams& copy_params,
+                                                 std::vector<TColumn>& input_columns) const {
   // create datum and push data to column structure from row data
   uint curr_col = 0;
   for (TStringValue ts : row) {
@@ -295,15 +301,15 @@ bool RowToColumnLoader::convert_string_to_column(std::vector<TStringValue> row,
             // now put into TColumn
             populate_TColumn(tsa, array_column_type_info_[curr_col], array_tcol, copy_params);
           }
-          input_columns_[curr_col].nulls.push_back(false);
-          input_columns_[curr_col].data.arr_col.push_back(array_tcol);
+          input_columns[curr_col].nulls.push_back(false);
+          input_columns[curr_col].data.arr_col.push_back(array_tcol);
 
         } break;
         default:
-          populate_TColumn(ts, column_type_info_[curr_col], input_columns_[curr_col], copy_params);
+          populate_TColumn(ts, column_type_info_[curr_col], input_columns[curr_col], copy_params);
       }
     } catch (const std::exception& e) {
-      remove_partial_row(curr_col, column_type_info_, input_columns_);
+      remove_partial_row(curr_col, column_type_info_, input_columns);
       // import_status.rows_rejected++;
       LOG(ERROR) << "Input exception thrown: " << e.what() << ". Row discarded, issue at column : " << (curr_col + 1)
                  << " data :" << print_row_with_delim(row, copy_params);
@@ -341,10 +347,7 @@ RowToColumnLoader::RowToColumnLoader(const std::string server_host,
   }
 
   // create vector for storage of the actual column data
-  for (TColumnType column : row_desc_) {
-    TColumn t;
-    input_columns_.push_back(t);
-  }
+  input_columns_ = create_input_columns();
 }
 RowToColumnLoader::~RowToColumnLoader() {
   closeConnection();
@@ -387,20 +390,48 @@ void RowToColumnLoader::wait_disconnet_reconnnect_retry(size_t tries,
   createConnection(conn_details);
 }
 
+std::vector<TColumn> RowToColumnLoader::create_input_columns() const {
+  return std::vector<TColumn>(row_desc_.size());
+}
+
 void RowToColumnLoader::do_load(int& nrows, int& nskipped, Importer_NS::CopyParams copy_params) {
+  do_load(nrows, nskipped, input_columns_, copy_params);
+}
+
+void RowToColumnLoader::do_load(int& nrows,
+                                int& nskipped,
+                                std::vector<TColumn>& input_columns,
+                                const Importer_NS::CopyParams& copy_params) {
   for (size_t tries = 0; tries < copy_params.retry_count; tries++) {  // allow for retries in case of insert failure
     try {
-      client_->load_table_binary_columnar(session_, table_name_, input_columns_);
+      client_->load_table_binary_columnar(session_, table_name_, input_columns);
       //      client->load_table(session, table_name, input_rows);
-      nrows += input_columns_[0].nulls.size();
+      nrows += input_columns[0].nulls.size();
       std::cout << nrows << " Rows Inserted, " << nskipped << " rows skipped." << std::endl;
       // we successfully loaded the data, lets move on
-      input_columns_.clear();
-      // create vector for storage of the actual column data
-      for (TColumnType column : row_desc_) {
-        TColumn t;
-        input_columns_.push_back(t);
-      }
+      input_columns = create_input_columns();
+      return;
+    } catch (TMapDException& e) {
+      std::cerr << "Exception trying to insert data " << e.error_msg << std::endl;
+      wait_disconnet_reconnnect_retry(tries, copy_params, conn_details_);
+    } catch (TException& te) {
+      std::cerr << "Exception trying to insert data " << te.what() << std::endl;
+      wait_disconnet_reconnnect_retry(tries, copy_params, conn_details_);
+    }
+  }
+  std::cerr << "Retries exhausted program terminated" << std::endl;
+  exit(1);
+}
+
+void RowToColumnLoader::do_load_arrow(int& nrows,
+                                      const std::string& arrow_stream,
+                                      const size_t stream_rows,
+                                      const Importer_NS::CopyParams& copy_params) {
+  for (size_t tries = 0; tries < copy_params.retry_count; tries++) {  // allow for retries in case of insert failure
+    try {
+      client_->load_table_binary_arrow(session_, table_name_, arrow_stream);
+      nrows += stream_rows;
+      std::cout << nrows << " Rows Inserted." << std::endl;
       return;
     } catch (TMapDException& e) {
       std::cerr << "Exception trying to insert data " << e.error_msg << std::endl;
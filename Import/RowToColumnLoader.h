@@ -80,9 +80,24 @@ class RowToColumnLoader {
                     const std::string table_name);
   ~RowToColumnLoader();
   void do_load(int& nrows, int& nskipped, Importer_NS::CopyParams copy_params);
+  // loads columns filled by the caller and clears them, the connection isn't shared so one loader per thread
+  void do_load(int& nrows,
+               int& nskipped,
+               std::vector<TColumn>& input_columns,
+               const Importer_NS::CopyParams& copy_params);
+  // loads an Arrow IPC stream of record batches, which the server decodes into the columns of the table
+  void do_load_arrow(int& nrows,
+                     const std::string& arrow_stream,
+                     const size_t stream_rows,
+                     const Importer_NS::CopyParams& copy_params);
   bool convert_string_to_column(std::vector<TStringValue> row, const Importer_NS::CopyParams& copy_params);
+  // only reads the table description, so threads can convert into columns of their own concurrently
+  bool convert_string_to_column(std::vector<TStringValue> row,
+                                const Importer_NS::CopyParams& copy_params,
+                                std::vector<TColumn>& input_columns) const;
+  std::vector<TColumn> create_input_columns() const;
   TRowDescriptor get_row_descriptor();
-  std::string print_row_with_delim(std::vector<TStringValue> row, const Importer_NS::CopyParams& copy_params);
+  std::string print_row_with_delim(std::vector<TStringValue> row, const Importer_NS::CopyParams& copy_params) const;
 
  private:
   std::string table_name_;
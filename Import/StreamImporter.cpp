@@ -33,6 +33,7 @@
 #include <glog/logging.h>
 
 #include "../Shared/sqltypes.h"
+#include "ArrowStreamReader.h"
 #include "RowToColumnLoader.h"
 
 #include <thread>
@@ -40,6 +41,12 @@
 
 #include <boost/program_options.hpp>
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+
 #define MAX_FIELD_LEN 20000
 
 bool print_error_data = false;
@@ -175,6 +182,57 @@ void stream_insert(RowToColumnLoader& row_loader,
   }
 }
 
+// reads an Arrow IPC stream from fd and loads its record batches to table_name, sending at least
+// copy_params.batch_size rows per load until the end of the stream
+void arrow_stream_insert(RowToColumnLoader& row_loader, const Importer_NS::CopyParams& copy_params, const int fd) {
+  int nrows = 0;
+  // every load is a stream of its own, with the schema and the dictionaries
+  read_arrow_stream(fd, copy_params.batch_size, [&](const std::string& stream, const size_t rows) {
+    row_loader.do_load_arrow(nrows, stream, rows, copy_params);
+  });
+}
+
+// accepts connections on address:port and loads the Arrow IPC stream each of them sends, one connection at a time.
+// Anyone who can connect loads rows as the user the importer logged in with.
+void arrow_socket_insert(RowToColumnLoader& row_loader,
+                         const Importer_NS::CopyParams& copy_params,
+                         const std::string& address,
+                         const int port) {
+  const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    LOG(FATAL) << "Could not create a socket: " << strerror(errno);
+  }
+  const int reuse = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    LOG(FATAL) << "Invalid listen address " << address;
+  }
+  addr.sin_port = htons(port);
+  if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) || listen(listen_fd, 1)) {
+    LOG(FATAL) << "Could not listen on " << address << ":" << port << ": " << strerror(errno);
+  }
+  LOG(INFO) << "Waiting for Arrow streams on " << address << ":" << port;
+  while (true) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno != EINTR) {
+        LOG(ERROR) << "Could not accept a connection: " << strerror(errno);
+      }
+      continue;
+    }
+    try {
+      arrow_stream_insert(row_loader, copy_params, fd);
+    } catch (const std::exception& e) {
+      // the batches loaded before the error stay loaded
+      LOG(ERROR) << "Dropping the connection: " << e.what();
+    }
+    close(fd);
+  }
+}
+
 int main(int argc, char** argv) {
   std::string server_host("localhost");  // default to localhost
   int port = 9091;                       // default port number
@@ -184,6 +242,9 @@ int main(int argc, char** argv) {
   std::string passwd;
   std::string delim_str(","), nulls("\\N"), line_delim_str("\n"), quoted("false");
   size_t batch_size = 10000;
+  std::string format("csv");
+  int listen_port = 0;
+  std::string listen_address("127.0.0.1");
   size_t retry_count = 10;
   size_t retry_wait = 5;
   bool remove_quotes = false;
@@ -209,6 +270,15 @@ int main(int argc, char** argv) {
                      po::value<std::string>(&quoted),
                      "Whether the source contains quoted fields (true/false, default false)");
   desc.add_options()("batch", po::value<size_t>(&batch_size)->default_value(batch_size), "Insert batch size");
+  desc.add_options()("format",
+                     po::value<std::string>(&format)->default_value(format),
+                     "Input format (csv: delimited rows, arrow: Arrow IPC stream of record batches)");
+  desc.add_options()("listen",
+                     po::value<int>(&listen_port),
+                     "Read Arrow streams from connections on this port instead of stdin (arrow format only)");
+  desc.add_options()("listen_address",
+                     po::value<std::string>(&listen_address)->default_value(listen_address),
+                     "IPv4 address to listen on, connections aren't authenticated so expose it with care");
   desc.add_options()(
       "retry_count", po::value<size_t>(&retry_count)->default_value(retry_count), "Number of time to retry an insert");
   desc.add_options()(
@@ -231,7 +301,8 @@ int main(int argc, char** argv) {
           << "Usage: <table name> <database name> {-u|--user} <user> {-p|--passwd} <password> [{--host} "
              "<hostname>][--port <port number>][--delim <delimiter>][--null <null string>][--line <line "
              "delimiter>][--batch <batch size>][{-t|--transform} transformation [--quoted <true|false>] "
-             "...][--retry_count <num_of_retries>] [--retry_wait <wait in secs>][--print_error][--print_transform]\n\n";
+             "...][--retry_count <num_of_retries>] [--retry_wait <wait in secs>][--format <csv|arrow>][--listen "
+             "<port number>][--listen_address <address>][--print_error][--print_transform]\n\n";
       std::cout << desc << std::endl;
       return 0;
     }
@@ -338,8 +409,33 @@ int main(int argc, char** argv) {
         std::unique_ptr<std::string>(new std::string(fmt_str)));
   }
 
+  if (format != "csv" && format != "arrow") {
+    std::cerr << "Unsupported input format: " << format << std::endl;
+    return 1;
+  }
+  if (format != "arrow" && listen_port) {
+    std::cerr << "--listen is only supported with --format arrow" << std::endl;
+    return 1;
+  }
+  if (format != "csv" && !transformations.empty()) {
+    std::cerr << "Transformations are only supported with --format csv" << std::endl;
+    return 1;
+  }
+
   Importer_NS::CopyParams copy_params(delim, nulls, line_delim, batch_size, retry_count, retry_wait);
   RowToColumnLoader row_loader(server_host, port, db_name, user_name, passwd, table_name);
+  if (format == "arrow") {
+    if (listen_port) {
+      arrow_socket_insert(row_loader, copy_params, listen_address, listen_port);  // doesn't return
+    }
+    try {
+      arrow_stream_insert(row_loader, copy_params, STDIN_FILENO);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
   stream_insert(row_loader, transformations, copy_params, remove_quotes);
   return 0;
 }
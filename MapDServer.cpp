@@ -21,6 +21,7 @@
 #include <thrift/concurrency/ThreadManager.h>
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/protocol/TJSONProtocol.h>
+#include <thrift/server/TThreadPoolServer.h>
 #include <thrift/server/TThreadedServer.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/THttpServer.h>
@@ -28,10 +29,14 @@
 
 #include "MapDRelease.h"
 
+#include "Fragmenter/InsertOrderFragmenter.h"
+#include "Fragmenter/InsertWal.h"
+#include "QueryEngine/SpillFile.h"
 #include "Shared/MapDParameters.h"
 #include "Shared/mapd_shared_ptr.h"
 #include "Shared/measure.h"
 #include "Shared/scope.h"
+#include "Shared/thread_count.h"
 
 #include <signal.h>
 #include <boost/algorithm/string.hpp>
@@ -49,7 +54,9 @@ using namespace ::apache::thrift::server;
 using namespace ::apache::thrift::transport;
 
 extern bool g_aggregator;
+extern bool g_leaf;
 extern size_t g_leaf_count;
+extern size_t g_query_result_cache_bytes;
 
 AggregatedColRange column_ranges_from_thrift(const std::vector<TColumnRange>& thrift_column_ranges) {
   AggregatedColRange column_ranges;
@@ -138,7 +145,7 @@ void register_signal_handler() {
   signal(SIGTERM, mapd_signal_handler);
 }
 
-void start_server(TThreadedServer& server) {
+void start_server(TServer& server) {
   try {
     server.serve();
   } catch (std::exception& e) {
@@ -146,6 +153,34 @@ void start_server(TThreadedServer& server) {
   }
 }
 
+mapd::shared_ptr<ThreadManager> make_thread_manager(const size_t worker_count, const size_t max_queued_connections) {
+  auto thread_manager = ThreadManager::newSimpleThreadManager(worker_count, max_queued_connections);
+  thread_manager->threadFactory(mapd::make_shared<PlatformThreadFactory>());
+  thread_manager->start();
+  return thread_manager;
+}
+
+// A thread-pool server keeps a fixed set of workers and queues accepted connections once all of them are busy;
+// the accepting thread blocks while the queue is full. A worker serves a connection until the client closes it.
+std::unique_ptr<TServer> make_server(const std::string& transport,
+                                     const bool use_thread_pool,
+                                     const size_t worker_count,
+                                     const size_t max_queued_connections,
+                                     MapDHandler& handler,
+                                     mapd::shared_ptr<TProcessor> processor,
+                                     mapd::shared_ptr<TServerTransport> server_transport,
+                                     mapd::shared_ptr<TTransportFactory> transport_factory,
+                                     mapd::shared_ptr<TProtocolFactory> protocol_factory) {
+  if (!use_thread_pool) {
+    return std::unique_ptr<TServer>(
+        new TThreadedServer(processor, server_transport, transport_factory, protocol_factory));
+  }
+  auto thread_manager = make_thread_manager(worker_count, max_queued_connections);
+  handler.registerRequestQueue(transport, thread_manager);
+  return std::unique_ptr<TServer>(
+      new TThreadPoolServer(processor, server_transport, transport_factory, protocol_factory, thread_manager));
+}
+
 mapd::shared_ptr<MapDHandler> warmup_handler = 0;  // global "warmup_handler" needed to avoid circular dependency
                                                    // between "MapDHandler" & function "run_warmup_queries"
 
@@ -244,6 +279,11 @@ int main(int argc, char** argv) {
   std::string db_convert_dir("");  // path to mapd DB to convert from; if path is empty, no conversion is requested
   std::string db_query_file("");   // path to file containing warmup queries list
   bool enable_access_priv_check = true;  // enable DB objects access privileges checking
+  std::string thrift_server_type("threaded");
+  size_t thrift_worker_threads = 0;  // 0 sizes the pool from the number of cpu threads
+  size_t thrift_max_queued_connections = 1024;
+  size_t max_concurrent_queries = 0;  // 0 for no limit
+  size_t max_queued_queries = 0;      // 0 for no limit
 
   namespace po = boost::program_options;
 
@@ -360,6 +400,15 @@ int main(int argc, char** argv) {
                          "Allow the queries which failed on GPU to retry on CPU, even when watchdog is enabled");
   desc_adv.add_options()(
       "db-query-list", po::value<std::string>(&db_query_file), "Path to file containing mapd queries");
+  desc_adv.add_options()("lazy-table-activation",
+                         po::value<bool>(&mapd_parameters.lazy_table_activation)
+                             ->default_value(mapd_parameters.lazy_table_activation)
+                             ->implicit_value(true),
+                         "Load all tables in the background after startup, most frequently accessed first");
+  desc_adv.add_options()(
+      "table-prewarm-threads",
+      po::value<size_t>(&mapd_parameters.table_prewarm_threads)->default_value(mapd_parameters.table_prewarm_threads),
+      "Number of threads per database loading tables in the background");
   desc_adv.add_options()(
       "enable-access-priv-check",
       po::value<bool>(&enable_access_priv_check)->default_value(enable_access_priv_check)->implicit_value(true),
@@ -373,6 +422,80 @@ int main(int argc, char** argv) {
                              ->default_value(g_inner_join_fragment_skipping)
                              ->implicit_value(true),
                          "Enable/disable inner join fragment skipping.");
+  desc_adv.add_options()(
+      "enable-spatial-join",
+      po::value<bool>(&g_enable_spatial_join)->default_value(g_enable_spatial_join)->implicit_value(true),
+      "Use a grid of the inner geometries for joins on ST_Contains and ST_Distance instead of a loop join.");
+  desc_adv.add_options()("enable-metadata-aggregates",
+                         po::value<bool>(&g_enable_metadata_aggregates)
+                             ->default_value(g_enable_metadata_aggregates)
+                             ->implicit_value(true),
+                         "Answer MIN, MAX and COUNT from fragment metadata when the fragments allow it.");
+  desc_adv.add_options()("enable-materialized-view-rewrite",
+                         po::value<bool>(&g_enable_materialized_view_rewrite)
+                             ->default_value(g_enable_materialized_view_rewrite)
+                             ->implicit_value(true),
+                         "Answer aggregate queries from up to date materialized views when they match.");
+  desc_adv.add_options()("subquery-result-cache-bytes",
+                         po::value<size_t>(&g_subquery_result_cache_bytes)->default_value(g_subquery_result_cache_bytes),
+                         "Memory budget for reusing sub-query results until the tables they read change, 0 to disable.");
+  desc_adv.add_options()("query-result-cache-bytes",
+                         po::value<size_t>(&g_query_result_cache_bytes)->default_value(g_query_result_cache_bytes),
+                         "Memory budget for caching SELECT results until the tables they read change, 0 to disable.");
+  desc_adv.add_options()("spill-memory-budget",
+                         po::value<size_t>(&g_spill_memory_budget)->default_value(g_spill_memory_budget),
+                         "Bytes of sort keys and overflowing group-by partitions a query keeps in memory before "
+                         "spilling them to mapd_spill under the data directory. Spilling is off by default (0).");
+  desc_adv.add_options()(
+      "enable-insert-wal",
+      po::value<bool>(&g_enable_insert_wal)->default_value(g_enable_insert_wal)->implicit_value(true),
+      "Log the inserts into disk tables and commit them with a shared fsync of the log instead of a checkpoint of "
+      "the table per insert. SQL INSERT statements hold the executor lock across their fsync, only concurrent loads "
+      "share it.");
+  desc_adv.add_options()(
+      "insert-wal-checkpoint-bytes",
+      po::value<size_t>(&g_insert_wal_checkpoint_bytes)->default_value(g_insert_wal_checkpoint_bytes),
+      "Size of the insert log of a table which triggers a background checkpoint of the table.");
+  desc_adv.add_options()("insert-wal-checkpoint-ms",
+                         po::value<size_t>(&g_insert_wal_checkpoint_ms)->default_value(g_insert_wal_checkpoint_ms),
+                         "Milliseconds since the last checkpoint of a table after which an insert into it triggers a "
+                         "background checkpoint.");
+  desc_adv.add_options()(
+      "enable-delta-store",
+      po::value<bool>(&g_enable_delta_store)->default_value(g_enable_delta_store)->implicit_value(true),
+      "Keep the rows inserted into disk tables in memory, where queries see them right away, and merge them into "
+      "the fragments of the table in large batches. Unless the insert log is enabled too, rows not merged yet are "
+      "lost in a crash.");
+  desc_adv.add_options()("delta-store-merge-rows",
+                         po::value<size_t>(&g_delta_store_merge_rows)->default_value(g_delta_store_merge_rows),
+                         "Rows in the delta store of a table which trigger a background merge.");
+  desc_adv.add_options()("delta-store-merge-ms",
+                         po::value<size_t>(&g_delta_store_merge_ms)->default_value(g_delta_store_merge_ms),
+                         "Milliseconds since the last merge of a table after which an insert into its delta store "
+                         "triggers a background merge.");
+  desc_adv.add_options()("thrift-server-type",
+                         po::value<std::string>(&thrift_server_type)->default_value(thrift_server_type),
+                         "Thrift server for the binary and HTTP ports: threaded (a thread per connection) or "
+                         "thread-pool (bounded workers, connections are queued while all of them are busy).");
+  desc_adv.add_options()("thrift-worker-threads",
+                         po::value<size_t>(&thrift_worker_threads)->default_value(thrift_worker_threads),
+                         "Workers per port for the thread-pool server, 0 for twice the number of cpu threads. A worker "
+                         "serves a connection until the client closes it.");
+  desc_adv.add_options()(
+      "thrift-max-queued-connections",
+      po::value<size_t>(&thrift_max_queued_connections)->default_value(thrift_max_queued_connections),
+      "Connections queued per port by the thread-pool server before it stops accepting, 0 for no limit.");
+  desc_adv.add_options()("max-concurrent-queries",
+                         po::value<size_t>(&max_concurrent_queries)->default_value(max_concurrent_queries),
+                         "Queries run at once across the binary and HTTP ports, 0 for no limit. Idle connections "
+                         "don't count against the limit.");
+  desc_adv.add_options()("max-queued-queries",
+                         po::value<size_t>(&max_queued_queries)->default_value(max_queued_queries),
+                         "Queries waiting for one of the running ones to finish before new ones are rejected, 0 for no "
+                         "limit.");
+  desc_adv.add_options()("auto-vacuum-threshold",
+                         po::value<double>(&g_auto_vacuum_threshold)->default_value(g_auto_vacuum_threshold),
+                         "Compact a fragment after DELETE once this fraction of its rows is deleted (0 to disable).");
 
   po::positional_options_description positionalOptions;
   positionalOptions.add("data", 1);
@@ -406,9 +529,12 @@ int main(int argc, char** argv) {
         g_aggregator = true;
       } else {
         db_leaves.clear();
+        g_leaf = true;
       }
       string_leaves = only_string_leaves(all_nodes);
-      g_cluster = true;
+      // Without a string dictionary server every leaf encodes strings with its own dictionaries
+      // and runs the queries it gets from the aggregator like a single node would.
+      g_cluster = g_aggregator || !string_leaves.empty();
     }
 
     if (vm.count("help")) {
@@ -449,6 +575,15 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  if (thrift_server_type != "threaded" && thrift_server_type != "thread-pool") {
+    std::cerr << "thrift-server-type must be threaded or thread-pool." << std::endl;
+    return 1;
+  }
+  const bool use_thread_pool = thrift_server_type == "thread-pool";
+  if (!thrift_worker_threads) {
+    thrift_worker_threads = 2 * cpu_threads();
+  }
+
   if (g_hll_precision_bits < 1 || g_hll_precision_bits > 16) {
     std::cerr << "hll-precision-bits must be between 1 and 16." << std::endl;
     return 1;
@@ -498,6 +633,12 @@ int main(int argc, char** argv) {
   // Initialize Google's logging library.
   google::InitGoogleLogging(argv[0]);
 
+  // Spill files are only needed while their query runs, leftovers of a crash are removed here.
+  const auto spill_path = boost::filesystem::path(base_path) / "mapd_spill";
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(spill_path, ec);
+  g_spill_dir = spill_path.string();
+
   boost::algorithm::trim_if(db_query_file, boost::is_any_of("\"'"));
   if (db_query_file.length() > 0 && !boost::filesystem::exists(db_query_file)) {
     LOG(ERROR) << "File containing DB queries " << db_query_file << " does not exist.";
@@ -563,6 +704,18 @@ int main(int argc, char** argv) {
   LOG(INFO) << " calcite JVM max memory  " << mapd_parameters.calcite_max_mem;
   LOG(INFO) << " MapD Server Port  " << mapd_parameters.mapd_server_port;
   LOG(INFO) << " MapD Calcite Port  " << mapd_parameters.calcite_port;
+  if (mapd_parameters.lazy_table_activation) {
+    LOG(INFO) << " Table prewarm threads  " << mapd_parameters.table_prewarm_threads;
+  }
+  LOG(INFO) << " Thrift server type  " << thrift_server_type;
+  if (use_thread_pool) {
+    LOG(INFO) << " Thrift worker threads  " << thrift_worker_threads;
+    LOG(INFO) << " Thrift max queued connections  " << thrift_max_queued_connections;
+  }
+  if (max_concurrent_queries) {
+    LOG(INFO) << " Max concurrent queries  " << max_concurrent_queries;
+    LOG(INFO) << " Max queued queries  " << max_queued_queries;
+  }
 
   boost::algorithm::trim_if(authMetadata.distinguishedName, boost::is_any_of("\"'"));
   boost::algorithm::trim_if(authMetadata.uri, boost::is_any_of("\"'"));
@@ -593,6 +746,9 @@ int main(int argc, char** argv) {
                                                         db_convert_dir,
                                                         enable_legacy_syntax,
                                                         enable_access_priv_check));
+  if (max_concurrent_queries) {
+    handler->limitConcurrentQueries(max_concurrent_queries, max_queued_queries);
+  }
 
   if (mapd_parameters.ha_group_id.empty()) {
     mapd::shared_ptr<TProcessor> processor(new MapDProcessor(handler));
@@ -601,15 +757,31 @@ int main(int argc, char** argv) {
 
     mapd::shared_ptr<TTransportFactory> bufTransportFactory(new TBufferedTransportFactory());
     mapd::shared_ptr<TProtocolFactory> bufProtocolFactory(new TBinaryProtocolFactory());
-    TThreadedServer bufServer(processor, bufServerTransport, bufTransportFactory, bufProtocolFactory);
+    auto bufServer = make_server("binary",
+                                 use_thread_pool,
+                                 thrift_worker_threads,
+                                 thrift_max_queued_connections,
+                                 *handler,
+                                 processor,
+                                 bufServerTransport,
+                                 bufTransportFactory,
+                                 bufProtocolFactory);
 
     mapd::shared_ptr<TServerTransport> httpServerTransport(new TServerSocket(http_port));
     mapd::shared_ptr<TTransportFactory> httpTransportFactory(new THttpServerTransportFactory());
     mapd::shared_ptr<TProtocolFactory> httpProtocolFactory(new TJSONProtocolFactory());
-    TThreadedServer httpServer(processor, httpServerTransport, httpTransportFactory, httpProtocolFactory);
-
-    std::thread bufThread(start_server, std::ref(bufServer));
-    std::thread httpThread(start_server, std::ref(httpServer));
+    auto httpServer = make_server("http",
+                                  use_thread_pool,
+                                  thrift_worker_threads,
+                                  thrift_max_queued_connections,
+                                  *handler,
+                                  processor,
+                                  httpServerTransport,
+                                  httpTransportFactory,
+                                  httpProtocolFactory);
+
+    std::thread bufThread(start_server, std::ref(*bufServer));
+    std::thread httpThread(start_server, std::ref(*httpServer));
 
     // run warm up queries if any exists
     run_warmup_queries(handler, base_path, db_query_file);
@@ -42,6 +42,7 @@
 #include "../QueryEngine/Execute.h"
 #include "../QueryEngine/ExtensionFunctionsWhitelist.h"
 #include "../QueryEngine/RelAlgExecutor.h"
+#include "../QueryEngine/RelAlgOptimizer.h"
 #include "../Shared/mapd_glob.h"
 #include "../Shared/measure.h"
 #include "DataMgr/LockMgr.h"
@@ -1552,6 +1553,8 @@ void InsertStmt::analyze(const Catalog_Namespace::Catalog& catalog, Analyzer::Qu
     throw std::runtime_error("Table " + *table + " does not exist.");
   if (td->isView)
     throw std::runtime_error("Insert to views is not supported yet.");
+  if (catalog.getMaterializedView(td->tableId))
+    throw std::runtime_error(*table + " is a materialized view.  Use REFRESH MATERIALIZED VIEW.");
   query.set_result_table_id(td->tableId);
   std::list<int> result_col_list;
   if (column_list.empty()) {
@@ -1814,6 +1817,24 @@ void validate_shard_column_type(const size_t shard_column_id, const std::list<Co
                            col_ti.get_compression_name());
 }
 
+// Returns the id the named column will get in the catalog, accounting for the physical
+// columns added after each geo column, or 0 if there's no such column.
+int sort_column_id(const std::string& name, const std::list<ColumnDescriptor>& columns) {
+  int column_id = 1;
+  for (const auto& cd : columns) {
+    if (cd.columnName == name) {
+      const auto& col_ti = cd.columnType;
+      if (col_ti.is_varlen()) {
+        throw std::runtime_error("Cannot sort on type " + col_ti.get_type_name() + ", encoding " +
+                                 col_ti.get_compression_name());
+      }
+      return column_id;
+    }
+    column_id += 1 + cd.columnType.get_physical_cols();
+  }
+  throw std::runtime_error("Specified sort column " + name + " doesn't exist");
+}
+
 void set_string_field(rapidjson::Value& obj,
                       const std::string& field_name,
                       const std::string& field_value,
@@ -2033,6 +2054,18 @@ void CreateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
         // encoding longitude/latitude as integers
         cd.columnType.set_compression(kENCODING_GEOINT);
         cd.columnType.set_comp_param(comp_param);
+      } else if (boost::iequals(comp, "days")) {
+        if (cd.columnType.get_type() != kDATE)
+          throw std::runtime_error(cd.columnName + ": Days encoding is only supported on DATE columns.");
+        if (compression->get_encoding_param() == 0)
+          comp_param = 32;  // default to 32-bits
+        else
+          comp_param = compression->get_encoding_param();
+        if (comp_param != 16 && comp_param != 32)
+          throw std::runtime_error(cd.columnName + ": Compression parameter for Days encoding must be 16 or 32.");
+        // dates stored as days since the epoch
+        cd.columnType.set_compression(kENCODING_DATE_IN_DAYS);
+        cd.columnType.set_comp_param(comp_param);
       } else
         throw std::runtime_error(cd.columnName + ": Invalid column compression scheme " + comp);
     }
@@ -2132,9 +2165,16 @@ void CreateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
         } else {
           td.hasDeletedCol = true;
         }
+      } else if (boost::iequals(*p->get_name(), "sort_column")) {
+        const auto sort_column = dynamic_cast<const StringLiteral*>(p->get_value());
+        if (!sort_column) {
+          throw std::runtime_error("SORT_COLUMN must be a string literal.");
+        }
+        td.sortedColumnId = sort_column_id(*sort_column->get_stringval(), columns);
       } else {
         throw std::runtime_error("Invalid CREATE TABLE option " + *p->get_name() +
-                                 ".  Should be FRAGMENT_SIZE, PAGE_SIZE, MAX_ROWS, PARTITIONS, VACUUM or SHARD_COUNT.");
+                                 ".  Should be FRAGMENT_SIZE, PAGE_SIZE, MAX_ROWS, PARTITIONS, VACUUM, SORT_COLUMN or "
+                                 "SHARD_COUNT.");
       }
     }
   }
@@ -2151,7 +2191,8 @@ void CreateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
 
 std::shared_ptr<ResultSet> getResultRows(const Catalog_Namespace::SessionInfo& session,
                                          const std::string select_stmt,
-                                         std::vector<TargetMetaInfo>& targets) {
+                                         std::vector<TargetMetaInfo>& targets,
+                                         const ScannedRowRange& row_range = {-1, 0, 0}) {
   auto& catalog = session.get_catalog();
 
   auto executor = Executor::getExecutor(catalog.get_currentDB().dbId);
@@ -2167,6 +2208,7 @@ std::shared_ptr<ResultSet> getResultRows(const Catalog_Namespace::SessionInfo& s
   CompilationOptions co = {device_type, true, ExecutorOptLevel::LoopStrengthReduction, false};
   ExecutionOptions eo = {false, true, false, true, false, false, false, false, 10000};
   RelAlgExecutor ra_executor(executor.get(), catalog);
+  ra_executor.setScannedRowRange(row_range);
   ExecutionResult result{
       std::make_shared<ResultSet>(
           std::vector<TargetInfo>{}, ExecutorDeviceType::CPU, QueryMemoryDescriptor{}, nullptr, nullptr),
@@ -2236,57 +2278,44 @@ int8_t* fill_dict_column(std::vector<std::unique_ptr<int8_t[]>>& dest_string_ids
   return dest_string_ids_owner.back().get();
 }
 
-}  // namespace
-
-void CreateTableAsSelectStmt::execute(const Catalog_Namespace::SessionInfo& session) {
-  if (g_cluster) {
-    throw std::runtime_error("Distributed CTAS not supported yet");
-  }
-  auto& catalog = session.get_catalog();
-
-  // check access privileges
-  if (!session.checkDBAccessPrivileges(DBObjectType::TableDBObjectType, AccessPrivileges::CREATE_TABLE)) {
-    throw std::runtime_error("CTAS failed. Table " + table_name_ +
-                             " will not be created. User has no create privileges.");
-  }
-
-  if (catalog.getMetadataForTable(table_name_) != nullptr) {
-    throw std::runtime_error("Table " + table_name_ + " already exists.");
+// The definitions of materialized views refer to the names of their source tables and columns.
+void check_no_materialized_views(const Catalog_Namespace::Catalog& catalog, const TableDescriptor* td) {
+  if (!catalog.getMaterializedViewsForTable(td->tableId).empty()) {
+    throw std::runtime_error("Table " + td->tableName + " is the source of materialized views.  Drop them first.");
   }
+}
 
-  // get read UpdateDeleteLock on tables involved in SELECT subquery
-  const auto query_ra = parse_to_ra(catalog, select_query_, session);
-  std::vector<std::shared_ptr<VLock>> readUpdateDeleteLocks;
-  Lock_Namespace::getTableLocks<mapd_shared_mutex>(
-      session.get_catalog(), query_ra, readUpdateDeleteLocks, Lock_Namespace::LockType::UpdateDeleteLock);
-  // [ write UpdateDeleteLocks ] lock is deferred in InsertOrderFragmenter::deleteFragments
-
-  std::vector<TargetMetaInfo> target_metainfos;
-  const auto result_rows = getResultRows(session, select_query_, target_metainfos);
+// The columns of a table holding the rows of a query with the given targets.
+std::list<ColumnDescriptor> get_columns_for_targets(const std::vector<TargetMetaInfo>& target_metainfos,
+                                                    const std::string& stmt_name) {
   std::list<ColumnDescriptor> column_descriptors;
-  std::vector<SQLTypeInfo> logical_column_types;
   for (const auto& target_metainfo : target_metainfos) {
     ColumnDescriptor cd;
     cd.columnName = target_metainfo.get_resname();
     cd.columnType = target_metainfo.get_type_info();
     if (cd.columnType.get_size() < 0) {
-      throw std::runtime_error("Variable-length type " + cd.columnType.get_type_name() + " not supported in CTAS");
+      throw std::runtime_error("Variable-length type " + cd.columnType.get_type_name() + " not supported in " +
+                               stmt_name);
     }
     if (cd.columnType.get_compression() == kENCODING_FIXED) {
-      throw std::runtime_error("Fixed encoding integers not supported in CTAS");
+      throw std::runtime_error("Fixed encoding integers not supported in " + stmt_name);
     }
     if (cd.columnType.get_compression() == kENCODING_DICT) {
       cd.columnType.set_comp_param(cd.columnType.get_size() * 8);
-      logical_column_types.push_back(target_metainfo.get_type_info());
-    } else {
-      logical_column_types.push_back(get_logical_type_info(target_metainfo.get_type_info()));
     }
     column_descriptors.push_back(cd);
   }
+  return column_descriptors;
+}
+
+TableDescriptor get_table_for_targets(const std::string& table_name,
+                                      const Catalog_Namespace::SessionInfo& session,
+                                      const size_t column_count,
+                                      const bool is_temporary) {
   TableDescriptor td;
-  td.tableName = table_name_;
+  td.tableName = table_name;
   td.userId = session.get_currentUser().userId;
-  td.nColumns = column_descriptors.size();
+  td.nColumns = column_count;
   td.isView = false;
   td.fragmenter = nullptr;
   td.fragType = Fragmenter_Namespace::FragmenterType::INSERT_ORDER;
@@ -2295,60 +2324,106 @@ void CreateTableAsSelectStmt::execute(const Catalog_Namespace::SessionInfo& sess
   td.fragPageSize = DEFAULT_PAGE_SIZE;
   td.maxRows = DEFAULT_MAX_ROWS;
   td.keyMetainfo = "[]";
-  if (is_temporary_) {
+  if (is_temporary) {
     td.persistenceLevel = Data_Namespace::MemoryLevel::CPU_LEVEL;
   } else {
     td.persistenceLevel = Data_Namespace::MemoryLevel::DISK_LEVEL;
   }
+  return td;
+}
+
+// Appends the rows of a query result to a table created by get_columns_for_targets for the same targets.
+// The caller holds the CheckpointLock of the table.
+void insert_result_rows(const Catalog_Namespace::Catalog& catalog,
+                        const TableDescriptor* td,
+                        const std::vector<TargetMetaInfo>& target_metainfos,
+                        const std::shared_ptr<ResultSet>& result_rows) {
+  if (result_rows->definitelyHasNoRows()) {
+    return;
+  }
+  std::vector<SQLTypeInfo> logical_column_types;
+  for (const auto& target_metainfo : target_metainfos) {
+    const auto& ti = target_metainfo.get_type_info();
+    logical_column_types.push_back(ti.get_compression() == kENCODING_DICT ? ti : get_logical_type_info(ti));
+  }
+  const auto row_set_mem_owner = result_rows->getRowSetMemOwner();
+  ColumnarResults columnar_results(row_set_mem_owner, *result_rows, target_metainfos.size(), logical_column_types);
+  Fragmenter_Namespace::InsertData insert_data;
+  insert_data.databaseId = catalog.get_currentDB().dbId;
+  insert_data.tableId = td->tableId;
+  const auto column_descriptors = catalog.getAllColumnMetadataForTable(td->tableId, false, false, false);
+  const auto& column_buffers = columnar_results.getColumnBuffers();
+  CHECK_EQ(column_descriptors.size(), column_buffers.size());
+  size_t col_idx = 0;
+  std::vector<std::unique_ptr<int8_t[]>> dest_string_ids_owner;
+  for (const auto cd : column_descriptors) {
+    DataBlockPtr p;
+    insert_data.columnIds.push_back(cd->columnId);
+    if (cd->columnType.get_compression() == kENCODING_DICT) {
+      const auto source_dd = catalog.getMetadataForDict(target_metainfos[col_idx].get_type_info().get_comp_param());
+      CHECK(source_dd);
+      const auto dest_dd = catalog.getMetadataForDict(cd->columnType.get_comp_param());
+      CHECK(dest_dd);
+      const auto dest_ids = fill_dict_column(dest_string_ids_owner,
+                                             dest_dd->stringDict.get(),
+                                             column_buffers[col_idx],
+                                             source_dd->stringDict.get(),
+                                             columnar_results.size(),
+                                             cd->columnType);
+      p.numbersPtr = reinterpret_cast<int8_t*>(dest_ids);
+    } else {
+      p.numbersPtr = const_cast<int8_t*>(column_buffers[col_idx]);
+    }
+    insert_data.data.push_back(p);
+    ++col_idx;
+  }
+  // [ write UpdateDeleteLocks ] lock is deferred in InsertOrderFragmenter::deleteFragments
+  insert_data.numRows = columnar_results.size();
+  td->fragmenter->insertData(insert_data);
+}
+
+}  // namespace
+
+void CreateTableAsSelectStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  if (g_cluster) {
+    throw std::runtime_error("Distributed CTAS not supported yet");
+  }
+  auto& catalog = session.get_catalog();
+
+  // check access privileges
+  if (!session.checkDBAccessPrivileges(DBObjectType::TableDBObjectType, AccessPrivileges::CREATE_TABLE)) {
+    throw std::runtime_error("CTAS failed. Table " + table_name_ +
+                             " will not be created. User has no create privileges.");
+  }
+
+  if (catalog.getMetadataForTable(table_name_) != nullptr) {
+    throw std::runtime_error("Table " + table_name_ + " already exists.");
+  }
+
+  // get read UpdateDeleteLock on tables involved in SELECT subquery
+  const auto query_ra = parse_to_ra(catalog, select_query_, session);
+  std::vector<std::shared_ptr<VLock>> readUpdateDeleteLocks;
+  Lock_Namespace::getTableLocks<mapd_shared_mutex>(
+      session.get_catalog(), query_ra, readUpdateDeleteLocks, Lock_Namespace::LockType::UpdateDeleteLock);
+  // [ write UpdateDeleteLocks ] lock is deferred in InsertOrderFragmenter::deleteFragments
+
+  std::vector<TargetMetaInfo> target_metainfos;
+  const auto result_rows = getResultRows(session, select_query_, target_metainfos);
+  const auto column_descriptors = get_columns_for_targets(target_metainfos, "CTAS");
+  auto td = get_table_for_targets(table_name_, session, column_descriptors.size(), is_temporary_);
   catalog.createTable(td, column_descriptors, {}, true);
   if (result_rows->definitelyHasNoRows()) {
     return;
   }
   const TableDescriptor* created_td{nullptr};
   try {
-    const auto row_set_mem_owner = result_rows->getRowSetMemOwner();
-    ColumnarResults columnar_results(row_set_mem_owner, *result_rows, column_descriptors.size(), logical_column_types);
-    Fragmenter_Namespace::InsertData insert_data;
-    insert_data.databaseId = catalog.get_currentDB().dbId;
     created_td = catalog.getMetadataForTable(table_name_);
     CHECK(created_td);
-    insert_data.tableId = created_td->tableId;
-    std::vector<int> column_ids;
-    const auto& column_buffers = columnar_results.getColumnBuffers();
-    CHECK_EQ(column_descriptors.size(), column_buffers.size());
-    size_t col_idx = 0;
-    std::vector<std::unique_ptr<int8_t[]>> dest_string_ids_owner;
-    for (const auto cd : column_descriptors) {
-      DataBlockPtr p;
-      const auto created_cd = catalog.getMetadataForColumn(insert_data.tableId, cd.columnName);
-      CHECK(created_cd);
-      column_ids.push_back(created_cd->columnId);
-      if (created_cd->columnType.get_compression() == kENCODING_DICT) {
-        const auto source_dd = catalog.getMetadataForDict(target_metainfos[col_idx].get_type_info().get_comp_param());
-        CHECK(source_dd);
-        const auto dest_dd = catalog.getMetadataForDict(created_cd->columnType.get_comp_param());
-        CHECK(dest_dd);
-        const auto dest_ids = fill_dict_column(dest_string_ids_owner,
-                                               dest_dd->stringDict.get(),
-                                               column_buffers[col_idx],
-                                               source_dd->stringDict.get(),
-                                               columnar_results.size(),
-                                               created_cd->columnType);
-        p.numbersPtr = reinterpret_cast<int8_t*>(dest_ids);
-      } else {
-        p.numbersPtr = const_cast<int8_t*>(column_buffers[col_idx]);
-      }
-      insert_data.data.push_back(p);
-      ++col_idx;
-    }
     // get CheckpointLock+UpdateDeleteLock locks on the table before trying to create its 1st fragment
     ChunkKey chunkKey = {catalog.get_currentDB().dbId, created_td->tableId};
     mapd_unique_lock<mapd_shared_mutex> chkptlLock(*Lock_Namespace::LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(
         Lock_Namespace::LockType::CheckpointLock, chunkKey));
-    // [ write UpdateDeleteLocks ] lock is deferred in InsertOrderFragmenter::deleteFragments
-    insert_data.columnIds = column_ids;
-    insert_data.numRows = columnar_results.size();
-    created_td->fragmenter->insertData(insert_data);
+    insert_result_rows(catalog, created_td, target_metainfos, result_rows);
   } catch (...) {
     if (created_td) {
       catalog.dropTable(created_td);
@@ -2378,6 +2453,9 @@ void DropTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
 
   if (td->isView)
     throw std::runtime_error(*table + " is a view.  Use DROP VIEW.");
+  if (catalog.getMaterializedView(td->tableId))
+    throw std::runtime_error(*table + " is a materialized view.  Use DROP MATERIALIZED VIEW.");
+  check_no_materialized_views(catalog, td);
 
   auto chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, *table, LockType::CheckpointLock);
   auto upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, *table, LockType::UpdateDeleteLock);
@@ -2406,9 +2484,45 @@ void TruncateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
 
   if (td->isView)
     throw std::runtime_error(*table + " is a view.  Cannot Truncate.");
+  if (catalog.getMaterializedView(td->tableId))
+    throw std::runtime_error(*table + " is a materialized view.  Cannot Truncate.");
   catalog.truncateTable(td);
 }
 
+void OptimizeTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  auto& catalog = session.get_catalog();
+  const TableDescriptor* td = catalog.getMetadataForTable(*table);
+  if (td == nullptr) {
+    throw std::runtime_error("Table " + *table + " does not exist.");
+  }
+
+  // vacuuming drops deleted rows for good, so it takes the same privilege as deleting them
+  if (SysCatalog::instance().arePrivilegesOn()) {
+    std::vector<DBObject> privObjects;
+    DBObject dbObject(*table, TableDBObjectType);
+    dbObject.loadKey(catalog);
+    dbObject.setPrivileges(AccessPrivileges::DELETE_FROM_TABLE);
+    privObjects.push_back(dbObject);
+    if (!SysCatalog::instance().checkPrivileges(session.get_currentUser(), privObjects)) {
+      throw std::runtime_error("Table " + *table + " will not be optimized. User " +
+                               session.get_currentUser().userName + " has no proper privileges.");
+    }
+  }
+
+  if (td->isView)
+    throw std::runtime_error(*table + " is a view.  Cannot Optimize.");
+  if (!td->hasDeletedCol && !td->sortedColumnId)
+    return;
+
+  auto chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, *table, LockType::CheckpointLock);
+  auto upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, *table, LockType::UpdateDeleteLock);
+  if (td->hasDeletedCol)
+    catalog.vacuumDeletedRows(td);
+  // batches are only sorted as they come in, merge the fragments left small in key order
+  if (td->sortedColumnId)
+    catalog.reclusterRows(td);
+}
+
 void RenameTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   auto& catalog = session.get_catalog();
   const TableDescriptor* td = catalog.getMetadataForTable(*table);
@@ -2423,6 +2537,7 @@ void RenameTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   if (catalog.getMetadataForTable(*new_table_name) != nullptr) {
     throw std::runtime_error("Table or View " + *new_table_name + " already exists.");
   }
+  check_no_materialized_views(catalog, td);
   catalog.renameTable(td, *new_table_name);
 }
 
@@ -2447,6 +2562,7 @@ void RenameColumnStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   if (reserved_keywords.find(boost::to_upper_copy<std::string>(*new_column_name)) != reserved_keywords.end()) {
     throw std::runtime_error("Cannot create column with reserved keyword '" + *new_column_name + "'");
   }
+  check_no_materialized_views(catalog, td);
   catalog.renameColumn(td, cd, *new_column_name);
 }
 
@@ -2473,6 +2589,9 @@ void CopyTableStmt::execute(
 
   auto& catalog = session.get_catalog();
   const TableDescriptor* td = catalog.getMetadataForTable(*table);
+  if (td && catalog.getMaterializedView(td->tableId)) {
+    throw std::runtime_error(*table + " is a materialized view.  Use REFRESH MATERIALIZED VIEW.");
+  }
 
   // if the table already exists, it's locked, so check access privileges
   if (td && SysCatalog::instance().arePrivilegesOn()) {
@@ -3375,6 +3494,202 @@ void DropViewStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   catalog.dropTable(td);
 }
 
+namespace {
+
+const TableDescriptor* get_materialized_view_table(const Catalog_Namespace::Catalog& catalog,
+                                                   const std::string& view_name) {
+  const auto td = catalog.getMetadataForTable(view_name);
+  if (!td || !catalog.getMaterializedView(td->tableId)) {
+    throw std::runtime_error("Materialized view " + view_name + " does not exist.");
+  }
+  return td;
+}
+
+// Appends the partial aggregates of the source rows in [first_row, last_row) to the view table.
+void append_materialized_view_rows(const Catalog_Namespace::SessionInfo& session,
+                                   const TableDescriptor* view_td,
+                                   const TableDescriptor* source_td,
+                                   const std::string& view_sql,
+                                   const int64_t first_row,
+                                   const int64_t last_row) {
+  auto& catalog = session.get_catalog();
+  std::vector<TargetMetaInfo> target_metainfos;
+  const auto result_rows =
+      getResultRows(session, view_sql, target_metainfos, {source_td->tableId, first_row, last_row});
+  ChunkKey chunkKey = {catalog.get_currentDB().dbId, view_td->tableId};
+  mapd_unique_lock<mapd_shared_mutex> chkptlLock(
+      *LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(LockType::CheckpointLock, chunkKey));
+  insert_result_rows(catalog, view_td, target_metainfos, result_rows);
+}
+
+std::mutex materialized_view_refresh_mutex;
+
+void refresh_materialized_view(const Catalog_Namespace::SessionInfo& session, const TableDescriptor* view_td) {
+  std::lock_guard<std::mutex> refresh_lock(materialized_view_refresh_mutex);
+  auto& catalog = session.get_catalog();
+  // appends from here on mark the view again
+  catalog.setMaterializedViewRefreshPending(view_td->tableId, false);
+  const auto mvd = catalog.getMaterializedView(view_td->tableId);
+  CHECK(mvd);
+  const auto source_td = catalog.getMetadataForTable(mvd->sourceTableId);
+  CHECK(source_td);
+  int64_t refreshed_rows = mvd->refreshedRows;
+  int64_t source_rows = 0;
+  {
+    auto upddelLock =
+        getTableLock<mapd_shared_mutex, mapd_shared_lock>(catalog, source_td->tableName, LockType::UpdateDeleteLock);
+    source_rows = source_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples();
+  }
+  if (mvd->needsRebuild || source_rows < refreshed_rows) {
+    // queries on the source hold its UpdateDeleteLock while they may read the view
+    auto source_upddelLock =
+        getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, source_td->tableName, LockType::UpdateDeleteLock);
+    auto chkptlLock =
+        getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, view_td->tableName, LockType::CheckpointLock);
+    auto upddelLock =
+        getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, view_td->tableName, LockType::UpdateDeleteLock);
+    catalog.setMaterializedViewRefreshState(view_td->tableId, 0, true);
+    catalog.truncateTable(view_td);
+    refreshed_rows = 0;
+    source_rows = source_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples();
+  }
+  if (source_rows == refreshed_rows && !mvd->needsRebuild) {
+    return;
+  }
+  // a failure half way leaves rows of the batch behind, the next refresh starts over
+  catalog.setMaterializedViewRefreshState(view_td->tableId, source_rows, true);
+  {
+    auto upddelLock =
+        getTableLock<mapd_shared_mutex, mapd_shared_lock>(catalog, source_td->tableName, LockType::UpdateDeleteLock);
+    append_materialized_view_rows(session, view_td, source_td, mvd->viewSQL, refreshed_rows, source_rows);
+  }
+  catalog.setMaterializedViewRefreshState(view_td->tableId, source_rows, false);
+}
+
+}  // namespace
+
+void refresh_materialized_views(const Catalog_Namespace::SessionInfo& session,
+                                const std::vector<std::string>& table_names) {
+  auto& catalog = session.get_catalog();
+  for (const auto& table_name : table_names) {
+    const auto td = catalog.getMetadataForTable(table_name, false);
+    if (!td) {
+      continue;
+    }
+    for (const auto& mvd : catalog.getMaterializedViewsForTable(td->tableId)) {
+      if (!mvd->refreshPending) {
+        continue;
+      }
+      const auto view_td = catalog.getMetadataForTable(mvd->tableId);
+      CHECK(view_td);
+      try {
+        refresh_materialized_view(session, view_td);
+      } catch (const std::exception& e) {
+        // the query falls back to the source table
+        LOG(WARNING) << "Refresh of materialized view " << view_td->tableName << " failed: " << e.what();
+      }
+    }
+  }
+}
+
+void CreateMaterializedViewStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  if (g_cluster) {
+    throw std::runtime_error("Distributed materialized views not supported yet");
+  }
+  auto& catalog = session.get_catalog();
+
+  if (!session.checkDBAccessPrivileges(DBObjectType::TableDBObjectType, AccessPrivileges::CREATE_TABLE)) {
+    throw std::runtime_error("Materialized view " + view_name_ +
+                             " will not be created. User has no create privileges.");
+  }
+
+  if (catalog.getMetadataForTable(view_name_) != nullptr) {
+    if (if_not_exists_) {
+      return;
+    }
+    throw std::runtime_error("Table or View " + view_name_ + " already exists.");
+  }
+
+  const auto query_after_shim = pg_shim(select_query_);
+  const auto view_ra = catalog.get_calciteMgr().process(session, query_after_shim, true, false).plan_result;
+  const auto source_td = check_materialized_view_plan(deserialize_materialized_view_ra(view_ra, catalog));
+  CHECK(source_td);
+  if (source_td->isView || source_td->nShards || source_td->maxRows != DEFAULT_MAX_ROWS) {
+    throw std::runtime_error("Materialized view source " + source_td->tableName +
+                             " must be a table without shards and MAX_ROWS.");
+  }
+  if (catalog.getMaterializedView(source_td->tableId)) {
+    throw std::runtime_error("Materialized view source " + source_td->tableName + " is a materialized view.");
+  }
+
+  auto upddelLock =
+      getTableLock<mapd_shared_mutex, mapd_shared_lock>(catalog, source_td->tableName, LockType::UpdateDeleteLock);
+  const int64_t source_rows =
+      source_td->fragmenter ? source_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples() : 0;
+  std::vector<TargetMetaInfo> target_metainfos;
+  const auto result_rows =
+      getResultRows(session, query_after_shim, target_metainfos, {source_td->tableId, 0, source_rows});
+  const auto column_descriptors = get_columns_for_targets(target_metainfos, "materialized views");
+  auto td = get_table_for_targets(view_name_, session, column_descriptors.size(), false);
+  catalog.createTable(td, column_descriptors, {}, true);
+  const TableDescriptor* created_td{nullptr};
+  try {
+    created_td = catalog.getMetadataForTable(view_name_);
+    CHECK(created_td);
+    {
+      ChunkKey chunkKey = {catalog.get_currentDB().dbId, created_td->tableId};
+      mapd_unique_lock<mapd_shared_mutex> chkptlLock(
+          *LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(LockType::CheckpointLock, chunkKey));
+      insert_result_rows(catalog, created_td, target_metainfos, result_rows);
+    }
+    MaterializedViewDescriptor mvd;
+    mvd.tableId = created_td->tableId;
+    mvd.sourceTableId = source_td->tableId;
+    mvd.viewSQL = query_after_shim;
+    mvd.viewRA = view_ra;
+    mvd.refreshedRows = source_rows;
+    mvd.needsRebuild = false;
+    mvd.refreshPending = false;
+    catalog.createMaterializedView(mvd);
+    if (SysCatalog::instance().arePrivilegesOn()) {
+      SysCatalog::instance().createDBObject(session.get_currentUser(), td.tableName, TableDBObjectType, catalog);
+    }
+  } catch (...) {
+    if (created_td) {
+      catalog.dropTable(created_td);
+    }
+    throw;
+  }
+}
+
+void RefreshMaterializedViewStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  auto& catalog = session.get_catalog();
+  const auto td = get_materialized_view_table(catalog, view_name_);
+  if (!session.checkDBAccessPrivileges(
+          DBObjectType::TableDBObjectType, AccessPrivileges::INSERT_INTO_TABLE, view_name_)) {
+    throw std::runtime_error("Materialized view " + view_name_ +
+                             " will not be refreshed. User has no insert privileges.");
+  }
+  refresh_materialized_view(session, td);
+}
+
+void DropMaterializedViewStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  auto& catalog = session.get_catalog();
+  const auto td = catalog.getMetadataForTable(view_name_);
+  if (!td && if_exists_) {
+    return;
+  }
+  get_materialized_view_table(catalog, view_name_);
+  if (!session.checkDBAccessPrivileges(DBObjectType::TableDBObjectType, AccessPrivileges::DROP_TABLE, view_name_)) {
+    throw std::runtime_error("Materialized view " + view_name_ +
+                             " will not be dropped. User has no proper privileges.");
+  }
+  std::lock_guard<std::mutex> refresh_lock(materialized_view_refresh_mutex);
+  auto chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, view_name_, LockType::CheckpointLock);
+  auto upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(catalog, view_name_, LockType::UpdateDeleteLock);
+  catalog.dropTable(td);
+}
+
 void CreateDBStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   if (SysCatalog::instance().arePrivilegesOn() && !session.get_currentUser().isSuper) {
     throw std::runtime_error("CREATE DATABASE command can only be executed by super user.");
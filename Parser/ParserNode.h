@@ -970,6 +970,20 @@ class TruncateTableStmt : public DDLStmt {
   std::unique_ptr<std::string> table;
 };
 
+/*
+ * @type OptimizeTableStmt
+ * @brief OPTIMIZE TABLE statement
+ */
+class OptimizeTableStmt : public DDLStmt {
+ public:
+  OptimizeTableStmt(std::string* tab) : table(tab) {}
+  const std::string* get_table() const { return table.get(); }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  std::unique_ptr<std::string> table;
+};
+
 class RenameTableStmt : public DDLStmt {
  public:
   RenameTableStmt(std::string* tab, std::string* new_tab_name) : table(tab), new_table_name(new_tab_name) {}
@@ -1378,6 +1392,58 @@ class DropViewStmt : public DDLStmt {
   bool if_exists;
 };
 
+/*
+ * @type CreateMaterializedViewStmt
+ * @brief CREATE MATERIALIZED VIEW statement
+ */
+class CreateMaterializedViewStmt : public DDLStmt {
+ public:
+  CreateMaterializedViewStmt(const std::string& view_name, const std::string& select_query, const bool if_not_exists)
+      : view_name_(view_name), select_query_(select_query), if_not_exists_(if_not_exists) {}
+  const std::string& get_view_name() const { return view_name_; }
+  const std::string& get_select_query() const { return select_query_; }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  const std::string view_name_;
+  const std::string select_query_;
+  const bool if_not_exists_;
+};
+
+/*
+ * @type RefreshMaterializedViewStmt
+ * @brief REFRESH MATERIALIZED VIEW statement
+ */
+class RefreshMaterializedViewStmt : public DDLStmt {
+ public:
+  RefreshMaterializedViewStmt(const std::string& view_name) : view_name_(view_name) {}
+  const std::string& get_view_name() const { return view_name_; }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  const std::string view_name_;
+};
+
+/*
+ * @type DropMaterializedViewStmt
+ * @brief DROP MATERIALIZED VIEW statement
+ */
+class DropMaterializedViewStmt : public DDLStmt {
+ public:
+  DropMaterializedViewStmt(const std::string& view_name, const bool if_exists)
+      : view_name_(view_name), if_exists_(if_exists) {}
+  const std::string& get_view_name() const { return view_name_; }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  const std::string view_name_;
+  const bool if_exists_;
+};
+
+// Folds the rows appended to the given tables into their materialized views, called before queries on them.
+void refresh_materialized_views(const Catalog_Namespace::SessionInfo& session,
+                                const std::vector<std::string>& table_names);
+
 /*
  * @type CreateDBStmt
  * @brief CREATE DATABASE statement
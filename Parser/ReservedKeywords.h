@@ -44,6 +44,7 @@ static std::set<std::string> reserved_keywords{
     "MULTIPOLYGON", // geo type
     "NOW",
     "NULLX",
+    "OPTIMIZE",
     "OPTION",
     "POINT",        // geo type
     "POLYGON",      // geo type
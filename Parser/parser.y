@@ -18,6 +18,30 @@
       parseTrees.emplace_back(new CreateViewStmt(view_name, select_query, if_not_exists));                              \
       return 0;                                                                                                         \
     }                                                                                                                   \
+    boost::regex create_materialized_view_expr{R"(CREATE\s+MATERIALIZED\s+VIEW\s+(IF\s+NOT\s+EXISTS\s+)?([A-Za-z_][A-Za-z0-9\$_]*)\s+AS\s+(.*);?)", \
+                                               boost::regex::extended | boost::regex::icase};                           \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, create_materialized_view_expr)) {        \
+      const bool if_not_exists = what[1].length() > 0;                                                                  \
+      const auto view_name = what[2].str();                                                                             \
+      const auto select_query = what[3].str();                                                                          \
+      parseTrees.emplace_back(new CreateMaterializedViewStmt(view_name, select_query, if_not_exists));                  \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
+    boost::regex refresh_materialized_view_expr{R"(REFRESH\s+MATERIALIZED\s+VIEW\s+([A-Za-z_][A-Za-z0-9\$_]*)\s*;)",    \
+                                                boost::regex::extended | boost::regex::icase};                          \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, refresh_materialized_view_expr)) {       \
+      const auto view_name = what[1].str();                                                                             \
+      parseTrees.emplace_back(new RefreshMaterializedViewStmt(view_name));                                              \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
+    boost::regex drop_materialized_view_expr{R"(DROP\s+MATERIALIZED\s+VIEW\s+(IF\s+EXISTS\s+)?([A-Za-z_][A-Za-z0-9\$_]*)\s*;)", \
+                                             boost::regex::extended | boost::regex::icase};                             \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, drop_materialized_view_expr)) {          \
+      const bool if_exists = what[1].length() > 0;                                                                      \
+      const auto view_name = what[2].str();                                                                             \
+      parseTrees.emplace_back(new DropMaterializedViewStmt(view_name, if_exists));                                      \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
     boost::regex create_table_as_expr{R"(CREATE\s+TABLE\s+([A-Za-z_][A-Za-z0-9\$_]*)\s+AS\s+(.*);?)",                   \
                                       boost::regex::extended | boost::regex::icase};                                    \
     if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, create_table_as_expr)) {                 \
@@ -170,7 +194,7 @@ using namespace Parser;
 %token ELSE END EXISTS EXPLAIN EXTRACT FETCH FIRST FLOAT FOR FOREIGN FOUND FROM
 %token GEOGRAPHY GEOMETRY GRANT GROUP HAVING IF ILIKE IN INSERT INTEGER INTO
 %token IS LANGUAGE LAST LENGTH LIKE LIMIT LINESTRING MOD MULTIPOLYGON NOW NULLX NUMERIC OF OFFSET ON OPEN OPTION
-%token ORDER PARAMETER POINT POLYGON PRECISION PRIMARY PRIVILEGES PROCEDURE
+%token OPTIMIZE ORDER PARAMETER POINT POLYGON PRECISION PRIMARY PRIVILEGES PROCEDURE
 %token SMALLINT SOME TABLE TEMPORARY TEXT THEN TIME TIMESTAMP TINYINT TO TRUNCATE UNION
 %token PUBLIC REAL REFERENCES RENAME REVOKE ROLE ROLLBACK SCHEMA SELECT SET SHARD SHARED SHOW
 %token UNIQUE UPDATE USER VALUES VIEW WHEN WHENEVER WHERE WITH WORK
@@ -196,6 +220,7 @@ sql:		/* schema {	$<nodeval>$ = $<nodeval>1; } */
 	| drop_view_statement { $<nodeval>$ = $<nodeval>1; }
 	| drop_table_statement { $<nodeval>$ = $<nodeval>1; }
 	| truncate_table_statement { $<nodeval>$ = $<nodeval>1; }
+	| optimize_table_statement { $<nodeval>$ = $<nodeval>1; }
 	| rename_table_statement { $<nodeval>$ = $<nodeval>1; }
 	| rename_column_statement { $<nodeval>$ = $<nodeval>1; }
   | copy_table_statement { $<nodeval>$ = $<nodeval>1; }
@@ -325,6 +350,12 @@ truncate_table_statement:
 		  $<nodeval>$ = new TruncateTableStmt($<stringval>3);
 		}
 		;
+optimize_table_statement:
+		OPTIMIZE TABLE table
+		{
+		  $<nodeval>$ = new OptimizeTableStmt($<stringval>3);
+		}
+		;
 rename_table_statement:
 		ALTER TABLE table RENAME TO table
 		{
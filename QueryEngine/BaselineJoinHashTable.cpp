@@ -122,6 +122,10 @@ std::vector<InnerOuter> normalize_column_pairs(const Analyzer::BinOper* conditio
   CHECK_EQ(lhs_tuple.size(), rhs_tuple.size());
   for (size_t i = 0; i < lhs_tuple.size(); ++i) {
     result.push_back(normalize_column_pair(lhs_tuple[i].get(), rhs_tuple[i].get(), cat, temporary_tables));
+    if (result.back().first->get_type_info().is_date_in_days()) {
+      // the composite keys are built from the stored days, unlike the single column tables the probe keeps seconds
+      throw HashJoinFail("Cannot apply hash join on composite keys to dates encoded as days");
+    }
   }
   return result;
 }
@@ -74,19 +74,11 @@ llvm::Value* Executor::codegenCast(llvm::Value* operand_lv,
 }
 
 llvm::Value* Executor::codegenCastTimestampToDate(llvm::Value* ts_lv, const bool nullable) {
-  static_assert(sizeof(time_t) == 4 || sizeof(time_t) == 8, "Unsupported time_t size");
   CHECK(ts_lv->getType()->isIntegerTy(32) || ts_lv->getType()->isIntegerTy(64));
-  if (sizeof(time_t) == 4 && ts_lv->getType()->isIntegerTy(64)) {
-    ts_lv = cgen_state_->ir_builder_.CreateCast(
-        llvm::Instruction::CastOps::Trunc, ts_lv, get_int_type(32, cgen_state_->context_));
-  }
-  std::vector<llvm::Value*> datetrunc_args{ll_int(static_cast<int32_t>(dtDAY)), ts_lv};
-  std::string datetrunc_fname{"DateTruncate"};
-  if (nullable) {
-    datetrunc_args.push_back(inlineIntNull(SQLTypeInfo(ts_lv->getType()->isIntegerTy(64) ? kBIGINT : kINT, false)));
-    datetrunc_fname += "Nullable";
-  }
-  return cgen_state_->emitExternalCall(datetrunc_fname, get_int_type(64, cgen_state_->context_), datetrunc_args);
+  const auto date_lv = codegenDateTruncInline(dtDAY, ts_lv, nullptr);
+  CHECK(date_lv);
+  return codegenDateTimeNullable(
+      ts_lv, date_lv, SQLTypeInfo(ts_lv->getType()->isIntegerTy(64) ? kBIGINT : kINT, !nullable));
 }
 
 llvm::Value* Executor::codegenCastFromString(llvm::Value* operand_lv,
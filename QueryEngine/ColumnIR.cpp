@@ -61,7 +61,8 @@ std::shared_ptr<Decoder> get_col_decoder(const Analyzer::ColumnVar* col_var) {
         return std::make_shared<FixedWidthUnsigned>(ti.get_size());
       }
       return std::make_shared<FixedWidthInt>(ti.get_size());
-    case kENCODING_FIXED: {
+    case kENCODING_FIXED:
+    case kENCODING_DATE_IN_DAYS: {
       const auto bit_width = col_var->get_comp_param();
       CHECK_EQ(0, bit_width % 8);
       return std::make_shared<FixedWidthInt>(bit_width / 8);
@@ -212,11 +213,21 @@ llvm::Value* Executor::codegenFixedLengthColVar(const Analyzer::ColumnVar* col_v
                                                            : llvm::Instruction::CastOps::Trunc,
                                                        dec_val,
                                                        get_int_type(col_width, cgen_state_->context_));
-    if ((col_ti.get_compression() == kENCODING_FIXED ||
+    if ((col_ti.get_compression() == kENCODING_FIXED || col_ti.is_date_in_days() ||
          (col_ti.get_compression() == kENCODING_DICT && col_ti.get_size() < 4)) &&
         !col_ti.get_notnull()) {
       dec_val_cast = codgenAdjustFixedEncNull(dec_val_cast, col_ti);
     }
+    if (col_ti.is_date_in_days()) {
+      // the rest of the query works with seconds since the epoch
+      auto& ir_builder = cgen_state_->ir_builder_;
+      auto date_lv = ir_builder.CreateMul(dec_val_cast, ll_int(int64_t(SECSPERDAY)));
+      if (!col_ti.get_notnull()) {
+        date_lv = ir_builder.CreateSelect(
+            ir_builder.CreateICmpEQ(dec_val_cast, inlineIntNull(col_ti)), dec_val_cast, date_lv);
+      }
+      dec_val_cast = date_lv;
+    }
   } else {
     CHECK_EQ(kENCODING_NONE, col_ti.get_compression());
     CHECK(dec_type->isFloatTy() || dec_type->isDoubleTy());
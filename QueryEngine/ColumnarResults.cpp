@@ -26,11 +26,15 @@ namespace {
 
 int64_t fixed_encoding_nullable_val(const int64_t val, const SQLTypeInfo& type_info) {
   if (type_info.get_compression() != kENCODING_NONE) {
-    CHECK(type_info.get_compression() == kENCODING_FIXED || type_info.get_compression() == kENCODING_DICT);
+    CHECK(type_info.get_compression() == kENCODING_FIXED || type_info.get_compression() == kENCODING_DICT ||
+          type_info.is_date_in_days());
     auto logical_ti = get_logical_type_info(type_info);
     if (val == inline_int_null_val(logical_ti)) {
       return inline_fixed_encoding_null_val(type_info);
     }
+    if (type_info.is_date_in_days()) {
+      return get_epoch_days_from_seconds(val);
+    }
   }
   return val;
 }
@@ -15,6 +15,68 @@
  */
 
 #include "Execute.h"
+#include "DateTruncate.h"
+#include "ExtractFromTime.h"
+
+namespace {
+
+// Length and start offset from the epoch of the DATE_TRUNC buckets which span the same number of seconds
+// everywhere on the time line, a zero length for the calendar dependent ones. January 1st 1970 was a Thursday,
+// the weeks start on the Sunday three days later.
+std::pair<int64_t, int64_t> get_fixed_datetrunc_bucket(const DatetruncField field) {
+  switch (field) {
+    case dtMICROSECOND:
+    case dtMILLISECOND:
+    case dtSECOND:
+      return {1, 0};
+    case dtMINUTE:
+      return {SECSPERMIN, 0};
+    case dtHOUR:
+      return {SECSPERHOUR, 0};
+    case dtQUARTERDAY:
+      return {SECSPERQUARTERDAY, 0};
+    case dtDAY:
+      return {SECSPERDAY, 0};
+    case dtWEEK:
+      return {DAYSPERWEEK * SECSPERDAY, 3 * SECSPERDAY};
+    default:
+      return {0, 0};
+  }
+}
+
+// Upper bound of the length of the calendar dependent buckets: truncating the start of a bucket plus this many
+// seconds gives the start of the next one. Zero for the fields which aren't inlined from the expression range.
+int64_t get_max_datetrunc_bucket(const DatetruncField field) {
+  switch (field) {
+    case dtMONTH:
+      return 31 * SECSPERDAY;
+    case dtQUARTER:
+      return 92 * SECSPERDAY;
+    case dtYEAR:
+      return 366 * SECSPERDAY;
+    default:
+      return 0;
+  }
+}
+
+// The DATE_TRUNC field whose buckets hold a single value of the given EXTRACT field.
+DatetruncField get_extract_datetrunc_field(const ExtractField field) {
+  switch (field) {
+    case kYEAR:
+      return dtYEAR;
+    case kQUARTER:
+      return dtQUARTER;
+    case kMONTH:
+      return dtMONTH;
+    default:
+      return dtINVALID;
+  }
+}
+
+// Past this many buckets a chain of selects isn't cheaper than the runtime function anymore.
+const size_t kMaxInlinedDatetruncBuckets{16};
+
+}  // namespace
 
 llvm::Value* Executor::codegen(const Analyzer::ExtractExpr* extract_expr, const CompilationOptions& co) {
   auto from_expr = codegen(extract_expr->get_from_expr(), true, co).front();
@@ -29,6 +91,10 @@ llvm::Value* Executor::codegen(const Analyzer::ExtractExpr* extract_expr, const
     return from_expr;
   }
   CHECK(from_expr->getType()->isIntegerTy(32) || from_expr->getType()->isIntegerTy(64));
+  const auto extract_inline = codegenExtractInline(extract_expr->get_field(), from_expr, extract_expr->get_from_expr());
+  if (extract_inline) {
+    return codegenDateTimeNullable(from_expr, extract_inline, extract_expr_ti);
+  }
   static_assert(sizeof(time_t) == 4 || sizeof(time_t) == 8, "Unsupported time_t size");
   if (sizeof(time_t) == 4 && from_expr->getType()->isIntegerTy(64)) {
     from_expr = cgen_state_->ir_builder_.CreateCast(
@@ -95,6 +161,11 @@ llvm::Value* Executor::codegen(const Analyzer::DatetruncExpr* datetrunc_expr, co
   auto from_expr = codegen(datetrunc_expr->get_from_expr(), true, co).front();
   const auto& datetrunc_expr_ti = datetrunc_expr->get_from_expr()->get_type_info();
   CHECK(from_expr->getType()->isIntegerTy(32) || from_expr->getType()->isIntegerTy(64));
+  const auto datetrunc_inline =
+      codegenDateTruncInline(datetrunc_expr->get_field(), from_expr, datetrunc_expr->get_from_expr());
+  if (datetrunc_inline) {
+    return codegenDateTimeNullable(from_expr, datetrunc_inline, datetrunc_expr_ti);
+  }
   static_assert(sizeof(time_t) == 4 || sizeof(time_t) == 8, "Unsupported time_t size");
   if (sizeof(time_t) == 4 && from_expr->getType()->isIntegerTy(64)) {
     from_expr = cgen_state_->ir_builder_.CreateCast(
@@ -108,3 +179,157 @@ llvm::Value* Executor::codegen(const Analyzer::DatetruncExpr* datetrunc_expr, co
   }
   return cgen_state_->emitExternalCall(datetrunc_fname, get_int_type(64, cgen_state_->context_), datetrunc_args);
 }
+
+// Computes the fields which don't depend on the calendar with a couple of integer operations instead of calling
+// ExtractFromTime for every row, and the month, quarter or year from the expression range if it's narrow enough.
+// Returns nullptr if the runtime function is needed; nulls are left to the caller.
+llvm::Value* Executor::codegenExtractInline(const ExtractField field,
+                                            llvm::Value* ts_lv,
+                                            const Analyzer::Expr* ts_expr) {
+  auto& ir_builder = cgen_state_->ir_builder_;
+  ts_lv = codegenDateTimeToInt64(ts_lv);
+  switch (field) {
+    case kHOUR:
+      return ir_builder.CreateSDiv(codegenFloorMod(ts_lv, SECSPERDAY), ll_int(int64_t(SECSPERHOUR)));
+    case kMINUTE:
+      return ir_builder.CreateSDiv(codegenFloorMod(ts_lv, SECSPERHOUR), ll_int(int64_t(SECSPERMIN)));
+    case kSECOND:
+      return codegenFloorMod(ts_lv, SECSPERMIN);
+    case kQUARTERDAY:
+      return ir_builder.CreateAdd(
+          ir_builder.CreateSDiv(codegenFloorMod(ts_lv, SECSPERDAY), ll_int(int64_t(SECSPERQUARTERDAY))),
+          ll_int(int64_t(1)));
+    case kDOW:
+      // 0 for the Sunday three days after the epoch
+      return ir_builder.CreateSDiv(
+          codegenFloorMod(ir_builder.CreateSub(ts_lv, ll_int(int64_t(3 * SECSPERDAY))), DAYSPERWEEK * SECSPERDAY),
+          ll_int(int64_t(SECSPERDAY)));
+    case kISODOW:
+      // 1 for the Monday four days after the epoch
+      return ir_builder.CreateAdd(
+          ir_builder.CreateSDiv(
+              codegenFloorMod(ir_builder.CreateSub(ts_lv, ll_int(int64_t(4 * SECSPERDAY))), DAYSPERWEEK * SECSPERDAY),
+              ll_int(int64_t(SECSPERDAY))),
+          ll_int(int64_t(1)));
+    default:
+      break;
+  }
+  const auto datetrunc_field = get_extract_datetrunc_field(field);
+  if (datetrunc_field == dtINVALID) {
+    return nullptr;
+  }
+  const auto buckets = getDatetruncBuckets(ts_expr, datetrunc_field);
+  if (buckets.empty()) {
+    return nullptr;
+  }
+  std::vector<int64_t> values;
+  for (const auto bucket : buckets) {
+    values.push_back(ExtractFromTime(field, bucket));
+  }
+  return codegenDateTimeFromBuckets(ts_lv, buckets, values);
+}
+
+// Truncates to the buckets of fixed length with a floor to their multiple instead of calling DateTruncate for
+// every row, and to months, quarters or years from the expression range if it's narrow enough. Returns nullptr if
+// the runtime function is needed; nulls are left to the caller.
+llvm::Value* Executor::codegenDateTruncInline(const DatetruncField field,
+                                              llvm::Value* ts_lv,
+                                              const Analyzer::Expr* ts_expr) {
+  ts_lv = codegenDateTimeToInt64(ts_lv);
+  const auto fixed_bucket = get_fixed_datetrunc_bucket(field);
+  if (fixed_bucket.first == 1) {
+    // this is the limit of current granularity
+    return ts_lv;
+  }
+  if (fixed_bucket.first) {
+    auto& ir_builder = cgen_state_->ir_builder_;
+    auto offset_lv =
+        fixed_bucket.second ? ir_builder.CreateSub(ts_lv, ll_int(int64_t(fixed_bucket.second))) : ts_lv;
+    return ir_builder.CreateSub(ts_lv, codegenFloorMod(offset_lv, fixed_bucket.first));
+  }
+  if (!ts_expr) {
+    return nullptr;
+  }
+  const auto buckets = getDatetruncBuckets(ts_expr, field);
+  if (buckets.empty()) {
+    return nullptr;
+  }
+  return codegenDateTimeFromBuckets(ts_lv, buckets, buckets);
+}
+
+// Starts of the buckets of the given field the values of the expression fall in according to the fragment metadata,
+// empty if the range isn't known or spans too many of them.
+std::vector<int64_t> Executor::getDatetruncBuckets(const Analyzer::Expr* ts_expr, const DatetruncField field) {
+  const int64_t max_bucket = get_max_datetrunc_bucket(field);
+  if (!max_bucket || cgen_state_->query_infos_.empty()) {
+    return {};
+  }
+  const auto col_var = dynamic_cast<const Analyzer::ColumnVar*>(ts_expr);
+  if (col_var && col_var->get_table_id() < 0) {
+    // Computing the range for temporary columns is a lot more expensive than the runtime call.
+    return {};
+  }
+  const auto ts_range = getExpressionRange(ts_expr, cgen_state_->query_infos_, this);
+  if (ts_range.getType() != ExpressionRangeType::Integer) {
+    return {};
+  }
+  std::vector<int64_t> buckets{DateTruncate(field, ts_range.getIntMin())};
+  while (buckets.back() <= std::numeric_limits<int64_t>::max() - max_bucket) {
+    const int64_t next_bucket = DateTruncate(field, buckets.back() + max_bucket);
+    CHECK_GT(next_bucket, buckets.back());
+    if (next_bucket > ts_range.getIntMax()) {
+      break;
+    }
+    if (buckets.size() == kMaxInlinedDatetruncBuckets) {
+      return {};
+    }
+    buckets.push_back(next_bucket);
+  }
+  return buckets;
+}
+
+// Picks the value of the bucket the timestamp falls in with a chain of compares and selects, the timestamp must not
+// be before the first bucket unless it's null.
+llvm::Value* Executor::codegenDateTimeFromBuckets(llvm::Value* ts_lv,
+                                                  const std::vector<int64_t>& buckets,
+                                                  const std::vector<int64_t>& values) {
+  CHECK(!buckets.empty());
+  CHECK_EQ(buckets.size(), values.size());
+  auto& ir_builder = cgen_state_->ir_builder_;
+  llvm::Value* ret = ll_int(values.front());
+  for (size_t i = 1; i < buckets.size(); ++i) {
+    ret = ir_builder.CreateSelect(ir_builder.CreateICmpSGE(ts_lv, ll_int(buckets[i])), ll_int(values[i]), ret);
+  }
+  return ret;
+}
+
+// The non-negative remainder of the division by the given divisor, which floors the timestamps before the epoch.
+llvm::Value* Executor::codegenFloorMod(llvm::Value* ts_lv, const int64_t divisor) {
+  CHECK_GT(divisor, 0);
+  CHECK(ts_lv->getType()->isIntegerTy(64));
+  auto& ir_builder = cgen_state_->ir_builder_;
+  const auto divisor_lv = ll_int(divisor);
+  const auto rem_lv = ir_builder.CreateSRem(ts_lv, divisor_lv);
+  return ir_builder.CreateSelect(
+      ir_builder.CreateICmpSLT(rem_lv, ll_int(int64_t(0))), ir_builder.CreateAdd(rem_lv, divisor_lv), rem_lv);
+}
+
+llvm::Value* Executor::codegenDateTimeToInt64(llvm::Value* ts_lv) {
+  if (ts_lv->getType()->isIntegerTy(64)) {
+    return ts_lv;
+  }
+  CHECK(ts_lv->getType()->isIntegerTy(32));
+  return cgen_state_->ir_builder_.CreateCast(
+      llvm::Instruction::CastOps::SExt, ts_lv, get_int_type(64, cgen_state_->context_));
+}
+
+// Returns the inline result unless the timestamp is null, the null sentinel of its type like the *Nullable runtime
+// functions otherwise.
+llvm::Value* Executor::codegenDateTimeNullable(llvm::Value* ts_lv, llvm::Value* ret_lv, const SQLTypeInfo& ts_ti) {
+  if (ts_ti.get_notnull()) {
+    return ret_lv;
+  }
+  auto& ir_builder = cgen_state_->ir_builder_;
+  const auto null_lv = ll_int(inline_int_null_val(ts_ti));
+  return ir_builder.CreateSelect(ir_builder.CreateICmpEQ(codegenDateTimeToInt64(ts_lv), null_lv), null_lv, ret_lv);
+}
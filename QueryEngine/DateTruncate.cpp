@@ -63,6 +63,15 @@ extern "C" NEVER_INLINE DEVICE time_t create_epoch(int year) {
   return new_time;
 }
 
+// Floors the time to a multiple of the bucket length past the offset, the generated code does the same inline.
+DEVICE time_t floor_to_multiple(const time_t timeval, const int64_t bucket, const int64_t offset) {
+  int64_t rem = ((int64_t)timeval - offset) % bucket;
+  if (rem < 0) {
+    rem += bucket;
+  }
+  return timeval - rem;
+}
+
 /*
  * @brief support the SQL DATE_TRUNC function
  */
@@ -80,41 +89,17 @@ extern "C" NEVER_INLINE DEVICE time_t DateTruncate(DatetruncField field, time_t
     case dtSECOND:
       /* this is the limit of current granularity*/
       return timeval;
-    case dtMINUTE: {
-      time_t ret = (uint64_t)(timeval / SECSPERMIN) * SECSPERMIN;
-      // in the case of a negative time we still want to push down so need to push one more
-      if (ret < 0)
-        ret -= SECSPERMIN;
-      return ret;
-    }
-    case dtHOUR: {
-      time_t ret = (uint64_t)(timeval / SECSPERHOUR) * SECSPERHOUR;
-      // in the case of a negative time we still want to push down so need to push one more
-      if (ret < 0)
-        ret -= SECSPERHOUR;
-      return ret;
-    }
-    case dtQUARTERDAY: {
-      time_t ret = (uint64_t)(timeval / SECSPERQUARTERDAY) * SECSPERQUARTERDAY;
-      // in the case of a negative time we still want to push down so need to push one more
-      if (ret < 0)
-        ret -= SECSPERQUARTERDAY;
-      return ret;
-    }
-    case dtDAY: {
-      time_t ret = (uint64_t)(timeval / SECSPERDAY) * SECSPERDAY;
-      // in the case of a negative time we still want to push down so need to push one more
-      if (ret < 0)
-        ret -= SECSPERDAY;
-      return ret;
-    }
-    case dtWEEK: {
-      time_t day = (uint64_t)(timeval / SECSPERDAY) * SECSPERDAY;
-      if (day < 0)
-        day -= SECSPERDAY;
-      int dow = extract_dow(&day);
-      return day - (dow * SECSPERDAY);
-    }
+    case dtMINUTE:
+      return floor_to_multiple(timeval, SECSPERMIN, 0);
+    case dtHOUR:
+      return floor_to_multiple(timeval, SECSPERHOUR, 0);
+    case dtQUARTERDAY:
+      return floor_to_multiple(timeval, SECSPERQUARTERDAY, 0);
+    case dtDAY:
+      return floor_to_multiple(timeval, SECSPERDAY, 0);
+    case dtWEEK:
+      // the weeks start on the Sunday three days after the epoch
+      return floor_to_multiple(timeval, DAYSPERWEEK * SECSPERDAY, 3 * SECSPERDAY);
     case dtMONTH: {
       if (timeval >= 0L && timeval <= UINT32_MAX - EPOCH_OFFSET_YEAR_1900) {
         uint32_t seconds_march_1900 = (int64_t)(timeval) + EPOCH_OFFSET_YEAR_1900 - SECONDS_FROM_JAN_1900_TO_MARCH_1900;
@@ -22,6 +22,7 @@
 #include "EquiJoinCondition.h"
 #include "ExecutionException.h"
 #include "ExpressionRewrite.h"
+#include "GeoQualUtils.h"
 #include "GpuMemUtils.h"
 #include "InPlaceSort.h"
 #include "JsonAccessors.h"
@@ -30,12 +31,14 @@
 #include "QueryTemplateGenerator.h"
 #include "RuntimeFunctions.h"
 #include "SpeculativeTopN.h"
+#include "SpillFile.h"
 
 #include "CudaMgr/CudaMgr.h"
 #include "DataMgr/BufferMgr/BufferMgr.h"
 #include "Parser/ParserNode.h"
 #include "Shared/MapDParameters.h"
 #include "Shared/checked_alloc.h"
+#include "Shared/geo_compression.h"
 #include "Shared/scope.h"
 #include "Shared/measure.h"
 #include "Shared/shard_key.h"
@@ -66,6 +69,11 @@ unsigned g_trivial_loop_join_threshold{1000};
 bool g_left_deep_join_optimization{true};
 bool g_from_table_reordering{true};
 bool g_inner_join_fragment_skipping{false};
+bool g_enable_spatial_join{true};
+bool g_enable_metadata_aggregates{true};
+bool g_enable_materialized_view_rewrite{true};
+size_t g_subquery_result_cache_bytes{0};  // 0 disables reuse of sub-query results across queries
+double g_auto_vacuum_threshold{0};  // fraction of deleted rows in a fragment which triggers a vacuum, 0 is off
 
 Executor::Executor(const int db_id,
                    const size_t block_size_x,
@@ -85,7 +93,8 @@ Executor::Executor(const int db_id,
       db_id_(db_id),
       catalog_(nullptr),
       temporary_tables_(nullptr),
-      input_table_info_cache_(this) {}
+      input_table_info_cache_(this),
+      subquery_result_cache_bytes_(0) {}
 
 std::shared_ptr<Executor> Executor::getExecutor(const int db_id,
                                                 const std::string& debug_dir,
@@ -809,6 +818,65 @@ RowSetPtr Executor::reduceMultiDeviceResultSets(
   return reduced_results;
 }
 
+// The groups of the spilled buffers are reduced one hash partition at a time, so only the entries of a partition
+// are resident besides the result. The in-memory results join their partitions first.
+RowSetPtr Executor::reduceSpilledGroupByPartitions(RowSetPtr in_memory_results,
+                                                   SpillFile& spill_file,
+                                                   SpilledGroupByPartitions& spilled_partitions,
+                                                   std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner) const {
+  const auto target_infos = in_memory_results->getTargetInfos();
+  const auto query_mem_desc = in_memory_results->getQueryMemDesc();
+  spill_group_by_entries(
+      spill_file, in_memory_results->getStorage()->getUnderlyingBuffer(), query_mem_desc, spilled_partitions);
+  in_memory_results.reset();
+  const auto row_bytes = query_mem_desc.getRowSize();
+  const auto make_result_set = [&](const size_t entry_count) {
+    auto result_query_mem_desc = query_mem_desc;
+    result_query_mem_desc.entry_count = entry_count;
+    auto result = std::make_shared<ResultSet>(
+        target_infos, ExecutorDeviceType::CPU, result_query_mem_desc, row_set_mem_owner, this);
+    result->allocateStorage(plan_state_->init_agg_vals_);
+    return result;
+  };
+  const auto read_run = [&](const SpilledGroupByRun& run) {
+    auto run_results = make_result_set(run.entry_count);
+    spill_file.read(run_results->getStorage()->getUnderlyingBuffer(), run.offset, run.entry_count * row_bytes);
+    return run_results;
+  };
+  // The reduced partitions go back to the spill file, in a single run each.
+  SpilledGroupByPartitions reduced_partitions(1);
+  for (const auto& runs : spilled_partitions) {
+    const auto entry_count =
+        std::accumulate(runs.begin(), runs.end(), size_t(0), [](const size_t init, const SpilledGroupByRun& run) {
+          return init + run.entry_count;
+        });
+    if (!entry_count) {
+      continue;
+    }
+    auto partition_results = make_result_set(entry_count);
+    partition_results->initializeStorage();
+    for (const auto& run : runs) {
+      partition_results->getStorage()->reduce(*read_run(run)->getStorage());
+    }
+    spill_group_by_entries(spill_file,
+                           partition_results->getStorage()->getUnderlyingBuffer(),
+                           partition_results->getQueryMemDesc(),
+                           reduced_partitions);
+  }
+  const auto& reduced_runs = reduced_partitions.front();
+  const auto group_count = std::accumulate(
+      reduced_runs.begin(), reduced_runs.end(), size_t(0), [](const size_t init, const SpilledGroupByRun& run) {
+        return init + run.entry_count;
+      });
+  // the partitions have no group in common, half of the slots stay free to keep the probes short
+  auto reduced_results = make_result_set(std::max(2 * group_count, size_t(1)));
+  reduced_results->initializeStorage();
+  for (const auto& run : reduced_runs) {
+    reduced_results->getStorage()->reduce(*read_run(run)->getStorage());
+  }
+  return reduced_results;
+}
+
 RowSetPtr Executor::reduceSpeculativeTopN(const RelAlgExecutionUnit& ra_exe_unit,
                                           std::vector<std::pair<ResultPtr, std::vector<size_t>>>& results_per_device,
                                           std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner,
@@ -1326,6 +1394,169 @@ std::unordered_map<int, const Analyzer::BinOper*> Executor::getInnerTabIdToJoinC
   return id_to_cond;
 }
 
+namespace {
+
+// The bytes of the coords or the values of the bounds of a geo literal.
+template <typename T>
+bool get_constant_array(const Analyzer::Expr* expr, std::vector<T>& values) {
+  const auto constant = dynamic_cast<const Analyzer::Constant*>(expr);
+  if (!constant || constant->get_is_null() || !constant->get_type_info().is_array()) {
+    return false;
+  }
+  values.clear();
+  for (const auto& elem : constant->get_value_list()) {
+    const auto elem_constant = dynamic_cast<const Analyzer::Constant*>(elem.get());
+    if (!elem_constant) {
+      return false;
+    }
+    const auto& datum = elem_constant->get_constval();
+    values.push_back(std::is_same<T, double>::value ? datum.doubleval : datum.tinyintval);
+  }
+  return true;
+}
+
+bool is_transformed_geo_function(const Analyzer::FunctionOper* function_oper,
+                                 const std::vector<size_t>& input_srid_args) {
+  const auto get_int_arg = [function_oper](const size_t idx) {
+    const auto constant = dynamic_cast<const Analyzer::Constant*>(function_oper->getArg(idx));
+    CHECK(constant);
+    return constant->get_constval().intval;
+  };
+  const auto output_srid = get_int_arg(function_oper->getArity() - 1);
+  for (const auto idx : input_srid_args) {
+    if (output_srid > 0 && get_int_arg(idx) != output_srid) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Viewport filters compare the bounds of the rows to constants or test the rows against a constant geometry; the
+// extents kept in the chunk metadata of the geo physical columns rule out the fragments none of whose rows pass.
+bool skip_fragment_on_spatial_extent(const InputDescriptor& table_desc,
+                                     const Fragmenter_Namespace::FragmentInfo& fragment,
+                                     const std::list<std::shared_ptr<Analyzer::Expr>>& quals) {
+  if (table_desc.getSourceType() != InputSourceType::TABLE) {
+    return false;
+  }
+  const auto& chunk_metadata_map = fragment.getChunkMetadataMap();
+  const auto get_extent = [&table_desc, &chunk_metadata_map](const Analyzer::Expr* expr,
+                                                             const int col_offset) -> const std::vector<double>* {
+    const auto col_var = dynamic_cast<const Analyzer::ColumnVar*>(expr);
+    if (!col_var || col_var->get_table_id() != table_desc.getTableId() || col_var->get_rte_idx()) {
+      return nullptr;
+    }
+    const auto chunk_meta_it = chunk_metadata_map.find(col_var->get_column_id() + col_offset);
+    if (chunk_meta_it == chunk_metadata_map.end() || chunk_meta_it->second.spatialExtent.size() != 4) {
+      return nullptr;
+    }
+    return &chunk_meta_it->second.spatialExtent;
+  };
+  for (const auto& qual : quals) {
+    if (const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(qual.get())) {
+      auto function_oper = dynamic_cast<const Analyzer::FunctionOper*>(bin_oper->get_left_operand());
+      auto constant = dynamic_cast<const Analyzer::Constant*>(bin_oper->get_right_operand());
+      auto optype = bin_oper->get_optype();
+      if (!function_oper) {
+        function_oper = dynamic_cast<const Analyzer::FunctionOper*>(bin_oper->get_right_operand());
+        constant = dynamic_cast<const Analyzer::Constant*>(bin_oper->get_left_operand());
+        optype = COMMUTE_COMPARISON(optype);
+      }
+      double value{0};
+      if (!function_oper || !get_constant_as_double(constant, value)) {
+        continue;
+      }
+      const auto& name = function_oper->getName();
+      const bool is_x = name == "ST_XMin_Bounds" || name == "ST_XMax_Bounds";
+      if ((!is_x && name != "ST_YMin_Bounds" && name != "ST_YMax_Bounds") ||
+          is_transformed_geo_function(function_oper, {1})) {
+        continue;
+      }
+      // the bounds of every row lie within the extent of the bounds column
+      const auto extent = get_extent(function_oper->getArg(0), 0);
+      if (!extent) {
+        continue;
+      }
+      const double extent_min = (*extent)[is_x ? 0 : 1];
+      const double extent_max = (*extent)[is_x ? 2 : 3];
+      switch (optype) {
+        case kGE:
+          if (extent_max < value) {
+            return true;
+          }
+          break;
+        case kGT:
+          if (extent_max <= value) {
+            return true;
+          }
+          break;
+        case kLE:
+          if (extent_min > value) {
+            return true;
+          }
+          break;
+        case kLT:
+          if (extent_min >= value) {
+            return true;
+          }
+          break;
+        case kEQ:
+          if (extent_min > value || extent_max < value) {
+            return true;
+          }
+          break;
+        default:
+          break;
+      }
+      continue;
+    }
+    const auto function_oper = dynamic_cast<const Analyzer::FunctionOper*>(qual.get());
+    if (!function_oper ||
+        (function_oper->getName() != "ST_Contains_Polygon_Point" &&
+         function_oper->getName() != "ST_Contains_MultiPolygon_Point")) {
+      continue;
+    }
+    // ..., polygon bounds, point, polygon compression and srid, point compression and srid, output srid
+    const size_t arity = function_oper->getArity();
+    if (arity < 7 || is_transformed_geo_function(function_oper, {arity - 4, arity - 2})) {
+      continue;
+    }
+    const auto poly_bounds = function_oper->getArg(arity - 7);
+    const auto point = function_oper->getArg(arity - 6);
+    std::vector<double> box;
+    std::vector<int8_t> coords;
+    if (get_constant_array(poly_bounds, box) && box.size() == 4) {
+      // the polygon only contains the points within its bounds, the extent of a POINT is the one of its coords
+      if (point->get_type_info().get_type() != kPOINT) {
+        continue;
+      }
+      const auto extent = get_extent(point, 1);
+      if (extent && ((*extent)[2] < box[0] - kGeoBoxPadding || (*extent)[0] > box[2] + kGeoBoxPadding ||
+                     (*extent)[3] < box[1] - kGeoBoxPadding || (*extent)[1] > box[3] + kGeoBoxPadding)) {
+        return true;
+      }
+    } else if (get_constant_array(point, coords)) {
+      // a constant point is only contained by the polygons whose bounds contain it
+      const auto compression = dynamic_cast<const Analyzer::Constant*>(function_oper->getArg(arity - 3));
+      CHECK(compression);
+      const auto ic = compression->get_constval().intval;
+      double x{0};
+      double y{0};
+      if ((ic != 0 && ic != 1) || !decompress_point(&coords[0], coords.size(), ic == 1, x, y)) {
+        continue;
+      }
+      const auto extent = get_extent(poly_bounds, 0);
+      if (extent && (x < (*extent)[0] - kGeoBoxPadding || x > (*extent)[2] + kGeoBoxPadding ||
+                     y < (*extent)[1] - kGeoBoxPadding || y > (*extent)[3] + kGeoBoxPadding)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 void Executor::dispatchFragments(
     const std::function<void(const ExecutorDeviceType chosen_device_type,
                              int chosen_device_id,
@@ -1380,6 +1611,10 @@ void Executor::dispatchFragments(
       if (skip_frag.first) {
         continue;
       }
+      if (skip_fragment_on_spatial_extent(outer_table_desc, fragment, ra_exe_unit.quals)) {
+        ++spatial_extent_skipped_fragments_;
+        continue;
+      }
       const auto device_count = catalog_->get_dataMgr().cudaMgr_->getDeviceCount();
       CHECK_GT(device_count, 0);
       const int device_id = fragment.shard == -1 ? fragment.deviceIds[static_cast<int>(Data_Namespace::GPU_LEVEL)]
@@ -1418,6 +1653,10 @@ void Executor::dispatchFragments(
       if (skip_frag.first) {
         continue;
       }
+      if (skip_fragment_on_spatial_extent(outer_table_desc, fragment, ra_exe_unit.quals)) {
+        ++spatial_extent_skipped_fragments_;
+        continue;
+      }
       rowid_lookup_key = std::max(rowid_lookup_key, skip_frag.second);
       auto chosen_device_type = device_type;
       const auto device_count =
@@ -2019,6 +2258,9 @@ bool check_rows_less_than_needed(const ResultPtr& results, const size_t scan_lim
   abort();
 }
 
+// Hash partitions of the spilled group-by entries, each one is reduced on its own.
+constexpr size_t spill_partition_count{64};
+
 }  // namespace
 
 int32_t Executor::executePlanWithGroupBy(const RelAlgExecutionUnit& ra_exe_unit,
@@ -2065,20 +2307,57 @@ int32_t Executor::executePlanWithGroupBy(const RelAlgExecutionUnit& ra_exe_unit,
     render_allocator_map_ptr = render_info->render_allocator_map_ptr.get();
   }
 
+  std::vector<std::pair<ResultPtr, std::vector<size_t>>> flushed_partitions;
+  // Once the flushed partitions the query holds in memory go over its budget, the entries of the next ones are
+  // appended to a spill file, split by the hash partition of their keys.
+  std::unique_ptr<SpillFile> spill_file;
+  SpilledGroupByPartitions spilled_partitions(spill_partition_count);
+  size_t reserved_spill_budget{0};
+  ScopeGuard release_spill_budget = [query_exe_context, &reserved_spill_budget] {
+    query_exe_context->row_set_mem_owner_->releaseSpillBudget(reserved_spill_budget);
+  };
   if (device_type == ExecutorDeviceType::CPU) {
-    query_exe_context->launchCpuCode(ra_exe_unit,
-                                     compilation_result.native_functions,
-                                     hoist_literals,
-                                     hoist_buf,
-                                     col_buffers,
-                                     num_rows,
-                                     frag_offsets,
-                                     frag_stride,
-                                     scan_limit,
-                                     query_exe_context->init_agg_vals_,
-                                     &error_code,
-                                     num_tables,
-                                     join_hash_table_ptrs);
+    // The resume position applies to the first fragment the kernel scans only.
+    const bool can_flush = !render_allocator_map_ptr && col_buffers.size() == size_t(1) &&
+                           canFlushGroupByBuffer(ra_exe_unit, query_exe_context->query_mem_desc_, scan_limit);
+    int32_t resume_row{0};
+    while (true) {
+      const auto first_row = resume_row ? resume_row : error_code;
+      query_exe_context->launchCpuCode(ra_exe_unit,
+                                       compilation_result.native_functions,
+                                       hoist_literals,
+                                       hoist_buf,
+                                       col_buffers,
+                                       num_rows,
+                                       frag_offsets,
+                                       frag_stride,
+                                       scan_limit,
+                                       query_exe_context->init_agg_vals_,
+                                       &error_code,
+                                       num_tables,
+                                       join_hash_table_ptrs,
+                                       resume_row);
+      // The kernel returns minus the position of the row which didn't find a slot. Instead of failing the
+      // whole query, move the full buffer to a partition of its own and resume the scan from that row.
+      if (!can_flush || error_code >= 0 || -error_code == first_row) {
+        break;
+      }
+      const auto partition_bytes =
+          query_exe_context->result_sets_.front()->getQueryMemDesc().getBufferSizeBytes(ExecutorDeviceType::CPU);
+      if (spill_enabled() &&
+          !query_exe_context->row_set_mem_owner_->reserveSpillBudget(partition_bytes, g_spill_memory_budget)) {
+        if (!spill_file) {
+          spill_file.reset(new SpillFile(g_spill_dir));
+        }
+        query_exe_context->spillGroupByBuffer(*spill_file, spilled_partitions);
+      } else {
+        flushed_partitions.emplace_back(query_exe_context->flushGroupByBuffer(), std::vector<size_t>{});
+        reserved_spill_budget += spill_enabled() ? partition_bytes : 0;
+      }
+      // not a rowid lookup, which would narrow the scan down to that single row
+      resume_row = -error_code;
+      error_code = 0;
+    }
   } else {
     try {
       query_exe_context->launchGpuCode(ra_exe_unit,
@@ -2119,6 +2398,18 @@ int32_t Executor::executePlanWithGroupBy(const RelAlgExecutionUnit& ra_exe_unit,
       !query_exe_context->query_mem_desc_.usesCachedContext() && !render_allocator_map_ptr) {
     CHECK(!query_exe_context->query_mem_desc_.sortOnGpu());
     results = query_exe_context->getResult(ra_exe_unit, outer_tab_frag_ids, was_auto_device);
+    if ((!flushed_partitions.empty() || spill_file) && !error_code) {
+      flushed_partitions.emplace_back(results, outer_tab_frag_ids);
+      auto reduced = reduceMultiDeviceResultSets(
+          flushed_partitions, query_exe_context->row_set_mem_owner_, query_exe_context->query_mem_desc_);
+      if (spill_file) {
+        flushed_partitions.clear();
+        results = RowSetPtr(nullptr);
+        reduced = reduceSpilledGroupByPartitions(
+            std::move(reduced), *spill_file, spilled_partitions, query_exe_context->row_set_mem_owner_);
+      }
+      results = reduced;
+    }
     if (auto rows = boost::get<RowSetPtr>(&results)) {
       (*rows)->holdLiterals(hoist_buf);
     }
@@ -2130,6 +2421,33 @@ int32_t Executor::executePlanWithGroupBy(const RelAlgExecutionUnit& ra_exe_unit,
   return 0;
 }
 
+bool Executor::canFlushGroupByBuffer(const RelAlgExecutionUnit& ra_exe_unit,
+                                     const QueryMemoryDescriptor& query_mem_desc,
+                                     const int64_t scan_limit) const {
+  // Resuming from the failed row is only correct if a row updates at most one group
+  // and the row function doesn't keep state across rows.
+  if (query_mem_desc.hash_type != GroupByColRangeType::MultiCol || query_mem_desc.output_columnar ||
+      query_mem_desc.keyless_hash || query_mem_desc.getSmallBufferSizeBytes() || query_mem_desc.usesCachedContext() ||
+      scan_limit || ra_exe_unit.estimator) {
+    return false;
+  }
+  const auto join_impl_type = plan_state_->join_info_.join_impl_type_;
+  if (join_impl_type != JoinImplType::Invalid && join_impl_type != JoinImplType::HashOneToOne) {
+    return false;
+  }
+  std::vector<const Analyzer::Expr*> exprs(ra_exe_unit.target_exprs.begin(), ra_exe_unit.target_exprs.end());
+  for (const auto& groupby_expr : ra_exe_unit.groupby_exprs) {
+    exprs.push_back(groupby_expr.get());
+  }
+  for (const auto expr : exprs) {
+    const auto uoper = dynamic_cast<const Analyzer::UOper*>(expr);
+    if (uoper && uoper->get_optype() == kUNNEST) {
+      return false;
+    }
+  }
+  return true;
+}
+
 std::vector<int64_t> Executor::getJoinHashTablePtrs(const ExecutorDeviceType device_type, const int device_id) {
   std::vector<int64_t> table_ptrs;
   const auto& join_hash_tables = plan_state_->join_info_.join_hash_tables_;
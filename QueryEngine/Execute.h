@@ -54,10 +54,12 @@
 
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <mutex>
 #include <stack>
@@ -75,6 +77,11 @@ extern bool g_null_div_by_zero;
 extern bool g_bigint_count;
 extern bool g_fast_strcmp;
 extern bool g_inner_join_fragment_skipping;
+extern bool g_enable_spatial_join;
+extern bool g_enable_metadata_aggregates;
+extern bool g_enable_materialized_view_rewrite;
+extern size_t g_subquery_result_cache_bytes;
+extern double g_auto_vacuum_threshold;
 
 class ExecutionResult;
 
@@ -390,6 +397,16 @@ class Executor {
 
   ExpressionRange getColRange(const PhysicalInput&) const;
 
+  // Outer table fragments not dispatched because the spatial extents of their geo columns rule out every row.
+  size_t getSpatialExtentSkippedFragmentCount() const { return spatial_extent_skipped_fragments_.load(); }
+
+  // Integer sets built from the result of an IN sub-query, reused for as long as the result set is alive.
+  std::shared_ptr<const std::vector<int64_t>> getInIntegerSet(const std::shared_ptr<ResultSet>& rows,
+                                                              const std::string& arg_key) const;
+  void putInIntegerSet(const std::shared_ptr<ResultSet>& rows,
+                       const std::string& arg_key,
+                       const std::shared_ptr<const std::vector<int64_t>>& values) const;
+
   typedef boost::variant<int8_t,
                          int16_t,
                          int32_t,
@@ -465,6 +482,15 @@ class Executor {
   llvm::Value* codegen(const Analyzer::DateaddExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::DatediffExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::DatetruncExpr*, const CompilationOptions&);
+  llvm::Value* codegenExtractInline(const ExtractField field, llvm::Value* ts_lv, const Analyzer::Expr* ts_expr);
+  llvm::Value* codegenDateTruncInline(const DatetruncField field, llvm::Value* ts_lv, const Analyzer::Expr* ts_expr);
+  std::vector<int64_t> getDatetruncBuckets(const Analyzer::Expr* ts_expr, const DatetruncField field);
+  llvm::Value* codegenDateTimeFromBuckets(llvm::Value* ts_lv,
+                                          const std::vector<int64_t>& buckets,
+                                          const std::vector<int64_t>& values);
+  llvm::Value* codegenFloorMod(llvm::Value* ts_lv, const int64_t divisor);
+  llvm::Value* codegenDateTimeToInt64(llvm::Value* ts_lv);
+  llvm::Value* codegenDateTimeNullable(llvm::Value* ts_lv, llvm::Value* ret_lv, const SQLTypeInfo& ts_ti);
   llvm::Value* codegen(const Analyzer::CharLengthExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::LikeExpr*, const CompilationOptions&);
   llvm::Value* codegenDictLike(const std::shared_ptr<Analyzer::Expr> arg,
@@ -958,6 +984,9 @@ class Executor {
                                  const uint32_t start_rowid,
                                  const uint32_t num_tables,
                                  RenderInfo* render_info);
+  bool canFlushGroupByBuffer(const RelAlgExecutionUnit& ra_exe_unit,
+                             const QueryMemoryDescriptor& query_mem_desc,
+                             const int64_t scan_limit) const;
   int32_t executePlanWithoutGroupBy(const RelAlgExecutionUnit& ra_exe_unit,
                                     const CompilationResult&,
                                     const bool hoist_literals,
@@ -991,6 +1020,10 @@ class Executor {
   RowSetPtr reduceMultiDeviceResultSets(std::vector<std::pair<ResultPtr, std::vector<size_t>>>& all_fragment_results,
                                         std::shared_ptr<RowSetMemoryOwner>,
                                         const QueryMemoryDescriptor&) const;
+  RowSetPtr reduceSpilledGroupByPartitions(RowSetPtr in_memory_results,
+                                           SpillFile& spill_file,
+                                           SpilledGroupByPartitions& spilled_partitions,
+                                           std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner) const;
   RowSetPtr reduceSpeculativeTopN(const RelAlgExecutionUnit&,
                                   std::vector<std::pair<ResultPtr, std::vector<size_t>>>& all_fragment_results,
                                   std::shared_ptr<RowSetMemoryOwner>,
@@ -1348,6 +1381,10 @@ class Executor {
       in_values_bitmaps_.emplace_back(std::move(in_values_bitmap));
       return in_values_bitmaps_.back().get();
     }
+    const InValuesBitmap* addInValuesBitmap(const std::shared_ptr<const InValuesBitmap>& in_values_bitmap) {
+      in_values_bitmaps_.push_back(in_values_bitmap);
+      return in_values_bitmaps_.back().get();
+    }
     // look up a runtime function based on the name, return type and type of
     // the arguments and call it; x64 only, don't call from GPU codegen
     llvm::Value* emitExternalCall(const std::string& fname,
@@ -1392,7 +1429,7 @@ class Executor {
     std::vector<llvm::BasicBlock*> inner_scan_labels_;
     std::vector<llvm::BasicBlock*> match_scan_labels_;
     std::unordered_map<int, llvm::Value*> scan_idx_to_hash_pos_;
-    std::vector<std::unique_ptr<const InValuesBitmap>> in_values_bitmaps_;
+    std::vector<std::shared_ptr<const InValuesBitmap>> in_values_bitmaps_;
     const std::vector<InputTableInfo>& query_infos_;
     bool needs_error_check_;
 
@@ -1538,6 +1575,31 @@ class Executor {
   AggregatedColRange agg_col_range_cache_;
   StringDictionaryGenerations string_dictionary_generations_;
   TableGenerations table_generations_;
+  std::atomic<size_t> spatial_extent_skipped_fragments_{0};
+
+  // The caches below are guarded by execute_mutex_.
+  struct CachedSubqueryResult {
+    std::string serialized_ra;
+    std::string table_versions;
+    std::shared_ptr<const ExecutionResult> result;
+    size_t size_bytes;
+  };
+  std::list<CachedSubqueryResult> subquery_result_cache_;  // most recently used first
+  size_t subquery_result_cache_bytes_;
+
+  struct CachedInIntegerSet {
+    std::weak_ptr<const ResultSet> rows;
+    std::string arg_key;
+    std::shared_ptr<const std::vector<int64_t>> values;
+  };
+  mutable std::unordered_map<const ResultSet*, CachedInIntegerSet> in_integer_set_cache_;
+
+  struct CachedInValuesBitmap {
+    std::weak_ptr<const std::vector<int64_t>> values;
+    int64_t null_val;
+    std::shared_ptr<const InValuesBitmap> bitmap;
+  };
+  std::unordered_map<const std::vector<int64_t>*, CachedInValuesBitmap> in_values_bitmap_cache_;  // CPU bitmaps
 
   static std::map<std::pair<int, ::QueryRenderer::QueryRenderManager*>, std::shared_ptr<Executor>> executors_;
   static std::mutex execute_mutex_;
@@ -1568,6 +1630,7 @@ class Executor {
   friend class QueryRewriter;
   friend class PendingExecutionClosure;
   friend class RelAlgExecutor;
+  friend class SpatialJoinHashTable;
 };
 
 inline std::string get_null_check_suffix(const SQLTypeInfo& lhs_ti, const SQLTypeInfo& rhs_ti) {
@@ -44,7 +44,7 @@ SQLTypeInfo UpdateLogForFragment::getColumnType(const size_t col_idx) const {
 }
 
 void Executor::executeUpdate(const RelAlgExecutionUnit& ra_exe_unit_in,
-                             const InputTableInfo& table_info,
+                             const InputTableInfo& table_info_in,
                              const CompilationOptions& co,
                              const ExecutionOptions& eo,
                              const Catalog_Namespace::Catalog& cat,
@@ -53,6 +53,22 @@ void Executor::executeUpdate(const RelAlgExecutionUnit& ra_exe_unit_in,
   CHECK(cb);
   const auto ra_exe_unit = addDeletedColumn(ra_exe_unit_in);
 
+  // The statement's locks don't keep the loads out, rows they add to the delta store after it got merged
+  // can't be modified until the next merge and are left alone.
+  InputTableInfo table_info{table_info_in.table_id, {}};
+  table_info.info.chunkKeyPrefix = table_info_in.info.chunkKeyPrefix;
+  size_t num_tuples{0};
+  for (const auto& fragment : table_info_in.info.fragments) {
+    if (!fragment.isDelta) {
+      table_info.info.fragments.push_back(fragment);
+      num_tuples += fragment.getPhysicalNumTuples();
+    }
+  }
+  if (table_info.info.fragments.empty()) {
+    return;
+  }
+  table_info.info.setPhysicalNumTuples(num_tuples);
+
   // could use std::thread::hardware_concurrency(), but some
   // slightly out-of-date compilers (gcc 4.7) implement it as always 0.
   // Play it POSIX.1 safe instead.
@@ -48,7 +48,11 @@ DEVICE int extract_minute(const time_t* tim_p) {
 
 DEVICE int extract_second(const time_t* tim_p) {
   const time_t lcltime = *tim_p;
-  return (int)((long)lcltime % SECSPERMIN);
+  long rem = ((long)lcltime) % SECSPERMIN;
+  if (rem < 0) {
+    rem += SECSPERMIN;
+  }
+  return (int)rem;
 }
 
 DEVICE int extract_dow(const time_t* tim_p) {
@@ -68,10 +72,13 @@ DEVICE int extract_dow(const time_t* tim_p) {
 }
 
 DEVICE int extract_quarterday(const time_t* tim_p) {
-  long quarterdays;
+  long rem;
   const time_t lcltime = *tim_p;
-  quarterdays = ((long)lcltime) / SECSPERQUARTERDAY;
-  return (int)(quarterdays % 4) + 1;
+  rem = ((long)lcltime) % SECSPERDAY;
+  if (rem < 0) {
+    rem += SECSPERDAY;
+  }
+  return (int)(rem / SECSPERQUARTERDAY) + 1;
 }
 
 DEVICE int extract_month_fast(const time_t* tim_p) {
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    GeoQualUtils.h
+ * @brief   Helpers shared by the optimizations which look at geo predicates on the host: the spatial join and the
+ *          fragment skipping on spatial extents.
+ *
+ */
+
+#ifndef QUERYENGINE_GEOQUALUTILS_H
+#define QUERYENGINE_GEOQUALUTILS_H
+
+#include "../Analyzer/Analyzer.h"
+#include "SqlTypesLayout.h"
+
+// Boxes and extents compared against geo predicates are padded by this much, which covers the tolerance of the
+// exact predicates and the loss of the GEOINT compression.
+const double kGeoBoxPadding{1e-6};
+
+inline bool is_geoint32(const SQLTypeInfo& ti) {
+  return ti.get_compression() == kENCODING_GEOINT && ti.get_comp_param() == 32;
+}
+
+// The value of a numeric literal, false for null and non-numeric ones.
+inline bool get_constant_as_double(const Analyzer::Constant* constant, double& value) {
+  if (!constant || constant->get_is_null()) {
+    return false;
+  }
+  const auto& ti = constant->get_type_info();
+  const auto& datum = constant->get_constval();
+  switch (ti.get_type()) {
+    case kDOUBLE:
+      value = datum.doubleval;
+      return true;
+    case kFLOAT:
+      value = datum.floatval;
+      return true;
+    case kSMALLINT:
+      value = datum.smallintval;
+      return true;
+    case kINT:
+      value = datum.intval;
+      return true;
+    case kBIGINT:
+      value = datum.bigintval;
+      return true;
+    case kDECIMAL:
+    case kNUMERIC:
+      value = static_cast<double>(datum.bigintval) / exp_to_scale(ti.get_scale());
+      return true;
+    default:
+      return false;
+  }
+}
+
+#endif  // QUERYENGINE_GEOQUALUTILS_H
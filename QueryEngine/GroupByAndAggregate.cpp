@@ -24,6 +24,7 @@
 #include "InPlaceSort.h"
 #include "LLVMFunctionAttributesUtil.h"
 #include "MaxwellCodegenPatch.h"
+#include "MurmurHash1Inl.h"
 #include "OutputBufferInitialization.h"
 #include "ScalarExprVisitor.h"
 
@@ -36,6 +37,7 @@
 #include "ResultRows.h"
 #include "RuntimeFunctions.h"
 #include "SpeculativeTopN.h"
+#include "SpillFile.h"
 #include "StreamingTopN.h"
 #include "TopKSort.h"
 
@@ -526,6 +528,72 @@ RowSetPtr QueryExecutionContext::getRowSet(const RelAlgExecutionUnit& ra_exe_uni
   return executor_->reduceMultiDeviceResults(ra_exe_unit, results_per_sm, row_set_mem_owner_, query_mem_desc);
 }
 
+RowSetPtr QueryExecutionContext::flushGroupByBuffer() {
+  CHECK(device_type_ == ExecutorDeviceType::CPU);
+  CHECK_EQ(size_t(1), group_by_buffers_.size());
+  CHECK(small_group_by_buffers_.empty());
+  CHECK(!output_columnar_ && !query_mem_desc_.keyless_hash);
+  const auto& full_result = result_sets_.front();
+  CHECK(full_result);
+  const auto& partition_query_mem_desc = full_result->getQueryMemDesc();
+  auto partition = std::make_shared<ResultSet>(
+      full_result->getTargetInfos(), ExecutorDeviceType::CPU, partition_query_mem_desc, row_set_mem_owner_, executor_);
+  auto partition_storage = partition->allocateStorage(executor_->plan_state_->init_agg_vals_);
+  // Count distinct buffers are owned by the row set memory owner, the partition takes over the handles.
+  memcpy(partition_storage->getUnderlyingBuffer(),
+         group_by_buffers_.front(),
+         partition_query_mem_desc.getBufferSizeBytes(ExecutorDeviceType::CPU));
+  initGroups(group_by_buffers_.front(), &init_agg_vals_[0], query_mem_desc_.entry_count, false, 1);
+  return partition;
+}
+
+void spill_group_by_entries(SpillFile& spill_file,
+                            const int8_t* buff,
+                            const QueryMemoryDescriptor& query_mem_desc,
+                            SpilledGroupByPartitions& spilled_partitions) {
+  CHECK(query_mem_desc.hash_type == GroupByColRangeType::MultiCol);
+  CHECK(!query_mem_desc.output_columnar && !query_mem_desc.keyless_hash);
+  CHECK(!spilled_partitions.empty());
+  const auto key_bytes = get_key_bytes_rowwise(query_mem_desc);
+  const auto row_bytes = query_mem_desc.getRowSize();
+  const auto key_width = query_mem_desc.getEffectiveKeyWidth();
+  std::vector<std::vector<int8_t>> partition_rows(spilled_partitions.size());
+  for (size_t i = 0; i < query_mem_desc.entry_count; ++i) {
+    const auto row_ptr = buff + i * row_bytes;
+    const bool empty = key_width == 4 ? *reinterpret_cast<const int32_t*>(row_ptr) == EMPTY_KEY_32
+                                      : *reinterpret_cast<const int64_t*>(row_ptr) == EMPTY_KEY_64;
+    if (empty) {
+      continue;
+    }
+    // not the hash of the baseline layout, which would crowd the entries of a partition into a few of its slots
+    const auto partition_idx = MurmurHash64AImpl(row_ptr, key_bytes, 0) % spilled_partitions.size();
+    auto& rows = partition_rows[partition_idx];
+    rows.insert(rows.end(), row_ptr, row_ptr + row_bytes);
+  }
+  for (size_t partition_idx = 0; partition_idx < partition_rows.size(); ++partition_idx) {
+    const auto& rows = partition_rows[partition_idx];
+    if (rows.empty()) {
+      continue;
+    }
+    spilled_partitions[partition_idx].push_back(
+        SpilledGroupByRun{spill_file.append(rows.data(), rows.size()), rows.size() / row_bytes});
+  }
+}
+
+void QueryExecutionContext::spillGroupByBuffer(SpillFile& spill_file, SpilledGroupByPartitions& spilled_partitions) {
+  CHECK(device_type_ == ExecutorDeviceType::CPU);
+  CHECK_EQ(size_t(1), group_by_buffers_.size());
+  CHECK(small_group_by_buffers_.empty());
+  CHECK(!output_columnar_ && !query_mem_desc_.keyless_hash);
+  const auto& full_result = result_sets_.front();
+  CHECK(full_result);
+  spill_group_by_entries(spill_file,
+                         reinterpret_cast<const int8_t*>(group_by_buffers_.front()),
+                         full_result->getQueryMemDesc(),
+                         spilled_partitions);
+  initGroups(group_by_buffers_.front(), &init_agg_vals_[0], query_mem_desc_.entry_count, false, 1);
+}
+
 bool QueryExecutionContext::isEmptyBin(const int64_t* group_by_buffer, const size_t bin, const size_t key_idx) const {
   auto key_ptr = reinterpret_cast<const int8_t*>(group_by_buffer) + query_mem_desc_.getKeyOffInBytes(bin, key_idx);
   switch (query_mem_desc_.getEffectiveKeyWidth()) {
@@ -1164,7 +1232,8 @@ std::vector<int64_t*> QueryExecutionContext::launchCpuCode(const RelAlgExecution
                                                            const std::vector<int64_t>& init_agg_vals,
                                                            int32_t* error_code,
                                                            const uint32_t num_tables,
-                                                           const std::vector<int64_t>& join_hash_tables) {
+                                                           const std::vector<int64_t>& join_hash_tables,
+                                                           const int32_t resume_row) {
   INJECT_TIMER(lauchCpuCode);
   std::vector<const int8_t**> multifrag_col_buffers;
   for (auto& col_buffer : col_buffers) {
@@ -1203,6 +1272,11 @@ std::vector<int64_t*> QueryExecutionContext::launchCpuCode(const RelAlgExecution
   }
   int64_t rowid_lookup_num_rows{*error_code ? *error_code + 1 : 0};
   auto num_rows_ptr = rowid_lookup_num_rows ? &rowid_lookup_num_rows : &flatened_num_rows[0];
+  if (resume_row) {
+    // pos_start takes the first row from the error code, the rows of the fragment are scanned up to the end
+    CHECK(!rowid_lookup_num_rows);
+    *error_code = resume_row;
+  }
   int32_t total_matched_init{0};
 
   std::vector<int64_t> cmpt_val_buff;
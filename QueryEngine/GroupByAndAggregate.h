@@ -98,6 +98,24 @@ inline std::string datum_to_string(const TargetValue& tv, const SQLTypeInfo& ti,
   return nullable_str_to_string(*sptr);
 }
 
+class SpillFile;
+
+// Group-by entries written to a spill file. Each run holds the entries of one hash partition of the keys, so the
+// partitions can be reduced one at a time.
+struct SpilledGroupByRun {
+  size_t offset;
+  size_t entry_count;
+};
+
+typedef std::vector<std::vector<SpilledGroupByRun>> SpilledGroupByPartitions;
+
+// Appends the non-empty entries of a row-wise baseline hash buffer to the spill file, adding a run to every
+// partition which gets some. The partition of an entry is picked by the hash of its key.
+void spill_group_by_entries(SpillFile& spill_file,
+                            const int8_t* buff,
+                            const QueryMemoryDescriptor& query_mem_desc,
+                            SpilledGroupByPartitions& spilled_partitions);
+
 class QueryExecutionContext : boost::noncopyable {
  public:
   // TODO(alex): move init_agg_vals to GroupByBufferDescriptor, remove device_type
@@ -129,6 +147,12 @@ class QueryExecutionContext : boost::noncopyable {
 
   IterTabPtr getIterTab(const std::vector<Analyzer::Expr*>& targets, const ssize_t frag_idx) const;
 
+  // Moves the entries of a full CPU baseline hash buffer to a result set of their own and empties the buffer.
+  RowSetPtr flushGroupByBuffer();
+
+  // Same as above, but the entries go to the spill file, split by the hash partition of their keys.
+  void spillGroupByBuffer(SpillFile& spill_file, SpilledGroupByPartitions& spilled_partitions);
+
   std::vector<int64_t*> launchGpuCode(const RelAlgExecutionUnit& ra_exe_unit,
                                       const std::vector<std::pair<void*, void*>>& cu_functions,
                                       const bool hoist_literals,
@@ -160,7 +184,8 @@ class QueryExecutionContext : boost::noncopyable {
                                       const std::vector<int64_t>& init_agg_vals,
                                       int32_t* error_code,
                                       const uint32_t num_tables,
-                                      const std::vector<int64_t>& join_hash_tables);
+                                      const std::vector<int64_t>& join_hash_tables,
+                                      const int32_t resume_row = 0);
 
   bool hasNoFragments() const { return consistent_frag_sizes_.empty(); }
 
@@ -18,6 +18,7 @@
 #include "Execute.h"
 #include "MaxwellCodegenPatch.h"
 #include "RelAlgTranslator.h"
+#include "SpatialJoinHashTable.h"
 
 // Driver methods for the IR generation.
 
@@ -489,6 +490,29 @@ std::shared_ptr<JoinHashTableInterface> Executor::buildCurrentLevelHashTable(
       }
     }
   }
+  // Without an equijoin, a geo predicate can still narrow down the inner rows to the ones in
+  // the grid cell of the outer point. The qual has been added to the execution unit above.
+  if (!current_level_hash_table && current_level_join_conditions.type == JoinType::INNER && g_enable_spatial_join) {
+    const auto memory_level =
+        co.device_type_ == ExecutorDeviceType::GPU ? MemoryLevel::GPU_LEVEL : MemoryLevel::CPU_LEVEL;
+    const int device_count =
+        memory_level == MemoryLevel::GPU_LEVEL ? catalog_->get_dataMgr().cudaMgr_->getDeviceCount() : 1;
+    for (const auto& join_qual : current_level_join_conditions.quals) {
+      if (!is_spatial_join_qual(join_qual.get())) {
+        continue;
+      }
+      try {
+        const auto spatial_hash_table =
+            SpatialJoinHashTable::getInstance(join_qual, query_infos, ra_exe_unit, memory_level, device_count, this);
+        plan_state_->join_info_.join_hash_tables_.push_back(spatial_hash_table);
+        plan_state_->join_info_.equi_join_tautologies_.push_back(spatial_hash_table->getTautology());
+        current_level_hash_table = spatial_hash_table;
+        break;
+      } catch (const HashJoinFail& e) {
+        fail_reasons.push_back(e.what());
+      }
+    }
+  }
   return current_level_hash_table;
 }
 
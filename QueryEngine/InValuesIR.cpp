@@ -69,12 +69,30 @@ llvm::Value* Executor::codegen(const Analyzer::InIntegerSet* in_integer_set, con
     throw std::runtime_error(
         "IN subquery with many right-hand side values not supported when literal hoisting is disabled");
   }
-  auto in_vals_bitmap = boost::make_unique<InValuesBitmap>(
-      in_integer_set->get_value_list(),
-      needle_null_val,
-      co.device_type_ == ExecutorDeviceType::GPU ? Data_Namespace::GPU_LEVEL : Data_Namespace::CPU_LEVEL,
-      deviceCount(co.device_type_),
-      &catalog_->get_dataMgr());
+  std::shared_ptr<const InValuesBitmap> in_vals_bitmap;
+  const auto& values = in_integer_set->get_shared_value_list();
+  if (co.device_type_ == ExecutorDeviceType::GPU) {
+    in_vals_bitmap = std::make_shared<InValuesBitmap>(
+        *values, needle_null_val, Data_Namespace::GPU_LEVEL, deviceCount(co.device_type_), &catalog_->get_dataMgr());
+  } else {
+    // the same set often comes back, from a cached sub-query result or a retry of the query
+    const auto it = in_values_bitmap_cache_.find(values.get());
+    if (it != in_values_bitmap_cache_.end() && !it->second.values.expired() &&
+        it->second.null_val == needle_null_val) {
+      in_vals_bitmap = it->second.bitmap;
+    } else {
+      in_vals_bitmap = std::make_shared<InValuesBitmap>(
+          *values, needle_null_val, Data_Namespace::CPU_LEVEL, deviceCount(co.device_type_), &catalog_->get_dataMgr());
+      for (auto cached_it = in_values_bitmap_cache_.begin(); cached_it != in_values_bitmap_cache_.end();) {
+        if (cached_it->second.values.expired()) {
+          cached_it = in_values_bitmap_cache_.erase(cached_it);
+        } else {
+          ++cached_it;
+        }
+      }
+      in_values_bitmap_cache_[values.get()] = CachedInValuesBitmap{values, needle_null_val, in_vals_bitmap};
+    }
+  }
   const auto& in_integer_set_ti = in_integer_set->get_type_info();
   CHECK(in_integer_set_ti.is_boolean());
   const auto lhs_lvs = codegen(in_arg, true, co);
@@ -92,6 +110,28 @@ llvm::Value* Executor::codegen(const Analyzer::InIntegerSet* in_integer_set, con
   return cgen_state_->addInValuesBitmap(in_vals_bitmap)->codegen(lhs_lvs.front(), this);
 }
 
+std::shared_ptr<const std::vector<int64_t>> Executor::getInIntegerSet(const std::shared_ptr<ResultSet>& rows,
+                                                                       const std::string& arg_key) const {
+  const auto it = in_integer_set_cache_.find(rows.get());
+  if (it == in_integer_set_cache_.end() || it->second.rows.expired() || it->second.arg_key != arg_key) {
+    return nullptr;
+  }
+  return it->second.values;
+}
+
+void Executor::putInIntegerSet(const std::shared_ptr<ResultSet>& rows,
+                               const std::string& arg_key,
+                               const std::shared_ptr<const std::vector<int64_t>>& values) const {
+  for (auto it = in_integer_set_cache_.begin(); it != in_integer_set_cache_.end();) {
+    if (it->second.rows.expired()) {
+      it = in_integer_set_cache_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  in_integer_set_cache_[rows.get()] = CachedInIntegerSet{rows, arg_key, values};
+}
+
 std::unique_ptr<InValuesBitmap> Executor::createInValuesBitmap(const Analyzer::InValues* in_values,
                                                                const CompilationOptions& co) {
   const auto& value_list = in_values->get_value_list();
@@ -246,6 +246,13 @@ std::shared_ptr<JoinHashTable> JoinHashTable::getInstance(const std::shared_ptr<
                                               0,
                                               source_col_range.hasNulls());
   }
+  if (ti.is_date_in_days()) {
+    // the hash table is built from the stored days, the probe side divides its seconds
+    col_range = ExpressionRange::makeIntRange(get_epoch_days_from_seconds(col_range.getIntMin()),
+                                              get_epoch_days_from_seconds(col_range.getIntMax()),
+                                              0,
+                                              col_range.hasNulls());
+  }
   // We can't allocate more than 2GB contiguous memory on GPU and each entry is 4 bytes.
   const auto max_hash_entry_count = memory_level == Data_Namespace::MemoryLevel::GPU_LEVEL
                                         ? static_cast<size_t>(std::numeric_limits<int32_t>::max() / sizeof(int32_t))
@@ -1081,8 +1088,18 @@ std::vector<llvm::Value*> JoinHashTable::getHashJoinArgs(llvm::Value* hash_ptr,
                                                          const CompilationOptions& co) {
   const auto key_lvs = executor_->codegen(key_col, true, co);
   CHECK_EQ(size_t(1), key_lvs.size());
+  auto key_lv = executor_->castToTypeIn(key_lvs.front(), 64);
+  if (col_var_->get_type_info().is_date_in_days()) {
+    // the dates of the probe side are whole days, the null sentinel is left alone
+    auto& ir_builder = executor_->cgen_state_->ir_builder_;
+    const auto key_col_logical_ti = get_logical_type_info(key_col->get_type_info());
+    const auto null_lv = executor_->ll_int(inline_fixed_encoding_null_val(key_col_logical_ti));
+    key_lv = ir_builder.CreateSelect(ir_builder.CreateICmpEQ(key_lv, null_lv),
+                                     key_lv,
+                                     ir_builder.CreateSDiv(key_lv, executor_->ll_int(int64_t(SECSPERDAY))));
+  }
   std::vector<llvm::Value*> hash_join_idx_args{hash_ptr,
-                                               executor_->castToTypeIn(key_lvs.front(), 64),
+                                               key_lv,
                                                executor_->ll_int(col_range_.getIntMin()),
                                                executor_->ll_int(col_range_.getIntMax())};
   if (shard_count) {
@@ -16,6 +16,7 @@
 
 #include "MurmurHash.h"
 #include "CompareKeysInl.h"
+#include "../Shared/geo_compression.h"
 
 DEVICE bool compare_to_key(const int8_t* entry, const int8_t* key, const size_t key_bytes) {
   for (size_t i = 0; i < key_bytes; ++i) {
@@ -117,3 +118,25 @@ extern "C" NEVER_INLINE DEVICE int64_t get_composite_key_index_64(const int64_t*
                                                                   const size_t entry_count) {
   return get_composite_key_index_impl(key, key_component_count, composite_key_dict, entry_count);
 }
+
+// Cell of the spatial join grid the point falls in, -1 for the null points and the ones outside of the grid.
+extern "C" NEVER_INLINE DEVICE int64_t spatial_join_cell(const int8_t* coords,
+                                                         const int64_t coords_size,
+                                                         const int32_t ic,
+                                                         const double min_x,
+                                                         const double min_y,
+                                                         const double cell_width,
+                                                         const double cell_height,
+                                                         const int64_t cells_x,
+                                                         const int64_t cells_y) {
+  double x, y;
+  if (!decompress_point(coords, coords_size, ic == 1, x, y)) {
+    return -1;
+  }
+  const double cell_x = (x - min_x) / cell_width;
+  const double cell_y = (y - min_y) / cell_height;
+  if (!(cell_x >= 0) || !(cell_y >= 0) || cell_x >= cells_x || cell_y >= cells_y) {
+    return -1;
+  }
+  return static_cast<int64_t>(cell_y) * cells_x + static_cast<int64_t>(cell_x);
+}
@@ -1436,6 +1436,9 @@ class RelAlgAbstractInterpreter {
     }
     CHECK(!nodes_.empty());
     bind_inputs(nodes_);
+    if (g_enable_materialized_view_rewrite) {
+      rewriteWithMaterializedViews();
+    }
     mark_nops(nodes_);
     simplify_sort(nodes_);
     sink_projected_boolean_expr_to_join(nodes_);
@@ -1464,7 +1467,44 @@ class RelAlgAbstractInterpreter {
     return nodes_.back();
   }
 
+  // Deserializes the plan of a materialized view as is, it's matched against the queries structurally.
+  std::vector<std::shared_ptr<RelAlgNode>> dispatchAndBind() {
+    dispatchNodes(field(query_ast_, "rels"));
+    CHECK(!nodes_.empty());
+    bind_inputs(nodes_);
+    return nodes_;
+  }
+
  private:
+  void rewriteWithMaterializedViews() {
+    std::vector<MaterializedViewPlan> views;
+    std::unordered_set<int> source_table_ids;
+    for (const auto& node : nodes_) {
+      const auto scan = std::dynamic_pointer_cast<const RelScan>(node);
+      if (!scan || !source_table_ids.insert(scan->getTableDescriptor()->tableId).second) {
+        continue;
+      }
+      const auto td = scan->getTableDescriptor();
+      for (const auto& mvd : cat_.getMaterializedViewsForTable(td->tableId)) {
+        // only views which folded in exactly the rows of the source are equivalent to it
+        if (mvd->needsRebuild || !td->fragmenter ||
+            static_cast<size_t>(mvd->refreshedRows) != td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples()) {
+          continue;
+        }
+        const auto view_td = cat_.getMetadataForTable(mvd->tableId);
+        CHECK(view_td);
+        try {
+          views.push_back({view_td, deserialize_materialized_view_ra(mvd->viewRA, cat_)});
+        } catch (const std::exception& e) {
+          LOG(WARNING) << "Materialized view " << view_td->tableName << " skipped: " << e.what();
+        }
+      }
+    }
+    if (!views.empty()) {
+      rewrite_aggregates_with_materialized_views(nodes_, views);
+    }
+  }
+
   void dispatchNodes(const rapidjson::Value& rels) {
     for (auto rels_it = rels.Begin(); rels_it != rels.End(); ++rels_it) {
       const auto& crt_node = *rels_it;
@@ -1691,8 +1731,11 @@ std::unique_ptr<const RexSubQuery> parse_subquery(const rapidjson::Value& expr,
   CHECK_GE(operands.Size(), unsigned(0));
   const auto& subquery_ast = field(expr, "subquery");
 
+  if (!ra_executor) {
+    throw QueryNotSupported("Subqueries not supported in this context");
+  }
   const auto ra = ra_interpret(subquery_ast, cat, ra_executor);
-  auto subquery = new RexSubQuery(ra);
+  auto subquery = new RexSubQuery(ra, json_node_to_string(subquery_ast));
   ra_executor->registerSubquery(subquery);
   return std::unique_ptr<const RexSubQuery>(subquery);
 }
@@ -1711,6 +1754,16 @@ std::shared_ptr<const RelAlgNode> deserialize_ra_dag(const std::string& query_ra
   return ra_interpret(query_ast, cat, ra_executor);
 }
 
+std::vector<std::shared_ptr<RelAlgNode>> deserialize_materialized_view_ra(const std::string& view_ra,
+                                                                        const Catalog_Namespace::Catalog& cat) {
+  rapidjson::Document view_ast;
+  view_ast.Parse(view_ra.c_str());
+  CHECK(!view_ast.HasParseError());
+  CHECK(view_ast.IsObject());
+  RelAlgAbstractInterpreter interp(view_ast, cat, nullptr);
+  return interp.dispatchAndBind();
+}
+
 // Prints the relational algebra as a tree; useful for debugging.
 std::string tree_string(const RelAlgNode* ra, const size_t indent) {
   std::string result = std::string(indent, ' ') + ra->toString() + "\n";
@@ -247,7 +247,8 @@ class ExecutionResult;
 
 class RexSubQuery : public RexScalar {
  public:
-  RexSubQuery(const std::shared_ptr<const RelAlgNode> ra) : type_(SQLTypeInfo(kNULLT, false)), ra_(ra) {}
+  RexSubQuery(const std::shared_ptr<const RelAlgNode> ra, const std::string& serialized_ra)
+      : type_(SQLTypeInfo(kNULLT, false)), ra_(ra), serialized_ra_(serialized_ra) {}
 
   RexSubQuery(const RexSubQuery&) = delete;
 
@@ -269,6 +270,9 @@ class RexSubQuery : public RexScalar {
 
   const RelAlgNode* getRelAlg() const { return ra_.get(); }
 
+  // The plan as received from Calcite, identical sub-queries have identical serialized plans.
+  const std::string& getSerializedRelAlg() const { return serialized_ra_; }
+
   std::string toString() const override {
     return "(RexSubQuery " + std::to_string(reinterpret_cast<const uint64_t>(this)) + ")";
   }
@@ -281,6 +285,7 @@ class RexSubQuery : public RexScalar {
   SQLTypeInfo type_;
   std::shared_ptr<const ExecutionResult> result_;
   const std::shared_ptr<const RelAlgNode> ra_;
+  const std::string serialized_ra_;
 };
 
 // The actual input node understood by the Executor.
@@ -1232,6 +1237,10 @@ std::shared_ptr<const RelAlgNode> deserialize_ra_dag(const std::string& query_ra
                                                      const Catalog_Namespace::Catalog& cat,
                                                      RelAlgExecutor* ra_executor);
 
+// The nodes of a materialized view plan, bound but not optimized. Throws for plans with subqueries.
+std::vector<std::shared_ptr<RelAlgNode>> deserialize_materialized_view_ra(const std::string& view_ra,
+                                                                        const Catalog_Namespace::Catalog& cat);
+
 std::string tree_string(const RelAlgNode*, const size_t indent = 0);
 
 typedef std::vector<RexInput> RANodeOutput;
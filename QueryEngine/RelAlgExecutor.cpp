@@ -22,6 +22,7 @@
 #include "EquiJoinCondition.h"
 #include "ExecutionException.h"
 #include "ExpressionRewrite.h"
+#include "HyperLogLog.h"
 #include "InputMetadata.h"
 #include "QueryPhysicalInputsCollector.h"
 #include "RangeTableIndexVisitor.h"
@@ -160,12 +161,14 @@ ExecutionResult RelAlgExecutor::executeRelAlgQueryNoRetry(const std::string& que
     }
     scanForTablesAndAggsInRelAlgSeqForRender(ed_list, render_info);
   }
-  // Dispatch the subqueries first
+  // Dispatch the subqueries first, identical ones are only executed once
+  std::unordered_map<std::string, std::shared_ptr<const ExecutionResult>> subquery_results;
   for (auto subquery : subqueries_) {
-    // Execute the subquery and cache the result.
-    RelAlgExecutor ra_executor(executor_, cat_);
-    auto result = ra_executor.executeRelAlgSubQuery(subquery, co, eo);
-    subquery->setExecutionResult(std::make_shared<ExecutionResult>(result));
+    auto& result = subquery_results[subquery->getSerializedRelAlg()];
+    if (!result) {
+      result = executeRelAlgSubQueryCached(subquery, co, eo);
+    }
+    subquery->setExecutionResult(result);
   }
   return executeRelAlgSeq(ed_list, co, eo, render_info, queue_time_ms);
 }
@@ -290,6 +293,74 @@ ExecutionResult RelAlgExecutor::executeRelAlgSubQuery(const RexSubQuery* subquer
   return executeRelAlgSeq(ed_list, co, eo, nullptr, 0);
 }
 
+namespace {
+
+// Describes the data read by a sub-query, empty if its result can't be reused by later queries.
+std::string get_subquery_table_versions(const RexSubQuery* subquery, const Catalog_Namespace::Catalog& cat) {
+  const auto& serialized_ra = subquery->getSerializedRelAlg();
+  // nested sub-queries read tables not reachable from the plan nodes
+  if (serialized_ra.find("\"subquery\"") != std::string::npos || serialized_ra.find("\"NOW\"") != std::string::npos ||
+      serialized_ra.find("\"DATETIME\"") != std::string::npos) {
+    return "";
+  }
+  const auto table_ids = get_physical_table_inputs(subquery->getRelAlg());
+  std::string table_versions;
+  for (const auto table_id : std::set<int>(table_ids.begin(), table_ids.end())) {
+    table_versions += std::to_string(table_id) + ":" + std::to_string(cat.getTableDataVersion(table_id)) + ";";
+  }
+  return table_versions;
+}
+
+}  // namespace
+
+std::shared_ptr<const ExecutionResult> RelAlgExecutor::executeRelAlgSubQueryCached(const RexSubQuery* subquery,
+                                                                                   const CompilationOptions& co,
+                                                                                   const ExecutionOptions& eo) {
+  const auto table_versions =
+      g_subquery_result_cache_bytes && !eo.just_explain ? get_subquery_table_versions(subquery, cat_) : "";
+  auto& cache = executor_->subquery_result_cache_;
+  if (!table_versions.empty()) {
+    const auto it = std::find_if(cache.begin(), cache.end(), [subquery](const Executor::CachedSubqueryResult& entry) {
+      return entry.serialized_ra == subquery->getSerializedRelAlg();
+    });
+    if (it != cache.end()) {
+      if (it->table_versions == table_versions) {
+        cache.splice(cache.begin(), cache, it);
+        return it->result;
+      }
+      executor_->subquery_result_cache_bytes_ -= it->size_bytes;
+      cache.erase(it);
+    }
+  }
+  // a cached result outlives the query, it gets its own memory owner instead of pinning the one of the query
+  const auto query_row_set_mem_owner = executor_->row_set_mem_owner_;
+  if (!table_versions.empty()) {
+    executor_->row_set_mem_owner_ = std::make_shared<RowSetMemoryOwner>();
+  }
+  ScopeGuard restore_row_set_mem_owner = [this, &query_row_set_mem_owner] {
+    executor_->row_set_mem_owner_ = query_row_set_mem_owner;
+  };
+  RelAlgExecutor ra_executor(executor_, cat_);
+  auto result = std::make_shared<const ExecutionResult>(ra_executor.executeRelAlgSubQuery(subquery, co, eo));
+  // appends only take the checkpoint lock, don't keep a result which may have raced with one
+  if (table_versions.empty() || !boost::get<RowSetPtr>(&result->getDataPtr()) ||
+      get_subquery_table_versions(subquery, cat_) != table_versions) {
+    return result;
+  }
+  const auto size_bytes = result->getRows()->getSelfContainedSizeBytes();
+  if (!size_bytes || size_bytes > g_subquery_result_cache_bytes) {
+    return result;
+  }
+  while (executor_->subquery_result_cache_bytes_ + size_bytes > g_subquery_result_cache_bytes) {
+    CHECK(!cache.empty());
+    executor_->subquery_result_cache_bytes_ -= cache.back().size_bytes;
+    cache.pop_back();
+  }
+  cache.push_front({subquery->getSerializedRelAlg(), table_versions, result, size_bytes});
+  executor_->subquery_result_cache_bytes_ += size_bytes;
+  return result;
+}
+
 ExecutionResult RelAlgExecutor::executeRelAlgSeq(std::vector<RaExecutionDesc>& exec_descs,
                                                  const CompilationOptions& co,
                                                  const ExecutionOptions& eo,
@@ -1219,6 +1290,9 @@ void RelAlgExecutor::executeDeleteViaCompound(const RelCompound* compound,
     executor_->executeUpdate(
         work_unit.exe_unit, table_infos.front(), co_project, eo, cat_, executor_->row_set_mem_owner_, delete_callback);
     delete_params.finalizeTransaction();
+    if (g_auto_vacuum_threshold > 0) {
+      cat_.vacuumDeletedRows(table_descriptor, g_auto_vacuum_threshold);
+    }
   } catch (...) {
     LOG(INFO) << "Delete operation failed.";
     throw;
@@ -1260,6 +1334,9 @@ void RelAlgExecutor::executeDeleteViaProject(const RelProject* project,
     executor_->executeUpdate(
         work_unit.exe_unit, table_infos.front(), co_project, eo, cat_, executor_->row_set_mem_owner_, delete_callback);
     delete_params.finalizeTransaction();
+    if (g_auto_vacuum_threshold > 0) {
+      cat_.vacuumDeletedRows(table_descriptor, g_auto_vacuum_threshold);
+    }
   } catch (...) {
     LOG(INFO) << "Delete operation failed.";
     throw;
@@ -1545,6 +1622,49 @@ size_t groups_approx_upper_bound(const std::vector<InputTableInfo>& table_infos)
   return std::max(max_num_groups, size_t(1));
 }
 
+// Estimates the number of groups by merging the distinct value sketches of the chunks, which saves the
+// estimation pass over the data. Filters are ignored, so it's an upper bound. Returns zero if the sketches
+// can't be used: joins, expressions, chunks without a sketch or a too loose estimate for multiple columns.
+size_t get_sketch_ndv_estimation(const RelAlgExecutionUnit& ra_exe_unit,
+                                 const std::vector<InputTableInfo>& table_infos) {
+  static const double max_multi_column_estimate{1 << 20};
+  if (ra_exe_unit.input_descs.size() != 1 || table_infos.size() != 1) {
+    return 0;
+  }
+  const auto& table_info = table_infos.front();
+  double estimate{1};
+  for (const auto& groupby_expr : ra_exe_unit.groupby_exprs) {
+    const auto col_var = std::dynamic_pointer_cast<Analyzer::ColumnVar>(groupby_expr);
+    if (!col_var || col_var->get_table_id() != table_info.table_id) {
+      return 0;
+    }
+    std::vector<uint8_t> merged_sketch(size_t(1) << CHUNK_SKETCH_BITS, 0);
+    bool has_nulls{false};
+    for (const auto& fragment : table_info.info.fragments) {
+      if (!fragment.getNumTuples()) {
+        continue;
+      }
+      const auto& chunk_metadata_map = fragment.getChunkMetadataMap();
+      const auto chunk_metadata_it = chunk_metadata_map.find(col_var->get_column_id());
+      if (chunk_metadata_it == chunk_metadata_map.end() ||
+          chunk_metadata_it->second.distinctSketch.size() != merged_sketch.size()) {
+        return 0;
+      }
+      const auto& sketch = chunk_metadata_it->second.distinctSketch;
+      for (size_t i = 0; i < merged_sketch.size(); ++i) {
+        merged_sketch[i] = std::max(merged_sketch[i], sketch[i]);
+      }
+      has_nulls = has_nulls || chunk_metadata_it->second.chunkStats.has_nulls;
+    }
+    estimate *= hll_size(&merged_sketch[0], CHUNK_SKETCH_BITS) + (has_nulls ? 1 : 0);
+  }
+  if (ra_exe_unit.groupby_exprs.size() > 1 && estimate > max_multi_column_estimate) {
+    return 0;
+  }
+  return std::max(static_cast<size_t>(std::min(estimate, static_cast<double>(groups_approx_upper_bound(table_infos)))),
+                  size_t(1));
+}
+
 bool can_use_scan_limit(const RelAlgExecutionUnit& ra_exe_unit) {
   for (const auto target_expr : ra_exe_unit.target_exprs) {
     if (dynamic_cast<const Analyzer::AggExpr*>(target_expr)) {
@@ -1622,6 +1742,294 @@ RelAlgExecutionUnit decide_approx_count_distinct_implementation(
   return ra_exe_unit;
 }
 
+// A simple qualifier of the form column <op> constant, which can be decided for a whole fragment from its metadata.
+struct MetadataQual {
+  int col_id;
+  SQLTypeInfo col_ti;
+  SQLOps optype;
+  int64_t val;
+};
+
+enum class FragmentMetadataCoverage { Skip, Full, Scan };
+
+bool get_metadata_quals(std::vector<MetadataQual>& metadata_quals,
+                        const std::list<std::shared_ptr<Analyzer::Expr>>& simple_quals,
+                        const int table_id) {
+  for (const auto& simple_qual : simple_quals) {
+    const auto comp_expr = std::dynamic_pointer_cast<const Analyzer::BinOper>(simple_qual);
+    if (!comp_expr) {
+      return false;
+    }
+    const auto lhs_col = dynamic_cast<const Analyzer::ColumnVar*>(comp_expr->get_left_operand());
+    const auto rhs_const = dynamic_cast<const Analyzer::Constant*>(comp_expr->get_right_operand());
+    if (!lhs_col || lhs_col->get_table_id() != table_id || lhs_col->get_rte_idx() || !rhs_const ||
+        rhs_const->get_is_null()) {
+      return false;
+    }
+    const auto& col_ti = lhs_col->get_type_info();
+    if ((!col_ti.is_integer() && !col_ti.is_time()) || rhs_const->get_type_info().get_type() != col_ti.get_type()) {
+      return false;
+    }
+    metadata_quals.push_back(MetadataQual{lhs_col->get_column_id(),
+                                          col_ti,
+                                          comp_expr->get_optype(),
+                                          extract_from_datum(rhs_const->get_constval(), col_ti)});
+  }
+  return true;
+}
+
+const Analyzer::ColumnVar* get_metadata_aggregate_column(const Analyzer::Expr* target_expr) {
+  const auto agg_expr = dynamic_cast<const Analyzer::AggExpr*>(target_expr);
+  CHECK(agg_expr);
+  return dynamic_cast<const Analyzer::ColumnVar*>(agg_expr->get_arg());
+}
+
+int64_t get_approx_count_distinct_bits(const Analyzer::AggExpr* agg_expr) {
+  const auto error_rate = agg_expr->get_error_rate();
+  return error_rate ? hll_size_for_rate(error_rate->get_constval().smallintval) : g_hll_precision_bits;
+}
+
+// MIN, MAX and non-distinct COUNT of numeric or time columns, the types whose chunk stats are kept.
+// APPROX_COUNT_DISTINCT of the columns with a distinct sketch, if the sketch is at least as precise
+// as the requested error rate.
+bool is_metadata_aggregate(const Analyzer::Expr* target_expr, const int table_id) {
+  const auto agg_expr = dynamic_cast<const Analyzer::AggExpr*>(target_expr);
+  if (!agg_expr || agg_expr->get_is_distinct()) {
+    return false;
+  }
+  switch (agg_expr->get_aggtype()) {
+    case kCOUNT:
+      if (!agg_expr->get_arg()) {
+        return true;
+      }
+      break;
+    case kMIN:
+    case kMAX:
+      break;
+    case kAPPROX_COUNT_DISTINCT:
+      if (get_approx_count_distinct_bits(agg_expr) > CHUNK_SKETCH_BITS) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+  const auto col_var = get_metadata_aggregate_column(target_expr);
+  if (!col_var || col_var->get_table_id() != table_id || col_var->get_rte_idx()) {
+    return false;
+  }
+  const auto& col_ti = col_var->get_type_info();
+  if (agg_expr->get_aggtype() == kAPPROX_COUNT_DISTINCT) {
+    return col_ti.is_integer() || col_ti.is_decimal() || col_ti.is_time() ||
+           (col_ti.is_string() && col_ti.get_compression() == kENCODING_DICT);
+  }
+  return col_ti.is_number() || col_ti.is_time();
+}
+
+// Folds HyperLogLog registers into ones with fewer index bits, as if the values had been added to the latter.
+// The index bits which are dropped lead the bits the rank is computed from.
+std::vector<uint8_t> fold_sketch(const std::vector<uint8_t>& sketch, const size_t from_bits, const size_t to_bits) {
+  CHECK_LE(to_bits, from_bits);
+  CHECK_EQ(size_t(1) << from_bits, sketch.size());
+  const size_t shift = from_bits - to_bits;
+  std::vector<uint8_t> folded(size_t(1) << to_bits, 0);
+  for (size_t i = 0; i < sketch.size(); ++i) {
+    if (!sketch[i]) {
+      continue;
+    }
+    const uint64_t dropped_bits = i & ((size_t(1) << shift) - 1);
+    const uint8_t rank = dropped_bits ? shift - (64 - __builtin_clzl(dropped_bits)) + 1 : shift + sketch[i];
+    auto& folded_register = folded[i >> shift];
+    folded_register = std::max(folded_register, rank);
+  }
+  return folded;
+}
+
+// Skip when no row can pass the quals, Full when every row passes them and the metadata of the aggregated
+// columns is exact (no deleted rows, no in-place updates), Scan otherwise.
+FragmentMetadataCoverage get_fragment_coverage(const Fragmenter_Namespace::FragmentInfo& fragment,
+                                               const std::vector<MetadataQual>& metadata_quals,
+                                               const ColumnDescriptor* deleted_cd,
+                                               const std::vector<Analyzer::Expr*>& target_exprs) {
+  if (!fragment.getNumTuples()) {
+    return FragmentMetadataCoverage::Skip;
+  }
+  const auto& chunk_metadata_map = fragment.getChunkMetadataMap();
+  bool all_rows_pass{true};
+  for (const auto& qual : metadata_quals) {
+    const auto chunk_metadata_it = chunk_metadata_map.find(qual.col_id);
+    if (chunk_metadata_it == chunk_metadata_map.end()) {
+      all_rows_pass = false;
+      continue;
+    }
+    const auto& chunk_metadata = chunk_metadata_it->second;
+    const auto chunk_min = extract_min_stat(chunk_metadata.chunkStats, qual.col_ti);
+    const auto chunk_max = extract_max_stat(chunk_metadata.chunkStats, qual.col_ti);
+    switch (qual.optype) {
+      case kGE:
+        if (chunk_max < qual.val) {
+          return FragmentMetadataCoverage::Skip;
+        }
+        all_rows_pass = all_rows_pass && chunk_min >= qual.val;
+        break;
+      case kGT:
+        if (chunk_max <= qual.val) {
+          return FragmentMetadataCoverage::Skip;
+        }
+        all_rows_pass = all_rows_pass && chunk_min > qual.val;
+        break;
+      case kLE:
+        if (chunk_min > qual.val) {
+          return FragmentMetadataCoverage::Skip;
+        }
+        all_rows_pass = all_rows_pass && chunk_max <= qual.val;
+        break;
+      case kLT:
+        if (chunk_min >= qual.val) {
+          return FragmentMetadataCoverage::Skip;
+        }
+        all_rows_pass = all_rows_pass && chunk_max < qual.val;
+        break;
+      case kEQ:
+        if (chunk_min > qual.val || chunk_max < qual.val) {
+          return FragmentMetadataCoverage::Skip;
+        }
+        all_rows_pass = all_rows_pass && chunk_min == qual.val && chunk_max == qual.val;
+        break;
+      default:
+        all_rows_pass = false;
+        break;
+    }
+    // Bounds widened by an update are still good for skipping, but not for proving every row passes.
+    if (chunk_metadata.chunkStats.has_nulls || !chunk_metadata.statsExact) {
+      all_rows_pass = false;
+    }
+  }
+  if (!all_rows_pass) {
+    return FragmentMetadataCoverage::Scan;
+  }
+  if (deleted_cd) {
+    const auto deleted_metadata_it = chunk_metadata_map.find(deleted_cd->columnId);
+    if (deleted_metadata_it == chunk_metadata_map.end() ||
+        deleted_metadata_it->second.chunkStats.max.tinyintval) {
+      return FragmentMetadataCoverage::Scan;
+    }
+  }
+  for (const auto target_expr : target_exprs) {
+    const auto col_var = get_metadata_aggregate_column(target_expr);
+    if (!col_var) {
+      continue;
+    }
+    const auto chunk_metadata_it = chunk_metadata_map.find(col_var->get_column_id());
+    if (chunk_metadata_it == chunk_metadata_map.end() || !chunk_metadata_it->second.statsExact) {
+      return FragmentMetadataCoverage::Scan;
+    }
+    const auto agg_expr = static_cast<const Analyzer::AggExpr*>(target_expr);
+    if (agg_expr->get_aggtype() == kCOUNT && chunk_metadata_it->second.chunkStats.has_nulls) {
+      return FragmentMetadataCoverage::Scan;
+    }
+    if (agg_expr->get_aggtype() == kAPPROX_COUNT_DISTINCT &&
+        chunk_metadata_it->second.distinctSketch.size() != size_t(1) << CHUNK_SKETCH_BITS) {
+      return FragmentMetadataCoverage::Scan;
+    }
+  }
+  return FragmentMetadataCoverage::Full;
+}
+
+// Aggregate value of a target so far, floating point columns keep theirs in fp_val and APPROX_COUNT_DISTINCT
+// the union of the chunk sketches.
+struct MetadataAggregateValue {
+  int64_t val{0};
+  double fp_val{0};
+  bool is_set{false};
+  std::vector<uint8_t> sketch;
+};
+
+template <typename T>
+void fold_aggregate_value(T& agg_val, bool& agg_val_set, const SQLAgg agg_kind, const T val) {
+  switch (agg_kind) {
+    case kCOUNT:
+      agg_val += val;
+      break;
+    case kMIN:
+      agg_val = agg_val_set ? std::min(agg_val, val) : val;
+      break;
+    case kMAX:
+      agg_val = agg_val_set ? std::max(agg_val, val) : val;
+      break;
+    default:
+      CHECK(false);
+  }
+  agg_val_set = true;
+}
+
+void fold_fragment_metadata(std::vector<MetadataAggregateValue>& agg_vals,
+                            const Fragmenter_Namespace::FragmentInfo& fragment,
+                            const std::vector<Analyzer::Expr*>& target_exprs) {
+  for (size_t i = 0; i < target_exprs.size(); ++i) {
+    const auto agg_expr = static_cast<const Analyzer::AggExpr*>(target_exprs[i]);
+    auto& agg_val = agg_vals[i];
+    if (agg_expr->get_aggtype() == kCOUNT) {
+      fold_aggregate_value(agg_val.val, agg_val.is_set, kCOUNT, static_cast<int64_t>(fragment.getNumTuples()));
+      continue;
+    }
+    const auto col_var = get_metadata_aggregate_column(agg_expr);
+    CHECK(col_var);
+    const auto& chunk_metadata_map = fragment.getChunkMetadataMap();
+    const auto chunk_metadata_it = chunk_metadata_map.find(col_var->get_column_id());
+    CHECK(chunk_metadata_it != chunk_metadata_map.end());
+    if (agg_expr->get_aggtype() == kAPPROX_COUNT_DISTINCT) {
+      const auto& sketch = chunk_metadata_it->second.distinctSketch;
+      agg_val.sketch.resize(sketch.size(), 0);
+      for (size_t j = 0; j < sketch.size(); ++j) {
+        agg_val.sketch[j] = std::max(agg_val.sketch[j], sketch[j]);
+      }
+      continue;
+    }
+    const auto& chunk_stats = chunk_metadata_it->second.chunkStats;
+    const auto& col_ti = col_var->get_type_info();
+    if (col_ti.is_fp()) {
+      const bool is_double = col_ti.get_type() == kDOUBLE;
+      const double chunk_min = is_double ? chunk_stats.min.doubleval : chunk_stats.min.floatval;
+      const double chunk_max = is_double ? chunk_stats.max.doubleval : chunk_stats.max.floatval;
+      if (chunk_min > chunk_max) {
+        // only nulls in this chunk
+        continue;
+      }
+      const auto agg_kind = agg_expr->get_aggtype();
+      fold_aggregate_value(agg_val.fp_val, agg_val.is_set, agg_kind, agg_kind == kMIN ? chunk_min : chunk_max);
+      continue;
+    }
+    const auto chunk_min = extract_min_stat(chunk_stats, col_ti);
+    const auto chunk_max = extract_max_stat(chunk_stats, col_ti);
+    if (chunk_min > chunk_max) {
+      // only nulls in this chunk
+      continue;
+    }
+    fold_aggregate_value(
+        agg_val.val, agg_val.is_set, agg_expr->get_aggtype(), agg_expr->get_aggtype() == kMIN ? chunk_min : chunk_max);
+  }
+}
+
+// The slot of a target in a single entry result set, MIN and MAX of FLOAT are read back as 32-bit floats.
+int64_t get_metadata_aggregate_slot(const MetadataAggregateValue& agg_val, const TargetInfo& agg_info) {
+  if (agg_info.agg_kind == kCOUNT) {
+    return agg_val.val;
+  }
+  if (!agg_info.sql_type.is_fp()) {
+    return agg_val.is_set ? agg_val.val : inline_int_null_val(agg_info.sql_type);
+  }
+  const double fp_val = agg_val.is_set ? agg_val.fp_val : inline_fp_null_val(agg_info.sql_type);
+  int64_t slot{0};
+  if (agg_info.sql_type.get_type() == kFLOAT) {
+    const float float_val = fp_val;
+    memcpy(&slot, &float_val, sizeof(float));
+  } else {
+    memcpy(&slot, &fp_val, sizeof(double));
+  }
+  return slot;
+}
+
 }  // namespace
 
 ExecutionResult RelAlgExecutor::executeWorkUnit(const RelAlgExecutor::WorkUnit& work_unit,
@@ -1647,6 +2055,14 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(const RelAlgExecutor::WorkUnit&
 
   const auto table_infos = get_table_infos(work_unit.exe_unit, executor_);
 
+  if (is_agg && !render_info) {
+    if (const auto metadata_rows = executeAggregatesFromMetadata(work_unit, table_infos, co, eo)) {
+      ExecutionResult result(metadata_rows, targets_meta);
+      result.setQueueTime(queue_time_ms);
+      return result;
+    }
+  }
+
   /*
   executor_->executeUpdate(work_unit.exe_unit,
                            table_infos.front(),
@@ -1744,10 +2160,159 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(const RelAlgExecutor::WorkUnit&
                      queue_time_ms);
 }
 
+// Answers a non-grouped MIN / MAX / COUNT / APPROX_COUNT_DISTINCT query from the chunk metadata of the fragments
+// which are either pruned by the simple quals or fully selected by them, and runs the query only on the remaining
+// fragments. Returns nullptr when the query doesn't qualify or no fragment can be answered from metadata.
+RowSetPtr RelAlgExecutor::executeAggregatesFromMetadata(const WorkUnit& work_unit,
+                                                        const std::vector<InputTableInfo>& table_infos,
+                                                        const CompilationOptions& co,
+                                                        const ExecutionOptions& eo) {
+  if (!g_enable_metadata_aggregates || g_cluster || eo.just_explain) {
+    return nullptr;
+  }
+  // The regular path counts small ranges exactly rather than approximately, make the same choice.
+  const auto ra_exe_unit = decide_approx_count_distinct_implementation(
+      work_unit.exe_unit, table_infos, executor_, co.device_type_, target_exprs_owned_);
+  if (ra_exe_unit.input_descs.size() != 1 || table_infos.size() != 1 ||
+      ra_exe_unit.input_descs.front().getSourceType() != InputSourceType::TABLE) {
+    return nullptr;
+  }
+  if (!ra_exe_unit.quals.empty() || !ra_exe_unit.inner_joins.empty() || !ra_exe_unit.inner_join_quals.empty() ||
+      !ra_exe_unit.outer_join_quals.empty() || !ra_exe_unit.groupby_exprs.empty() || ra_exe_unit.estimator ||
+      ra_exe_unit.target_exprs.empty()) {
+    return nullptr;
+  }
+  const int table_id = ra_exe_unit.input_descs.front().getTableId();
+  for (const auto target_expr : ra_exe_unit.target_exprs) {
+    if (!is_metadata_aggregate(target_expr, table_id)) {
+      return nullptr;
+    }
+  }
+  std::vector<MetadataQual> metadata_quals;
+  if (!get_metadata_quals(metadata_quals, ra_exe_unit.simple_quals, table_id)) {
+    return nullptr;
+  }
+  const auto td = cat_.getMetadataForTable(table_id);
+  CHECK(td);
+  const auto deleted_cd = cat_.getDeletedColumn(td);
+  std::vector<MetadataAggregateValue> agg_vals(ra_exe_unit.target_exprs.size());
+  auto scan_table_infos = table_infos;
+  auto& scan_fragments = scan_table_infos.front().info.fragments;
+  scan_fragments.clear();
+  size_t scan_tuple_count{0};
+  bool used_metadata{false};
+  for (const auto& fragment : table_infos.front().info.fragments) {
+    switch (get_fragment_coverage(fragment, metadata_quals, deleted_cd, ra_exe_unit.target_exprs)) {
+      case FragmentMetadataCoverage::Skip:
+        used_metadata = true;
+        break;
+      case FragmentMetadataCoverage::Full:
+        fold_fragment_metadata(agg_vals, fragment, ra_exe_unit.target_exprs);
+        used_metadata = true;
+        break;
+      case FragmentMetadataCoverage::Scan:
+        scan_fragments.push_back(fragment);
+        scan_tuple_count += fragment.getNumTuples();
+        break;
+    }
+  }
+  if (!used_metadata) {
+    return nullptr;
+  }
+  if (!scan_fragments.empty()) {
+    // The scan only returns the estimate, not the registers to merge the sketches with.
+    for (const auto target_expr : ra_exe_unit.target_exprs) {
+      if (static_cast<const Analyzer::AggExpr*>(target_expr)->get_aggtype() == kAPPROX_COUNT_DISTINCT) {
+        return nullptr;
+      }
+    }
+    scan_table_infos.front().info.setPhysicalNumTuples(scan_tuple_count);
+    int32_t error_code{0};
+    size_t one{1};
+    const auto scan_result = executor_->executeWorkUnit(&error_code,
+                                                        one,
+                                                        true,
+                                                        scan_table_infos,
+                                                        ra_exe_unit,
+                                                        co,
+                                                        eo,
+                                                        cat_,
+                                                        executor_->row_set_mem_owner_,
+                                                        nullptr,
+                                                        false);
+    if (error_code) {
+      return nullptr;
+    }
+    const auto& scan_rows = boost::get<RowSetPtr>(scan_result);
+    CHECK(scan_rows);
+    const auto scan_row = scan_rows->getNextRow(false, false);
+    CHECK_EQ(ra_exe_unit.target_exprs.size(), scan_row.size());
+    for (size_t i = 0; i < scan_row.size(); ++i) {
+      const auto scalar_tv = boost::get<ScalarTargetValue>(&scan_row[i]);
+      CHECK(scalar_tv);
+      const auto agg_kind = static_cast<const Analyzer::AggExpr*>(ra_exe_unit.target_exprs[i])->get_aggtype();
+      const auto& target_ti = ra_exe_unit.target_exprs[i]->get_type_info();
+      auto& agg_val = agg_vals[i];
+      if (agg_kind != kCOUNT && target_ti.is_fp()) {
+        const auto float_ptr = boost::get<float>(scalar_tv);
+        const auto double_ptr = boost::get<double>(scalar_tv);
+        CHECK(float_ptr || double_ptr);
+        const double fp_val = float_ptr ? *float_ptr : *double_ptr;
+        if (fp_val == inline_fp_null_val(target_ti)) {
+          continue;
+        }
+        fold_aggregate_value(agg_val.fp_val, agg_val.is_set, agg_kind, fp_val);
+        continue;
+      }
+      const auto val_ptr = boost::get<int64_t>(scalar_tv);
+      CHECK(val_ptr);
+      if (agg_kind != kCOUNT && *val_ptr == inline_int_null_val(target_ti)) {
+        continue;
+      }
+      fold_aggregate_value(agg_val.val, agg_val.is_set, agg_kind, *val_ptr);
+    }
+  }
+  QueryMemoryDescriptor query_mem_desc{0};
+  query_mem_desc.executor_ = executor_;
+  query_mem_desc.entry_count = 1;
+  query_mem_desc.hash_type = GroupByColRangeType::Scan;
+  std::vector<TargetInfo> target_infos;
+  std::vector<int64_t> entry;
+  for (size_t i = 0; i < ra_exe_unit.target_exprs.size(); ++i) {
+    auto agg_info = target_info(ra_exe_unit.target_exprs[i]);
+    if (agg_info.agg_kind == kAPPROX_COUNT_DISTINCT) {
+      // same registers as the ones the query would compute, the estimate is returned like a count
+      const auto agg_expr = static_cast<const Analyzer::AggExpr*>(ra_exe_unit.target_exprs[i]);
+      const auto bits = get_approx_count_distinct_bits(agg_expr);
+      auto& agg_val = agg_vals[i];
+      agg_val.val = agg_val.sketch.empty()
+                        ? 0
+                        : hll_size(&fold_sketch(agg_val.sketch, CHUNK_SKETCH_BITS, bits)[0], bits);
+      agg_info.agg_kind = kCOUNT;
+      agg_info.is_distinct = false;
+    }
+    agg_info.sql_type.set_notnull(false);
+    agg_info.agg_arg_type.set_notnull(false);
+    target_infos.push_back(agg_info);
+    query_mem_desc.agg_col_widths.emplace_back(ColWidths{8, 8});
+    entry.push_back(get_metadata_aggregate_slot(agg_vals[i], agg_info));
+  }
+  auto rs = std::make_shared<ResultSet>(
+      target_infos, ExecutorDeviceType::CPU, query_mem_desc, executor_->getRowSetMemoryOwner(), executor_);
+  rs->allocateStorage();
+  rs->fillOneEntry(entry);
+  return rs;
+}
+
 size_t RelAlgExecutor::getNDVEstimation(const WorkUnit& work_unit,
                                         const bool is_agg,
                                         const CompilationOptions& co,
                                         const ExecutionOptions& eo) {
+  const auto sketch_estimation =
+      get_sketch_ndv_estimation(work_unit.exe_unit, get_table_infos(work_unit.exe_unit, executor_));
+  if (sketch_estimation) {
+    return sketch_estimation;
+  }
   const auto estimator_exe_unit = create_ndv_execution_unit(work_unit.exe_unit);
   int32_t error_code{0};
   size_t one{1};
@@ -2347,6 +2912,32 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createModifyCompoundWorkUnit(const RelC
           std::unique_ptr<QueryRewriter>(query_rewriter)};
 }
 
+std::list<std::shared_ptr<Analyzer::Expr>> RelAlgExecutor::addScannedRowRangeQuals(
+    const std::vector<InputDescriptor>& input_descs,
+    const std::list<std::shared_ptr<Analyzer::Expr>>& simple_quals) const {
+  if (input_descs.empty() || input_descs.front().getSourceType() != InputSourceType::TABLE ||
+      input_descs.front().getTableId() != scanned_row_range_.table_id) {
+    return simple_quals;
+  }
+  const auto cd = cat_.getMetadataForColumn(scanned_row_range_.table_id, "rowid");
+  CHECK(cd && cd->isVirtualCol);
+  auto rowid_ti = cd->columnType;
+  rowid_ti.set_size(8);
+  const auto rowid = makeExpr<Analyzer::ColumnVar>(rowid_ti, scanned_row_range_.table_id, cd->columnId, 0);
+  auto rowid_constant = [](const int64_t val) {
+    Datum d;
+    d.bigintval = val;
+    return makeExpr<Analyzer::Constant>(kBIGINT, false, d);
+  };
+  // simple quals on the rowid skip the fragments out of the range by their row offsets
+  auto quals = simple_quals;
+  quals.push_back(
+      makeExpr<Analyzer::BinOper>(kBOOLEAN, kGE, kONE, rowid, rowid_constant(scanned_row_range_.first_row)));
+  quals.push_back(
+      makeExpr<Analyzer::BinOper>(kBOOLEAN, kLT, kONE, rowid, rowid_constant(scanned_row_range_.last_row)));
+  return quals;
+}
+
 RelAlgExecutor::WorkUnit RelAlgExecutor::createCompoundWorkUnit(const RelCompound* compound,
                                                                 const SortInfo& sort_info,
                                                                 const bool just_explain) {
@@ -2388,7 +2979,7 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createCompoundWorkUnit(const RelCompoun
   const RelAlgExecutionUnit exe_unit = {input_descs,
                                         extra_input_descs,
                                         input_col_descs,
-                                        quals_cf.simple_quals,
+                                        addScannedRowRangeQuals(input_descs, quals_cf.simple_quals),
                                         separated_quals.regular_quals,
                                         left_deep_join ? JoinType::INVALID : join_types.back(),
                                         left_deep_inner_joins,
@@ -2722,7 +3313,7 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createAggregateWorkUnit(const RelAggreg
   return {{input_descs,
            extra_input_descs,
            input_col_descs,
-           {},
+           addScannedRowRangeQuals(input_descs, {}),
            {},
            join_type,
            {},
@@ -2844,7 +3435,7 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createProjectWorkUnit(const RelProject*
   return {{input_descs,
            extra_input_descs,
            input_col_descs,
-           {},
+           addScannedRowRangeQuals(input_descs, {}),
            {},
            left_deep_join ? JoinType::INVALID : join_types.back(),
            left_deep_inner_joins,
@@ -2926,7 +3517,7 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createFilterWorkUnit(const RelFilter* f
   return {{input_descs,
            extra_input_descs,
            input_col_descs,
-           {},
+           addScannedRowRangeQuals(input_descs, {}),
            separated_quals.regular_quals,
            join_type,
            {},
@@ -46,6 +46,13 @@ struct RelAlgExecutorTraits {
   using TableDescriptorType = TableDescriptor;
 };
 
+// Rows of a table, by rowid, in [first_row, last_row).
+struct ScannedRowRange {
+  int table_id;
+  int64_t first_row;
+  int64_t last_row;
+};
+
 class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
  public:
   using TargetInfoList = std::vector<TargetInfo>;
@@ -72,6 +79,11 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
                                         const CompilationOptions& co,
                                         const ExecutionOptions& eo);
 
+  // Same as above, but reuses the result of an earlier execution if the tables it read haven't changed since.
+  std::shared_ptr<const ExecutionResult> executeRelAlgSubQueryCached(const RexSubQuery* subquery,
+                                                                     const CompilationOptions& co,
+                                                                     const ExecutionOptions& eo);
+
   ExecutionResult executeRelAlgSeq(std::vector<RaExecutionDesc>& ed_list,
                                    const CompilationOptions& co,
                                    const ExecutionOptions& eo,
@@ -95,6 +107,10 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
 
   Executor* getExecutor() const;
 
+  // Restricts the scans of a table to the given rows, used to aggregate the rows appended to the source of a
+  // materialized view since its last refresh.
+  void setScannedRowRange(const ScannedRowRange& row_range) { scanned_row_range_ = row_range; }
+
  private:
   ExecutionResult executeRelAlgQueryNoRetry(const std::string& query_ra,
                                             const CompilationOptions& co,
@@ -188,6 +204,11 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
                                   RenderInfo*,
                                   const int64_t queue_time_ms);
 
+  RowSetPtr executeAggregatesFromMetadata(const WorkUnit& work_unit,
+                                          const std::vector<InputTableInfo>& table_infos,
+                                          const CompilationOptions& co,
+                                          const ExecutionOptions& eo);
+
   size_t getNDVEstimation(const WorkUnit& work_unit,
                           const bool is_agg,
                           const CompilationOptions& co,
@@ -267,6 +288,11 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
       const std::unordered_map<const RelAlgNode*, int>& input_to_nest_level,
       const bool just_explain) const;
 
+  // The simple quals plus the rowid range of the scanned row range, if the outer input is its table.
+  std::list<std::shared_ptr<Analyzer::Expr>> addScannedRowRangeQuals(
+      const std::vector<InputDescriptor>& input_descs,
+      const std::list<std::shared_ptr<Analyzer::Expr>>& simple_quals) const;
+
   Executor* executor_;
   const Catalog_Namespace::Catalog& cat_;
   TemporaryTables temporary_tables_;
@@ -275,6 +301,7 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
   std::vector<RexSubQuery*> subqueries_;
   std::unordered_map<unsigned, AggregatedResult> leaf_results_;
   int64_t queue_time_ms_;
+  ScannedRowRange scanned_row_range_{-1, 0, 0};
   static SpeculativeTopNBlacklist speculative_topn_blacklist_;
   static const size_t max_groups_buffer_entry_default_guess{16384};
 };
@@ -19,6 +19,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -1574,3 +1575,298 @@ void simplify_sort(std::vector<std::shared_ptr<RelAlgNode>>& nodes) noexcept {
   }
   nodes.swap(new_nodes);
 }
+
+extern bool g_bigint_count;
+
+namespace {
+
+// Aggregate <- [Project] <- [Filter] <- Scan, the only shape materialized views are built from and matched against.
+struct AggregateChain {
+  const RelScan* scan;
+  const RelFilter* filter;
+  const RelProject* project;
+  const RelAggregate* aggregate;
+};
+
+bool get_aggregate_chain(const RelAggregate* aggregate, AggregateChain& chain) {
+  chain = AggregateChain{nullptr, nullptr, nullptr, aggregate};
+  CHECK_EQ(size_t(1), aggregate->inputCount());
+  auto input = aggregate->getInput(0);
+  if (auto project = dynamic_cast<const RelProject*>(input)) {
+    chain.project = project;
+    input = project->getInput(0);
+  }
+  if (auto filter = dynamic_cast<const RelFilter*>(input)) {
+    chain.filter = filter;
+    input = filter->getInput(0);
+  }
+  chain.scan = dynamic_cast<const RelScan*>(input);
+  return chain.scan != nullptr;
+}
+
+// Structural key of an expression over the scanned columns, independent of the plan it belongs to.
+// Empty for expressions which can't be compared, such as subqueries.
+std::string rex_key(const RexScalar* rex) {
+  if (auto input = dynamic_cast<const RexInput*>(rex)) {
+    return "$" + std::to_string(input->getIndex());
+  }
+  if (auto literal = dynamic_cast<const RexLiteral*>(rex)) {
+    return literal->toString() + ":" + std::to_string(literal->getType()) + ":" +
+           std::to_string(literal->getTargetType()) + ":" + std::to_string(literal->getScale()) + ":" +
+           std::to_string(literal->getTypeScale());
+  }
+  if (auto oper = dynamic_cast<const RexOperator*>(rex)) {
+    const auto func = dynamic_cast<const RexFunctionOperator*>(rex);
+    std::string key = "(" + std::to_string(oper->getOperator()) + (func ? func->getName() : "") + ":" +
+                      oper->getType().get_type_name();
+    for (size_t i = 0; i < oper->size(); ++i) {
+      const auto operand_key = rex_key(oper->getOperand(i));
+      if (operand_key.empty()) {
+        return "";
+      }
+      key += " " + operand_key;
+    }
+    return key + ")";
+  }
+  if (auto rex_case = dynamic_cast<const RexCase*>(rex)) {
+    std::string key = "(CASE";
+    for (size_t i = 0; i < rex_case->branchCount(); ++i) {
+      const auto when_key = rex_key(rex_case->getWhen(i));
+      const auto then_key = rex_key(rex_case->getThen(i));
+      if (when_key.empty() || then_key.empty()) {
+        return "";
+      }
+      key += " " + when_key + " " + then_key;
+    }
+    if (rex_case->getElse()) {
+      const auto else_key = rex_key(rex_case->getElse());
+      if (else_key.empty()) {
+        return "";
+      }
+      key += " " + else_key;
+    }
+    return key + ")";
+  }
+  return "";
+}
+
+std::string aggregate_input_key(const AggregateChain& chain, const size_t idx) {
+  return chain.project ? rex_key(chain.project->getProjectAt(idx)) : "$" + std::to_string(idx);
+}
+
+std::string agg_key(const AggregateChain& chain, const RexAgg* agg) {
+  CHECK_LE(agg->size(), size_t(1));
+  if (!agg->size()) {
+    return std::to_string(agg->getKind()) + " *";
+  }
+  const auto operand_key = aggregate_input_key(chain, agg->getOperand(0));
+  return operand_key.empty() ? "" : std::to_string(agg->getKind()) + " " + operand_key;
+}
+
+bool is_rollup_agg(const RexAgg* agg) {
+  if (agg->isDistinct()) {
+    return false;
+  }
+  switch (agg->getKind()) {
+    case kSUM:
+    case kCOUNT:
+    case kMIN:
+    case kMAX:
+      return true;
+    default:
+      return false;
+  }
+}
+
+struct MaterializedViewColumns {
+  AggregateChain chain;
+  std::string filter_key;
+  std::vector<std::string> fields;
+  std::unordered_map<std::string, size_t> group_columns;
+  std::unordered_map<std::string, size_t> agg_columns;
+};
+
+MaterializedViewColumns get_materialized_view_columns(const std::vector<std::shared_ptr<RelAlgNode>>& nodes) {
+  MaterializedViewColumns view;
+  const auto root = nodes.back().get();
+  const auto top_project = dynamic_cast<const RelProject*>(root);
+  const auto aggregate = dynamic_cast<const RelAggregate*>(top_project ? top_project->getInput(0) : root);
+  CHECK(aggregate);
+  CHECK(get_aggregate_chain(aggregate, view.chain));
+  view.filter_key = view.chain.filter ? rex_key(view.chain.filter->getCondition()) : "";
+  view.fields = top_project ? top_project->getFields() : aggregate->getFields();
+  for (size_t col = 0; col < root->size(); ++col) {
+    size_t aggregate_out_idx = col;
+    if (top_project) {
+      const auto input = dynamic_cast<const RexInput*>(top_project->getProjectAt(col));
+      CHECK(input);
+      aggregate_out_idx = input->getIndex();
+    }
+    if (aggregate_out_idx < aggregate->getGroupByCount()) {
+      view.group_columns.emplace(aggregate_input_key(view.chain, aggregate_out_idx), col);
+    } else {
+      const auto agg = aggregate->getAggExprs()[aggregate_out_idx - aggregate->getGroupByCount()].get();
+      view.agg_columns.emplace(agg_key(view.chain, agg), col);
+    }
+  }
+  return view;
+}
+
+// Builds Scan(view) -> Project -> Aggregate [-> Project] producing the same columns as the query aggregate
+// of the given chain by re-aggregating the partial aggregates of the view, or nothing if the view can't answer it.
+std::vector<std::shared_ptr<RelAlgNode>> rollup_from_materialized_view(const AggregateChain& query,
+                                                                     const MaterializedViewColumns& view,
+                                                                     const TableDescriptor* view_td) {
+  if (query.scan->getTableDescriptor()->tableId != view.chain.scan->getTableDescriptor()->tableId) {
+    return {};
+  }
+  const auto query_filter_key = query.filter ? rex_key(query.filter->getCondition()) : "";
+  if ((query.filter && query_filter_key.empty()) || query_filter_key != view.filter_key) {
+    return {};
+  }
+  const auto groupby_count = query.aggregate->getGroupByCount();
+  std::vector<size_t> view_columns;
+  for (size_t i = 0; i < groupby_count; ++i) {
+    const auto it = view.group_columns.find(aggregate_input_key(query, i));
+    if (it == view.group_columns.end()) {
+      return {};
+    }
+    view_columns.push_back(it->second);
+  }
+  bool has_count{false};
+  for (const auto& agg : query.aggregate->getAggExprs()) {
+    // COUNT of no rows is 0, the SUM of the partial counts would be null
+    if (!is_rollup_agg(agg.get()) || (agg->getKind() == kCOUNT && !groupby_count)) {
+      return {};
+    }
+    const auto it = view.agg_columns.find(agg_key(query, agg.get()));
+    if (it == view.agg_columns.end()) {
+      return {};
+    }
+    view_columns.push_back(it->second);
+    has_count = has_count || agg->getKind() == kCOUNT;
+  }
+
+  auto scan = std::make_shared<RelScan>(view_td, view.fields);
+  std::vector<std::unique_ptr<const RexScalar>> exprs;
+  std::vector<std::string> project_fields;
+  for (const auto col : view_columns) {
+    exprs.emplace_back(boost::make_unique<RexInput>(scan.get(), col));
+    project_fields.push_back(view.fields[col]);
+  }
+  auto project = std::make_shared<RelProject>(exprs, project_fields, scan);
+  std::vector<std::unique_ptr<const RexAgg>> aggs;
+  const auto& query_aggs = query.aggregate->getAggExprs();
+  for (size_t i = 0; i < query_aggs.size(); ++i) {
+    const auto kind = query_aggs[i]->getKind() == kCOUNT ? kSUM : query_aggs[i]->getKind();
+    aggs.emplace_back(new RexAgg(kind, false, query_aggs[i]->getType(), std::vector<size_t>{groupby_count + i}));
+  }
+  auto rollup = std::make_shared<RelAggregate>(groupby_count, aggs, query.aggregate->getFields(), project);
+  std::vector<std::shared_ptr<RelAlgNode>> new_nodes{scan, project, rollup};
+  if (has_count && !g_bigint_count) {
+    // the sum of the partial counts is a BIGINT, cast it back to the type of COUNT
+    std::vector<std::unique_ptr<const RexScalar>> cast_exprs;
+    for (size_t i = 0; i < rollup->size(); ++i) {
+      std::unique_ptr<const RexScalar> input(new RexInput(rollup.get(), i));
+      if (i >= groupby_count && query_aggs[i - groupby_count]->getKind() == kCOUNT) {
+        std::vector<std::unique_ptr<const RexScalar>> operands;
+        operands.push_back(std::move(input));
+        input.reset(new RexOperator(kCAST, operands, SQLTypeInfo(kINT, false)));
+      }
+      cast_exprs.push_back(std::move(input));
+    }
+    new_nodes.push_back(std::make_shared<RelProject>(cast_exprs, query.aggregate->getFields(), rollup));
+  }
+  return new_nodes;
+}
+
+}  // namespace
+
+const TableDescriptor* check_materialized_view_plan(const std::vector<std::shared_ptr<RelAlgNode>>& nodes) {
+  CHECK(!nodes.empty());
+  const auto root = nodes.back().get();
+  const auto top_project = dynamic_cast<const RelProject*>(root);
+  if (top_project && !top_project->isSimple()) {
+    throw std::runtime_error("Materialized view columns must be group by keys or aggregates");
+  }
+  const auto aggregate = dynamic_cast<const RelAggregate*>(top_project ? top_project->getInput(0) : root);
+  AggregateChain chain;
+  if (!aggregate || !get_aggregate_chain(aggregate, chain) ||
+      nodes.size() != 2 + !!chain.filter + !!chain.project + !!top_project) {
+    throw std::runtime_error("Materialized view must be an aggregate query over a single table");
+  }
+  if (!aggregate->getGroupByCount()) {
+    throw std::runtime_error("Materialized view must have a GROUP BY clause");
+  }
+  for (size_t i = 0; i < aggregate->getGroupByCount(); ++i) {
+    if (aggregate_input_key(chain, i).empty()) {
+      throw std::runtime_error("Materialized view group by key not supported");
+    }
+  }
+  for (const auto& agg : aggregate->getAggExprs()) {
+    if (!is_rollup_agg(agg.get()) || agg_key(chain, agg.get()).empty()) {
+      throw std::runtime_error("Materialized views only support SUM, COUNT, MIN and MAX aggregates");
+    }
+  }
+  if (chain.filter && rex_key(chain.filter->getCondition()).empty()) {
+    throw std::runtime_error("Materialized view filter not supported");
+  }
+  return chain.scan->getTableDescriptor();
+}
+
+void rewrite_aggregates_with_materialized_views(std::vector<std::shared_ptr<RelAlgNode>>& nodes,
+                                                const std::vector<MaterializedViewPlan>& views) noexcept {
+  std::vector<MaterializedViewColumns> view_columns;
+  for (const auto& view : views) {
+    view_columns.push_back(get_materialized_view_columns(view.nodes));
+  }
+  auto web = build_du_web(nodes);
+  for (size_t node_idx = 0; node_idx < nodes.size(); ++node_idx) {
+    auto aggregate = std::dynamic_pointer_cast<RelAggregate>(nodes[node_idx]);
+    AggregateChain query;
+    if (!aggregate || !get_aggregate_chain(aggregate.get(), query)) {
+      continue;
+    }
+    // the nodes below the aggregate go away, nothing else may use them
+    if ((query.project && web[query.project].size() != 1) || (query.filter && web[query.filter].size() != 1)) {
+      continue;
+    }
+    std::vector<std::shared_ptr<RelAlgNode>> new_nodes;
+    for (size_t i = 0; i < views.size() && new_nodes.empty(); ++i) {
+      new_nodes = rollup_from_materialized_view(query, view_columns[i], views[i].td);
+    }
+    if (new_nodes.empty()) {
+      continue;
+    }
+    LOG(INFO) << "Aggregate " << aggregate->getId() << " answered from materialized view "
+              << new_nodes.front()->toString();
+    const std::shared_ptr<const RelAlgNode> old_aggregate = aggregate;
+    const std::shared_ptr<const RelAlgNode> new_root = new_nodes.back();
+    for (auto& node : nodes) {
+      if (node->hasInput(old_aggregate.get())) {
+        node->replaceInput(old_aggregate, new_root);
+      }
+    }
+    std::unordered_set<const RelAlgNode*> dead{aggregate.get(), query.project, query.filter, query.scan};
+    auto is_used = [&nodes, &dead](const RelAlgNode* def) {
+      for (const auto& node : nodes) {
+        if (!dead.count(node.get()) && node->hasInput(def)) {
+          return true;
+        }
+      }
+      return false;
+    };
+    std::vector<std::shared_ptr<RelAlgNode>> rewritten;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (i == node_idx) {
+        rewritten.insert(rewritten.end(), new_nodes.begin(), new_nodes.end());
+      } else if (!dead.count(nodes[i].get()) || is_used(nodes[i].get())) {
+        // the scan may still feed other parts of the query
+        rewritten.push_back(nodes[i]);
+      }
+    }
+    nodes.swap(rewritten);
+    node_idx = std::find(nodes.begin(), nodes.end(), new_nodes.back()) - nodes.begin();
+    web = build_du_web(nodes);
+  }
+}
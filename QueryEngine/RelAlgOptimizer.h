@@ -23,6 +23,13 @@
 #include <vector>
 
 class RelAlgNode;
+struct TableDescriptor;
+
+// The plan of a materialized view and the table holding its partial aggregates.
+struct MaterializedViewPlan {
+  const TableDescriptor* td;
+  std::vector<std::shared_ptr<RelAlgNode>> nodes;
+};
 
 std::unordered_map<const RelAlgNode*, std::unordered_set<const RelAlgNode*>> build_du_web(
     const std::vector<std::shared_ptr<RelAlgNode>>& nodes) noexcept;
@@ -33,4 +40,8 @@ void hoist_filter_cond_to_cross_join(std::vector<std::shared_ptr<RelAlgNode>>& n
 void simplify_sort(std::vector<std::shared_ptr<RelAlgNode>>& nodes) noexcept;
 void sink_projected_boolean_expr_to_join(std::vector<std::shared_ptr<RelAlgNode>>& nodes) noexcept;
 
+const TableDescriptor* check_materialized_view_plan(const std::vector<std::shared_ptr<RelAlgNode>>& nodes);
+void rewrite_aggregates_with_materialized_views(std::vector<std::shared_ptr<RelAlgNode>>& nodes,
+                                                const std::vector<MaterializedViewPlan>& views) noexcept;
+
 #endif  // QUERYENGINE_RELALGOPTIMIZER_H
@@ -274,6 +274,8 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateScalarSubquery(const
   if (row_set->rowCount() != size_t(1)) {
     throw std::runtime_error("Scalar sub-query returned multiple rows");
   }
+  // the result can be shared by identical sub-queries, don't rely on the iteration state
+  row_set->moveToBegin();
   auto first_row = row_set->getNextRow(false, false);
   auto scalar_tv = boost::get<ScalarTargetValue>(&first_row[0]);
   auto ti = rex_subquery->getType();
@@ -461,7 +463,7 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateInOper(const RexOpera
     std::shared_ptr<Analyzer::Expr> expr;
     if ((ti.is_integer() || (ti.is_string() && ti.get_compression() == kENCODING_DICT)) &&
         !row_set->getQueryMemDesc().output_columnar) {
-      expr = getInIntegerSetExpr(lhs, *row_set);
+      expr = getInIntegerSetExpr(lhs, row_set);
       // Handle the highly unlikely case when the InIntegerSet ended up being tiny.
       // Just let it fall through the usual InValues path at the end of this method,
       // its codegen knows to use inline comparisons for few values.
@@ -630,8 +632,10 @@ void fill_dictionary_encoded_in_vals(std::vector<int64_t>& in_vals,
 // shared pointers. We can avoid the big overhead of each Analyzer::Constant and the
 // refcounting associated with shared pointers by creating an abbreviated InIntegerSet
 // representation of the IN expression which takes advantage of the this information.
-std::shared_ptr<Analyzer::Expr> RelAlgTranslator::getInIntegerSetExpr(std::shared_ptr<Analyzer::Expr> arg,
-                                                                      const ResultSet& val_set) const {
+std::shared_ptr<Analyzer::Expr> RelAlgTranslator::getInIntegerSetExpr(
+    std::shared_ptr<Analyzer::Expr> arg,
+    const std::shared_ptr<ResultSet>& val_set_ptr) const {
+  const auto& val_set = *val_set_ptr;
   if (!can_use_parallel_algorithms(val_set)) {
     return nullptr;
   }
@@ -647,6 +651,27 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::getInIntegerSetExpr(std::share
     // Skip this case for now, see comment for fill_dictionary_encoded_in_vals.
     return nullptr;
   }
+  const bool not_null = arg_type.get_notnull() && col_type.get_notnull();
+  // Strings are translated to the ids of the left hand side dictionary, the set is only good for its generation.
+  std::string arg_key{std::to_string(arg_type.get_type())};
+  if (arg_type.is_string()) {
+    const auto generation =
+        arg_type.get_comp_param() > 0
+            ? executor_->getStringDictionaryProxy(arg_type.get_comp_param(), executor_->getRowSetMemoryOwner(), true)
+                  ->getGeneration()
+            : ssize_t(-1);
+    if (generation >= 0) {
+      arg_key += ":" + std::to_string(arg_type.get_comp_param()) + ":" + std::to_string(generation);
+    } else {
+      arg_key.clear();
+    }
+  }
+  if (!arg_key.empty()) {
+    const auto cached_values = executor_->getInIntegerSet(val_set_ptr, arg_key);
+    if (cached_values) {
+      return makeExpr<Analyzer::InIntegerSet>(arg, cached_values, not_null);
+    }
+  }
   std::atomic<size_t> total_in_vals_count{0};
   for (size_t i = 0, start_entry = 0, stride = (entry_count + fetcher_count - 1) / fetcher_count;
        i < fetcher_count && start_entry < entry_count;
@@ -659,7 +684,9 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::getInIntegerSetExpr(std::share
       // const int32_t source_dict_id = col_type.get_comp_param();
       const DictRef dest_dict_ref(arg_type.get_comp_param(), cat_.getDatabaseId());
       const DictRef source_dict_ref(col_type.get_comp_param(), cat_.getDatabaseId());
-      const auto dd = executor_->getStringDictionaryProxy(arg_type.get_comp_param(), val_set.getRowSetMemOwner(), true);
+      // the values may come from an earlier query, look them up in the dictionary as of this query
+      const auto dd =
+          executor_->getStringDictionaryProxy(arg_type.get_comp_param(), executor_->getRowSetMemoryOwner(), true);
       const auto sd = executor_->getStringDictionaryProxy(col_type.get_comp_param(), val_set.getRowSetMemOwner(), true);
       CHECK(sd);
       const auto needle_null_val = inline_int_null_val(arg_type);
@@ -707,7 +734,11 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::getInIntegerSetExpr(std::share
   for (auto& exprs : expr_set) {
     value_exprs.insert(value_exprs.end(), exprs.begin(), exprs.end());
   }
-  return makeExpr<Analyzer::InIntegerSet>(arg, value_exprs, arg_type.get_notnull() && col_type.get_notnull());
+  const auto values = std::make_shared<const std::vector<int64_t>>(std::move(value_exprs));
+  if (!arg_key.empty()) {
+    executor_->putInIntegerSet(val_set_ptr, arg_key, values);
+  }
+  return makeExpr<Analyzer::InIntegerSet>(arg, values, not_null);
 }
 
 std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateOper(const RexOperator* rex_operator) const {
@@ -70,7 +70,7 @@ class RelAlgTranslator {
   std::shared_ptr<Analyzer::Expr> translateInOper(const RexOperator*) const;
 
   std::shared_ptr<Analyzer::Expr> getInIntegerSetExpr(std::shared_ptr<Analyzer::Expr> arg,
-                                                      const ResultSet& val_set) const;
+                                                      const std::shared_ptr<ResultSet>& val_set_ptr) const;
 
   std::shared_ptr<Analyzer::Expr> translateOper(const RexOperator*) const;
 
@@ -249,6 +249,23 @@ class RowSetMemoryOwner : boost::noncopyable {
     col_buffers_.push_back(const_cast<void*>(col_buffer));
   }
 
+  // Accounts intermediate results the query keeps in memory against its spill budget. Returns false, accounting
+  // nothing, if they don't fit the budget anymore.
+  bool reserveSpillBudget(const size_t bytes, const size_t budget) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (spill_budget_used_ + bytes > budget) {
+      return false;
+    }
+    spill_budget_used_ += bytes;
+    return true;
+  }
+
+  void releaseSpillBudget(const size_t bytes) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    CHECK_LE(bytes, spill_budget_used_);
+    spill_budget_used_ -= bytes;
+  }
+
   ~RowSetMemoryOwner() {
     for (const auto& count_distinct_buffer : count_distinct_bitmaps_) {
       if (count_distinct_buffer.system_allocated) {
@@ -285,6 +302,7 @@ class RowSetMemoryOwner : boost::noncopyable {
   std::unordered_map<int, StringDictionaryProxy*> str_dict_proxy_owned_;
   std::shared_ptr<StringDictionaryProxy> lit_str_dict_proxy_;
   std::vector<void*> col_buffers_;
+  size_t spill_budget_used_{0};
   mutable std::mutex state_mutex_;
 
   friend class ResultRows;
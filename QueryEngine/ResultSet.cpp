@@ -31,12 +31,26 @@
 #include "Shared/checked_alloc.h"
 #include "Shared/likely.h"
 #include "Shared/thread_count.h"
+#include "SpillFile.h"
 #include "SqlTypesLayout.h"
 
 #include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <cstring>
 #include <future>
 #include <numeric>
+#include <queue>
+
+namespace {
+
+// Result sets with more entries than this are counted and sorted by several threads.
+constexpr size_t parallel_entry_threshold{100000};
+
+// One byte for the null position followed by the big-endian, order preserving image of the value.
+constexpr size_t normalized_key_width{sizeof(int8_t) + sizeof(uint64_t)};
+
+}  // namespace
 
 ResultSetStorage::ResultSetStorage(const std::vector<TargetInfo>& targets,
                                    const QueryMemoryDescriptor& query_mem_desc,
@@ -300,7 +314,7 @@ size_t ResultSet::rowCount(const bool force_parallel) const {
   if (!storage_) {
     return 0;
   }
-  if (force_parallel || entryCount() > 100000) {
+  if (force_parallel || entryCount() > parallel_entry_threshold) {
     return parallelRowCount();
   }
   std::lock_guard<std::mutex> lock(row_iteration_mutex_);
@@ -490,7 +504,7 @@ void ResultSet::sort(const std::list<Analyzer::OrderEntry>& order_entries, const
   CHECK(permutation_.empty());
 
   const bool use_heap{order_entries.size() == 1 && top_n};
-  if (use_heap && entryCount() > 100000) {
+  if (use_heap && entryCount() > parallel_entry_threshold) {
     if (g_enable_watchdog && (entryCount() > 20000000)) {
       throw WatchdogException("Sorting the result would be too slow");
     }
@@ -498,6 +512,16 @@ void ResultSet::sort(const std::list<Analyzer::OrderEntry>& order_entries, const
     return;
   }
 
+  // Sorting on normalized keys is cheap enough to be allowed past the watchdog limit below. It's also the sort which
+  // can spill, taken whatever the entry count when the keys don't fit the spill budget.
+  const bool keys_over_spill_budget =
+      spill_enabled() &&
+      entryCount() * (order_entries.size() * normalized_key_width + sizeof(uint32_t)) > g_spill_memory_budget;
+  if (!use_heap && (entryCount() > parallel_entry_threshold || keys_over_spill_budget) &&
+      parallelSortWithNormalizedKeys(order_entries, top_n)) {
+    return;
+  }
+
   if (g_enable_watchdog && (entryCount() > Executor::baseline_threshold)) {
     throw WatchdogException("Sorting the result would be too slow");
   }
@@ -620,10 +644,34 @@ ResultSet::StorageLookupResult ResultSet::findStorage(const size_t entry_idx) co
       stg_idx ? appended_storage_[stg_idx - 1].get() : storage_.get(), fixedup_entry_idx, static_cast<size_t>(stg_idx)};
 }
 
+// Dictionary encoded sort keys are compared on the sort ranks of their dictionary, which avoids decoding both
+// strings for every comparison. Strings not covered by the ranks (transient or newer) fall back to decoding.
+// Ranking a dictionary without a persisted or previously built sort order sorts all of it, skip that for
+// dictionaries larger than the result set.
+std::vector<std::shared_ptr<const std::vector<int32_t>>> ResultSet::getDictSortedRanks(
+    const std::list<Analyzer::OrderEntry>& order_entries) const {
+  std::vector<std::shared_ptr<const std::vector<int32_t>>> dict_sorted_ranks;
+  for (const auto& order_entry : order_entries) {
+    CHECK_GE(order_entry.tle_no, 1);
+    const auto& entry_ti = get_compact_type(targets_[order_entry.tle_no - 1]);
+    std::shared_ptr<const std::vector<int32_t>> sorted_ranks;
+    if (entry_ti.is_string() && entry_ti.get_compression() == kENCODING_DICT) {
+      const auto string_dict_proxy =
+          executor_->getStringDictionaryProxy(entry_ti.get_comp_param(), row_set_mem_owner_, false);
+      if (string_dict_proxy->hasSortedRanks() || string_dict_proxy->storageEntryCount() <= entryCount()) {
+        sorted_ranks = string_dict_proxy->getSortedRanks();
+      }
+    }
+    dict_sorted_ranks.push_back(sorted_ranks);
+  }
+  return dict_sorted_ranks;
+}
+
 std::function<bool(const uint32_t, const uint32_t)> ResultSet::createComparator(
     const std::list<Analyzer::OrderEntry>& order_entries,
     const bool use_heap) const {
-  return [this, &order_entries, use_heap](const uint32_t lhs, const uint32_t rhs) {
+  const auto dict_sorted_ranks = getDictSortedRanks(order_entries);
+  return [this, &order_entries, use_heap, dict_sorted_ranks](const uint32_t lhs, const uint32_t rhs) {
     // NB: The compare function must define a strict weak ordering, otherwise
     // std::sort will trigger a segmentation fault (or corrupt memory).
     const auto lhs_storage_lookup_result = findStorage(lhs);
@@ -632,7 +680,9 @@ std::function<bool(const uint32_t, const uint32_t)> ResultSet::createComparator(
     const auto rhs_storage = rhs_storage_lookup_result.storage_ptr;
     const auto fixedup_lhs = lhs_storage_lookup_result.fixedup_entry_idx;
     const auto fixedup_rhs = rhs_storage_lookup_result.fixedup_entry_idx;
+    size_t order_entry_idx{0};
     for (const auto order_entry : order_entries) {
+      const auto& sorted_ranks = dict_sorted_ranks[order_entry_idx++];
       CHECK_GE(order_entry.tle_no, 1);
       const auto& agg_info = targets_[order_entry.tle_no - 1];
       const auto& entry_ti = get_compact_type(agg_info);
@@ -664,6 +714,15 @@ std::function<bool(const uint32_t, const uint32_t)> ResultSet::createComparator(
         CHECK(rhs_v.isInt());
         if (UNLIKELY(entry_ti.is_string() && entry_ti.get_compression() == kENCODING_DICT)) {
           CHECK_EQ(4, entry_ti.get_logical_size());
+          if (sorted_ranks && lhs_v.i1 >= 0 && rhs_v.i1 >= 0 && static_cast<size_t>(lhs_v.i1) < sorted_ranks->size() &&
+              static_cast<size_t>(rhs_v.i1) < sorted_ranks->size()) {
+            const auto lhs_rank = (*sorted_ranks)[lhs_v.i1];
+            const auto rhs_rank = (*sorted_ranks)[rhs_v.i1];
+            if (lhs_rank == rhs_rank) {
+              continue;
+            }
+            return use_desc_cmp ? lhs_rank > rhs_rank : lhs_rank < rhs_rank;
+          }
           const auto string_dict_proxy =
               executor_->getStringDictionaryProxy(entry_ti.get_comp_param(), row_set_mem_owner_, false);
           auto lhs_str = string_dict_proxy->getString(lhs_v.i1);
@@ -740,6 +799,394 @@ void ResultSet::sortPermutation(const std::function<bool(const uint32_t, const u
   std::sort(permutation_.begin(), permutation_.end(), compare);
 }
 
+namespace {
+
+uint64_t normalize_int(const int64_t ival) {
+  return static_cast<uint64_t>(ival) ^ (uint64_t(1) << 63);
+}
+
+uint64_t normalize_fp(const double dval) {
+  const double nonnegative_zero_dval = dval == 0 ? 0 : dval;
+  const auto bits = *reinterpret_cast<const uint64_t*>(may_alias_ptr(&nonnegative_zero_dval));
+  return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+void write_normalized_key(uint8_t* key_ptr,
+                          const Analyzer::OrderEntry& order_entry,
+                          const bool is_null,
+                          const uint64_t normalized_val) {
+  if (is_null) {
+    key_ptr[0] = order_entry.nulls_first ? 0 : 2;
+    std::fill(key_ptr + 1, key_ptr + normalized_key_width, 0);
+    return;
+  }
+  key_ptr[0] = 1;
+  const auto val = order_entry.is_desc ? ~normalized_val : normalized_val;
+  for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+    key_ptr[1 + i] = static_cast<uint8_t>(val >> (8 * (sizeof(uint64_t) - 1 - i)));
+  }
+}
+
+std::vector<size_t> get_chunk_bounds(const size_t entry_count, const size_t chunk_count) {
+  const size_t chunk_size = std::max((entry_count + chunk_count - 1) / chunk_count, size_t(1));
+  std::vector<size_t> chunk_bounds;
+  for (size_t i = 0; i < entry_count; i += chunk_size) {
+    chunk_bounds.push_back(i);
+  }
+  chunk_bounds.push_back(entry_count);
+  return chunk_bounds;
+}
+
+// Returns the positions of the keys in sorted order. Slices are sorted in parallel, then the sorted runs are merged
+// pairwise in parallel, each round halving the number of runs.
+std::vector<uint32_t> sort_normalized_keys(const std::vector<uint8_t>& keys,
+                                           const size_t key_width,
+                                           const size_t entry_count,
+                                           const size_t thread_count) {
+  std::vector<uint32_t> positions(entry_count);
+  std::iota(positions.begin(), positions.end(), 0);
+  const auto key_less = [&keys, key_width](const uint32_t lhs, const uint32_t rhs) {
+    return memcmp(&keys[size_t(lhs) * key_width], &keys[size_t(rhs) * key_width], key_width) < 0;
+  };
+  auto chunk_bounds = get_chunk_bounds(entry_count, thread_count);
+  std::vector<std::future<void>> sort_futures;
+  for (size_t chunk_idx = 0; chunk_idx + 1 < chunk_bounds.size(); ++chunk_idx) {
+    const auto begin = positions.begin() + chunk_bounds[chunk_idx];
+    const auto end = positions.begin() + chunk_bounds[chunk_idx + 1];
+    sort_futures.emplace_back(
+        std::async(std::launch::async, [begin, end, &key_less] { std::sort(begin, end, key_less); }));
+  }
+  for (auto& sort_future : sort_futures) {
+    sort_future.wait();
+  }
+  for (auto& sort_future : sort_futures) {
+    sort_future.get();
+  }
+  while (chunk_bounds.size() > 2) {
+    std::vector<size_t> merged_bounds;
+    std::vector<std::future<void>> merge_futures;
+    for (size_t run_idx = 0; run_idx + 1 < chunk_bounds.size(); run_idx += 2) {
+      merged_bounds.push_back(chunk_bounds[run_idx]);
+      if (run_idx + 2 >= chunk_bounds.size()) {
+        continue;
+      }
+      const auto begin = positions.begin() + chunk_bounds[run_idx];
+      const auto middle = positions.begin() + chunk_bounds[run_idx + 1];
+      const auto end = positions.begin() + chunk_bounds[run_idx + 2];
+      merge_futures.emplace_back(std::async(std::launch::async, [begin, middle, end, &key_less] {
+        std::inplace_merge(begin, middle, end, key_less);
+      }));
+    }
+    merged_bounds.push_back(entry_count);
+    for (auto& merge_future : merge_futures) {
+      merge_future.wait();
+    }
+    for (auto& merge_future : merge_futures) {
+      merge_future.get();
+    }
+    chunk_bounds.swap(merged_bounds);
+  }
+  return positions;
+}
+
+}  // namespace
+
+bool ResultSet::writeNormalizedSortKey(
+    uint8_t* key_ptr,
+    const uint32_t entry_idx,
+    const std::list<Analyzer::OrderEntry>& order_entries,
+    const std::vector<std::shared_ptr<const std::vector<int32_t>>>& dict_sorted_ranks) const {
+  const auto storage_lookup_result = findStorage(entry_idx);
+  const auto storage = storage_lookup_result.storage_ptr;
+  const auto fixedup_entry_idx = storage_lookup_result.fixedup_entry_idx;
+  size_t order_entry_idx{0};
+  for (const auto& order_entry : order_entries) {
+    const auto& sorted_ranks = dict_sorted_ranks[order_entry_idx++];
+    const auto& agg_info = targets_[order_entry.tle_no - 1];
+    const auto& entry_ti = get_compact_type(agg_info);
+    bool float_argument_input = takes_float_argument(agg_info);
+    if (entry_ti.get_type() == kFLOAT &&
+        query_mem_desc_.agg_col_widths[order_entry.tle_no - 1].compact == sizeof(float)) {
+      float_argument_input = true;
+    }
+    const auto val =
+        getColumnInternal(storage->buff_, fixedup_entry_idx, order_entry.tle_no - 1, storage_lookup_result);
+    if (isNull(entry_ti, val, float_argument_input)) {
+      write_normalized_key(key_ptr, order_entry, true, 0);
+    } else if (val.isInt()) {
+      uint64_t normalized_val{0};
+      if (entry_ti.is_string() && entry_ti.get_compression() == kENCODING_DICT) {
+        if (!sorted_ranks || val.i1 < 0 || static_cast<size_t>(val.i1) >= sorted_ranks->size()) {
+          return false;
+        }
+        normalized_val = normalize_int((*sorted_ranks)[val.i1]);
+      } else if (is_distinct_target(agg_info)) {
+        normalized_val = normalize_int(
+            count_distinct_set_size(val.i1, order_entry.tle_no - 1, query_mem_desc_.count_distinct_descriptors_));
+      } else if (entry_ti.is_fp()) {
+        normalized_val = float_argument_input ? normalize_fp(*reinterpret_cast<const float*>(may_alias_ptr(&val.i1)))
+                                              : normalize_fp(*reinterpret_cast<const double*>(may_alias_ptr(&val.i1)));
+      } else {
+        normalized_val = normalize_int(val.i1);
+      }
+      write_normalized_key(key_ptr, order_entry, false, normalized_val);
+    } else if (val.isPair()) {
+      write_normalized_key(
+          key_ptr, order_entry, false, normalize_fp(pair_to_double({val.i1, val.i2}, entry_ti, float_argument_input)));
+    } else {
+      // none encoded strings don't have a fixed width image
+      return false;
+    }
+    key_ptr += normalized_key_width;
+  }
+  return true;
+}
+
+bool ResultSet::writeNormalizedSortKeys(
+    std::vector<uint8_t>& keys,
+    const uint32_t* entries,
+    const size_t entry_count,
+    const std::list<Analyzer::OrderEntry>& order_entries,
+    const std::vector<std::shared_ptr<const std::vector<int32_t>>>& dict_sorted_ranks) const {
+  const size_t key_width = order_entries.size() * normalized_key_width;
+  CHECK_EQ(entry_count * key_width, keys.size());
+  const auto chunk_bounds = get_chunk_bounds(entry_count, cpu_threads());
+  std::atomic<bool> normalized{true};
+  std::vector<std::future<void>> key_futures;
+  for (size_t chunk_idx = 0; chunk_idx + 1 < chunk_bounds.size(); ++chunk_idx) {
+    const auto begin = chunk_bounds[chunk_idx];
+    const auto end = chunk_bounds[chunk_idx + 1];
+    key_futures.emplace_back(std::async(std::launch::async, [&, begin, end] {
+      for (size_t i = begin; i < end && normalized; ++i) {
+        if (!writeNormalizedSortKey(&keys[i * key_width], entries[i], order_entries, dict_sorted_ranks)) {
+          normalized = false;
+        }
+      }
+    }));
+  }
+  for (auto& key_future : key_futures) {
+    key_future.wait();
+  }
+  for (auto& key_future : key_futures) {
+    key_future.get();
+  }
+  return normalized;
+}
+
+// Encodes the ORDER BY keys of every entry into fixed width, memcmp-comparable keys and sorts them with a
+// parallel merge sort, so the comparisons don't go through the ResultSet accessors. Returns false, leaving the
+// permutation untouched, when a key can't be normalized. Only the top_n first entries are kept, if top_n is set.
+bool ResultSet::parallelSortWithNormalizedKeys(const std::list<Analyzer::OrderEntry>& order_entries,
+                                               const size_t top_n) {
+  for (const auto& order_entry : order_entries) {
+    const auto& entry_ti = get_compact_type(targets_[order_entry.tle_no - 1]);
+    if (entry_ti.is_string() && entry_ti.get_compression() != kENCODING_DICT) {
+      return false;
+    }
+  }
+  const auto dict_sorted_ranks = getDictSortedRanks(order_entries);
+  const size_t thread_count = cpu_threads();
+  std::vector<std::vector<uint32_t>> strided_permutations(thread_count);
+  std::vector<std::future<void>> init_futures;
+  for (size_t start = 0; start < thread_count; ++start) {
+    init_futures.emplace_back(std::async(std::launch::async, [this, start, thread_count, &strided_permutations] {
+      strided_permutations[start] = initPermutationBuffer(start, thread_count);
+    }));
+  }
+  for (auto& init_future : init_futures) {
+    init_future.wait();
+  }
+  for (auto& init_future : init_futures) {
+    init_future.get();
+  }
+  std::vector<uint32_t> permutation;
+  for (auto& strided_permutation : strided_permutations) {
+    permutation.insert(permutation.end(), strided_permutation.begin(), strided_permutation.end());
+    std::vector<uint32_t>().swap(strided_permutation);
+  }
+  const auto entry_count = permutation.size();
+  const size_t key_width = order_entries.size() * normalized_key_width;
+  if (spill_enabled() && entry_count * (key_width + sizeof(uint32_t)) > g_spill_memory_budget) {
+    return externalSortWithNormalizedKeys(permutation, order_entries, dict_sorted_ranks, top_n);
+  }
+  std::vector<uint8_t> keys(entry_count * key_width);
+  if (!writeNormalizedSortKeys(keys, permutation.data(), entry_count, order_entries, dict_sorted_ranks)) {
+    return false;
+  }
+  const auto positions = sort_normalized_keys(keys, key_width, entry_count, thread_count);
+  // like the heap sort, only the top_n first entries are kept
+  permutation_.resize(top_n ? std::min(top_n, entry_count) : entry_count);
+  for (size_t i = 0; i < permutation_.size(); ++i) {
+    permutation_[i] = permutation[positions[i]];
+  }
+  return true;
+}
+
+namespace {
+
+// Sorted (normalized key, entry index) records in the spill file.
+struct SortedRun {
+  size_t offset;
+  size_t entry_count;
+};
+
+// Streams the records of the runs in key order to the consumer, which returns false to stop early. Each run is read
+// through a buffer of its own, of buffer_bytes at most.
+void merge_sorted_runs(const SpillFile& spill_file,
+                       const std::vector<SortedRun>& runs,
+                       const size_t key_width,
+                       const size_t record_width,
+                       const size_t buffer_bytes,
+                       const std::function<bool(const int8_t*)>& consume) {
+  struct RunCursor {
+    size_t offset;
+    size_t remaining;
+    std::vector<int8_t> buffer;
+    size_t buffer_pos;
+  };
+  const size_t buffer_entry_count = std::max(buffer_bytes / record_width, size_t(1));
+  std::vector<RunCursor> cursors;
+  for (const auto& run : runs) {
+    cursors.push_back(RunCursor{run.offset, run.entry_count, {}, 0});
+  }
+  const auto refill = [&spill_file, buffer_entry_count, record_width](RunCursor& cursor) {
+    const auto read_entry_count = std::min(buffer_entry_count, cursor.remaining);
+    cursor.buffer.resize(read_entry_count * record_width);
+    spill_file.read(cursor.buffer.data(), cursor.offset, cursor.buffer.size());
+    cursor.offset += cursor.buffer.size();
+    cursor.remaining -= read_entry_count;
+    cursor.buffer_pos = 0;
+  };
+  const auto cursor_greater = [&cursors, key_width](const size_t lhs, const size_t rhs) {
+    const auto& lhs_cursor = cursors[lhs];
+    const auto& rhs_cursor = cursors[rhs];
+    return memcmp(&lhs_cursor.buffer[lhs_cursor.buffer_pos], &rhs_cursor.buffer[rhs_cursor.buffer_pos], key_width) > 0;
+  };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(cursor_greater)> merge_heap(cursor_greater);
+  for (size_t i = 0; i < cursors.size(); ++i) {
+    if (cursors[i].remaining) {
+      refill(cursors[i]);
+      merge_heap.push(i);
+    }
+  }
+  while (!merge_heap.empty()) {
+    const auto cursor_idx = merge_heap.top();
+    merge_heap.pop();
+    auto& cursor = cursors[cursor_idx];
+    if (!consume(&cursor.buffer[cursor.buffer_pos])) {
+      return;
+    }
+    cursor.buffer_pos += record_width;
+    if (cursor.buffer_pos == cursor.buffer.size()) {
+      if (!cursor.remaining) {
+        continue;
+      }
+      refill(cursor);
+    }
+    merge_heap.push(cursor_idx);
+  }
+}
+
+// Smallest read buffer of a run during a merge, the merges of more runs than the budget allows buffers this big for
+// take several passes.
+constexpr size_t min_merge_buffer_bytes{64 * 1024};
+
+}  // namespace
+
+// Same as above, for key buffers larger than the spill budget: sorted runs of (key, entry index) records which fit
+// the budget are written to the spill file, then merged into the permutation. The rows themselves stay in the
+// result set storage, the records refer to them by index. Runs are merged a bounded number at a time, in as many
+// passes as it takes, and the last pass stops after the top_n first entries, if any.
+bool ResultSet::externalSortWithNormalizedKeys(
+    std::vector<uint32_t>& permutation,
+    const std::list<Analyzer::OrderEntry>& order_entries,
+    const std::vector<std::shared_ptr<const std::vector<int32_t>>>& dict_sorted_ranks,
+    const size_t top_n) {
+  const size_t key_width = order_entries.size() * normalized_key_width;
+  const size_t record_width = key_width + sizeof(uint32_t);
+  const size_t run_entry_count = std::max(g_spill_memory_budget / record_width, size_t(1));
+  const size_t write_batch_bytes = std::min(run_entry_count * record_width, min_merge_buffer_bytes);
+  SpillFile spill_file(g_spill_dir);
+  std::vector<SortedRun> runs;
+  for (size_t run_start = 0; run_start < permutation.size(); run_start += run_entry_count) {
+    const auto run_size = std::min(run_entry_count, permutation.size() - run_start);
+    std::vector<uint8_t> keys(run_size * key_width);
+    if (!writeNormalizedSortKeys(keys, &permutation[run_start], run_size, order_entries, dict_sorted_ranks)) {
+      return false;
+    }
+    const auto positions = sort_normalized_keys(keys, key_width, run_size, cpu_threads());
+    runs.push_back(SortedRun{spill_file.size(), run_size});
+    std::vector<int8_t> records;
+    records.reserve(write_batch_bytes + record_width);
+    for (size_t i = 0; i < run_size; ++i) {
+      const auto key_ptr = reinterpret_cast<const int8_t*>(&keys[size_t(positions[i]) * key_width]);
+      const auto entry_idx = permutation[run_start + positions[i]];
+      records.insert(records.end(), key_ptr, key_ptr + key_width);
+      records.insert(records.end(),
+                     reinterpret_cast<const int8_t*>(&entry_idx),
+                     reinterpret_cast<const int8_t*>(&entry_idx) + sizeof(uint32_t));
+      if (records.size() >= write_batch_bytes || i + 1 == run_size) {
+        spill_file.append(records.data(), records.size());
+        records.clear();
+      }
+    }
+  }
+  const auto entry_count = permutation.size();
+  std::vector<uint32_t>().swap(permutation);
+  if (!entry_count) {
+    return true;
+  }
+  const size_t max_merge_width = std::max(g_spill_memory_budget / min_merge_buffer_bytes, size_t(2));
+  while (runs.size() > max_merge_width) {
+    std::vector<SortedRun> merged_runs;
+    for (size_t run_idx = 0; run_idx < runs.size(); run_idx += max_merge_width) {
+      const std::vector<SortedRun> merged_group(runs.begin() + run_idx,
+                                                runs.begin() + std::min(run_idx + max_merge_width, runs.size()));
+      if (merged_group.size() == 1) {
+        merged_runs.push_back(merged_group.front());
+        continue;
+      }
+      SortedRun merged_run{spill_file.size(), 0};
+      std::vector<int8_t> records;
+      records.reserve(min_merge_buffer_bytes + record_width);
+      merge_sorted_runs(spill_file,
+                        merged_group,
+                        key_width,
+                        record_width,
+                        min_merge_buffer_bytes,
+                        [&spill_file, &records, &merged_run, record_width](const int8_t* record) {
+                          records.insert(records.end(), record, record + record_width);
+                          ++merged_run.entry_count;
+                          if (records.size() >= min_merge_buffer_bytes) {
+                            spill_file.append(records.data(), records.size());
+                            records.clear();
+                          }
+                          return true;
+                        });
+      if (!records.empty()) {
+        spill_file.append(records.data(), records.size());
+      }
+      merged_runs.push_back(merged_run);
+    }
+    runs.swap(merged_runs);
+  }
+  const size_t output_entry_count = top_n ? std::min(top_n, entry_count) : entry_count;
+  permutation_.reserve(output_entry_count);
+  merge_sorted_runs(spill_file,
+                    runs,
+                    key_width,
+                    record_width,
+                    std::max(g_spill_memory_budget / runs.size(), min_merge_buffer_bytes),
+                    [this, key_width, output_entry_count](const int8_t* record) {
+                      uint32_t entry_idx;
+                      memcpy(&entry_idx, record + key_width, sizeof(uint32_t));
+                      permutation_.push_back(entry_idx);
+                      return permutation_.size() < output_entry_count;
+                    });
+  CHECK_EQ(output_entry_count, permutation_.size());
+  return true;
+}
+
 void ResultSet::radixSortOnGpu(const std::list<Analyzer::OrderEntry>& order_entries) const {
   auto data_mgr = &executor_->catalog_->get_dataMgr();
   const int device_id{0};
@@ -298,6 +298,10 @@ class ResultSet {
 
   size_t getBufferSizeBytes(const ExecutorDeviceType device_type) const;
 
+  // Size of the host buffers holding the rows if they don't point into column buffers owned by the storage layer,
+  // zero otherwise. Only a result set with a non-zero size can be kept around after its query finished.
+  size_t getSelfContainedSizeBytes() const;
+
   bool definitelyHasNoRows() const;
 
   const QueryMemoryDescriptor& getQueryMemDesc() const;
@@ -463,10 +467,31 @@ class ResultSet {
 
   StorageLookupResult findStorage(const size_t entry_idx) const;
 
+  std::vector<std::shared_ptr<const std::vector<int32_t>>> getDictSortedRanks(
+      const std::list<Analyzer::OrderEntry>& order_entries) const;
+
   std::function<bool(const uint32_t, const uint32_t)> createComparator(
       const std::list<Analyzer::OrderEntry>& order_entries,
       const bool use_heap) const;
 
+  bool writeNormalizedSortKey(uint8_t* key_ptr,
+                              const uint32_t entry_idx,
+                              const std::list<Analyzer::OrderEntry>& order_entries,
+                              const std::vector<std::shared_ptr<const std::vector<int32_t>>>& dict_sorted_ranks) const;
+
+  bool writeNormalizedSortKeys(std::vector<uint8_t>& keys,
+                               const uint32_t* entries,
+                               const size_t entry_count,
+                               const std::list<Analyzer::OrderEntry>& order_entries,
+                               const std::vector<std::shared_ptr<const std::vector<int32_t>>>& dict_sorted_ranks) const;
+
+  bool parallelSortWithNormalizedKeys(const std::list<Analyzer::OrderEntry>& order_entries, const size_t top_n);
+
+  bool externalSortWithNormalizedKeys(std::vector<uint32_t>& permutation,
+                                      const std::list<Analyzer::OrderEntry>& order_entries,
+                                      const std::vector<std::shared_ptr<const std::vector<int32_t>>>& dict_sorted_ranks,
+                                      const size_t top_n);
+
   static void topPermutation(std::vector<uint32_t>& to_sort,
                              const size_t n,
                              const std::function<bool(const uint32_t, const uint32_t)> compare);
@@ -493,6 +493,22 @@ size_t ResultSet::getBufferSizeBytes(const ExecutorDeviceType device_type) const
   return storage_->query_mem_desc_.getBufferSizeBytes(device_type);
 }
 
+size_t ResultSet::getSelfContainedSizeBytes() const {
+  if (!storage_ || !chunks_.empty() || !chunk_iters_.empty() || !col_buffers_.empty()) {
+    return 0;
+  }
+  for (const auto& col_lazy_fetch : lazy_fetch_info_) {
+    if (col_lazy_fetch.is_lazily_fetched) {
+      return 0;
+    }
+  }
+  size_t size_bytes = getBufferSizeBytes(ExecutorDeviceType::CPU) + permutation_.size() * sizeof(uint32_t);
+  for (const auto& storage : appended_storage_) {
+    size_bytes += storage->query_mem_desc_.getBufferSizeBytes(ExecutorDeviceType::CPU);
+  }
+  return size_bytes;
+}
+
 int64_t lazy_decode(const ColumnLazyFetchInfo& col_lazy_fetch, const int8_t* byte_stream, const int64_t pos) {
   CHECK(col_lazy_fetch.is_lazily_fetched);
   const auto& type_info = col_lazy_fetch.type;
@@ -508,7 +524,7 @@ int64_t lazy_decode(const ColumnLazyFetchInfo& col_lazy_fetch, const int8_t* byt
   CHECK(type_info.is_integer() || type_info.is_decimal() || type_info.is_time() || type_info.is_boolean() ||
         type_info.is_string() || type_info.is_array());
   size_t type_bitwidth = get_bit_width(type_info);
-  if (type_info.get_compression() == kENCODING_FIXED) {
+  if (type_info.get_compression() == kENCODING_FIXED || type_info.is_date_in_days()) {
     type_bitwidth = type_info.get_comp_param();
   } else if (type_info.get_compression() == kENCODING_DICT) {
     type_bitwidth = 8 * type_info.get_size();
@@ -519,9 +535,10 @@ int64_t lazy_decode(const ColumnLazyFetchInfo& col_lazy_fetch, const int8_t* byt
                  ? fixed_width_unsigned_decode_noinline(byte_stream, type_bitwidth / 8, pos)
                  : fixed_width_int_decode_noinline(byte_stream, type_bitwidth / 8, pos);
   if (type_info.get_compression() != kENCODING_NONE) {
-    CHECK(type_info.get_compression() == kENCODING_FIXED || type_info.get_compression() == kENCODING_DICT);
+    CHECK(type_info.get_compression() == kENCODING_FIXED || type_info.get_compression() == kENCODING_DICT ||
+          type_info.is_date_in_days());
     auto encoding = type_info.get_compression();
-    if (encoding == kENCODING_FIXED) {
+    if (encoding == kENCODING_FIXED || encoding == kENCODING_DATE_IN_DAYS) {
       encoding = kENCODING_NONE;
     }
     SQLTypeInfo col_logical_ti(type_info.get_type(),
@@ -534,6 +551,9 @@ int64_t lazy_decode(const ColumnLazyFetchInfo& col_lazy_fetch, const int8_t* byt
     if (val == inline_fixed_encoding_null_val(type_info)) {
       return inline_int_null_val(col_logical_ti);
     }
+    if (type_info.is_date_in_days()) {
+      return get_epoch_seconds_from_days(val);
+    }
   }
   return val;
 }
@@ -0,0 +1,466 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SpatialJoinHashTable.h"
+#include "Execute.h"
+#include "ExpressionRewrite.h"
+#include "GeoQualUtils.h"
+#include "../Shared/geo_compression.h"
+#include "../Utils/ChunkIter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+std::vector<std::pair<SpatialJoinHashTable::HashTableCacheKey, SpatialJoinHashTable::HashTableCacheValue>>
+    SpatialJoinHashTable::hash_table_cache_;
+std::mutex SpatialJoinHashTable::hash_table_cache_mutex_;
+
+namespace {
+
+// The geo functions the qual is translated to and, for the distance, the constant it's compared to.
+struct SpatialJoinFunction {
+  const Analyzer::FunctionOper* function_oper;
+  double distance;
+};
+
+SpatialJoinFunction get_spatial_join_function(const Analyzer::Expr* qual) {
+  if (const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(qual)) {
+    if (bin_oper->get_optype() != kLT && bin_oper->get_optype() != kLE) {
+      return {nullptr, 0};
+    }
+    const auto function_oper = dynamic_cast<const Analyzer::FunctionOper*>(bin_oper->get_left_operand());
+    double distance{0};
+    if (!function_oper || function_oper->getName() != "ST_Distance_Point_Point" ||
+        !get_constant_as_double(dynamic_cast<const Analyzer::Constant*>(bin_oper->get_right_operand()), distance)) {
+      return {nullptr, 0};
+    }
+    return {function_oper, distance};
+  }
+  const auto function_oper = dynamic_cast<const Analyzer::FunctionOper*>(qual);
+  if (!function_oper ||
+      (function_oper->getName() != "ST_Contains_Polygon_Point" &&
+       function_oper->getName() != "ST_Contains_MultiPolygon_Point")) {
+    return {nullptr, 0};
+  }
+  return {function_oper, 0};
+}
+
+int32_t get_int_arg(const Analyzer::FunctionOper* function_oper, const size_t idx) {
+  const auto constant = dynamic_cast<const Analyzer::Constant*>(function_oper->getArg(idx));
+  CHECK(constant);
+  return constant->get_constval().intval;
+}
+
+// Must agree with spatial_join_cell for the points the outer rows are probed with.
+int64_t get_cell(const double coord, const double origin, const double cell_size, const int64_t cell_count) {
+  const double cell = (coord - origin) / cell_size;
+  if (!(cell >= 0)) {
+    return 0;
+  }
+  return cell >= cell_count ? cell_count - 1 : static_cast<int64_t>(cell);
+}
+
+}  // namespace
+
+bool is_spatial_join_qual(const Analyzer::Expr* qual) {
+  return get_spatial_join_function(qual).function_oper;
+}
+
+std::shared_ptr<SpatialJoinHashTable> SpatialJoinHashTable::getInstance(const std::shared_ptr<Analyzer::Expr> qual_in,
+                                                                        const std::vector<InputTableInfo>& query_infos,
+                                                                        const RelAlgExecutionUnit& ra_exe_unit,
+                                                                        const Data_Namespace::MemoryLevel memory_level,
+                                                                        const int device_count,
+                                                                        Executor* executor) {
+  const auto qual = redirect_expr(qual_in.get(), ra_exe_unit.input_col_descs);
+  const auto spatial_join_function = get_spatial_join_function(qual.get());
+  const auto function_oper = spatial_join_function.function_oper;
+  if (!function_oper) {
+    throw HashJoinFail("Not a spatial join predicate");
+  }
+  const bool is_contains = function_oper->getName() != "ST_Distance_Point_Point";
+  const size_t arity = function_oper->getArity();
+  CHECK_EQ(is_contains ? size_t(8) : size_t(7), arity);
+  const auto input_srid0 = get_int_arg(function_oper, arity - 4);
+  const auto input_srid1 = get_int_arg(function_oper, arity - 2);
+  const auto output_srid = get_int_arg(function_oper, arity - 1);
+  if ((input_srid0 != output_srid && output_srid > 0) || (input_srid1 != output_srid && output_srid > 0)) {
+    throw HashJoinFail("Cannot use a spatial join on transformed coordinates");
+  }
+  const auto lhs_col = dynamic_cast<const Analyzer::ColumnVar*>(function_oper->getArg(0));
+  const auto rhs_col = dynamic_cast<const Analyzer::ColumnVar*>(function_oper->getArg(is_contains ? 2 : 1));
+  if (!lhs_col || !rhs_col || lhs_col->get_table_id() < 0 || rhs_col->get_table_id() < 0 ||
+      lhs_col->get_rte_idx() == rhs_col->get_rte_idx()) {
+    throw HashJoinFail("Cannot use a spatial join for given expression");
+  }
+  const Analyzer::ColumnVar* inner_col{nullptr};
+  const Analyzer::ColumnVar* outer_col{nullptr};
+  if (is_contains) {
+    if (lhs_col->get_rte_idx() < rhs_col->get_rte_idx()) {
+      throw HashJoinFail("Spatial join requires the polygons on the inner side");
+    }
+    inner_col = dynamic_cast<const Analyzer::ColumnVar*>(function_oper->getArg(1));
+    CHECK(inner_col);
+    outer_col = rhs_col;
+  } else {
+    if (spatial_join_function.distance < 0) {
+      throw HashJoinFail("Cannot use a spatial join for a negative distance");
+    }
+    std::tie(inner_col, outer_col) = lhs_col->get_rte_idx() > rhs_col->get_rte_idx() ? std::make_pair(lhs_col, rhs_col)
+                                                                                     : std::make_pair(rhs_col, lhs_col);
+  }
+  CHECK_EQ(kPOINT, outer_col->get_type_info().get_type());
+  const auto& catalog = *executor->getCatalog();
+  const auto inner_td = catalog.getMetadataForTable(inner_col->get_table_id());
+  CHECK(inner_td);
+  if (inner_td->nShards) {
+    throw HashJoinFail("Cannot use a spatial join on the sharded table '" + inner_td->tableName + "'");
+  }
+  if (g_cluster && !table_is_replicated(inner_td)) {
+    throw std::runtime_error("Join table " + inner_td->tableName + " must be replicated");
+  }
+  const auto& query_info = get_inner_query_info(inner_col->get_table_id(), query_infos).info;
+  if (query_info.fragments.size() > 1) {
+    throw HashJoinFail("Multi-fragment inner table '" + inner_td->tableName + "' not supported by spatial joins yet");
+  }
+  auto join_hash_table = std::shared_ptr<SpatialJoinHashTable>(new SpatialJoinHashTable(
+      qual, inner_col, outer_col, spatial_join_function.distance, query_infos, memory_level, executor));
+  join_hash_table->reify(device_count);
+  return join_hash_table;
+}
+
+SpatialJoinHashTable::SpatialJoinHashTable(const std::shared_ptr<Analyzer::Expr> qual,
+                                           const Analyzer::ColumnVar* inner_col,
+                                           const Analyzer::ColumnVar* outer_col,
+                                           const double expansion,
+                                           const std::vector<InputTableInfo>& query_infos,
+                                           const Data_Namespace::MemoryLevel memory_level,
+                                           Executor* executor)
+    : qual_(qual),
+      inner_col_(inner_col),
+      outer_col_(outer_col),
+      expansion_(expansion),
+      query_infos_(query_infos),
+      memory_level_(memory_level),
+      executor_(executor),
+      grid_{0, 0, 1, 1, 1, 1} {}
+
+int64_t SpatialJoinHashTable::getJoinHashBuffer(const ExecutorDeviceType device_type, const int device_id) noexcept {
+  if (device_type == ExecutorDeviceType::CPU && !cpu_hash_table_buff_) {
+    return 0;
+  }
+#ifdef HAVE_CUDA
+  CHECK_LT(static_cast<size_t>(device_id), gpu_hash_table_buff_.size());
+  return device_type == ExecutorDeviceType::CPU
+             ? reinterpret_cast<int64_t>(&(*cpu_hash_table_buff_)[0])
+             : reinterpret_cast<int64_t>(gpu_hash_table_buff_[device_id]->getMemoryPtr());
+#else
+  CHECK(device_type == ExecutorDeviceType::CPU);
+  return reinterpret_cast<int64_t>(&(*cpu_hash_table_buff_)[0]);
+#endif
+}
+
+SpatialJoinHashTable::HashTableCacheKey SpatialJoinHashTable::getCacheKey() const {
+  const auto& query_info = get_inner_query_info(inner_col_->get_table_id(), query_infos_).info;
+  std::vector<int> fragment_ids;
+  for (const auto& fragment : query_info.fragments) {
+    fragment_ids.push_back(fragment.fragmentId);
+  }
+  return {{executor_->getCatalog()->get_currentDB().dbId, inner_col_->get_table_id(), inner_col_->get_column_id()},
+          fragment_ids,
+          query_info.getNumTuples(),
+          expansion_};
+}
+
+void SpatialJoinHashTable::reify(const int device_count) {
+  CHECK_LT(0, device_count);
+#ifdef HAVE_CUDA
+  gpu_hash_table_buff_.resize(device_count);
+#endif  // HAVE_CUDA
+  const auto cache_key = getCacheKey();
+  {
+    std::lock_guard<std::mutex> hash_table_cache_lock(hash_table_cache_mutex_);
+    for (const auto& kv : hash_table_cache_) {
+      if (kv.first == cache_key) {
+        cpu_hash_table_buff_ = kv.second.buffer;
+        grid_ = kv.second.grid;
+        break;
+      }
+    }
+  }
+  if (!cpu_hash_table_buff_) {
+    initHashTableOnCpu(fetchInnerBoxes());
+    std::lock_guard<std::mutex> hash_table_cache_lock(hash_table_cache_mutex_);
+    hash_table_cache_.emplace_back(cache_key, HashTableCacheValue{cpu_hash_table_buff_, grid_});
+  }
+  copyToDevices(device_count);
+}
+
+std::vector<double> SpatialJoinHashTable::fetchInnerBoxes() const {
+  const auto& catalog = *executor_->getCatalog();
+  const auto& inner_ti = inner_col_->get_type_info();
+  const bool is_point = inner_ti.get_type() == kPOINT;
+  // The coordinates of a point are in the physical column following the geo column.
+  const int col_id = is_point ? inner_col_->get_column_id() + 1 : inner_col_->get_column_id();
+  const auto cd = catalog.getMetadataForColumn(inner_col_->get_table_id(), col_id);
+  CHECK(cd);
+  const auto pad = [this](const double coord) { return expansion_ + kGeoBoxPadding * std::max(1.0, std::fabs(coord)); };
+  std::vector<double> boxes;
+  const auto& query_info = get_inner_query_info(inner_col_->get_table_id(), query_infos_).info;
+  for (const auto& fragment : query_info.fragments) {
+    if (fragment.isEmptyPhysicalFragment()) {
+      continue;
+    }
+    auto chunk_meta_it = fragment.getChunkMetadataMap().find(col_id);
+    CHECK(chunk_meta_it != fragment.getChunkMetadataMap().end());
+    ChunkKey chunk_key{catalog.get_currentDB().dbId, fragment.physicalTableId, col_id, fragment.fragmentId};
+    const auto chunk = Chunk_NS::Chunk::getChunk(cd,
+                                                 &catalog.get_dataMgr(),
+                                                 chunk_key,
+                                                 Data_Namespace::CPU_LEVEL,
+                                                 0,
+                                                 chunk_meta_it->second.numBytes,
+                                                 chunk_meta_it->second.numElements);
+    CHECK(chunk);
+    auto chunk_iter = chunk->begin_iterator(chunk_meta_it->second);
+    for (size_t i = 0; i < chunk_meta_it->second.numElements; ++i) {
+      ArrayDatum ad;
+      bool is_end;
+      ChunkIter_get_nth(&chunk_iter, i, &ad, &is_end);
+      CHECK(!is_end);
+      double min_x{1}, min_y{1}, max_x{0}, max_y{0};  // empty box for the nulls
+      if (!ad.is_null && ad.pointer) {
+        if (is_point) {
+          double x, y;
+          if (decompress_point(ad.pointer, ad.length, is_geoint32(inner_ti), x, y)) {
+            min_x = max_x = x;
+            min_y = max_y = y;
+          }
+        } else if (ad.length >= 4 * sizeof(double)) {
+          const auto bounds = reinterpret_cast<const double*>(ad.pointer);
+          min_x = bounds[0];
+          min_y = bounds[1];
+          max_x = bounds[2];
+          max_y = bounds[3];
+        }
+      }
+      if (min_x <= max_x && min_y <= max_y) {
+        min_x -= pad(min_x);
+        min_y -= pad(min_y);
+        max_x += pad(max_x);
+        max_y += pad(max_y);
+      }
+      boxes.insert(boxes.end(), {min_x, min_y, max_x, max_y});
+    }
+  }
+  return boxes;
+}
+
+void SpatialJoinHashTable::initHashTableOnCpu(const std::vector<double>& boxes) {
+  CHECK_EQ(size_t(0), boxes.size() % 4);
+  const size_t row_count = boxes.size() / 4;
+  const auto is_valid = [&boxes](const size_t row) {
+    return boxes[4 * row] <= boxes[4 * row + 2] && boxes[4 * row + 1] <= boxes[4 * row + 3];
+  };
+  double min_x{std::numeric_limits<double>::max()};
+  double min_y{std::numeric_limits<double>::max()};
+  double max_x{std::numeric_limits<double>::lowest()};
+  double max_y{std::numeric_limits<double>::lowest()};
+  double width_sum{0};
+  double height_sum{0};
+  size_t box_count{0};
+  for (size_t row = 0; row < row_count; ++row) {
+    if (!is_valid(row)) {
+      continue;
+    }
+    min_x = std::min(min_x, boxes[4 * row]);
+    min_y = std::min(min_y, boxes[4 * row + 1]);
+    max_x = std::max(max_x, boxes[4 * row + 2]);
+    max_y = std::max(max_y, boxes[4 * row + 3]);
+    width_sum += boxes[4 * row + 2] - boxes[4 * row];
+    height_sum += boxes[4 * row + 3] - boxes[4 * row + 1];
+    ++box_count;
+  }
+  if (!box_count) {
+    // a single empty cell, nothing matches
+    grid_ = {0, 0, 1, 1, 1, 1};
+    cpu_hash_table_buff_ = std::make_shared<std::vector<int32_t>>(std::vector<int32_t>{-1, 0});
+    return;
+  }
+  // Cells about the size of the average box, so that a box spans a few cells and a cell
+  // holds a few boxes, but no more than a few cells per box over the whole extent.
+  const int64_t max_cell_count = 4 * box_count + 16;
+  const double extent_x = max_x - min_x;
+  const double extent_y = max_y - min_y;
+  double cell_width = std::max(width_sum / box_count, extent_x / max_cell_count);
+  double cell_height = std::max(height_sum / box_count, extent_y / max_cell_count);
+  if (!(cell_width > 0)) {
+    cell_width = 1;
+  }
+  if (!(cell_height > 0)) {
+    cell_height = 1;
+  }
+  const auto cells_along = [](const double extent, const double cell_size) {
+    return static_cast<int64_t>(extent / cell_size) + 1;
+  };
+  while (cells_along(extent_x, cell_width) * cells_along(extent_y, cell_height) > max_cell_count) {
+    cell_width *= 2;
+    cell_height *= 2;
+  }
+  grid_ = {
+      min_x, min_y, cell_width, cell_height, cells_along(extent_x, cell_width), cells_along(extent_y, cell_height)};
+  const auto cell_count = grid_.cellCount();
+  const auto for_each_cell = [this, &boxes](const size_t row, const std::function<void(const int64_t)>& func) {
+    const auto cell_x_begin = get_cell(boxes[4 * row], grid_.min_x, grid_.cell_width, grid_.cells_x);
+    const auto cell_y_begin = get_cell(boxes[4 * row + 1], grid_.min_y, grid_.cell_height, grid_.cells_y);
+    const auto cell_x_end = get_cell(boxes[4 * row + 2], grid_.min_x, grid_.cell_width, grid_.cells_x);
+    const auto cell_y_end = get_cell(boxes[4 * row + 3], grid_.min_y, grid_.cell_height, grid_.cells_y);
+    for (auto cell_y = cell_y_begin; cell_y <= cell_y_end; ++cell_y) {
+      for (auto cell_x = cell_x_begin; cell_x <= cell_x_end; ++cell_x) {
+        func(cell_y * grid_.cells_x + cell_x);
+      }
+    }
+  };
+  std::vector<int32_t> counts(cell_count, 0);
+  int64_t entry_count{0};
+  for (size_t row = 0; row < row_count; ++row) {
+    if (is_valid(row)) {
+      for_each_cell(row, [&counts, &entry_count](const int64_t cell) {
+        ++counts[cell];
+        ++entry_count;
+      });
+    }
+  }
+  if (2 * cell_count + entry_count > std::numeric_limits<int32_t>::max()) {
+    throw TooManyHashEntries();
+  }
+  // Same layout as the one-to-many hash tables: offsets, counts and the row ids per cell.
+  cpu_hash_table_buff_ = std::make_shared<std::vector<int32_t>>(2 * cell_count + entry_count);
+  auto pos_buff = cpu_hash_table_buff_->data();
+  auto count_buff = pos_buff + cell_count;
+  auto row_id_buff = count_buff + cell_count;
+  int32_t offset{0};
+  for (int64_t cell = 0; cell < cell_count; ++cell) {
+    pos_buff[cell] = counts[cell] ? offset : -1;
+    offset += counts[cell];
+  }
+  for (size_t row = 0; row < row_count; ++row) {
+    if (is_valid(row)) {
+      for_each_cell(row, [pos_buff, count_buff, row_id_buff, row](const int64_t cell) {
+        row_id_buff[pos_buff[cell] + count_buff[cell]++] = row;
+      });
+    }
+  }
+}
+
+void SpatialJoinHashTable::copyToDevices(const int device_count) {
+  if (memory_level_ != Data_Namespace::GPU_LEVEL) {
+    return;
+  }
+#ifdef HAVE_CUDA
+  auto& data_mgr = executor_->getCatalog()->get_dataMgr();
+  const auto buffer_size = cpu_hash_table_buff_->size() * sizeof((*cpu_hash_table_buff_)[0]);
+  CHECK_EQ(static_cast<size_t>(device_count), gpu_hash_table_buff_.size());
+  for (int device_id = 0; device_id < device_count; ++device_id) {
+    gpu_hash_table_buff_[device_id] = alloc_gpu_abstract_buffer(&data_mgr, buffer_size, device_id);
+    copy_to_gpu(&data_mgr,
+                reinterpret_cast<CUdeviceptr>(gpu_hash_table_buff_[device_id]->getMemoryPtr()),
+                &(*cpu_hash_table_buff_)[0],
+                buffer_size,
+                device_id);
+  }
+#else
+  CHECK(false);
+#endif
+}
+
+#define LL_CONTEXT executor_->cgen_state_->context_
+#define LL_BUILDER executor_->cgen_state_->ir_builder_
+#define LL_INT(v) executor_->ll_int(v)
+#define LL_FP(v) executor_->ll_fp(v)
+
+llvm::Value* SpatialJoinHashTable::codegenSlotIsValid(const CompilationOptions&, const size_t) {
+  // The qual is never replaced by the tautology, see getTautology().
+  CHECK(false);
+  return nullptr;
+}
+
+llvm::Value* SpatialJoinHashTable::codegenSlot(const CompilationOptions&, const size_t) {
+  CHECK(false);
+  return nullptr;
+}
+
+HashJoinMatchingSet SpatialJoinHashTable::codegenMatchingSet(const CompilationOptions& co, const size_t index) {
+  const auto coords_lvs = executor_->codegen(outer_col_, true, co);
+  CHECK_EQ(size_t(1), coords_lvs.size());
+  const auto pos_lv = executor_->posArg(outer_col_);
+  const auto coords_ptr_lv = executor_->cgen_state_->emitExternalCall(
+      "array_buff", llvm::Type::getInt8PtrTy(LL_CONTEXT), {coords_lvs.front(), pos_lv});
+  const auto coords_size_lv = executor_->cgen_state_->emitExternalCall(
+      "array_size", get_int_type(32, LL_CONTEXT), {coords_lvs.front(), pos_lv, LL_INT(int32_t(0))});
+  const auto cell_lv = executor_->cgen_state_->emitExternalCall(
+      "spatial_join_cell",
+      get_int_type(64, LL_CONTEXT),
+      {coords_ptr_lv,
+       LL_BUILDER.CreateZExt(coords_size_lv, get_int_type(64, LL_CONTEXT)),
+       LL_INT(int32_t(is_geoint32(outer_col_->get_type_info()) ? 1 : 0)),
+       LL_FP(grid_.min_x),
+       LL_FP(grid_.min_y),
+       LL_FP(grid_.cell_width),
+       LL_FP(grid_.cell_height),
+       LL_INT(grid_.cells_x),
+       LL_INT(grid_.cells_y)});
+  auto hash_ptr = JoinHashTable::codegenHashTableLoad(index, executor_);
+  if (hash_ptr->getType()->isPointerTy()) {
+    hash_ptr = LL_BUILDER.CreatePtrToInt(hash_ptr, llvm::Type::getInt64Ty(LL_CONTEXT));
+  } else {
+    CHECK(hash_ptr->getType()->isIntegerTy(64));
+  }
+  const auto cell_count = grid_.cellCount();
+  return JoinHashTable::codegenMatchingSet({hash_ptr, cell_lv, LL_INT(int64_t(0)), LL_INT(cell_count - 1)},
+                                           false,
+                                           false,
+                                           false,
+                                           cell_count * sizeof(int32_t),
+                                           executor_);
+}
+
+#undef LL_FP
+#undef LL_INT
+#undef LL_BUILDER
+#undef LL_CONTEXT
+
+int SpatialJoinHashTable::getInnerTableId() const noexcept {
+  return inner_col_->get_table_id();
+}
+
+int SpatialJoinHashTable::getInnerTableRteIdx() const noexcept {
+  return inner_col_->get_rte_idx();
+}
+
+JoinHashTableInterface::HashType SpatialJoinHashTable::getHashType() const noexcept {
+  return JoinHashTableInterface::HashType::OneToMany;
+}
+
+std::shared_ptr<Analyzer::BinOper> SpatialJoinHashTable::getTautology() const {
+  // The matching set only narrows down the candidates, the qual is still evaluated. Comparing
+  // it to a constant keeps it from being taken for an equi-join on inner columns.
+  Datum true_datum;
+  true_datum.boolval = true;
+  return std::make_shared<Analyzer::BinOper>(
+      kBOOLEAN, kEQ, kONE, qual_, makeExpr<Analyzer::Constant>(kBOOLEAN, false, true_datum));
+}
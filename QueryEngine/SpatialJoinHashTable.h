@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef QUERYENGINE_SPATIALJOINHASHTABLE_H
+#define QUERYENGINE_SPATIALJOINHASHTABLE_H
+
+#include "../Analyzer/Analyzer.h"
+#include "../DataMgr/MemoryLevel.h"
+#include "InputMetadata.h"
+#include "JoinHashTableInterface.h"
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class Executor;
+
+// Candidate generator for the joins on ST_Contains(inner polygon, outer point) and on
+// ST_Distance(inner point, outer point) < distance. The bounding boxes of the inner rows,
+// expanded by the distance for the latter, are binned into the cells of a uniform grid
+// and the outer point is probed into the single cell it falls in. The layout is the
+// one-to-many layout of JoinHashTable with grid cells as keys, the matching set is a
+// superset of the actual matches and the predicate itself stays in the join quals.
+class SpatialJoinHashTable : public JoinHashTableInterface {
+ public:
+  static std::shared_ptr<SpatialJoinHashTable> getInstance(const std::shared_ptr<Analyzer::Expr> qual,
+                                                           const std::vector<InputTableInfo>& query_infos,
+                                                           const RelAlgExecutionUnit& ra_exe_unit,
+                                                           const Data_Namespace::MemoryLevel memory_level,
+                                                           const int device_count,
+                                                           Executor* executor);
+
+  int64_t getJoinHashBuffer(const ExecutorDeviceType device_type, const int device_id) noexcept override;
+
+  llvm::Value* codegenSlotIsValid(const CompilationOptions&, const size_t) override;
+
+  llvm::Value* codegenSlot(const CompilationOptions&, const size_t) override;
+
+  HashJoinMatchingSet codegenMatchingSet(const CompilationOptions&, const size_t) override;
+
+  int getInnerTableId() const noexcept override;
+
+  int getInnerTableRteIdx() const noexcept override;
+
+  JoinHashTableInterface::HashType getHashType() const noexcept override;
+
+  // Stands in for the qual in the equi-join tautologies, which must be binary operators.
+  std::shared_ptr<Analyzer::BinOper> getTautology() const;
+
+  static auto yieldCacheInvalidator() -> std::function<void()> {
+    return []() -> void {
+      std::lock_guard<std::mutex> guard(hash_table_cache_mutex_);
+      hash_table_cache_.clear();
+    };
+  }
+
+ private:
+  struct Grid {
+    double min_x;
+    double min_y;
+    double cell_width;
+    double cell_height;
+    int64_t cells_x;
+    int64_t cells_y;
+
+    int64_t cellCount() const { return cells_x * cells_y; }
+  };
+
+  SpatialJoinHashTable(const std::shared_ptr<Analyzer::Expr> qual,
+                       const Analyzer::ColumnVar* inner_col,
+                       const Analyzer::ColumnVar* outer_col,
+                       const double expansion,
+                       const std::vector<InputTableInfo>& query_infos,
+                       const Data_Namespace::MemoryLevel memory_level,
+                       Executor* executor);
+
+  void reify(const int device_count);
+
+  // The expanded bounding boxes of the inner rows, 4 values per row, empty for the nulls.
+  std::vector<double> fetchInnerBoxes() const;
+
+  void initHashTableOnCpu(const std::vector<double>& boxes);
+
+  void copyToDevices(const int device_count);
+
+  struct HashTableCacheKey {
+    const ChunkKey chunk_key;  // without the fragment id
+    const std::vector<int> fragment_ids;
+    const size_t num_elements;
+    const double expansion;
+
+    bool operator==(const struct HashTableCacheKey& that) const {
+      return chunk_key == that.chunk_key && fragment_ids == that.fragment_ids && num_elements == that.num_elements &&
+             expansion == that.expansion;
+    }
+  };
+
+  HashTableCacheKey getCacheKey() const;
+
+  const std::shared_ptr<Analyzer::Expr> qual_;
+  // The bounds column of the polygon for ST_Contains, the point otherwise.
+  const Analyzer::ColumnVar* inner_col_;
+  const Analyzer::ColumnVar* outer_col_;
+  const double expansion_;
+  const std::vector<InputTableInfo>& query_infos_;
+  const Data_Namespace::MemoryLevel memory_level_;
+  Executor* executor_;
+  Grid grid_;
+  std::shared_ptr<std::vector<int32_t>> cpu_hash_table_buff_;
+#ifdef HAVE_CUDA
+  std::vector<Data_Namespace::AbstractBuffer*> gpu_hash_table_buff_;
+#endif
+
+  struct HashTableCacheValue {
+    const std::shared_ptr<std::vector<int32_t>> buffer;
+    const Grid grid;
+  };
+
+  static std::vector<std::pair<HashTableCacheKey, HashTableCacheValue>> hash_table_cache_;
+  static std::mutex hash_table_cache_mutex_;
+};
+
+// Whether the qual has the shape of a predicate the spatial join can produce candidates for.
+bool is_spatial_join_qual(const Analyzer::Expr* qual);
+
+#endif  // QUERYENGINE_SPATIALJOINHASHTABLE_H
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SpillFile.h"
+
+#include <boost/filesystem.hpp>
+#include <glog/logging.h>
+
+#include <stdexcept>
+
+std::string g_spill_dir;
+size_t g_spill_memory_budget{0};
+
+SpillFile::SpillFile(const std::string& spill_dir) : file_(nullptr), size_(0) {
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(spill_dir, ec);
+  if (ec) {
+    throw std::runtime_error("Could not create the spill directory " + spill_dir + ": " + ec.message());
+  }
+  path_ = (boost::filesystem::path(spill_dir) / boost::filesystem::unique_path("spill-%%%%-%%%%-%%%%-%%%%")).string();
+  file_ = fopen(path_.c_str(), "w+b");
+  if (!file_) {
+    throw std::runtime_error("Could not create the spill file " + path_);
+  }
+}
+
+SpillFile::~SpillFile() {
+  if (file_) {
+    fclose(file_);
+  }
+  boost::system::error_code ec;
+  boost::filesystem::remove(path_, ec);
+  if (ec) {
+    LOG(WARNING) << "Could not remove the spill file " << path_ << ": " << ec.message();
+  }
+}
+
+size_t SpillFile::append(const int8_t* data, const size_t size) {
+  const auto offset = size_;
+  if (fseek(file_, offset, SEEK_SET) || fwrite(data, 1, size, file_) != size) {
+    throw std::runtime_error("Could not write to the spill file " + path_);
+  }
+  size_ += size;
+  return offset;
+}
+
+void SpillFile::read(int8_t* data, const size_t offset, const size_t size) const {
+  CHECK_LE(offset + size, size_);
+  if (fseek(file_, offset, SEEK_SET) || fread(data, 1, size, file_) != size) {
+    throw std::runtime_error("Could not read from the spill file " + path_);
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    SpillFile.h
+ * @brief   Temporary file for the intermediate results which don't fit the query memory budget.
+ *
+ * Copyright (c) 2017 MapD Technologies, Inc.  All rights reserved.
+ **/
+
+#ifndef QUERYENGINE_SPILLFILE_H
+#define QUERYENGINE_SPILLFILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Where the spill files go, empty to disable spilling. The server points it to mapd_spill under the data path.
+extern std::string g_spill_dir;
+// Bytes of sort keys and flushed group-by partitions a query can keep in memory before spilling, 0 (the default)
+// disables spilling.
+extern size_t g_spill_memory_budget;
+
+inline bool spill_enabled() {
+  return g_spill_memory_budget && !g_spill_dir.empty();
+}
+
+// Blocks are appended and read back by the offset append() returned. The file is removed with the object.
+class SpillFile {
+ public:
+  SpillFile(const std::string& spill_dir);
+
+  ~SpillFile();
+
+  size_t append(const int8_t* data, const size_t size);
+
+  void read(int8_t* data, const size_t offset, const size_t size) const;
+
+  size_t size() const { return size_; }
+
+ private:
+  std::string path_;
+  FILE* file_;
+  size_t size_;
+};
+
+#endif  // QUERYENGINE_SPILLFILE_H
@@ -6,8 +6,9 @@
 // Classes that are involved in needing a cache invalidated when there is an update
 #include "BaselineJoinHashTable.h"
 #include "JoinHashTable.h"
+#include "SpatialJoinHashTable.h"
 
-using UpdateTriggeredCacheInvalidator = CacheInvalidator<BaselineJoinHashTable, JoinHashTable>;
+using UpdateTriggeredCacheInvalidator = CacheInvalidator<BaselineJoinHashTable, JoinHashTable, SpatialJoinHashTable>;
 using DeleteTriggeredCacheInvalidator = UpdateTriggeredCacheInvalidator;
 
 #endif
@@ -478,7 +478,13 @@ StandardCommand(GetOptimizedSchema, {
       case TDatumType::TIME: {
         return 32;
       }
-      case TDatumType::DATE:
+      case TDatumType::DATE: {
+        // days since the epoch, -32768 is the null sentinel of DAYS(16)
+        return run_query(context,
+                         "select case when (extract( epoch from mn)  >= -2831068800 and extract (epoch from mx) <= "
+                         "2831068800) then 16 else 32 end from (select min(" +
+                             col_name + ") mn, max(" + col_name + ") mx from " + table_name + " );");
+      }
       case TDatumType::TIMESTAMP: {
         return run_query(context,
                          "select case when (extract( epoch from mn)  > -2147483648 and extract (epoch from mx) < "
@@ -530,7 +536,8 @@ StandardCommand(GetOptimizedSchema, {
         }
       } else {
         int opt_size = get_optimal_size(context, table_name, p.col_name, p.col_type.type);
-        encoding = (opt_size == 0 ? "" : " ENCODING FIXED(" + std::to_string(opt_size) + ")");
+        const std::string encoding_name = p.col_type.type == TDatumType::DATE ? "DAYS" : "FIXED";
+        encoding = (opt_size == 0 ? "" : " ENCODING " + encoding_name + "(" + std::to_string(opt_size) + ")");
       }
       output_stream << comma_or_blank << p.col_name << " " << thrift_to_name(p.col_type)
                     << (p.col_type.nullable ? "" : " NOT NULL") << encoding;
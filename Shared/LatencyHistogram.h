@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    LatencyHistogram.h
+ * @brief   Lock-free, fixed bucket histogram of request latencies.
+ *
+ */
+
+#ifndef SHARED_LATENCYHISTOGRAM_H
+#define SHARED_LATENCYHISTOGRAM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class LatencyHistogram {
+ public:
+  LatencyHistogram() : counts_(bucketUpperBounds().size() + 1), total_count_(0), total_ms_(0) {}
+
+  // Inclusive upper bounds in milliseconds. The last bucket, which has no bound, holds the slower requests.
+  static const std::vector<int64_t>& bucketUpperBounds() {
+    static const std::vector<int64_t> upper_bounds{1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000};
+    return upper_bounds;
+  }
+
+  void record(const int64_t duration_ms) {
+    const auto& upper_bounds = bucketUpperBounds();
+    const auto bucket = std::lower_bound(upper_bounds.begin(), upper_bounds.end(), duration_ms) - upper_bounds.begin();
+    counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+    total_count_.fetch_add(1, std::memory_order_relaxed);
+    total_ms_.fetch_add(std::max(duration_ms, int64_t(0)), std::memory_order_relaxed);
+  }
+
+  // Relaxed snapshot, the buckets may not add up to getCount() while requests are being recorded.
+  std::vector<int64_t> getBucketCounts() const {
+    std::vector<int64_t> counts;
+    counts.reserve(counts_.size());
+    for (const auto& count : counts_) {
+      counts.push_back(count.load(std::memory_order_relaxed));
+    }
+    return counts;
+  }
+
+  int64_t getCount() const { return total_count_.load(std::memory_order_relaxed); }
+
+  int64_t getTotalMs() const { return total_ms_.load(std::memory_order_relaxed); }
+
+ private:
+  std::vector<std::atomic<int64_t>> counts_;
+  std::atomic<int64_t> total_count_;
+  std::atomic<int64_t> total_ms_;
+};
+
+#endif  // SHARED_LATENCYHISTOGRAM_H
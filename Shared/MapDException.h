@@ -0,0 +1,31 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARED_MAPDEXCEPTION_H
+#define SHARED_MAPDEXCEPTION_H
+
+#include "gen-cpp/mapd_types.h"
+
+#include <glog/logging.h>
+
+// Errors reported to Thrift clients, including the aggregator of a cluster.
+#define THROW_MAPD_EXCEPTION(errstr) \
+  TMapDException ex;                 \
+  ex.error_msg = errstr;             \
+  LOG(ERROR) << ex.error_msg;        \
+  throw ex;
+
+#endif  // SHARED_MAPDEXCEPTION_H
@@ -37,6 +37,8 @@ struct MapDParameters {
   std::string ha_brokers;           // name of the HA broker
   std::string ha_shared_data;       // name of shared data directory base
   bool is_decr_start_epoch;         // are we doing a start epoch decrement?
+  bool lazy_table_activation = false;  // load the storage of all tables in the background after startup
+  size_t table_prewarm_threads = 1;    // threads per database loading tables in the background
 
   MapDParameters() : cuda_block_size(0), cuda_grid_size(0), calcite_max_mem(1024) {}
 };
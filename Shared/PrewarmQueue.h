@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    PrewarmQueue.h
+ * @brief   Runs a task once for each key on background threads, keys can be moved to the front while waiting.
+ *
+ */
+
+#ifndef SHARED_PREWARMQUEUE_H
+#define SHARED_PREWARMQUEUE_H
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class PrewarmQueue {
+ public:
+  // The task must not throw. Keys run in the given order, unless promoted.
+  PrewarmQueue(std::function<void(const int)> task, const std::vector<int>& keys, const size_t num_threads)
+      : task_(task), stop_(false) {
+    for (const auto key : keys) {
+      if (!positions_.count(key)) {
+        positions_[key] = queue_.insert(queue_.end(), key);
+      }
+    }
+    for (size_t i = 0; i < std::max(num_threads, size_t(1)); ++i) {
+      workers_.emplace_back([this] { run(); });
+    }
+  }
+
+  // Keys still waiting are dropped, the running tasks are waited for.
+  ~PrewarmQueue() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    join();
+  }
+
+  // Moves the keys to the front of the queue, in the given order. Keys which already ran or are running are ignored.
+  void promote(const std::vector<int>& keys) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+      const auto pos_it = positions_.find(*it);
+      if (pos_it != positions_.end()) {
+        queue_.splice(queue_.begin(), queue_, pos_it->second);
+      }
+    }
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+  // Waits until the queue is drained, or stopped.
+  void join() {
+    for (auto& worker : workers_) {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+  }
+
+ private:
+  void run() {
+    while (true) {
+      int key;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_ || queue_.empty()) {
+          return;
+        }
+        key = queue_.front();
+        queue_.pop_front();
+        positions_.erase(key);
+      }
+      task_(key);
+    }
+  }
+
+  const std::function<void(const int)> task_;
+  std::list<int> queue_;
+  std::unordered_map<int, std::list<int>::iterator> positions_;
+  bool stop_;
+  mutable std::mutex mutex_;
+  std::vector<std::thread> workers_;
+};
+
+#endif  // SHARED_PREWARMQUEUE_H
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    QueryAdmission.h
+ * @brief   Bounds the number of queries running at once, queueing the rest in arrival order up to a limit.
+ *
+ */
+
+#ifndef SHARED_QUERYADMISSION_H
+#define SHARED_QUERYADMISSION_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+class QueryAdmission {
+ public:
+  // Holds one of the running slots until destroyed. A default constructed slot holds nothing.
+  class Slot {
+   public:
+    Slot() : admission_(nullptr) {}
+
+    Slot(Slot&& other) : admission_(other.admission_) { other.admission_ = nullptr; }
+
+    Slot& operator=(Slot&& other) {
+      if (this != &other) {
+        release();
+        admission_ = other.admission_;
+        other.admission_ = nullptr;
+      }
+      return *this;
+    }
+
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+
+    ~Slot() { release(); }
+
+   private:
+    explicit Slot(QueryAdmission* admission) : admission_(admission) { ++heldSlots(); }
+
+    void release() {
+      if (admission_) {
+        --heldSlots();
+        admission_->release();
+        admission_ = nullptr;
+      }
+    }
+
+    QueryAdmission* admission_;
+
+    friend class QueryAdmission;
+  };
+
+  // max_queued of 0 lets any number of queries wait.
+  QueryAdmission(const size_t max_running, const size_t max_queued)
+      : max_running_(std::max(max_running, size_t(1)))
+      , max_queued_(max_queued)
+      , running_(0)
+      , queued_(0)
+      , rejected_(0)
+      , next_ticket_(0)
+      , next_admitted_ticket_(0) {}
+
+  // Waits for a running slot. Throws if max_queued queries are already waiting. A thread which already holds a
+  // slot gets an empty one right away, so that queries issued while running a query can't deadlock on the limit.
+  Slot admit() {
+    if (heldSlots()) {
+      return Slot();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (max_queued_ && queued_ >= max_queued_) {
+      ++rejected_;
+      throw std::runtime_error("Server is busy, " + std::to_string(running_) + " queries are running and " +
+                               std::to_string(queued_) + " are waiting. Retry later.");
+    }
+    const auto ticket = next_ticket_++;
+    ++queued_;
+    cv_.wait(lock, [this, ticket] { return ticket == next_admitted_ticket_ && running_ < max_running_; });
+    --queued_;
+    ++running_;
+    ++next_admitted_ticket_;
+    // the next ticket may be able to run as well
+    cv_.notify_all();
+    return Slot(this);
+  }
+
+  size_t getMaxRunning() const { return max_running_; }
+
+  size_t getMaxQueued() const { return max_queued_; }
+
+  size_t getRunningCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+  }
+
+  size_t getQueuedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queued_;
+  }
+
+  int64_t getRejectedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rejected_;
+  }
+
+ private:
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --running_;
+    }
+    cv_.notify_all();
+  }
+
+  static size_t& heldSlots() {
+    static thread_local size_t held_slots{0};
+    return held_slots;
+  }
+
+  const size_t max_running_;
+  const size_t max_queued_;
+  size_t running_;
+  size_t queued_;
+  int64_t rejected_;
+  uint64_t next_ticket_;
+  uint64_t next_admitted_ticket_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+#endif  // SHARED_QUERYADMISSION_H
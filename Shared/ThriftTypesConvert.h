@@ -143,6 +143,7 @@ inline TEncodingType::type encoding_to_thrift(const SQLTypeInfo& type_info) {
     THRIFT_ENCODING_CASE(DICT)
     THRIFT_ENCODING_CASE(SPARSE)
     THRIFT_ENCODING_CASE(GEOINT)
+    THRIFT_ENCODING_CASE(DATE_IN_DAYS)
     default:
       CHECK(false);
   }
@@ -160,6 +161,7 @@ inline EncodingType thrift_to_encoding(const TEncodingType::type tEncodingType)
     UNTHRIFT_ENCODING_CASE(DICT)
     UNTHRIFT_ENCODING_CASE(SPARSE)
     UNTHRIFT_ENCODING_CASE(GEOINT)
+    UNTHRIFT_ENCODING_CASE(DATE_IN_DAYS)
     default:
       CHECK(false);
   }
@@ -124,6 +124,14 @@ static inline void put_scalar(void* ndptr, const SQLTypeInfo& ntype, const T ova
       else
         put_scalar<T>(ndptr, get_decimal_int_type(ntype), 0, oval * pow(10, ntype.get_scale()));
       break;
+    case kDATE:
+      if (ntype.is_date_in_days()) {
+        // days-encoded dates are stored as a small integer
+        put_scalar<int64_t>(ndptr, get_decimal_int_type(ntype), 0, get_epoch_days_from_seconds(oval));
+      } else {
+        put_scalar<T>(ndptr, etype, get_uncompressed_element_size(ntype), oval);
+      }
+      break;
     default:
       if (otype && otype->is_decimal())
         put_scalar<double>(ndptr, ntype, decimal_to_double(*otype, oval));
@@ -137,6 +145,10 @@ static inline void put_null(void* ndptr, const SQLTypeInfo& ntype, const std::st
   if (ntype.get_notnull())
     throw std::runtime_error("NULL value on NOT NULL column '" + col_name + "'");
 
+  if (ntype.is_date_in_days()) {
+    put_scalar<int64_t>(ndptr, get_decimal_int_type(ntype), 0, ntype.get_size() == 2 ? NULL_SMALLINT : NULL_INT);
+    return;
+  }
   switch (ntype.get_type()) {
     case kBOOLEAN:
       *(int8_t*)ndptr = NULL_BOOLEAN;
@@ -171,6 +183,12 @@ static inline void put_null(void* ndptr, const SQLTypeInfo& ntype, const std::st
 
 template <typename T>
 static inline bool get_scalar(void* ndptr, const SQLTypeInfo& ntype, T& v) {
+  if (ntype.is_date_in_days()) {
+    int64_t days;
+    const bool is_null = get_scalar(ndptr, SQLTypeInfo(get_decimal_int_type(ntype), ntype.get_notnull()), days);
+    v = is_null ? NULL_BIGINT : get_epoch_seconds_from_days(days);
+    return is_null;
+  }
   switch (ntype.get_type()) {
     case kBOOLEAN:
       return NULL_BOOLEAN == (v = *(int8_t*)ndptr);
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARED_GEO_COMPRESSION_H
+#define SHARED_GEO_COMPRESSION_H
+
+#include "funcannotations.h"
+
+#include <stdint.h>
+
+// GEOINT32 maps longitudes (x) from [-180, 180] and latitudes (y) from [-90, 90] to the range of int32_t.
+DEVICE inline double decompress_geoint32_coord(const int32_t compressed_coord, const bool x) {
+  return (x ? 180.0 : 90.0) * (static_cast<double>(compressed_coord) / 2147483647.0);
+}
+
+// Reads the point stored in the coords of a POINT, a pair of GEOINT32 compressed or of plain doubles.
+// Returns false when the coords are too short to hold one.
+DEVICE inline bool decompress_point(const int8_t* coords,
+                                    const int64_t coords_size,
+                                    const bool geoint32,
+                                    double& x,
+                                    double& y) {
+  if (geoint32) {
+    if (coords_size < static_cast<int64_t>(2 * sizeof(int32_t))) {
+      return false;
+    }
+    const auto compressed_coords = reinterpret_cast<const int32_t*>(coords);
+    x = decompress_geoint32_coord(compressed_coords[0], true);
+    y = decompress_geoint32_coord(compressed_coords[1], false);
+    return true;
+  }
+  if (coords_size < static_cast<int64_t>(2 * sizeof(double))) {
+    return false;
+  }
+  const auto double_coords = reinterpret_cast<const double*>(coords);
+  x = double_coords[0];
+  y = double_coords[1];
+  return true;
+}
+
+#endif  // SHARED_GEO_COMPRESSION_H
@@ -118,14 +118,15 @@ union DataBlockPtr {
 
 // must not change because these values persist in catalogs.
 enum EncodingType {
-  kENCODING_NONE = 0,    // no encoding
-  kENCODING_FIXED = 1,   // Fixed-bit encoding
-  kENCODING_RL = 2,      // Run Length encoding
-  kENCODING_DIFF = 3,    // Differential encoding
-  kENCODING_DICT = 4,    // Dictionary encoding
-  kENCODING_SPARSE = 5,  // Null encoding for sparse columns
-  kENCODING_GEOINT = 6,  // Encoding coordinates as intergers
-  kENCODING_LAST = 7
+  kENCODING_NONE = 0,          // no encoding
+  kENCODING_FIXED = 1,         // Fixed-bit encoding
+  kENCODING_RL = 2,            // Run Length encoding
+  kENCODING_DIFF = 3,          // Differential encoding
+  kENCODING_DICT = 4,          // Dictionary encoding
+  kENCODING_SPARSE = 5,        // Null encoding for sparse columns
+  kENCODING_GEOINT = 6,        // Encoding coordinates as intergers
+  kENCODING_DATE_IN_DAYS = 7,  // Date encoded as days since the epoch
+  kENCODING_LAST = 8
 };
 
 #define IS_INTEGER(T) (((T) == kINT) || ((T) == kSMALLINT) || ((T) == kBIGINT) || ((T) == kTINYINT))
@@ -211,7 +212,7 @@ class SQLTypeInfo {
   HOST DEVICE inline int get_comp_param() const { return comp_param; }
   HOST DEVICE inline int get_size() const { return size; }
   inline int get_logical_size() const {
-    if (compression == kENCODING_FIXED) {
+    if (compression == kENCODING_FIXED || compression == kENCODING_DATE_IN_DAYS) {
       SQLTypeInfo ti(type, dimension, scale, notnull, kENCODING_NONE, 0, subtype);
       return ti.get_size();
     }
@@ -314,6 +315,7 @@ class SQLTypeInfo {
   inline bool is_boolean() const { return type == kBOOLEAN; }
   inline bool is_array() const { return type == kARRAY; }
   inline bool is_timeinterval() const { return type == kINTERVAL_DAY_TIME || type == kINTERVAL_YEAR_MONTH; }
+  HOST DEVICE inline bool is_date_in_days() const { return type == kDATE && compression == kENCODING_DATE_IN_DAYS; }
   inline bool is_geometry() const { return IS_GEO(type); }
 
   inline bool is_varlen() const {
@@ -545,6 +547,7 @@ class SQLTypeInfo {
           case kENCODING_NONE:
             return sizeof(time_t);
           case kENCODING_FIXED:
+          case kENCODING_DATE_IN_DAYS:
             return comp_param / 8;
           case kENCODING_RL:
           case kENCODING_DIFF:
@@ -589,7 +592,7 @@ int64_t convert_decimal_value_to_scale(const int64_t decimal_value,
 
 inline SQLTypeInfo get_logical_type_info(const SQLTypeInfo& type_info) {
   EncodingType encoding = type_info.get_compression();
-  if (encoding == kENCODING_FIXED) {
+  if (encoding == kENCODING_FIXED || encoding == kENCODING_DATE_IN_DAYS) {
     encoding = kENCODING_NONE;
   }
   return SQLTypeInfo(type_info.get_type(),
@@ -601,6 +604,15 @@ inline SQLTypeInfo get_logical_type_info(const SQLTypeInfo& type_info) {
                      type_info.get_subtype());
 }
 
+// DATE columns encoded as days store the days since the epoch, floored for the dates before it.
+HOST DEVICE inline int64_t get_epoch_days_from_seconds(const int64_t seconds) {
+  return (seconds - (SECSPERDAY - 1) * (seconds < 0)) / SECSPERDAY;
+}
+
+HOST DEVICE inline int64_t get_epoch_seconds_from_days(const int64_t days) {
+  return days * SECSPERDAY;
+}
+
 template <class T>
 inline int64_t inline_int_null_value() {
   return std::is_signed<T>::value ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
@@ -27,6 +27,7 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/sort/spreadsort/string_sort.hpp>
 
+#include <algorithm>
 #include <future>
 #include <thread>
 
@@ -118,8 +119,13 @@ StringDictionary::StringDictionary(const std::string& folder,
     boost::filesystem::path storage_path(folder);
     offsets_path_ = (storage_path / boost::filesystem::path("DictOffsets")).string();
     const auto payload_path = (storage_path / boost::filesystem::path("DictPayload")).string();
+    sorted_cache_path_ = (storage_path / boost::filesystem::path("DictSortedCache")).string();
     payload_fd_ = checked_open(payload_path.c_str(), recover);
     offset_fd_ = checked_open(offsets_path_.c_str(), recover);
+    if (!recover) {
+      // the sort order of a truncated dictionary is meaningless
+      unlink(sorted_cache_path_.c_str());
+    }
     payload_file_size_ = file_size(payload_fd_);
     offset_file_size_ = file_size(offset_fd_);
   }
@@ -174,6 +180,7 @@ StringDictionary::StringDictionary(const std::string& folder,
       if (dictionary_futures.size() != 0) {
         processDictionaryFutures(dictionary_futures);
       }
+      loadSortedCache();
     }
   }
 }
@@ -245,14 +252,67 @@ void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
     getOrAddBulkRemote(string_vec, encoded_vec);
     return;
   }
-  size_t out_idx{0};
+  // Look all the strings up under a single read lock, spread over threads for large batches, then add the
+  // missing ones under a single write lock rather than locking once or twice per string.
+  std::vector<size_t> hashes(string_vec.size());
+  std::vector<int32_t> string_ids(string_vec.size());
+  const bool multithreaded = string_vec.size() > 10000;
+  const auto worker_count = multithreaded ? static_cast<size_t>(cpu_threads()) : size_t(1);
+  CHECK_GT(worker_count, 0);
+  std::vector<std::vector<size_t>> worker_misses(worker_count);
+  {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+    auto lookup = [this, &string_vec, &hashes, &string_ids](
+        std::vector<size_t>& misses, const size_t start, const size_t end) {
+      for (size_t i = start; i < end; ++i) {
+        const auto& str = string_vec[i];
+        // @TODO(wei) treat empty string as NULL for now
+        if (str.empty()) {
+          string_ids[i] = inline_int_null_value<int32_t>();
+          continue;
+        }
+        CHECK(str.size() <= MAX_STRLEN);
+        hashes[i] = rk_hash(str);
+        string_ids[i] = str_ids_[computeBucket(hashes[i], str, str_ids_, false)];
+        if (string_ids[i] == INVALID_STR_ID) {
+          misses.push_back(i);
+        }
+      }
+    };
+    if (multithreaded) {
+      std::vector<std::future<void>> workers;
+      const auto stride = (string_vec.size() + (worker_count - 1)) / worker_count;
+      for (size_t worker_idx = 0, start = 0, end = std::min(start + stride, string_vec.size());
+           worker_idx < worker_count && start < string_vec.size();
+           ++worker_idx, start += stride, end = std::min(start + stride, string_vec.size())) {
+        workers.push_back(std::async(std::launch::async, lookup, std::ref(worker_misses[worker_idx]), start, end));
+      }
+      for (auto& worker : workers) {
+        worker.get();
+      }
+    } else {
+      lookup(worker_misses[0], 0, string_vec.size());
+    }
+  }
+  if (std::any_of(worker_misses.begin(), worker_misses.end(), [](const std::vector<size_t>& misses) {
+        return !misses.empty();
+      })) {
+    mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+    // the slices are in order, so are the ids of the new strings
+    for (const auto& misses : worker_misses) {
+      for (const auto i : misses) {
+        string_ids[i] = getOrAddUnlocked(hashes[i], string_vec[i]);
+      }
+    }
+  }
 
-  for (const auto& str : string_vec) {
-    const auto string_id = getOrAddImpl(str);
+  size_t out_idx{0};
+  for (size_t i = 0; i < string_vec.size(); ++i) {
+    const auto string_id = string_ids[i];
     const bool invalid = string_id > max_valid_int_value<T>();
     if (invalid || string_id == inline_int_null_value<int32_t>()) {
       if (invalid) {
-        log_encoding_error<T>(str);
+        log_encoding_error<T>(string_vec[i]);
       }
       encoded_vec[out_idx++] = inline_int_null_value<T>();
       continue;
@@ -740,9 +800,13 @@ int32_t StringDictionary::getOrAddImpl(const std::string& str) noexcept {
     }
   }
   mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  return getOrAddUnlocked(hash, str);
+}
+
+int32_t StringDictionary::getOrAddUnlocked(const size_t hash, const std::string& str) noexcept {
   // need to recalculate the bucket in case it changed before
   // we got the lock
-  bucket = computeBucket(hash, str, str_ids_, false);
+  auto bucket = computeBucket(hash, str, str_ids_, false);
   if (str_ids_[bucket] == INVALID_STR_ID) {
     if (fillRateIsHigh()) {
       // resize when more than 50% is full
@@ -942,6 +1006,97 @@ bool StringDictionary::checkpoint() noexcept {
   ret = ret && (msync((void*)payload_map_, payload_file_size_, MS_SYNC) == 0);
   ret = ret && (fsync(offset_fd_) == 0);
   ret = ret && (fsync(payload_fd_) == 0);
+  if (ret) {
+    mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+    // the sort order can always be rebuilt from the payload, don't fail the checkpoint over it
+    if (!persistSortedCache()) {
+      LOG(WARNING) << "Could not persist dictionary sort order " << sorted_cache_path_;
+    }
+  }
+  return ret;
+}
+
+std::shared_ptr<const std::vector<int32_t>> StringDictionary::getSortedRanks() {
+  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  if (client_) {
+    return nullptr;
+  }
+  if (sorted_cache.size() < str_count_) {
+    buildSortedCache();
+  }
+  // The sorted cache only ever grows, so a rank array of the same size is up to date.
+  if (!sorted_ranks_ || sorted_ranks_->size() != sorted_cache.size()) {
+    auto sorted_ranks = std::make_shared<std::vector<int32_t>>(sorted_cache.size());
+    for (size_t rank = 0; rank < sorted_cache.size(); ++rank) {
+      (*sorted_ranks)[sorted_cache[rank]] = rank;
+    }
+    sorted_ranks_ = sorted_ranks;
+  }
+  return sorted_ranks_;
+}
+
+bool StringDictionary::hasSortedRanks() const {
+  mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+  return !client_ && !sorted_cache.empty();
+}
+
+void StringDictionary::loadSortedCache() noexcept {
+  // Only the strings which were present at the last checkpoint are covered by
+  // the persisted order, the rest get merged in by buildSortedCache on demand.
+  const auto fd = open(sorted_cache_path_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  const size_t bytes = file_size(fd);
+  std::vector<int32_t> loaded_cache(bytes / sizeof(int32_t));
+  bool valid = bytes % sizeof(int32_t) == 0 && loaded_cache.size() <= str_count_;
+  for (size_t read_bytes = 0; valid && read_bytes < bytes;) {
+    const auto crt_read = read(fd, reinterpret_cast<char*>(loaded_cache.data()) + read_bytes, bytes - read_bytes);
+    valid = crt_read > 0;
+    read_bytes += valid ? crt_read : 0;
+  }
+  close(fd);
+  // must be a permutation of the first loaded_cache.size() string ids
+  std::vector<bool> seen(valid ? loaded_cache.size() : 0, false);
+  for (size_t i = 0; valid && i < loaded_cache.size(); ++i) {
+    const auto string_id = loaded_cache[i];
+    valid = string_id >= 0 && static_cast<size_t>(string_id) < loaded_cache.size() && !seen[string_id];
+    if (valid) {
+      seen[string_id] = true;
+    }
+  }
+  if (!valid) {
+    LOG(WARNING) << "Ignoring invalid dictionary sort order " << sorted_cache_path_;
+    return;
+  }
+  sorted_cache.swap(loaded_cache);
+}
+
+bool StringDictionary::persistSortedCache() noexcept {
+  // This method is not thread-safe.
+  if (sorted_cache.empty()) {
+    // nobody asked for an ordered view of this dictionary yet
+    return true;
+  }
+  if (sorted_cache.size() < str_count_) {
+    buildSortedCache();
+  }
+  const auto tmp_path = sorted_cache_path_ + ".tmp";
+  const auto fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  const size_t bytes = sorted_cache.size() * sizeof(int32_t);
+  bool ret = true;
+  for (size_t written_bytes = 0; ret && written_bytes < bytes;) {
+    const auto crt_write =
+        write(fd, reinterpret_cast<const char*>(sorted_cache.data()) + written_bytes, bytes - written_bytes);
+    ret = crt_write > 0;
+    written_bytes += ret ? crt_write : 0;
+  }
+  ret = ret && (fsync(fd) == 0);
+  close(fd);
+  ret = ret && (rename(tmp_path.c_str(), sorted_cache_path_.c_str()) == 0);
   return ret;
 }
 
@@ -70,6 +70,10 @@ class StringDictionary {
 
   std::shared_ptr<const std::vector<std::string>> copyStrings() const;
 
+  std::shared_ptr<const std::vector<int32_t>> getSortedRanks();
+  // true when a sort order was loaded or built before, getSortedRanks then only sorts the strings added since
+  bool hasSortedRanks() const;
+
   bool checkpoint() noexcept;
 
   static const int32_t INVALID_STR_ID;
@@ -94,6 +98,8 @@ class StringDictionary {
   bool fillRateIsHigh() const noexcept;
   void increaseCapacity() noexcept;
   int32_t getOrAddImpl(const std::string& str) noexcept;
+  // the caller holds the write lock
+  int32_t getOrAddUnlocked(const size_t hash, const std::string& str) noexcept;
   template <class T>
   void getOrAddBulkRemote(const std::vector<std::string>& string_vec, T* encoded_vec);
   int32_t getUnlocked(const std::string& str) const noexcept;
@@ -117,13 +123,17 @@ class StringDictionary {
   void insertInSortedCache(std::string str, int32_t str_id);
   void sortCache(std::vector<int32_t>& cache);
   void mergeSortedCache(std::vector<int32_t>& temp_sorted_cache);
+  void loadSortedCache() noexcept;
+  bool persistSortedCache() noexcept;
   compare_cache_value_t* binary_search_cache(const std::string& pattern) const;
 
   size_t str_count_;
   std::vector<int32_t> str_ids_;
   std::vector<int32_t> sorted_cache;
+  std::shared_ptr<std::vector<int32_t>> sorted_ranks_;
   bool isTemp_;
   std::string offsets_path_;
+  std::string sorted_cache_path_;
   int payload_fd_;
   int offset_fd_;
   StringIdxEntry* offset_map_;
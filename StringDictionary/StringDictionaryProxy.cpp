@@ -177,6 +177,14 @@ std::vector<int32_t> StringDictionaryProxy::getRegexpLike(const std::string& pat
   return result;
 }
 
+std::shared_ptr<const std::vector<int32_t>> StringDictionaryProxy::getSortedRanks() const {
+  return string_dict_->getSortedRanks();
+}
+
+bool StringDictionaryProxy::hasSortedRanks() const {
+  return string_dict_->hasSortedRanks();
+}
+
 int32_t StringDictionaryProxy::getOrAdd(const std::string& str) noexcept {
   return string_dict_->getOrAdd(str);
 }
@@ -54,6 +54,10 @@ class StringDictionaryProxy {
 
   std::vector<int32_t> getRegexpLike(const std::string& pattern, const char escape) const;
 
+  // ranks of the persistent (non-negative) string ids in sort order, transient strings aren't ranked
+  std::shared_ptr<const std::vector<int32_t>> getSortedRanks() const;
+  bool hasSortedRanks() const;
+
  private:
   std::shared_ptr<StringDictionary> string_dict_;
   std::map<int32_t, std::string> transient_int_to_str_;
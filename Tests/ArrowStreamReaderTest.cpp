@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../Import/ArrowStreamReader.h"
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+const auto schema = arrow::schema({arrow::field("x", arrow::int32())});
+
+std::shared_ptr<arrow::RecordBatch> make_batch(const int32_t first, const int32_t rows) {
+  std::unique_ptr<arrow::ArrayBuilder> builder;
+  arrow_stream_throw_not_ok(arrow::MakeBuilder(arrow::default_memory_pool(), arrow::int32(), &builder));
+  auto int_builder = static_cast<arrow::Int32Builder*>(builder.get());
+  for (int32_t i = first; i < first + rows; ++i) {
+    arrow_stream_throw_not_ok(int_builder->Append(i));
+  }
+  std::shared_ptr<arrow::Array> array;
+  arrow_stream_throw_not_ok(builder->Finish(&array));
+  return std::make_shared<arrow::RecordBatch>(schema, rows, std::vector<std::shared_ptr<arrow::Array>>{array});
+}
+
+// a stream of batches holding the given numbers of rows, x counts the rows over all of them
+std::string make_stream(const std::vector<int32_t>& batch_rows) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  int32_t first = 0;
+  for (const auto rows : batch_rows) {
+    batches.push_back(make_batch(first, rows));
+    first += rows;
+  }
+  return serialize_arrow_stream(schema, batches);
+}
+
+// a descriptor to read input from, closed by the test
+int input_fd(const std::string& input) {
+  int fds[2];
+  if (pipe(fds)) {
+    throw std::runtime_error("Could not create a pipe");
+  }
+  EXPECT_EQ(static_cast<ssize_t>(input.size()), write(fds[1], input.data(), input.size()));
+  close(fds[1]);
+  return fds[0];
+}
+
+struct Load {
+  size_t rows;
+  std::vector<int32_t> values;  // decoded off the stream of the load
+};
+
+std::vector<Load> read_loads(const std::string& input, const size_t min_rows) {
+  std::vector<Load> loads;
+  const auto fd = input_fd(input);
+  try {
+    read_arrow_stream(fd, min_rows, [&loads](const std::string& stream, const size_t rows) {
+      Load load{rows, {}};
+      auto buffer = std::make_shared<arrow::Buffer>(reinterpret_cast<const uint8_t*>(stream.data()),
+                                                    static_cast<int64_t>(stream.size()));
+      arrow::io::BufferReader buffer_reader(buffer);
+      std::shared_ptr<arrow::RecordBatchReader> reader;
+      arrow_stream_throw_not_ok(arrow::ipc::RecordBatchStreamReader::Open(&buffer_reader, &reader));
+      std::shared_ptr<arrow::RecordBatch> batch;
+      while (true) {
+        arrow_stream_throw_not_ok(reader->ReadNext(&batch));
+        if (!batch) {
+          break;
+        }
+        const auto column = std::static_pointer_cast<arrow::Int32Array>(batch->column(0));
+        for (int64_t i = 0; i < column->length(); ++i) {
+          load.values.push_back(column->Value(i));
+        }
+      }
+      loads.push_back(load);
+    });
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+  return loads;
+}
+
+void expect_malformed(const std::string& input) {
+  EXPECT_THROW(read_loads(input, 1), std::runtime_error);
+}
+
+}  // namespace
+
+TEST(ArrowStreamReader, Batches) {
+  // loads of at least 10 rows, but for the last one
+  const auto loads = read_loads(make_stream({4, 4, 4, 12, 3}), 10);
+  ASSERT_EQ(size_t(3), loads.size());
+  EXPECT_EQ(size_t(12), loads[0].rows);
+  EXPECT_EQ(size_t(12), loads[1].rows);
+  EXPECT_EQ(size_t(3), loads[2].rows);
+  std::vector<int32_t> values;
+  for (const auto& load : loads) {
+    EXPECT_EQ(load.rows, load.values.size());
+    values.insert(values.end(), load.values.begin(), load.values.end());
+  }
+  std::vector<int32_t> expected(27);
+  std::iota(expected.begin(), expected.end(), 0);
+  EXPECT_EQ(expected, values);
+}
+
+TEST(ArrowStreamReader, EndOfStream) {
+  EXPECT_TRUE(read_loads(make_stream({}), 10).empty());
+}
+
+TEST(ArrowStreamReader, Truncated) {
+  const auto stream = make_stream({3});
+  // no schema, in the length of the schema, in the schema and in the record batch
+  for (const size_t size : {size_t(0), size_t(2), size_t(20), stream.size() - 20}) {
+    expect_malformed(stream.substr(0, size));
+  }
+}
+
+TEST(ArrowStreamReader, Malformed) {
+  expect_malformed(std::string(64, '\x7f'));
+  // a record batch in place of the schema, the schema-only stream ends with the 4 bytes of the end marker
+  const auto stream = make_stream({3});
+  expect_malformed(stream.substr(make_stream({}).size() - 4));
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../Import/BatchPipeline.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <tuple>
+
+TEST(BatchPipeline, FullQueueBlocksPush) {
+  BoundedQueue<int> queue(2);
+  queue.push(0);
+  queue.push(1);
+  std::atomic<bool> pushed{false};
+  std::thread producer([&queue, &pushed] {
+    queue.push(2);
+    pushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_FALSE(pushed);
+  ASSERT_EQ(size_t(2), queue.size());
+  int item{-1};
+  ASSERT_TRUE(queue.pop(item));
+  ASSERT_EQ(0, item);
+  producer.join();
+  ASSERT_TRUE(pushed);
+  ASSERT_EQ(size_t(2), queue.size());
+}
+
+TEST(BatchPipeline, ClosedQueueDrains) {
+  BoundedQueue<int> queue(4);
+  queue.push(1);
+  queue.push(2);
+  queue.close();
+  int item{0};
+  ASSERT_TRUE(queue.pop(item));
+  ASSERT_EQ(1, item);
+  ASSERT_TRUE(queue.pop(item));
+  ASSERT_EQ(2, item);
+  ASSERT_FALSE(queue.pop(item));
+}
+
+// A stalled last stage holds back the producer at the start of the pipeline, with no more items in flight than
+// the queues and the stage in between can hold.
+TEST(BatchPipeline, StalledStageHoldsBackProducer) {
+  const size_t capacity{4};
+  const int item_count{100};
+  BoundedQueue<int> parse_queue(capacity);
+  BoundedQueue<int> load_queue(capacity);
+  std::atomic<int> produced{0};
+  std::thread producer([&] {
+    for (int i = 0; i < item_count; ++i) {
+      parse_queue.push(i);
+      ++produced;
+    }
+    parse_queue.close();
+  });
+  std::thread stage([&] {
+    int item;
+    while (parse_queue.pop(item)) {
+      load_queue.push(item);
+    }
+    load_queue.close();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_GE(static_cast<int>(2 * capacity + 1), produced.load());
+  int item{-1};
+  for (int i = 0; i < item_count; ++i) {
+    ASSERT_TRUE(load_queue.pop(item));
+    ASSERT_EQ(i, item);
+  }
+  ASSERT_FALSE(load_queue.pop(item));
+  producer.join();
+  stage.join();
+  ASSERT_EQ(item_count, produced.load());
+}
+
+TEST(BatchPipeline, OutOfOrderCompletionCommitsContiguousPrefix) {
+  BatchCommitTracker tracker(2);
+  BatchCommitTracker::PartitionOffsets offsets;
+  size_t messages{0};
+  // batches 2 and 1 of worker 0 finish before batch 0, nothing may be committed yet
+  std::tie(offsets, messages) = tracker.complete(0, 2, {{0, 29}, {2, 7}}, 10);
+  ASSERT_TRUE(offsets.empty());
+  ASSERT_EQ(size_t(0), messages);
+  std::tie(offsets, messages) = tracker.complete(0, 1, {{0, 19}}, 10);
+  ASSERT_TRUE(offsets.empty());
+  ASSERT_EQ(size_t(0), messages);
+  // the batches of another worker are committed on their own
+  std::tie(offsets, messages) = tracker.complete(1, 0, {{1, 4}}, 5);
+  ASSERT_EQ(BatchCommitTracker::PartitionOffsets({{1, 4}}), offsets);
+  ASSERT_EQ(size_t(5), messages);
+  // batch 0 releases the whole prefix, with the latest offset of each partition
+  std::tie(offsets, messages) = tracker.complete(0, 0, {{0, 9}, {2, 3}}, 10);
+  ASSERT_EQ(BatchCommitTracker::PartitionOffsets({{0, 29}, {2, 7}}), offsets);
+  ASSERT_EQ(size_t(30), messages);
+  // batch 4 waits for batch 3 only
+  std::tie(offsets, messages) = tracker.complete(0, 4, {{0, 49}}, 10);
+  ASSERT_TRUE(offsets.empty());
+  std::tie(offsets, messages) = tracker.complete(0, 3, {{0, 39}}, 10);
+  ASSERT_EQ(BatchCommitTracker::PartitionOffsets({{0, 49}}), offsets);
+  ASSERT_EQ(size_t(20), messages);
+}
+
+int main(int argc, char* argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,272 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Shared/mapd_shared_ptr.h"
+#include "gen-cpp/MapD.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+#include <thrift/transport/TSocket.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+#ifndef MAPD_BIN_DIR
+#define MAPD_BIN_DIR "./bin"
+#endif
+
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::transport;
+
+namespace {
+
+// Every node uses three consecutive ports: Thrift, HTTP and Calcite.
+const int BASE_PORT{26274};
+const size_t LEAF_COUNT{2};
+
+pid_t spawn(const std::vector<std::string>& args) {
+  const auto pid = fork();
+  CHECK_NE(pid, -1);
+  if (!pid) {
+    std::vector<char*> argv;
+    for (const auto& arg : args) {
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    execv(argv.front(), argv.data());
+    _exit(127);
+  }
+  return pid;
+}
+
+void run(const std::vector<std::string>& args) {
+  const auto pid = spawn(args);
+  int status{0};
+  CHECK_EQ(pid, waitpid(pid, &status, 0));
+  CHECK(WIFEXITED(status) && !WEXITSTATUS(status)) << args.front() << " failed";
+}
+
+class Connection {
+ public:
+  Connection(const int port) {
+    mapd::shared_ptr<TTransport> socket(new TSocket("localhost", port));
+    transport_.reset(new TBufferedTransport(socket));
+    mapd::shared_ptr<TProtocol> protocol(new TBinaryProtocol(transport_));
+    client_.reset(new MapDClient(protocol));
+    // Starting Calcite takes a while, retry until the server takes connections.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(120);
+    while (true) {
+      try {
+        transport_->open();
+        client_->connect(session_, "mapd", "HyperInteractive", "mapd");
+        break;
+      } catch (const apache::thrift::TException&) {
+        transport_->close();
+        CHECK(std::chrono::steady_clock::now() < deadline) << "Server on port " << port << " didn't start";
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+      }
+    }
+  }
+
+  ~Connection() {
+    try {
+      client_->disconnect(session_);
+    } catch (const apache::thrift::TException&) {
+    }
+    transport_->close();
+  }
+
+  TQueryResult execute(const std::string& query_str) {
+    TQueryResult result;
+    client_->sql_execute(result, session_, query_str, true, "", -1, -1);
+    return result;
+  }
+
+  int64_t executeInt(const std::string& query_str) {
+    const auto result = execute(query_str);
+    CHECK_EQ(size_t(1), result.row_set.columns.size());
+    CHECK_EQ(size_t(1), result.row_set.columns.front().data.int_col.size());
+    return result.row_set.columns.front().data.int_col.front();
+  }
+
+ private:
+  mapd::shared_ptr<TTransport> transport_;
+  std::unique_ptr<MapDClient> client_;
+  TSessionId session_;
+};
+
+// An aggregator and LEAF_COUNT leaves, each a mapd_server process on localhost.
+class LocalCluster {
+ public:
+  LocalCluster() : base_path_(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(base_path_);
+    const auto cluster_file = (base_path_ / "cluster.conf").string();
+    std::ofstream cluster_config(cluster_file);
+    cluster_config << "[";
+    for (size_t leaf_idx = 0; leaf_idx < LEAF_COUNT; ++leaf_idx) {
+      cluster_config << (leaf_idx ? ", " : "") << "{\"host\": \"localhost\", \"port\": " << leafPort(leaf_idx)
+                     << ", \"role\": \"dbleaf\"}";
+    }
+    cluster_config << "]";
+    cluster_config.close();
+    for (size_t leaf_idx = 0; leaf_idx < LEAF_COUNT; ++leaf_idx) {
+      startNode("leaf" + std::to_string(leaf_idx), leafPort(leaf_idx), "--string-servers", cluster_file);
+    }
+    startNode("aggregator", BASE_PORT, "--cluster", cluster_file);
+  }
+
+  ~LocalCluster() {
+    for (const auto pid : pids_) {
+      kill(pid, SIGTERM);
+    }
+    for (const auto pid : pids_) {
+      waitpid(pid, nullptr, 0);
+    }
+    boost::filesystem::remove_all(base_path_);
+  }
+
+  static int leafPort(const size_t leaf_idx) { return BASE_PORT + 10 * (leaf_idx + 1); }
+
+ private:
+  void startNode(const std::string& name, const int port, const std::string& role_flag, const std::string& config) {
+    const auto data_path = (base_path_ / name).string();
+    boost::filesystem::create_directories(data_path);
+    run({MAPD_BIN_DIR "/initdb", "-f", "--skip-geo", data_path});
+    pids_.push_back(spawn({MAPD_BIN_DIR "/mapd_server",
+                           data_path,
+                           "--cpu",
+                           "--port",
+                           std::to_string(port),
+                           "--http-port",
+                           std::to_string(port + 1),
+                           "--calcite-port",
+                           std::to_string(port + 2),
+                           role_flag,
+                           config}));
+  }
+
+  const boost::filesystem::path base_path_;
+  std::vector<pid_t> pids_;
+};
+
+std::unique_ptr<LocalCluster> g_cluster_nodes;
+
+}  // namespace
+
+class DistributedTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { g_cluster_nodes.reset(new LocalCluster()); }
+
+  static void TearDownTestCase() { g_cluster_nodes.reset(); }
+};
+
+TEST_F(DistributedTest, ShardedLoadAndAggregate) {
+  Connection aggregator(BASE_PORT);
+  aggregator.execute("DROP TABLE IF EXISTS dist_test;");
+  aggregator.execute(
+      "CREATE TABLE dist_test (k INT, s TEXT ENCODING DICT(32), v BIGINT, SHARD KEY (s)) WITH (shard_count = " +
+      std::to_string(2 * LEAF_COUNT) + ");");
+  // Every string twice, so that both rows of a key must land on the same leaf.
+  for (int i = 0; i < 40; ++i) {
+    aggregator.execute("INSERT INTO dist_test VALUES (" + std::to_string(i) + ", 'str" + std::to_string(i % 20) +
+                       "', " + std::to_string(i * 10) + ");");
+  }
+  EXPECT_EQ(int64_t(40), aggregator.executeInt("SELECT COUNT(*) FROM dist_test;"));
+  EXPECT_EQ(int64_t(7800), aggregator.executeInt("SELECT SUM(v) FROM dist_test;"));
+  EXPECT_EQ(int64_t(39), aggregator.executeInt("SELECT MAX(k) FROM dist_test;"));
+  EXPECT_EQ(int64_t(2), aggregator.executeInt("SELECT COUNT(*) FROM dist_test WHERE s = 'str7';"));
+  EXPECT_EQ(int64_t(2),
+            aggregator.executeInt("SELECT COUNT(*) AS n FROM dist_test GROUP BY s ORDER BY n DESC LIMIT 1;"));
+  EXPECT_EQ(int64_t(580),
+            aggregator.executeInt("SELECT SUM(v) AS total FROM dist_test GROUP BY s ORDER BY total DESC LIMIT 1;"));
+
+  int64_t leaf_row_count{0};
+  int64_t leaf_key_count{0};
+  for (size_t leaf_idx = 0; leaf_idx < LEAF_COUNT; ++leaf_idx) {
+    Connection leaf(LocalCluster::leafPort(leaf_idx));
+    const auto row_count = leaf.executeInt("SELECT COUNT(*) FROM dist_test;");
+    EXPECT_LT(int64_t(0), row_count);
+    leaf_row_count += row_count;
+    leaf_key_count += leaf.executeInt("SELECT COUNT(DISTINCT s) FROM dist_test;");
+  }
+  EXPECT_EQ(int64_t(40), leaf_row_count);
+  // No key is split across leaves.
+  EXPECT_EQ(int64_t(20), leaf_key_count);
+
+  try {
+    aggregator.execute("SELECT COUNT(DISTINCT k) FROM dist_test;");
+    FAIL() << "Distinct aggregates shouldn't run on the cluster";
+  } catch (const TMapDException& e) {
+    EXPECT_NE(std::string::npos, e.error_msg.find("Distinct aggregates not supported"));
+  }
+  // Both sides are sharded on the join key, every leaf joins its own shards.
+  EXPECT_EQ(int64_t(80), aggregator.executeInt("SELECT COUNT(*) FROM dist_test a JOIN dist_test b ON a.s = b.s;"));
+  try {
+    aggregator.execute("SELECT COUNT(*) FROM dist_test a JOIN dist_test b ON a.k = b.k;");
+    FAIL() << "Joins on columns other than the shard key shouldn't run on the cluster";
+  } catch (const TMapDException& e) {
+    EXPECT_NE(std::string::npos, e.error_msg.find("Joins in distributed mode"));
+  }
+  aggregator.execute("DROP TABLE dist_test;");
+}
+
+TEST_F(DistributedTest, ReplicatedAndRoundRobin) {
+  Connection aggregator(BASE_PORT);
+  aggregator.execute("DROP TABLE IF EXISTS dist_rr;");
+  aggregator.execute("DROP TABLE IF EXISTS dist_repl;");
+  aggregator.execute("CREATE TABLE dist_rr (x INT);");
+  aggregator.execute("CREATE TABLE dist_repl (x INT) WITH (partitions = 'REPLICATED');");
+  for (int i = 0; i < 10; ++i) {
+    aggregator.execute("INSERT INTO dist_rr VALUES (" + std::to_string(i) + ");");
+    aggregator.execute("INSERT INTO dist_repl VALUES (" + std::to_string(i) + ");");
+  }
+  EXPECT_EQ(int64_t(10), aggregator.executeInt("SELECT COUNT(*) FROM dist_rr;"));
+  EXPECT_EQ(int64_t(45), aggregator.executeInt("SELECT SUM(x) FROM dist_rr;"));
+  // Every leaf has all the rows of dist_repl, the aggregator must not add them up.
+  EXPECT_EQ(int64_t(10), aggregator.executeInt("SELECT COUNT(*) FROM dist_repl;"));
+  EXPECT_EQ(int64_t(45), aggregator.executeInt("SELECT SUM(x) FROM dist_repl;"));
+  EXPECT_EQ(int64_t(10), aggregator.executeInt("SELECT COUNT(*) FROM dist_repl a JOIN dist_repl b ON a.x = b.x;"));
+  EXPECT_EQ(int64_t(10), aggregator.executeInt("SELECT COUNT(*) FROM dist_rr a JOIN dist_repl b ON a.x = b.x;"));
+  EXPECT_EQ(int64_t(9),
+            aggregator.executeInt("SELECT COUNT(*) FROM dist_rr a JOIN dist_repl b ON a.x = b.x + 1 WHERE b.x < 9;"));
+  try {
+    aggregator.execute("SELECT COUNT(*) FROM dist_rr a JOIN dist_rr b ON a.x = b.x;");
+    FAIL() << "Joins between round robin tables shouldn't run on the cluster";
+  } catch (const TMapDException& e) {
+    EXPECT_NE(std::string::npos, e.error_msg.find("Joins in distributed mode"));
+  }
+  for (size_t leaf_idx = 0; leaf_idx < LEAF_COUNT; ++leaf_idx) {
+    Connection leaf(LocalCluster::leafPort(leaf_idx));
+    EXPECT_EQ(int64_t(10), leaf.executeInt("SELECT COUNT(*) FROM dist_repl;"));
+    EXPECT_EQ(int64_t(10 / LEAF_COUNT), leaf.executeInt("SELECT COUNT(*) FROM dist_rr;"));
+  }
+  aggregator.execute("DROP TABLE dist_rr;");
+  aggregator.execute("DROP TABLE dist_repl;");
+}
+
+int main(int argc, char* argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
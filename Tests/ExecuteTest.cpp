@@ -19,6 +19,7 @@
 #include "../QueryEngine/ArrowResultSet.h"
 #include "../QueryEngine/Execute.h"
 #include "../QueryEngine/RelAlgExecutionDescriptor.h"
+#include "../QueryEngine/SpillFile.h"
 #include "../QueryRunner/QueryRunner.h"
 #include "../Shared/ConfigResolve.h"
 #include "../SqliteConnector/SqliteConnector.h"
@@ -26,9 +27,12 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/program_options.hpp>
 #include <cmath>
+#include <fstream>
 #include <sstream>
+#include <thread>
 
 #ifndef BASE_PATH
 #define BASE_PATH "./tmp"
@@ -1688,6 +1692,18 @@ TEST(Select, Time) {
     ASSERT_EQ(-2103840000L,
               v<int64_t>(run_simple_agg(
                   "SELECT DATE_TRUNC(week, CAST('1903-05-08 20:15:12' AS TIMESTAMP)) FROM test limit 1;", dt)));
+    ASSERT_EQ(-86400L,
+              v<int64_t>(run_simple_agg(
+                  "SELECT DATE_TRUNC(day, CAST('1969-12-31 00:00:00' AS TIMESTAMP)) FROM test limit 1;", dt)));
+    ASSERT_EQ(-60L,
+              v<int64_t>(run_simple_agg(
+                  "SELECT DATE_TRUNC(minute, CAST('1969-12-31 23:59:30' AS TIMESTAMP)) FROM test limit 1;", dt)));
+    ASSERT_EQ(30L,
+              v<int64_t>(run_simple_agg(
+                  "SELECT EXTRACT(SECOND FROM CAST('1969-12-31 23:59:30' AS TIMESTAMP)) FROM test limit 1;", dt)));
+    ASSERT_EQ(4L,
+              v<int64_t>(run_simple_agg(
+                  "SELECT EXTRACT(QUARTERDAY FROM CAST('1969-12-31 23:59:30' AS TIMESTAMP)) FROM test limit 1;", dt)));
 
     ASSERT_EQ(31536000L,
               v<int64_t>(run_simple_agg(
@@ -2238,6 +2254,62 @@ TEST(Select, Time) {
                                   "EXTRACT(DOW from TIMESTAMPADD(HOUR, -5, TIMESTAMP '2017-05-31 1:11:11')) = 2;",
                                   dt)));
   }
+  // Months, quarters and years of a column are picked from the buckets its range spans when there are at most 16 of
+  // them, the runtime functions are called otherwise. narrow spans 9 months, mid 35 months but 12 quarters and wide
+  // 53 years, from before the epoch.
+  run_ddl_statement("DROP TABLE IF EXISTS datetrunc_buckets;");
+  run_ddl_statement("CREATE TABLE datetrunc_buckets (k INT, narrow TIMESTAMP, mid TIMESTAMP, wide TIMESTAMP);");
+  run_multiple_agg(
+      "INSERT INTO datetrunc_buckets VALUES(1, '2015-11-20 10:00:00', '2014-02-10 00:00:00', '1965-06-15 12:00:00');",
+      ExecutorDeviceType::CPU);
+  run_multiple_agg(
+      "INSERT INTO datetrunc_buckets VALUES(2, '2016-02-29 23:59:59', '2015-08-31 23:59:59', '1999-12-31 23:59:59');",
+      ExecutorDeviceType::CPU);
+  run_multiple_agg(
+      "INSERT INTO datetrunc_buckets VALUES(3, '2016-03-01 00:00:00', '2016-11-01 00:00:00', '2000-01-01 00:00:00');",
+      ExecutorDeviceType::CPU);
+  run_multiple_agg(
+      "INSERT INTO datetrunc_buckets VALUES(4, '2016-07-15 08:30:00', '2016-12-31 23:59:59', '2017-05-05 05:05:05');",
+      ExecutorDeviceType::CPU);
+  struct BucketedTime {
+    std::string column;
+    int k;
+    int64_t month;
+    int64_t quarter;
+    int64_t year;
+    int64_t month_of_year;
+    int64_t quarter_of_year;
+    int64_t year_value;
+  };
+  const std::vector<BucketedTime> bucketed_times{
+      {"narrow", 1, 1446336000, 1443657600, 1420070400, 11, 4, 2015},
+      {"narrow", 2, 1454284800, 1451606400, 1451606400, 2, 1, 2016},
+      {"narrow", 3, 1456790400, 1451606400, 1451606400, 3, 1, 2016},
+      {"narrow", 4, 1467331200, 1467331200, 1451606400, 7, 3, 2016},
+      {"mid", 1, 1391212800, 1388534400, 1388534400, 2, 1, 2014},
+      {"mid", 2, 1438387200, 1435708800, 1420070400, 8, 3, 2015},
+      {"mid", 3, 1477958400, 1475280000, 1451606400, 11, 4, 2016},
+      {"mid", 4, 1480550400, 1475280000, 1451606400, 12, 4, 2016},
+      {"wide", 1, -144720000, -149990400, -157766400, 6, 2, 1965},
+      {"wide", 2, 944006400, 938736000, 915148800, 12, 4, 1999},
+      {"wide", 3, 946684800, 946684800, 946684800, 1, 1, 2000},
+      {"wide", 4, 1493596800, 1491004800, 1483228800, 5, 2, 2017}};
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (const auto& t : bucketed_times) {
+      const auto select = [&t, dt](const std::string& expr) {
+        return v<int64_t>(run_simple_agg(
+            "SELECT " + expr + " FROM datetrunc_buckets WHERE k = " + std::to_string(t.k) + ";", dt));
+      };
+      ASSERT_EQ(t.month, select("DATE_TRUNC(month, " + t.column + ")"));
+      ASSERT_EQ(t.quarter, select("DATE_TRUNC(quarter, " + t.column + ")"));
+      ASSERT_EQ(t.year, select("DATE_TRUNC(year, " + t.column + ")"));
+      ASSERT_EQ(t.month_of_year, select("EXTRACT(MONTH FROM " + t.column + ")"));
+      ASSERT_EQ(t.quarter_of_year, select("EXTRACT(QUARTER FROM " + t.column + ")"));
+      ASSERT_EQ(t.year_value, select("EXTRACT(YEAR FROM " + t.column + ")"));
+    }
+  }
+  run_ddl_statement("DROP TABLE datetrunc_buckets;");
 }
 
 TEST(Select, In) {
@@ -2461,6 +2533,61 @@ TEST(Select, ColumnWidths) {
   }
 }
 
+TEST(Select, DateInDaysEncoding) {
+  run_ddl_statement("DROP TABLE IF EXISTS date_days;");
+  run_ddl_statement("CREATE TABLE date_days (d16 DATE ENCODING DAYS(16), d32 DATE ENCODING DAYS(32), d DATE);");
+  run_multiple_agg("INSERT INTO date_days VALUES('1901-12-14', '1901-12-14', '1901-12-14');", ExecutorDeviceType::CPU);
+  run_multiple_agg("INSERT INTO date_days VALUES('1969-12-31', '1969-12-31', '1969-12-31');", ExecutorDeviceType::CPU);
+  run_multiple_agg("INSERT INTO date_days VALUES('2017-06-15', '2017-06-15', '2017-06-15');", ExecutorDeviceType::CPU);
+  run_multiple_agg("INSERT INTO date_days VALUES(NULL, NULL, NULL);", ExecutorDeviceType::CPU);
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(3), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days WHERE d16 = d;", dt)));
+    ASSERT_EQ(int64_t(3), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days WHERE d32 = d;", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days WHERE d16 IS NULL;", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days WHERE d32 IS NULL;", dt)));
+    ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days WHERE d16 < '2000-01-01';", dt)));
+    ASSERT_EQ(int64_t(-86400),
+              v<int64_t>(run_simple_agg("SELECT MAX(d16) FROM date_days WHERE d16 < '2000-01-01';", dt)));
+    ASSERT_EQ(int64_t(-2147472000), v<int64_t>(run_simple_agg("SELECT MIN(d16) FROM date_days;", dt)));
+    ASSERT_EQ(int64_t(1497484800), v<int64_t>(run_simple_agg("SELECT MAX(d32) FROM date_days;", dt)));
+    ASSERT_EQ(int64_t(2017), v<int64_t>(run_simple_agg("SELECT MAX(EXTRACT(YEAR FROM d16)) FROM date_days;", dt)));
+  }
+  // past the range of DAYS(16), stored as NULL rather than as another date
+  run_multiple_agg("INSERT INTO date_days VALUES('2100-01-01', '2100-01-01', '2100-01-01');", ExecutorDeviceType::CPU);
+  run_ddl_statement("DROP TABLE IF EXISTS date_days_dim;");
+  run_ddl_statement("CREATE TABLE date_days_dim (d16 DATE ENCODING DAYS(16), d32 DATE ENCODING DAYS(32), k INT);");
+  run_multiple_agg("INSERT INTO date_days_dim VALUES('1969-12-31', '1969-12-31', 1);", ExecutorDeviceType::CPU);
+  run_multiple_agg("INSERT INTO date_days_dim VALUES('2017-06-15', '2017-06-15', 2);", ExecutorDeviceType::CPU);
+  run_multiple_agg("INSERT INTO date_days_dim VALUES('2100-01-01', '2100-01-01', 4);", ExecutorDeviceType::CPU);
+  // the inner table is small enough for a trivial loop join, which must not stand in for the hash join
+  const auto saved_trivial_loop_join_threshold = g_trivial_loop_join_threshold;
+  g_trivial_loop_join_threshold = 0;
+  const auto sum_joined = [](const std::string& qual, const ExecutorDeviceType dt) {
+    const auto rows =
+        run_multiple_agg("SELECT SUM(k) FROM date_days, date_days_dim WHERE " + qual + ";", dt, false);
+    const auto crt_row = rows->getNextRow(true, true);
+    CHECK_EQ(size_t(1), crt_row.size());
+    return v<int64_t>(crt_row[0]);
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days WHERE d16 IS NULL;", dt)));
+    ASSERT_EQ(int64_t(2100), v<int64_t>(run_simple_agg("SELECT MAX(EXTRACT(YEAR FROM d32)) FROM date_days;", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM date_days_dim WHERE d16 IS NULL;", dt)));
+    // the dates encoded as days are the inner side of the hash join
+    ASSERT_EQ(int64_t(3), sum_joined("date_days.d = date_days_dim.d16", dt));
+    ASSERT_EQ(int64_t(7), sum_joined("date_days.d = date_days_dim.d32", dt));
+    ASSERT_EQ(int64_t(3), sum_joined("date_days.d16 = date_days_dim.d16", dt));
+    ASSERT_EQ(int64_t(7), sum_joined("date_days.d32 = date_days_dim.d32", dt));
+  }
+  g_trivial_loop_join_threshold = saved_trivial_loop_join_threshold;
+  run_ddl_statement("DROP TABLE date_days_dim;");
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE date_days_8 (d DATE ENCODING DAYS(8));"), std::runtime_error);
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE date_days_ts (t TIMESTAMP ENCODING DAYS(32));"), std::runtime_error);
+  run_ddl_statement("DROP TABLE date_days;");
+}
+
 TEST(Select, TimeInterval) {
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
     SKIP_NO_GPU();
@@ -5813,6 +5940,450 @@ TEST(Delete, ExtraFragment) {
   }
 }
 
+namespace {
+
+// 20000 rows and 18000 distinct (x, y) groups spread over a wide range: the baseline group by buffer sized from
+// the default entry guess overflows on CPU and the kernel has to flush it and resume the scan.
+void create_group_by_overflow_table(const std::string& table_name) {
+  const auto csv_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.csv");
+  {
+    std::ofstream csv(csv_path.string());
+    for (int64_t i = 0; i < 20000; ++i) {
+      const auto x = i % 18000;
+      csv << x << "," << x * 1000003 << "\n";
+    }
+  }
+  run_ddl_statement("DROP TABLE IF EXISTS " + table_name + ";");
+  run_ddl_statement("CREATE TABLE " + table_name + " (x int, y bigint);");
+  run_ddl_statement("COPY " + table_name + " FROM '" + csv_path.string() + "' WITH (header='false');");
+  boost::filesystem::remove(csv_path);
+}
+
+void check_group_by_overflow_results(const std::string& table_name, const ExecutorDeviceType dt) {
+  ASSERT_EQ(int64_t(20000), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM " + table_name + ";", dt)));
+  ASSERT_EQ(
+      int64_t(18000),
+      v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM (SELECT x, y FROM " + table_name + " GROUP BY x, y);", dt)));
+  ASSERT_EQ(int64_t(2000),
+            v<int64_t>(run_simple_agg(
+                "SELECT COUNT(*) FROM (SELECT x, y FROM " + table_name + " GROUP BY x, y HAVING COUNT(*) = 2);", dt)));
+  ASSERT_EQ(int64_t(20000),
+            v<int64_t>(run_simple_agg(
+                "SELECT SUM(n) FROM (SELECT x, y, COUNT(*) AS n FROM " + table_name + " GROUP BY x, y);", dt)));
+  ASSERT_EQ(int64_t(1999),
+            v<int64_t>(run_simple_agg(
+                "SELECT MAX(x) FROM (SELECT x, y FROM " + table_name + " GROUP BY x, y HAVING COUNT(*) = 2);", dt)));
+}
+
+}  // namespace
+
+TEST(Select, GroupByBufferFlush) {
+  create_group_by_overflow_table("group_by_flush_test");
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    check_group_by_overflow_results("group_by_flush_test", dt);
+  }
+  run_ddl_statement("DROP TABLE group_by_flush_test;");
+}
+
+TEST(Select, GroupBySpill) {
+  create_group_by_overflow_table("group_by_spill_test");
+  const auto saved_spill_dir = g_spill_dir;
+  const auto saved_spill_memory_budget = g_spill_memory_budget;
+  const auto spill_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("spill-%%%%-%%%%");
+  boost::filesystem::create_directories(spill_dir);
+  g_spill_dir = spill_dir.string();
+  // every flushed partition goes to disk and every sort spills, one key per run
+  g_spill_memory_budget = 1;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    check_group_by_overflow_results("group_by_spill_test", dt);
+    // sorts whose keys don't fit the budget spill whatever their entry count
+    ASSERT_EQ(int64_t(1999),
+              v<int64_t>(run_simple_agg("SELECT x FROM (SELECT x, y, COUNT(*) AS n FROM group_by_spill_test GROUP BY "
+                                        "x, y) ORDER BY n DESC, x DESC LIMIT 1;",
+                                        dt)));
+    const auto rows = run_multiple_agg(
+        "SELECT x, n FROM (SELECT x, y, COUNT(*) AS n FROM group_by_spill_test GROUP BY x, y) ORDER BY n DESC, x;",
+        dt);
+    ASSERT_EQ(size_t(18000), rows->rowCount());
+    for (int64_t i = 0; i < 18000; ++i) {
+      const auto row = rows->getNextRow(true, true);
+      ASSERT_EQ(i, v<int64_t>(row[0]));
+      ASSERT_EQ(int64_t(i < 2000 ? 2 : 1), v<int64_t>(row[1]));
+    }
+    // the spill files go away with the query
+    EXPECT_TRUE(boost::filesystem::is_empty(spill_dir));
+  }
+  g_spill_dir = saved_spill_dir;
+  g_spill_memory_budget = saved_spill_memory_budget;
+  boost::filesystem::remove_all(spill_dir);
+  run_ddl_statement("DROP TABLE group_by_spill_test;");
+}
+
+TEST(Select, MetadataAggregates) {
+  if (!std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value ||
+      std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value)
+    return;
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("DROP TABLE IF EXISTS metadata_agg_test;");
+    run_ddl_statement(
+        "CREATE TABLE metadata_agg_test (x int, y bigint, z double, f float) WITH (vacuum='delayed', "
+        "fragment_size=10);");
+    for (int i = 1; i <= 50; ++i) {
+      const std::string y_val = i % 7 ? std::to_string(i * 10) : "NULL";
+      run_multiple_agg("INSERT INTO metadata_agg_test VALUES(" + std::to_string(i) + ", " + y_val + ", " +
+                           std::to_string(i * 1.5) + ", " + std::to_string(i * 0.25) + ");",
+                       dt);
+    }
+
+    ASSERT_EQ(int64_t(50), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT MIN(x) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(50), v<int64_t>(run_simple_agg("SELECT MAX(x) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(43), v<int64_t>(run_simple_agg("SELECT COUNT(y) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(10), v<int64_t>(run_simple_agg("SELECT MIN(y) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(500), v<int64_t>(run_simple_agg("SELECT MAX(y) FROM metadata_agg_test;", dt)));
+    // whole fragments pruned or selected
+    ASSERT_EQ(int64_t(30), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM metadata_agg_test WHERE x > 20;", dt)));
+    ASSERT_EQ(int64_t(210), v<int64_t>(run_simple_agg("SELECT MIN(y) FROM metadata_agg_test WHERE x > 20;", dt)));
+    // partially selected fragments are scanned
+    ASSERT_EQ(int64_t(36), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM metadata_agg_test WHERE x >= 15;", dt)));
+    ASSERT_EQ(int64_t(15), v<int64_t>(run_simple_agg("SELECT MIN(x) FROM metadata_agg_test WHERE x >= 15;", dt)));
+    ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg("SELECT MAX(x) FROM metadata_agg_test WHERE x < 3;", dt)));
+    ASSERT_EQ(int64_t(0), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM metadata_agg_test WHERE x > 50;", dt)));
+    ASSERT_EQ(1.5, v<double>(run_simple_agg("SELECT MIN(z) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(75., v<double>(run_simple_agg("SELECT MAX(z) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(0.25f, v<float>(run_simple_agg("SELECT MIN(f) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(12.5f, v<float>(run_simple_agg("SELECT MAX(f) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(15., v<double>(run_simple_agg("SELECT MAX(z) FROM metadata_agg_test WHERE x <= 10;", dt)));
+
+    // the updated and the deleted fragments can't be answered from metadata anymore
+    run_multiple_agg("UPDATE metadata_agg_test SET x = 100 WHERE x = 25;", dt);
+    run_multiple_agg("DELETE FROM metadata_agg_test WHERE x = 50;", dt);
+    ASSERT_EQ(int64_t(49), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(100), v<int64_t>(run_simple_agg("SELECT MAX(x) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(480), v<int64_t>(run_simple_agg("SELECT MAX(y) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(int64_t(10), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM metadata_agg_test WHERE x > 40;", dt)));
+    // an update which lowers the maximum leaves the stats of the chunk as mere bounds
+    run_multiple_agg("UPDATE metadata_agg_test SET z = 2.0, f = 2.0 WHERE x = 49;", dt);
+    ASSERT_EQ(72., v<double>(run_simple_agg("SELECT MAX(z) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(12.f, v<float>(run_simple_agg("SELECT MAX(f) FROM metadata_agg_test;", dt)));
+    ASSERT_EQ(0.25f, v<float>(run_simple_agg("SELECT MIN(f) FROM metadata_agg_test;", dt)));
+
+    run_ddl_statement("DROP TABLE metadata_agg_test;");
+  }
+}
+
+TEST(Select, MetadataApproxCountDistinct) {
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("DROP TABLE IF EXISTS metadata_approx_test;");
+    run_ddl_statement("CREATE TABLE metadata_approx_test (w bigint, str text) WITH (fragment_size=25);");
+    for (int i = 1; i <= 100; ++i) {
+      const std::string w_val = i % 9 ? std::to_string(i * 1000003) : "NULL";
+      run_multiple_agg(
+          "INSERT INTO metadata_approx_test VALUES(" + w_val + ", 'str" + std::to_string(i % 40) + "');", dt);
+    }
+
+    // the chunk sketches, folded to the requested precision, hold the registers the scan would compute
+    for (const std::string query : {"SELECT APPROX_COUNT_DISTINCT(w, 7) FROM metadata_approx_test;",
+                                    "SELECT APPROX_COUNT_DISTINCT(w, 10) FROM metadata_approx_test;",
+                                    "SELECT APPROX_COUNT_DISTINCT(str, 10) FROM metadata_approx_test;",
+                                    "SELECT APPROX_COUNT_DISTINCT(w, 10) FROM metadata_approx_test WHERE w > 0;",
+                                    "SELECT APPROX_COUNT_DISTINCT(w) FROM metadata_approx_test;"}) {
+      g_enable_metadata_aggregates = false;
+      const auto scanned = v<int64_t>(run_simple_agg(query, dt));
+      g_enable_metadata_aggregates = true;
+      ASSERT_EQ(scanned, v<int64_t>(run_simple_agg(query, dt)));
+    }
+    ASSERT_EQ(int64_t(0),
+              v<int64_t>(run_simple_agg("SELECT APPROX_COUNT_DISTINCT(w, 10) FROM metadata_approx_test WHERE w < 0;",
+                                        dt)));
+
+    run_ddl_statement("DROP TABLE metadata_approx_test;");
+  }
+}
+
+TEST(Select, MaterializedView) {
+  if (!std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value ||
+      std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value)
+    return;
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("DROP MATERIALIZED VIEW IF EXISTS mv_test;");
+    run_ddl_statement("DROP TABLE IF EXISTS mv_source;");
+    run_ddl_statement(
+        "CREATE TABLE mv_source (x int, g int, region text encoding dict) WITH (vacuum='delayed', fragment_size=10);");
+    auto insert_rows = [dt](const int first, const int last) {
+      for (int i = first; i <= last; ++i) {
+        run_multiple_agg("INSERT INTO mv_source VALUES(" + std::to_string(i) + ", " + std::to_string(i % 3) + ", '" +
+                             (i % 2 ? "a" : "b") + "');",
+                         dt);
+      }
+    };
+    insert_rows(1, 30);
+    run_ddl_statement(
+        "CREATE MATERIALIZED VIEW mv_test AS SELECT g, region, SUM(x) AS sx, COUNT(*) AS n, MIN(x) AS mn, MAX(x) AS mx "
+        "FROM mv_source GROUP BY g, region;");
+    ASSERT_EQ(int64_t(6), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_test;", dt)));
+    ASSERT_EQ(int64_t(465), v<int64_t>(run_simple_agg("SELECT SUM(x) FROM mv_source;", dt)));
+    ASSERT_EQ(int64_t(10),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_source GROUP BY g ORDER BY g LIMIT 1;", dt)));
+    ASSERT_EQ(int64_t(29),
+              v<int64_t>(run_simple_agg("SELECT MAX(x) AS m FROM mv_source GROUP BY region ORDER BY m LIMIT 1;", dt)));
+
+    // appended rows go to the source only, the refresh adds the partial aggregates of the new rows
+    insert_rows(31, 60);
+    ASSERT_EQ(int64_t(1830), v<int64_t>(run_simple_agg("SELECT SUM(x) FROM mv_source;", dt)));
+    run_ddl_statement("REFRESH MATERIALIZED VIEW mv_test;");
+    ASSERT_EQ(int64_t(12), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_test;", dt)));
+    ASSERT_EQ(int64_t(1830), v<int64_t>(run_simple_agg("SELECT SUM(x) FROM mv_source;", dt)));
+    ASSERT_EQ(int64_t(20),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_source GROUP BY g ORDER BY g LIMIT 1;", dt)));
+    ASSERT_EQ(int64_t(59),
+              v<int64_t>(run_simple_agg("SELECT MAX(x) AS m FROM mv_source GROUP BY region ORDER BY m LIMIT 1;", dt)));
+
+    // deletes make the refresh start over
+    run_multiple_agg("DELETE FROM mv_source WHERE x = 60;", dt);
+    ASSERT_EQ(int64_t(1770), v<int64_t>(run_simple_agg("SELECT SUM(x) FROM mv_source;", dt)));
+    run_ddl_statement("REFRESH MATERIALIZED VIEW mv_test;");
+    ASSERT_EQ(int64_t(6), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_test;", dt)));
+    ASSERT_EQ(int64_t(1770), v<int64_t>(run_simple_agg("SELECT SUM(x) FROM mv_source;", dt)));
+    ASSERT_EQ(int64_t(19),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_source GROUP BY g ORDER BY g LIMIT 1;", dt)));
+
+    // an up to date view answers the query with the results of the source
+    const auto saved_enable_materialized_view_rewrite = g_enable_materialized_view_rewrite;
+    for (const auto& query : {"SELECT SUM(x) FROM mv_source;",
+                              "SELECT COUNT(*) FROM mv_source WHERE region = 'a';",
+                              "SELECT SUM(x) AS s FROM mv_source GROUP BY g ORDER BY s LIMIT 1;",
+                              "SELECT MIN(x) AS m FROM mv_source GROUP BY region ORDER BY m DESC LIMIT 1;"}) {
+      g_enable_materialized_view_rewrite = true;
+      const auto rewritten = v<int64_t>(run_simple_agg(query, dt));
+      g_enable_materialized_view_rewrite = false;
+      ASSERT_EQ(v<int64_t>(run_simple_agg(query, dt)), rewritten);
+    }
+    g_enable_materialized_view_rewrite = saved_enable_materialized_view_rewrite;
+
+    // only the refreshes write to the view
+    EXPECT_THROW(run_multiple_agg("INSERT INTO mv_test VALUES(0, 'a', 1000000, 1, 0, 0);", dt), std::runtime_error);
+    EXPECT_THROW(run_multiple_agg("INSERT INTO mv_test SELECT * FROM mv_test;", dt), std::runtime_error);
+    ASSERT_EQ(int64_t(6), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mv_test;", dt)));
+
+    EXPECT_THROW(run_ddl_statement("DROP TABLE mv_source;"), std::runtime_error);
+    EXPECT_THROW(run_ddl_statement("DROP TABLE mv_test;"), std::runtime_error);
+    run_ddl_statement("DROP MATERIALIZED VIEW mv_test;");
+    run_ddl_statement("DROP TABLE mv_source;");
+  }
+}
+
+TEST(Select, SubqueryReuse) {
+  if (!std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value ||
+      std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value)
+    return;
+
+  const auto saved_subquery_result_cache_bytes = g_subquery_result_cache_bytes;
+  g_subquery_result_cache_bytes = size_t(1) << 20;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("DROP TABLE IF EXISTS subquery_reuse;");
+    run_ddl_statement("CREATE TABLE subquery_reuse (x int, s text encoding dict) WITH (fragment_size=10);");
+    for (int i = 1; i <= 20; ++i) {
+      run_multiple_agg(
+          "INSERT INTO subquery_reuse VALUES(" + std::to_string(i) + ", 's" + std::to_string(i % 5) + "');", dt);
+    }
+    const std::string repeated_subquery{
+        "SELECT SUM(x) FROM subquery_reuse WHERE x > (SELECT AVG(x) FROM subquery_reuse) AND "
+        "x < (SELECT AVG(x) FROM subquery_reuse) + 5;"};
+    const std::string in_subquery{
+        "SELECT COUNT(*) FROM subquery_reuse WHERE s IN (SELECT s FROM subquery_reuse WHERE x > 18);"};
+    // the second run reuses the sub-query results of the first one
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_EQ(int64_t(65), v<int64_t>(run_simple_agg(repeated_subquery, dt)));
+      ASSERT_EQ(int64_t(8), v<int64_t>(run_simple_agg(in_subquery, dt)));
+    }
+    run_multiple_agg("INSERT INTO subquery_reuse VALUES(100, 'new');", dt);
+    ASSERT_EQ(int64_t(85), v<int64_t>(run_simple_agg(repeated_subquery, dt)));
+    ASSERT_EQ(int64_t(9), v<int64_t>(run_simple_agg(in_subquery, dt)));
+    run_multiple_agg("DELETE FROM subquery_reuse WHERE x = 100;", dt);
+    ASSERT_EQ(int64_t(65), v<int64_t>(run_simple_agg(repeated_subquery, dt)));
+    ASSERT_EQ(int64_t(8), v<int64_t>(run_simple_agg(in_subquery, dt)));
+    run_ddl_statement("DROP TABLE subquery_reuse;");
+  }
+  g_subquery_result_cache_bytes = saved_subquery_result_cache_bytes;
+}
+
+// Writers inserting concurrently into a table created through the catalog, whose rowids are virtual, don't shift the
+// rowids of the rows already in it.
+TEST(Select, ConcurrentInsertRowIds) {
+  run_ddl_statement("DROP TABLE IF EXISTS concurrent_insert_rowid;");
+  run_ddl_statement("CREATE TABLE concurrent_insert_rowid (x int) WITH (fragment_size=100);");
+  const auto& cat = g_session->get_catalog();
+  const auto td = cat.getMetadataForTable("concurrent_insert_rowid");
+  CHECK(td);
+  const auto cd = cat.getMetadataForColumn(td->tableId, "x");
+  CHECK(cd);
+  const int writer_count = 8;
+  const int inserts_per_writer = 20;
+  const int rows_per_insert = 30;
+  const auto insert_concurrently = [&cat, td, cd](const int round) {
+    std::vector<std::thread> writers;
+    for (int w = 0; w < writer_count; ++w) {
+      writers.emplace_back([&cat, td, cd, round, w] {
+        std::vector<int32_t> xs(rows_per_insert);
+        for (int i = 0; i < inserts_per_writer; ++i) {
+          for (int r = 0; r < rows_per_insert; ++r) {
+            xs[r] = ((round * writer_count + w) * inserts_per_writer + i) * rows_per_insert + r;
+          }
+          Fragmenter_Namespace::InsertData insert_data;
+          insert_data.databaseId = cat.get_currentDB().dbId;
+          insert_data.tableId = td->tableId;
+          insert_data.columnIds = {cd->columnId};
+          insert_data.numRows = rows_per_insert;
+          DataBlockPtr x_block;
+          x_block.numbersPtr = reinterpret_cast<int8_t*>(&xs[0]);
+          insert_data.data = {x_block};
+          td->fragmenter->insertDataNoCheckpoint(insert_data);
+        }
+      });
+    }
+    for (auto& writer : writers) {
+      writer.join();
+    }
+  };
+  const auto get_x_by_rowid = [] {
+    std::map<int64_t, int64_t> x_by_rowid;
+    const auto rows = run_multiple_agg("SELECT rowid, x FROM concurrent_insert_rowid;", ExecutorDeviceType::CPU);
+    while (true) {
+      const auto crt_row = rows->getNextRow(true, true);
+      if (crt_row.empty()) {
+        break;
+      }
+      EXPECT_TRUE(x_by_rowid.emplace(v<int64_t>(crt_row[0]), v<int64_t>(crt_row[1])).second);
+    }
+    return x_by_rowid;
+  };
+  const size_t rows_per_round = writer_count * inserts_per_writer * rows_per_insert;
+  insert_concurrently(0);
+  const auto first_x_by_rowid = get_x_by_rowid();
+  ASSERT_EQ(rows_per_round, first_x_by_rowid.size());
+  insert_concurrently(1);
+  const auto x_by_rowid = get_x_by_rowid();
+  ASSERT_EQ(2 * rows_per_round, x_by_rowid.size());
+  // the rowids are the offsets of the rows, and the rows of the first round kept theirs
+  ASSERT_EQ(int64_t(0), x_by_rowid.begin()->first);
+  ASSERT_EQ(static_cast<int64_t>(2 * rows_per_round - 1), x_by_rowid.rbegin()->first);
+  for (const auto& rowid_x : first_x_by_rowid) {
+    ASSERT_EQ(rowid_x.second, x_by_rowid.at(rowid_x.first));
+  }
+  std::set<int64_t> xs;
+  for (const auto& rowid_x : x_by_rowid) {
+    xs.insert(rowid_x.second);
+  }
+  ASSERT_EQ(2 * rows_per_round, xs.size());
+  run_ddl_statement("DROP TABLE concurrent_insert_rowid;");
+}
+
+TEST(Delete, Vacuum) {
+  if (std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value)
+    return;
+
+  auto insert_op = [](int random_val) -> std::string {
+    std::ostringstream insert_string;
+    insert_string << "insert into vacuum_test values (" << random_val << ", '" << random_val << "', '" << random_val
+                  << "');";
+    return insert_string.str();
+  };
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement(
+        "create table vacuum_test (i1 integer, t1 text encoding none, t2 text) with (vacuum='delayed', "
+        "fragment_size=10);");
+    for (int i = 1; i <= 100; i++) {
+      run_multiple_agg(insert_op(i), dt);
+    }
+    run_multiple_agg("delete from vacuum_test where mod(i1, 3) = 0 or i1 > 95;", dt);
+    run_ddl_statement("optimize table vacuum_test;");
+
+    ASSERT_EQ(int64_t(64), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test;", dt)));
+    ASSERT_EQ(int64_t(3072), v<int64_t>(run_simple_agg("SELECT SUM(i1) FROM vacuum_test;", dt)));
+    ASSERT_EQ(int64_t(95), v<int64_t>(run_simple_agg("SELECT MAX(i1) FROM vacuum_test;", dt)));
+    ASSERT_EQ(int64_t(58),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test WHERE CHAR_LENGTH(t1) = 2;", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test WHERE t1 LIKE '94';", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test WHERE t2 = '94';", dt)));
+
+    // appends go to the compacted last fragment
+    run_multiple_agg(insert_op(101), dt);
+    ASSERT_EQ(int64_t(65), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test;", dt)));
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test WHERE t1 LIKE '101';", dt)));
+
+    run_ddl_statement("drop table vacuum_test;");
+  }
+}
+
+TEST(Delete, VacuumSortColumn) {
+  if (std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value)
+    return;
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement(
+        "create table sort_test (i1 integer, t2 text, t3 text encoding none) with (vacuum='delayed', "
+        "fragment_size=10, sort_column='i1');");
+    for (int i = 100; i >= 1; i--) {
+      const auto str = std::to_string(i);
+      run_multiple_agg("insert into sort_test values (" + str + ", '" + str + "', '" + str + "');", dt);
+    }
+    run_multiple_agg("delete from sort_test where mod(i1, 3) = 0;", dt);
+    run_ddl_statement("optimize table sort_test;");
+
+    ASSERT_EQ(int64_t(67), v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test;", dt)));
+    ASSERT_EQ(int64_t(3367), v<int64_t>(run_simple_agg("SELECT SUM(i1) FROM sort_test;", dt)));
+    // Fragments 0 to 8 hold 6 or 7 rows each after the vacuum. In the order of their keys, fragments 8 to 3 make a
+    // group of 40 rows which fills fragments 3 to 6, and fragments 2 to 0 a group of 20 rows which fills fragments 0
+    // and 1. The last fragment, open for inserts, keeps its rows.
+    ASSERT_EQ(int64_t(71), v<int64_t>(run_simple_agg("SELECT MIN(i1) FROM sort_test WHERE rowid < 10;", dt)));
+    ASSERT_EQ(int64_t(85), v<int64_t>(run_simple_agg("SELECT MAX(i1) FROM sort_test WHERE rowid < 10;", dt)));
+    ASSERT_EQ(int64_t(86),
+              v<int64_t>(run_simple_agg("SELECT MIN(i1) FROM sort_test WHERE rowid >= 10 AND rowid < 20;", dt)));
+    ASSERT_EQ(int64_t(11),
+              v<int64_t>(run_simple_agg("SELECT MIN(i1) FROM sort_test WHERE rowid >= 20 AND rowid < 30;", dt)));
+    ASSERT_EQ(int64_t(70),
+              v<int64_t>(run_simple_agg("SELECT MAX(i1) FROM sort_test WHERE rowid >= 20 AND rowid < 60;", dt)));
+    ASSERT_EQ(int64_t(10), v<int64_t>(run_simple_agg("SELECT MAX(i1) FROM sort_test WHERE rowid >= 60;", dt)));
+    // the strings moved along with their rows
+    ASSERT_EQ(int64_t(1),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test WHERE rowid = 0 AND t2 = '71';", dt)));
+    ASSERT_EQ(int64_t(1),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test WHERE i1 = 50 AND t2 = '50';", dt)));
+    ASSERT_EQ(int64_t(1),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test WHERE i1 = 50 AND t3 LIKE '50';", dt)));
+    ASSERT_EQ(int64_t(1),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test WHERE rowid = 59 AND t3 LIKE '70';", dt)));
+    ASSERT_EQ(int64_t(19),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test WHERE rowid < 20 AND CHAR_LENGTH(t3) = 2;",
+                                        dt)));
+
+    // appends still go to the last fragment
+    run_multiple_agg("insert into sort_test values (0, '0', '0');", dt);
+    ASSERT_EQ(int64_t(1),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sort_test WHERE rowid = 67 AND t3 LIKE '0';", dt)));
+
+    run_ddl_statement("drop table sort_test;");
+  }
+}
+
 TEST(Delete, Joins_ImplicitJoins) {
   if (std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value)
     return;
@@ -6399,6 +6970,87 @@ TEST(Select, GeoSpatial) {
   }
 }
 
+TEST(Select, GeoSpatialJoin) {
+  run_ddl_statement("DROP TABLE IF EXISTS geospatial_join_polys;");
+  run_ddl_statement("DROP TABLE IF EXISTS geospatial_join_points;");
+  run_ddl_statement("CREATE TABLE geospatial_join_polys (id INT, poly POLYGON, p POINT);");
+  run_ddl_statement("CREATE TABLE geospatial_join_points (id INT, p POINT) WITH (fragment_size=2);");
+  for (int i = 0; i < 5; ++i) {
+    const auto x0 = std::to_string(i);
+    const auto x1 = std::to_string(i + 2);
+    run_multiple_agg("INSERT INTO geospatial_join_polys VALUES(" + x0 + ", 'POLYGON((" + x0 + " 0, " + x1 + " 0, " +
+                         x1 + " 2, " + x0 + " 2, " + x0 + " 0))', 'POINT(" + x0 + " 0)');",
+                     ExecutorDeviceType::CPU);
+  }
+  for (int i = 0; i < 8; ++i) {
+    run_multiple_agg("INSERT INTO geospatial_join_points VALUES(" + std::to_string(i) + ", 'POINT(" +
+                         std::to_string(i) + ".5 1)');",
+                     ExecutorDeviceType::CPU);
+  }
+  // the inner table is small enough for a trivial loop join, which must not stand in for a failed grid join
+  const auto saved_trivial_loop_join_threshold = g_trivial_loop_join_threshold;
+  g_trivial_loop_join_threshold = 0;
+  const auto count_joined = [](const std::string& quals, const ExecutorDeviceType dt) {
+    const auto rows = run_multiple_agg(
+        "SELECT COUNT(*) FROM geospatial_join_points a, geospatial_join_polys b WHERE " + quals + ";", dt, false);
+    const auto crt_row = rows->getNextRow(true, true);
+    CHECK_EQ(size_t(1), crt_row.size());
+    return v<int64_t>(crt_row[0]);
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(10), count_joined("ST_Contains(b.poly, a.p)", dt));
+    ASSERT_EQ(int64_t(2), count_joined("ST_Contains(b.poly, a.p) AND b.id = 3", dt));
+    ASSERT_EQ(int64_t(9), count_joined("ST_Distance(b.p, a.p) < 1.2", dt));
+    ASSERT_EQ(int64_t(0), count_joined("ST_Distance(b.p, a.p) < 0.5", dt));
+  }
+  g_trivial_loop_join_threshold = saved_trivial_loop_join_threshold;
+  run_ddl_statement("DROP TABLE geospatial_join_polys;");
+  run_ddl_statement("DROP TABLE geospatial_join_points;");
+}
+
+TEST(Select, GeoSpatialExtentSkipping) {
+  run_ddl_statement("DROP TABLE IF EXISTS geospatial_extent;");
+  run_ddl_statement(
+      "CREATE TABLE geospatial_extent (id INT, p POINT, gp GEOMETRY(POINT, 4326), poly POLYGON) "
+      "WITH (fragment_size=2);");
+  for (int i = 0; i < 8; ++i) {
+    const auto x0 = std::to_string(i);
+    const auto x1 = std::to_string(i + 2);
+    const auto point = "'POINT(" + x0 + ".5 1)'";
+    run_multiple_agg("INSERT INTO geospatial_extent VALUES(" + x0 + ", " + point + ", " + point + ", 'POLYGON((" + x0 +
+                         " 0, " + x1 + " 0, " + x1 + " 2, " + x0 + " 2, " + x0 + " 0))');",
+                     ExecutorDeviceType::CPU);
+  }
+  // Four fragments of two rows, the points of fragment i lie in [2i + 0.5, 2i + 1.5] x [1, 1] and the bounds of its
+  // polygons in [2i, 2i + 3] x [0, 2]. Returns the count and the number of fragments ruled out by their extents.
+  const auto executor = Executor::getExecutor(g_session->get_catalog().get_currentDB().dbId);
+  const auto count_and_skipped = [&executor](const std::string& filter, const ExecutorDeviceType dt) {
+    const auto skipped_before = executor->getSpatialExtentSkippedFragmentCount();
+    const auto count = v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM geospatial_extent WHERE " + filter + ";", dt));
+    return std::make_pair(count, executor->getSpatialExtentSkippedFragmentCount() - skipped_before);
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(std::make_pair(int64_t(3), size_t(2)),
+              count_and_skipped("ST_Contains(ST_GeomFromText('POLYGON((2 0, 5 0, 5 2, 2 2, 2 0))'), p)", dt));
+    ASSERT_EQ(std::make_pair(int64_t(3), size_t(2)),
+              count_and_skipped("ST_Contains(ST_GeomFromText('POLYGON((2 0, 5 0, 5 2, 2 2, 2 0))', 4326), gp)", dt));
+    ASSERT_EQ(std::make_pair(int64_t(0), size_t(4)),
+              count_and_skipped("ST_Contains(ST_GeomFromText('POLYGON((20 0, 25 0, 25 2, 20 0))'), p)", dt));
+    ASSERT_EQ(std::make_pair(int64_t(2), size_t(3)),
+              count_and_skipped("ST_Contains(poly, ST_GeomFromText('POINT(3.5 1)'))", dt));
+    ASSERT_EQ(std::make_pair(int64_t(3), size_t(0)),
+              count_and_skipped("ST_XMin(poly) >= 2 AND ST_XMax(poly) <= 6", dt));
+    ASSERT_EQ(std::make_pair(int64_t(1), size_t(2)), count_and_skipped("ST_XMax(poly) < 3", dt));
+    ASSERT_EQ(std::make_pair(int64_t(0), size_t(0)), count_and_skipped("ST_YMin(poly) > 1", dt));
+    ASSERT_EQ(std::make_pair(int64_t(0), size_t(4)), count_and_skipped("ST_YMax(poly) > 2", dt));
+    // without a spatial filter every fragment is dispatched
+    ASSERT_EQ(std::make_pair(int64_t(8), size_t(0)), count_and_skipped("id >= 0", dt));
+  }
+  run_ddl_statement("DROP TABLE geospatial_extent;");
+}
+
 TEST(Rounding, ROUND) {
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
     SKIP_NO_GPU();
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../ThriftHandler/QueryResultCache.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+TRowSet make_row_set(const std::vector<int64_t>& values) {
+  TRowSet row_set;
+  row_set.is_columnar = true;
+  TColumn column;
+  column.data.int_col = values;
+  column.nulls = std::vector<bool>(values.size(), false);
+  row_set.columns.push_back(column);
+  return row_set;
+}
+
+}  // namespace
+
+TEST(QueryResultCache, HitAndMiss) {
+  QueryResultCache cache(1 << 20);
+  TRowSet row_set;
+  ASSERT_FALSE(cache.get(row_set, "plan", "1:0:0;"));
+  cache.put("plan", "1:0:0;", make_row_set({1, 2, 3}));
+  ASSERT_TRUE(cache.get(row_set, "plan", "1:0:0;"));
+  ASSERT_TRUE(row_set.is_columnar);
+  ASSERT_EQ(size_t(1), row_set.columns.size());
+  ASSERT_EQ(std::vector<int64_t>({1, 2, 3}), row_set.columns.front().data.int_col);
+  ASSERT_FALSE(cache.get(row_set, "other plan", "1:0:0;"));
+}
+
+TEST(QueryResultCache, StaleVersions) {
+  QueryResultCache cache(1 << 20);
+  TRowSet row_set;
+  cache.put("plan", "1:0:0;", make_row_set({1}));
+  ASSERT_FALSE(cache.get(row_set, "plan", "1:0:1;"));
+  // the stale entry is gone even if asked for with the old versions again
+  ASSERT_FALSE(cache.get(row_set, "plan", "1:0:0;"));
+  cache.put("plan", "1:0:1;", make_row_set({1, 2}));
+  ASSERT_TRUE(cache.get(row_set, "plan", "1:0:1;"));
+  ASSERT_EQ(std::vector<int64_t>({1, 2}), row_set.columns.front().data.int_col);
+}
+
+TEST(QueryResultCache, LruEviction) {
+  const std::vector<int64_t> values(100, 42);
+  QueryResultCache cache(2500);
+  cache.put("plan_a", "1:0:0;", make_row_set(values));
+  cache.put("plan_b", "1:0:0;", make_row_set(values));
+  TRowSet row_set;
+  ASSERT_TRUE(cache.get(row_set, "plan_a", "1:0:0;"));
+  // no room for a third entry, the least recently used one has to go
+  cache.put("plan_c", "1:0:0;", make_row_set(values));
+  ASSERT_TRUE(cache.get(row_set, "plan_a", "1:0:0;"));
+  ASSERT_FALSE(cache.get(row_set, "plan_b", "1:0:0;"));
+  ASSERT_TRUE(cache.get(row_set, "plan_c", "1:0:0;"));
+}
+
+TEST(QueryResultCache, OverBudget) {
+  QueryResultCache cache(64);
+  cache.put("plan", "1:0:0;", make_row_set(std::vector<int64_t>(100, 42)));
+  TRowSet row_set;
+  ASSERT_FALSE(cache.get(row_set, "plan", "1:0:0;"));
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -26,8 +26,10 @@
 #include "../QueryEngine/ResultRows.h"
 #include "../QueryEngine/ResultSet.h"
 #include "../QueryEngine/RuntimeFunctions.h"
+#include "../QueryEngine/SpillFile.h"
 #include "../StringDictionary/StringDictionary.h"
 
+#include <boost/filesystem.hpp>
 #include <boost/make_unique.hpp>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
@@ -2878,6 +2880,120 @@ TEST(ReduceRandomGroups, BaselineHashColumnar_Large_NullVal_0075) {
   test_reduce_random_groups(target_infos, query_mem_desc, gen1, gen2, prct1, prct2, silent, 2);
 }
 
+namespace {
+
+class CyclicNumberGenerator : public NumberGenerator {
+ public:
+  CyclicNumberGenerator(const int64_t period) : crt_(0), period_(period) {}
+
+  int64_t getNextValue() override {
+    const auto crt = (crt_ * 37) % period_ - period_ / 2;
+    ++crt_;
+    return crt;
+  }
+
+  void reset() override { crt_ = 0; }
+
+ private:
+  int64_t crt_;
+  const int64_t period_;
+};
+
+}  // namespace
+
+namespace {
+
+// Sorts on a nullable first key with many ties, broken by the second key, with the nulls of the first key at the
+// requested end. Only the top_n first rows are kept, if top_n is set.
+void check_normalized_keys_multi_col_sort(const bool is_desc, const bool nulls_first, const size_t top_n = 0) {
+  const auto target_infos = generate_random_groups_nullable_target_infos();
+  const auto query_mem_desc = perfect_hash_one_col_desc(target_infos, 8, 0, 399999);
+  const auto row_set_mem_owner = std::make_shared<RowSetMemoryOwner>();
+  ResultSet rs(target_infos, ExecutorDeviceType::CPU, query_mem_desc, row_set_mem_owner, nullptr);
+  const auto storage = rs.allocateStorage();
+  CyclicNumberGenerator generator(101);
+  const auto buff = storage->getUnderlyingBuffer();
+  fill_storage_buffer(buff, target_infos, query_mem_desc, generator, 2);
+  // MAX holds the first key and SUM the second one
+  const auto i64_buff = reinterpret_cast<int64_t*>(buff);
+  const auto target_slot_count = get_slot_count(target_infos);
+  const auto null_val = inline_int_null_val(target_infos[1].sql_type);
+  for (size_t i = 0; i < query_mem_desc.entry_count; i += 2) {
+    const int64_t j = i / 2;
+    i64_buff[slot_offset_rowwise(i, 1, 1, target_slot_count)] = j % 7 ? (j * 37) % 101 - 50 : null_val;
+    i64_buff[slot_offset_rowwise(i, 2, 1, target_slot_count)] = (j * 13) % 1009;
+  }
+  std::list<Analyzer::OrderEntry> order_entries;
+  order_entries.emplace_back(2, is_desc, nulls_first);
+  order_entries.emplace_back(3, false, false);
+  rs.sort(order_entries, top_n);
+  size_t row_count{0};
+  size_t null_count{0};
+  bool seen_non_null{false};
+  int64_t prev_first{0};
+  int64_t prev_second{0};
+  while (true) {
+    const auto row = rs.getNextRow(false, false);
+    if (row.empty()) {
+      break;
+    }
+    const auto crt_first = v<int64_t>(row[1]);
+    const auto crt_second = v<int64_t>(row[2]);
+    if (crt_first == null_val) {
+      // the nulls are all before or all after the values
+      ASSERT_EQ(nulls_first, !seen_non_null);
+      ++null_count;
+    } else {
+      ASSERT_TRUE(nulls_first || !null_count);
+      seen_non_null = true;
+    }
+    if (row_count && (crt_first == null_val) == (prev_first == null_val)) {
+      if (crt_first == prev_first) {
+        ASSERT_LE(prev_second, crt_second);
+      } else if (is_desc) {
+        ASSERT_LT(crt_first, prev_first);
+      } else {
+        ASSERT_GT(crt_first, prev_first);
+      }
+    }
+    prev_first = crt_first;
+    prev_second = crt_second;
+    ++row_count;
+  }
+  if (top_n) {
+    ASSERT_EQ(top_n, row_count);
+    return;
+  }
+  ASSERT_EQ(size_t(200000), row_count);
+  ASSERT_EQ(size_t(200000 / 7 + 1), null_count);
+}
+
+}  // namespace
+
+TEST(Sort, NormalizedKeysMultiCol) {
+  check_normalized_keys_multi_col_sort(true, true);
+  check_normalized_keys_multi_col_sort(false, false);
+  check_normalized_keys_multi_col_sort(false, true, 50000);
+}
+
+TEST(Sort, NormalizedKeysSpill) {
+  const auto saved_spill_dir = g_spill_dir;
+  const auto saved_spill_memory_budget = g_spill_memory_budget;
+  const auto spill_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  g_spill_dir = spill_path.string();
+  // a single merge pass, then runs too many for the budget to merge at once
+  for (const size_t spill_memory_budget : {size_t(1) << 20, size_t(1) << 17}) {
+    g_spill_memory_budget = spill_memory_budget;
+    check_normalized_keys_multi_col_sort(true, true);
+    check_normalized_keys_multi_col_sort(false, false);
+    check_normalized_keys_multi_col_sort(false, true, 50000);
+  }
+  g_spill_dir = saved_spill_dir;
+  g_spill_memory_budget = saved_spill_memory_budget;
+  ASSERT_TRUE(boost::filesystem::is_empty(spill_path));
+  boost::filesystem::remove_all(spill_path);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   auto err = RUN_ALL_TESTS();
@@ -18,9 +18,12 @@
 #include <string>
 #include <cstring>
 
+#include <atomic>
 #include <cstdlib>
 #include <exception>
+#include <limits>
 #include <memory>
+#include <set>
 
 #include <thread>
 
@@ -31,8 +34,13 @@
 #include "../Parser/parser.h"
 #include "../Analyzer/Analyzer.h"
 #include "../Parser/ParserNode.h"
+#include "../DataMgr/ArrayNoneEncoder.h"
 #include "../DataMgr/DataMgr.h"
+#include "../DataMgr/FileMgr/GlobalFileMgr.h"
 #include "../Fragmenter/Fragmenter.h"
+#include "../Fragmenter/InsertOrderFragmenter.h"
+#include "../Fragmenter/InsertWal.h"
+#include "../QueryEngine/HyperLogLog.h"
 #include "../QueryRunner/QueryRunner.h"
 #include "PopulateTableRandom.h"
 #include "ScanTable.h"
@@ -175,6 +183,637 @@ TEST(StorageSmallParallel, AllTypes) {
   ASSERT_NO_THROW(run_ddl_statement("drop table alltypes;"););
 }
 
+TEST(StoragePrewarm, ConcurrentLookup) {
+  const size_t table_count{8};
+  auto& cat = gsession->get_catalog();
+  for (size_t table_idx = 0; table_idx < table_count; ++table_idx) {
+    const auto table_name = "prewarm_test_" + std::to_string(table_idx);
+    ASSERT_NO_THROW(run_ddl_statement("drop table if exists " + table_name + ";"););
+    ASSERT_NO_THROW(run_ddl_statement("create table " + table_name + " (a int, b bigint) with (fragment_size=100);"););
+    populate_table_random(table_name, 1000 + table_idx, cat);
+    cat.get_dataMgr().checkpoint(cat.get_currentDB().dbId, cat.getMetadataForTable(table_name)->tableId);
+  }
+  {
+    // A second catalog of the database has no fragmenters yet, like after a restart.
+    Catalog prewarm_cat(BASE_PATH,
+                        cat.get_currentDB(),
+                        std::shared_ptr<Data_Namespace::DataMgr>(&cat.get_dataMgr(), [](Data_Namespace::DataMgr*) {}),
+                        std::vector<LeafHostInfo>{},
+                        std::shared_ptr<Calcite>(&cat.get_calciteMgr(), [](Calcite*) {}));
+    prewarm_cat.startTablePrewarm(2);
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> lookups;
+    for (size_t thread_idx = 0; thread_idx < 4; ++thread_idx) {
+      lookups.emplace_back([&prewarm_cat, &mismatches, thread_idx, table_count] {
+        for (size_t i = 0; i < 100; ++i) {
+          const auto table_idx = (thread_idx + i) % table_count;
+          const auto td = prewarm_cat.getMetadataForTable("prewarm_test_" + std::to_string(table_idx));
+          if (!td || !td->fragmenter ||
+              td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples() != 1000 + table_idx) {
+            ++mismatches;
+          }
+        }
+      });
+    }
+    for (auto& lookup : lookups) {
+      lookup.join();
+    }
+    EXPECT_EQ(size_t(0), mismatches.load());
+  }
+  for (size_t table_idx = 0; table_idx < table_count; ++table_idx) {
+    ASSERT_NO_THROW(run_ddl_statement("drop table prewarm_test_" + std::to_string(table_idx) + ";"););
+  }
+}
+
+namespace {
+
+size_t append_ints(AbstractBuffer* buffer, std::vector<int32_t> values) {
+  auto data = reinterpret_cast<int8_t*>(&values[0]);
+  buffer->encoder->appendData(data, values.size());
+  return values.size() * sizeof(int32_t);
+}
+
+std::vector<int32_t> read_ints(AbstractBuffer* buffer) {
+  std::vector<int32_t> values(buffer->size() / sizeof(int32_t));
+  buffer->read(reinterpret_cast<int8_t*>(&values[0]), buffer->size());
+  return values;
+}
+
+ChunkMetadata get_chunk_metadata(File_Namespace::GlobalFileMgr& gfm, const ChunkKey& key) {
+  std::vector<std::pair<ChunkKey, ChunkMetadata>> chunk_metadata_vec;
+  gfm.getChunkMetadataVecForKeyPrefix(chunk_metadata_vec, key);
+  CHECK_EQ(size_t(1), chunk_metadata_vec.size());
+  return chunk_metadata_vec.front().second;
+}
+
+}  // namespace
+
+TEST(StoragePageDirectory, Reopen) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "page_directory_test";
+  boost::filesystem::remove_all(data_path);
+  const ChunkKey key{1, 1, 1, 1};
+  const auto page_directory_path = data_path / "table_1_1" / "page_directory";
+  size_t checkpointed_size = 0;
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    auto buffer = gfm.createBuffer(key);
+    buffer->initEncoder(SQLTypeInfo(kINT, false));
+    checkpointed_size += append_ints(buffer, {3, 1, 4, 1, 5, 9, 2, 6});
+    gfm.checkpoint(1, 1);
+    ASSERT_TRUE(boost::filesystem::exists(page_directory_path));
+    // not checkpointed, must not survive the restart
+    append_ints(gfm.getBuffer(key), {-7, 100});
+  }
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    EXPECT_TRUE(gfm.getFileMgr(1, 1)->openedFromPageDirectory());
+    EXPECT_EQ(checkpointed_size, gfm.getBuffer(key)->size());
+    const auto chunk_metadata = get_chunk_metadata(gfm, key);
+    EXPECT_EQ(size_t(8), chunk_metadata.numElements);
+    EXPECT_EQ(1, chunk_metadata.chunkStats.min.intval);
+    EXPECT_EQ(9, chunk_metadata.chunkStats.max.intval);
+    EXPECT_EQ(std::vector<int32_t>({3, 1, 4, 1, 5, 9, 2, 6}), read_ints(gfm.getBuffer(key)));
+    checkpointed_size += append_ints(gfm.getBuffer(key), {-7, 100});
+    gfm.checkpoint(1, 1);
+  }
+  {
+    // flip a byte of the body, the checksum has to reject the page directory
+    FILE* f = fopen(page_directory_path.string().c_str(), "r+b");
+    ASSERT_TRUE(f);
+    fseek(f, 40, SEEK_SET);
+    const int c = fgetc(f);
+    fseek(f, 40, SEEK_SET);
+    fputc(~c & 0xff, f);
+    fclose(f);
+  }
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    EXPECT_FALSE(gfm.getFileMgr(1, 1)->openedFromPageDirectory());
+    EXPECT_EQ(checkpointed_size, gfm.getBuffer(key)->size());
+    const auto chunk_metadata = get_chunk_metadata(gfm, key);
+    EXPECT_EQ(size_t(10), chunk_metadata.numElements);
+    EXPECT_EQ(-7, chunk_metadata.chunkStats.min.intval);
+    EXPECT_EQ(100, chunk_metadata.chunkStats.max.intval);
+    EXPECT_EQ(std::vector<int32_t>({3, 1, 4, 1, 5, 9, 2, 6, -7, 100}), read_ints(gfm.getBuffer(key)));
+  }
+  boost::filesystem::remove_all(data_path);
+}
+
+TEST(StorageChunkSketch, Persisted) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "chunk_sketch_test";
+  boost::filesystem::remove_all(data_path);
+  const ChunkKey int_key{1, 1, 1, 1};
+  const ChunkKey float_key{1, 1, 2, 1};
+  const auto page_directory_path = data_path / "table_1_1" / "page_directory";
+  std::vector<int32_t> values;
+  for (int32_t i = 0; i < 3000; ++i) {
+    values.push_back(i % 1000);
+  }
+  values.push_back(inline_int_null_value<int32_t>());
+  const auto check_sketch = [](const ChunkMetadata& chunk_metadata) {
+    ASSERT_EQ(size_t(1) << CHUNK_SKETCH_BITS, chunk_metadata.distinctSketch.size());
+    const auto ndv = hll_size(&chunk_metadata.distinctSketch[0], CHUNK_SKETCH_BITS);
+    EXPECT_GT(ndv, size_t(850));
+    EXPECT_LT(ndv, size_t(1150));
+  };
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    auto int_buffer = gfm.createBuffer(int_key);
+    int_buffer->initEncoder(SQLTypeInfo(kINT, false));
+    append_ints(int_buffer, values);
+    auto float_buffer = gfm.createBuffer(float_key);
+    float_buffer->initEncoder(SQLTypeInfo(kFLOAT, false));
+    std::vector<float> floats{1.5, 2.5};
+    auto float_data = reinterpret_cast<int8_t*>(&floats[0]);
+    float_buffer->encoder->appendData(float_data, floats.size());
+    check_sketch(get_chunk_metadata(gfm, int_key));
+    EXPECT_TRUE(get_chunk_metadata(gfm, float_key).distinctSketch.empty());
+    EXPECT_TRUE(get_chunk_metadata(gfm, float_key).statsExact);
+    // in place updates leave the stats of the floats as bounds
+    gfm.getBuffer(float_key)->encoder->updateStats(0.5, false);
+    EXPECT_FALSE(get_chunk_metadata(gfm, float_key).statsExact);
+    gfm.checkpoint(1, 1);
+  }
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    EXPECT_TRUE(gfm.getFileMgr(1, 1)->openedFromPageDirectory());
+    check_sketch(get_chunk_metadata(gfm, int_key));
+    EXPECT_TRUE(get_chunk_metadata(gfm, int_key).statsExact);
+    EXPECT_FALSE(get_chunk_metadata(gfm, float_key).statsExact);
+  }
+  boost::filesystem::remove(page_directory_path);
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    EXPECT_FALSE(gfm.getFileMgr(1, 1)->openedFromPageDirectory());
+    check_sketch(get_chunk_metadata(gfm, int_key));
+    EXPECT_FALSE(get_chunk_metadata(gfm, float_key).statsExact);
+    // in place updates can't maintain the sketch
+    gfm.getBuffer(int_key)->encoder->updateStats(int64_t(5000), false);
+    EXPECT_TRUE(get_chunk_metadata(gfm, int_key).distinctSketch.empty());
+    EXPECT_FALSE(get_chunk_metadata(gfm, int_key).statsExact);
+  }
+  boost::filesystem::remove_all(data_path);
+}
+
+TEST(StorageSpatialExtent, Persisted) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "spatial_extent_test";
+  boost::filesystem::remove_all(data_path);
+  const ChunkKey bounds_key{1, 1, 1, 1, 1};
+  const ChunkKey doubles_key{1, 1, 2, 1, 1};
+  const auto make_array = [](const std::vector<double>& values) {
+    auto data = static_cast<int8_t*>(malloc(values.size() * sizeof(double)));
+    std::memcpy(data, &values[0], values.size() * sizeof(double));
+    return ArrayDatum(values.size() * sizeof(double), data, false);
+  };
+  const auto append_arrays = [](File_Namespace::GlobalFileMgr& gfm,
+                                const ChunkKey& key,
+                                const std::vector<ArrayDatum>& arrays) {
+    SQLTypeInfo ti(kARRAY, true);
+    ti.set_subtype(kDOUBLE);
+    auto buffer = gfm.createBuffer(key);
+    buffer->initEncoder(ti);
+    auto index_key = key;
+    index_key.back() = 2;
+    auto encoder = dynamic_cast<ArrayNoneEncoder*>(buffer->encoder.get());
+    CHECK(encoder);
+    encoder->set_index_buf(gfm.createBuffer(index_key));
+    encoder->appendData(&arrays, 0, arrays.size());
+  };
+  const std::vector<double> expected_extent{-74.1, 40.6, 2.4, 48.9};
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    append_arrays(
+        gfm, bounds_key, {make_array({-74.1, 40.6, -73.9, 40.8}), ArrayDatum(), make_array({2.2, 48.8, 2.4, 48.9})});
+    EXPECT_EQ(expected_extent, get_chunk_metadata(gfm, bounds_key).spatialExtent);
+    // only arrays of boxes have an extent
+    append_arrays(gfm, doubles_key, {make_array({-74.1, 40.6, -73.9, 40.8}), make_array({1.0, 2.0})});
+    EXPECT_TRUE(get_chunk_metadata(gfm, doubles_key).spatialExtent.empty());
+    gfm.checkpoint(1, 1);
+  }
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    EXPECT_TRUE(gfm.getFileMgr(1, 1)->openedFromPageDirectory());
+    EXPECT_EQ(expected_extent, get_chunk_metadata(gfm, bounds_key).spatialExtent);
+    EXPECT_TRUE(get_chunk_metadata(gfm, doubles_key).spatialExtent.empty());
+  }
+  boost::filesystem::remove(data_path / "table_1_1" / "page_directory");
+  {
+    File_Namespace::GlobalFileMgr gfm(0, data_path.string());
+    EXPECT_FALSE(gfm.getFileMgr(1, 1)->openedFromPageDirectory());
+    EXPECT_EQ(expected_extent, get_chunk_metadata(gfm, bounds_key).spatialExtent);
+    EXPECT_TRUE(get_chunk_metadata(gfm, doubles_key).spatialExtent.empty());
+  }
+  boost::filesystem::remove_all(data_path);
+}
+
+TEST(StorageInsertWal, Replay) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "insert_wal_test";
+  boost::filesystem::remove_all(data_path);
+  const auto wal_path = data_path / "table_1_1" / "insert_wal";
+  const auto saved_enable_insert_wal = g_enable_insert_wal;
+  const auto saved_insert_wal_checkpoint_ms = g_insert_wal_checkpoint_ms;
+  g_enable_insert_wal = true;
+  g_insert_wal_checkpoint_ms = 3600 * 1000;
+  const ColumnDescriptor int_cd(1, 1, "x", SQLTypeInfo(kINT, false));
+  const ColumnDescriptor str_cd(1, 2, "s", SQLTypeInfo(kTEXT, false));
+  const auto make_fragmenter = [&int_cd, &str_cd](Data_Namespace::DataMgr& data_mgr) {
+    std::vector<Chunk_NS::Chunk> chunk_vec;
+    Chunk_NS::Chunk::translateColumnDescriptorsToChunkVec({&int_cd, &str_cd}, chunk_vec);
+    return std::unique_ptr<InsertOrderFragmenter>(
+        new InsertOrderFragmenter({1, 1}, chunk_vec, &data_mgr, nullptr, 1, -1));
+  };
+  const auto insert_rows = [](InsertOrderFragmenter& fragmenter,
+                              std::vector<int32_t> ints,
+                              std::vector<std::string> strs) {
+    InsertData insert_data;
+    insert_data.databaseId = 1;
+    insert_data.tableId = 1;
+    insert_data.columnIds = {1, 2};
+    insert_data.numRows = ints.size();
+    DataBlockPtr int_block;
+    int_block.numbersPtr = reinterpret_cast<int8_t*>(&ints[0]);
+    DataBlockPtr str_block;
+    str_block.stringsPtr = &strs;
+    insert_data.data = {int_block, str_block};
+    fragmenter.insertData(insert_data);
+  };
+  const auto check_rows = [](InsertOrderFragmenter& fragmenter, const size_t num_rows, const int32_t max_int) {
+    const auto table_info = fragmenter.getFragmentsForQuery();
+    EXPECT_EQ(num_rows, table_info.getPhysicalNumTuples());
+    ASSERT_EQ(size_t(1), table_info.fragments.size());
+    const auto& chunk_metadata = table_info.fragments.front().getChunkMetadataMapPhysical();
+    EXPECT_EQ(1, chunk_metadata.at(1).chunkStats.min.intval);
+    EXPECT_EQ(max_int, chunk_metadata.at(1).chunkStats.max.intval);
+    EXPECT_EQ(num_rows, chunk_metadata.at(2).numElements);
+  };
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    auto fragmenter = make_fragmenter(data_mgr);
+    insert_rows(*fragmenter, {3, 1, 2}, {"a", "bb", ""});
+    insert_rows(*fragmenter, {5, 4}, {"ccc", "d"});
+    // committed to the log only, the table was never checkpointed
+    EXPECT_GT(boost::filesystem::file_size(wal_path), size_t(0));
+  }
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    auto fragmenter = make_fragmenter(data_mgr);
+    check_rows(*fragmenter, 5, 5);
+    EXPECT_EQ(size_t(0), boost::filesystem::file_size(wal_path));
+    insert_rows(*fragmenter, {6}, {"e"});
+  }
+  // the log is replayed even after logging was turned off
+  g_enable_insert_wal = false;
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    auto fragmenter = make_fragmenter(data_mgr);
+    check_rows(*fragmenter, 6, 6);
+    EXPECT_FALSE(boost::filesystem::exists(wal_path));
+  }
+  g_enable_insert_wal = saved_enable_insert_wal;
+  g_insert_wal_checkpoint_ms = saved_insert_wal_checkpoint_ms;
+  boost::filesystem::remove_all(data_path);
+}
+
+TEST(StorageInsertWal, RollbackKeepsLoggedInserts) {
+  const auto saved_enable_insert_wal = g_enable_insert_wal;
+  const auto saved_insert_wal_checkpoint_ms = g_insert_wal_checkpoint_ms;
+  g_enable_insert_wal = true;
+  g_insert_wal_checkpoint_ms = 3600 * 1000;
+  auto& cat = gsession->get_catalog();
+  const auto db_id = cat.get_currentDB().dbId;
+  run_ddl_statement("DROP TABLE IF EXISTS insert_wal_rollback_test;");
+  run_ddl_statement("CREATE TABLE insert_wal_rollback_test (x INT, s TEXT ENCODING NONE);");
+  const auto insert_rows = [db_id](const TableDescriptor* td, std::vector<int32_t> ints, const bool logged) {
+    std::vector<std::string> strs(ints.size(), "s");
+    InsertData insert_data;
+    insert_data.databaseId = db_id;
+    insert_data.tableId = td->tableId;
+    insert_data.columnIds = {1, 2};
+    insert_data.numRows = ints.size();
+    DataBlockPtr int_block;
+    int_block.numbersPtr = reinterpret_cast<int8_t*>(&ints[0]);
+    DataBlockPtr str_block;
+    str_block.stringsPtr = &strs;
+    insert_data.data = {int_block, str_block};
+    if (logged) {
+      td->fragmenter->insertData(insert_data);
+    } else {
+      td->fragmenter->insertDataNoCheckpoint(insert_data);
+    }
+  };
+  auto td = cat.getMetadataForTable("insert_wal_rollback_test");
+  ASSERT_TRUE(td && td->fragmenter);
+  const auto start_epoch = cat.getTableEpoch(db_id, td->tableId);
+  // INSERTs acknowledged from the log while a COPY loads without checkpoints, then the COPY fails
+  insert_rows(td, {1, 2}, true);
+  insert_rows(td, {100, 101, 102}, false);
+  insert_rows(td, {3}, true);
+  EXPECT_EQ(size_t(6), td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples());
+  cat.setTableEpoch(db_id, td->tableId, start_epoch);
+  // the rows of the COPY are gone, the logged ones are replayed into the rolled back table
+  td = cat.getMetadataForTable("insert_wal_rollback_test");
+  ASSERT_TRUE(td && td->fragmenter);
+  const auto table_info = td->fragmenter->getFragmentsForQuery();
+  EXPECT_EQ(size_t(3), table_info.getPhysicalNumTuples());
+  ASSERT_EQ(size_t(1), table_info.fragments.size());
+  const auto& chunk_metadata = table_info.fragments.front().getChunkMetadataMapPhysical();
+  EXPECT_EQ(1, chunk_metadata.at(1).chunkStats.min.intval);
+  EXPECT_EQ(3, chunk_metadata.at(1).chunkStats.max.intval);
+  run_ddl_statement("DROP TABLE insert_wal_rollback_test;");
+  g_enable_insert_wal = saved_enable_insert_wal;
+  g_insert_wal_checkpoint_ms = saved_insert_wal_checkpoint_ms;
+}
+
+namespace {
+
+InsertData make_writer_insert(const size_t writer,
+                              const size_t row_count,
+                              std::vector<int32_t>& ints,
+                              std::vector<std::string>& strs) {
+  ints.assign(row_count, writer);
+  strs.assign(row_count, std::to_string(writer));
+  InsertData insert_data;
+  insert_data.databaseId = 1;
+  insert_data.tableId = 1;
+  insert_data.columnIds = {1, 2};
+  insert_data.numRows = row_count;
+  DataBlockPtr int_block;
+  int_block.numbersPtr = reinterpret_cast<int8_t*>(&ints[0]);
+  DataBlockPtr str_block;
+  str_block.stringsPtr = &strs;
+  insert_data.data = {int_block, str_block};
+  return insert_data;
+}
+
+}  // namespace
+
+// with a materialized rowid, the writers fill open fragments of their own
+TEST(StorageConcurrentInsert, OpenFragments) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "concurrent_insert_test";
+  boost::filesystem::remove_all(data_path);
+  const ColumnDescriptor int_cd(1, 1, "x", SQLTypeInfo(kINT, false));
+  const ColumnDescriptor str_cd(1, 2, "s", SQLTypeInfo(kTEXT, false));
+  const ColumnDescriptor rowid_cd(1, 3, "rowid", SQLTypeInfo(kBIGINT, true));
+  const size_t max_fragment_rows = 1000;
+  const size_t writer_count = 8;
+  const size_t inserts_per_writer = 50;
+  const size_t rows_per_insert = 70;
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    std::vector<Chunk_NS::Chunk> chunk_vec;
+    Chunk_NS::Chunk::translateColumnDescriptorsToChunkVec({&int_cd, &str_cd, &rowid_cd}, chunk_vec);
+    InsertOrderFragmenter fragmenter({1, 1}, chunk_vec, &data_mgr, nullptr, 1, -1, max_fragment_rows);
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < writer_count; ++w) {
+      writers.emplace_back([&fragmenter, w, inserts_per_writer, rows_per_insert] {
+        std::vector<int32_t> ints;
+        std::vector<std::string> strs;
+        for (size_t i = 0; i < inserts_per_writer; ++i) {
+          auto insert_data = make_writer_insert(w, rows_per_insert, ints, strs);
+          // half of them commit through a checkpoint of their own
+          if (i % 2) {
+            fragmenter.insertData(insert_data);
+          } else {
+            fragmenter.insertDataNoCheckpoint(insert_data);
+          }
+        }
+      });
+    }
+    for (auto& writer : writers) {
+      writer.join();
+    }
+    data_mgr.checkpoint(1, 1);
+    const auto table_info = fragmenter.getFragmentsForQuery();
+    EXPECT_EQ(writer_count * inserts_per_writer * rows_per_insert, table_info.getPhysicalNumTuples());
+    std::set<int> fragment_ids;
+    for (const auto& fragment : table_info.fragments) {
+      EXPECT_LE(fragment.getPhysicalNumTuples(), max_fragment_rows);
+      EXPECT_TRUE(fragment_ids.insert(fragment.fragmentId).second);
+      const auto& chunk_metadata = fragment.getChunkMetadataMapPhysical();
+      if (fragment.getPhysicalNumTuples()) {
+        EXPECT_EQ(fragment.getPhysicalNumTuples(), chunk_metadata.at(1).numElements);
+        EXPECT_EQ(fragment.getPhysicalNumTuples(), chunk_metadata.at(2).numElements);
+        EXPECT_EQ(fragment.getPhysicalNumTuples(), chunk_metadata.at(3).numElements);
+      }
+    }
+  }
+  {
+    // every fragment was checkpointed consistently
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    std::vector<Chunk_NS::Chunk> chunk_vec;
+    Chunk_NS::Chunk::translateColumnDescriptorsToChunkVec({&int_cd, &str_cd, &rowid_cd}, chunk_vec);
+    InsertOrderFragmenter fragmenter({1, 1}, chunk_vec, &data_mgr, nullptr, 1, -1, max_fragment_rows);
+    EXPECT_EQ(writer_count * inserts_per_writer * rows_per_insert,
+              fragmenter.getFragmentsForQuery().getPhysicalNumTuples());
+  }
+  boost::filesystem::remove_all(data_path);
+}
+
+// Virtual rowids are the offsets of the rows over the fragments in order. Concurrent writers fill fragments of their
+// own, but a fragment a query sees rows after never grows again, so the rowids of rows already there never shift.
+TEST(StorageConcurrentInsert, VirtualRowIds) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "concurrent_insert_rowid_test";
+  boost::filesystem::remove_all(data_path);
+  const ColumnDescriptor int_cd(1, 1, "x", SQLTypeInfo(kINT, false));
+  const ColumnDescriptor str_cd(1, 2, "s", SQLTypeInfo(kTEXT, false));
+  const size_t max_fragment_rows = 1000;
+  const size_t writer_count = 8;
+  const size_t inserts_per_writer = 50;
+  const size_t rows_per_insert = 70;
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    std::vector<Chunk_NS::Chunk> chunk_vec;
+    Chunk_NS::Chunk::translateColumnDescriptorsToChunkVec({&int_cd, &str_cd}, chunk_vec);
+    InsertOrderFragmenter fragmenter({1, 1}, chunk_vec, &data_mgr, nullptr, 1, -1, max_fragment_rows);
+    std::vector<size_t> seen_rows;  // per fragment, as of the previous check
+    const auto check_fragments = [&fragmenter, &seen_rows] {
+      const auto table_info = fragmenter.getFragmentsForQuery();
+      ASSERT_GE(table_info.fragments.size(), seen_rows.size());
+      bool rows_after{false};
+      for (size_t i = seen_rows.size(); i-- > 0;) {
+        if (rows_after) {
+          EXPECT_EQ(seen_rows[i], table_info.fragments[i].getPhysicalNumTuples());
+        }
+        rows_after = rows_after || seen_rows[i];
+      }
+      seen_rows.clear();
+      for (const auto& fragment : table_info.fragments) {
+        seen_rows.push_back(fragment.getPhysicalNumTuples());
+      }
+    };
+    std::atomic<bool> writers_done{false};
+    std::thread reader([&check_fragments, &writers_done] {
+      while (!writers_done) {
+        check_fragments();
+      }
+    });
+    std::vector<std::thread> writers;
+    for (size_t w = 0; w < writer_count; ++w) {
+      writers.emplace_back([&fragmenter, w, inserts_per_writer, rows_per_insert] {
+        std::vector<int32_t> ints;
+        std::vector<std::string> strs;
+        for (size_t i = 0; i < inserts_per_writer; ++i) {
+          auto insert_data = make_writer_insert(w, rows_per_insert, ints, strs);
+          fragmenter.insertDataNoCheckpoint(insert_data);
+        }
+      });
+    }
+    for (auto& writer : writers) {
+      writer.join();
+    }
+    writers_done = true;
+    reader.join();
+    check_fragments();
+    EXPECT_EQ(writer_count * inserts_per_writer * rows_per_insert,
+              fragmenter.getFragmentsForQuery().getPhysicalNumTuples());
+  }
+  boost::filesystem::remove_all(data_path);
+}
+
+TEST(StorageDeltaStore, Merge) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "delta_store_test";
+  boost::filesystem::remove_all(data_path);
+  const auto saved_enable_delta_store = g_enable_delta_store;
+  const auto saved_delta_store_merge_rows = g_delta_store_merge_rows;
+  const auto saved_delta_store_merge_ms = g_delta_store_merge_ms;
+  g_enable_delta_store = true;
+  g_delta_store_merge_rows = 1000000;
+  g_delta_store_merge_ms = 3600 * 1000;
+  const ColumnDescriptor int_cd(1, 1, "x", SQLTypeInfo(kINT, false));
+  const ColumnDescriptor str_cd(1, 2, "s", SQLTypeInfo(kTEXT, false));
+  const auto make_fragmenter = [&int_cd, &str_cd](Data_Namespace::DataMgr& data_mgr) {
+    std::vector<Chunk_NS::Chunk> chunk_vec;
+    Chunk_NS::Chunk::translateColumnDescriptorsToChunkVec({&int_cd, &str_cd}, chunk_vec);
+    return std::unique_ptr<InsertOrderFragmenter>(
+        new InsertOrderFragmenter({1, 1}, chunk_vec, &data_mgr, nullptr, 1, -1, 1000));
+  };
+  const auto insert_rows = [](InsertOrderFragmenter& fragmenter, const size_t num_rows, const int32_t first) {
+    std::vector<int32_t> ints(num_rows);
+    std::vector<std::string> strs;
+    for (size_t i = 0; i < num_rows; ++i) {
+      ints[i] = first + i;
+      strs.push_back(std::to_string(ints[i]));
+    }
+    InsertData insert_data;
+    insert_data.databaseId = 1;
+    insert_data.tableId = 1;
+    insert_data.columnIds = {1, 2};
+    insert_data.numRows = num_rows;
+    DataBlockPtr int_block;
+    int_block.numbersPtr = reinterpret_cast<int8_t*>(&ints[0]);
+    DataBlockPtr str_block;
+    str_block.stringsPtr = &strs;
+    insert_data.data = {int_block, str_block};
+    fragmenter.insertData(insert_data);
+  };
+  const auto disk_chunk_count = [](Data_Namespace::DataMgr& data_mgr) {
+    std::vector<std::pair<ChunkKey, ChunkMetadata>> chunk_metadata_vec;
+    data_mgr.getChunkMetadataVecForKeyPrefix(chunk_metadata_vec, {1, 1});
+    return chunk_metadata_vec.size();
+  };
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    auto fragmenter = make_fragmenter(data_mgr);
+    for (int32_t i = 0; i < 30; ++i) {
+      insert_rows(*fragmenter, 70, i * 70);
+    }
+    // queries see the rows in memory, checkpoints leave them there
+    EXPECT_EQ(size_t(2100), fragmenter->getFragmentsForQuery().getPhysicalNumTuples());
+    data_mgr.checkpoint(1, 1);
+    EXPECT_EQ(size_t(0), disk_chunk_count(data_mgr));
+
+    fragmenter->mergeDeltaStore();
+    const auto table_info = fragmenter->getFragmentsForQuery();
+    EXPECT_EQ(size_t(2100), table_info.getPhysicalNumTuples());
+    // full fragments rather than one tail per insert
+    ASSERT_EQ(size_t(3), table_info.fragments.size());
+    EXPECT_EQ(size_t(1000), table_info.fragments[0].getPhysicalNumTuples());
+    EXPECT_EQ(size_t(1000), table_info.fragments[1].getPhysicalNumTuples());
+    EXPECT_EQ(size_t(100), table_info.fragments[2].getPhysicalNumTuples());
+    int64_t min_int = std::numeric_limits<int64_t>::max();
+    int64_t max_int = std::numeric_limits<int64_t>::min();
+    for (const auto& fragment : table_info.fragments) {
+      const auto& chunk_metadata = fragment.getChunkMetadataMapPhysical();
+      EXPECT_EQ(fragment.getPhysicalNumTuples(), chunk_metadata.at(2).numElements);
+      min_int = std::min(min_int, static_cast<int64_t>(chunk_metadata.at(1).chunkStats.min.intval));
+      max_int = std::max(max_int, static_cast<int64_t>(chunk_metadata.at(1).chunkStats.max.intval));
+    }
+    EXPECT_EQ(0, min_int);
+    EXPECT_EQ(2099, max_int);
+    EXPECT_EQ(size_t(3 * 2), disk_chunk_count(data_mgr));
+
+    insert_rows(*fragmenter, 50, 2100);
+    const auto delta_table_info = fragmenter->getFragmentsForQuery();
+    EXPECT_EQ(size_t(2150), delta_table_info.getPhysicalNumTuples());
+    ASSERT_EQ(size_t(4), delta_table_info.fragments.size());
+    EXPECT_FALSE(delta_table_info.fragments[2].isDelta);
+    EXPECT_TRUE(delta_table_info.fragments[3].isDelta);
+  }
+  {
+    // not merged when the fragmenter goes away, without the insert log the rows are lost like in a crash
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    auto fragmenter = make_fragmenter(data_mgr);
+    const auto table_info = fragmenter->getFragmentsForQuery();
+    EXPECT_EQ(size_t(2100), table_info.getPhysicalNumTuples());
+    EXPECT_EQ(size_t(3), table_info.fragments.size());
+  }
+  g_enable_delta_store = saved_enable_delta_store;
+  g_delta_store_merge_rows = saved_delta_store_merge_rows;
+  g_delta_store_merge_ms = saved_delta_store_merge_ms;
+  boost::filesystem::remove_all(data_path);
+}
+
+// COPY FROM appends to the fragments without a checkpoint, the delta rows get merged first so that their row ids,
+// which follow those of the fragments, don't shift
+TEST(StorageDeltaStore, CopyDuringDelta) {
+  const auto data_path = boost::filesystem::path(BASE_PATH) / "delta_store_copy_test";
+  boost::filesystem::remove_all(data_path);
+  const auto saved_enable_delta_store = g_enable_delta_store;
+  const auto saved_delta_store_merge_rows = g_delta_store_merge_rows;
+  const auto saved_delta_store_merge_ms = g_delta_store_merge_ms;
+  g_enable_delta_store = true;
+  g_delta_store_merge_rows = 1000000;
+  g_delta_store_merge_ms = 3600 * 1000;
+  const ColumnDescriptor int_cd(1, 1, "x", SQLTypeInfo(kINT, false));
+  const ColumnDescriptor str_cd(1, 2, "s", SQLTypeInfo(kTEXT, false));
+  {
+    Data_Namespace::DataMgr data_mgr(data_path.string(), 0, false, 0);
+    std::vector<Chunk_NS::Chunk> chunk_vec;
+    Chunk_NS::Chunk::translateColumnDescriptorsToChunkVec({&int_cd, &str_cd}, chunk_vec);
+    InsertOrderFragmenter fragmenter({1, 1}, chunk_vec, &data_mgr, nullptr, 1, -1, 100);
+    std::vector<int32_t> ints;
+    std::vector<std::string> strs;
+    // x is the order of the inserts
+    for (size_t i = 0; i < 2; ++i) {
+      auto insert_data = make_writer_insert(i, 60, ints, strs);
+      fragmenter.insertData(insert_data);
+    }
+    ASSERT_TRUE(fragmenter.getFragmentsForQuery().fragments.back().isDelta);
+    auto copy_data = make_writer_insert(2, 50, ints, strs);
+    fragmenter.insertDataNoCheckpoint(copy_data);
+    auto insert_data = make_writer_insert(3, 10, ints, strs);
+    fragmenter.insertData(insert_data);
+    const auto table_info = fragmenter.getFragmentsForQuery();
+    EXPECT_EQ(size_t(180), table_info.getPhysicalNumTuples());
+    int64_t prev_max = std::numeric_limits<int64_t>::min();
+    for (const auto& fragment : table_info.fragments) {
+      // only the insert after the append went to the delta store
+      EXPECT_EQ(&fragment == &table_info.fragments.back(), fragment.isDelta);
+      if (!fragment.getPhysicalNumTuples()) {
+        continue;
+      }
+      const auto& stats = fragment.getChunkMetadataMapPhysical().at(1).chunkStats;
+      EXPECT_LE(prev_max, static_cast<int64_t>(stats.min.intval));
+      prev_max = stats.max.intval;
+    }
+    EXPECT_EQ(3, prev_max);
+  }
+  g_enable_delta_store = saved_enable_delta_store;
+  g_delta_store_merge_rows = saved_delta_store_merge_rows;
+  g_delta_store_merge_ms = saved_delta_store_merge_ms;
+  boost::filesystem::remove_all(data_path);
+}
+
 int main(int argc, char* argv[]) {
   google::InitGoogleLogging(argv[0]);
   ::testing::InitGoogleTest(&argc, argv);
@@ -86,6 +86,60 @@ TEST(StringDictionary, RecoverMany) {
   }
 }
 
+TEST(StringDictionary, SortedRanks) {
+  {
+    StringDictionary string_dict(BASE_PATH, false, false);
+    for (const auto& str : {"pear", "apple", "fig"}) {
+      string_dict.getOrAdd(str);
+    }
+    ASSERT_FALSE(string_dict.hasSortedRanks());
+    const auto sorted_ranks = string_dict.getSortedRanks();
+    ASSERT_EQ(std::vector<int32_t>({2, 0, 1}), *sorted_ranks);
+    ASSERT_TRUE(string_dict.checkpoint());
+  }
+  StringDictionary string_dict(BASE_PATH, false, true);
+  // the order persisted by the checkpoint is picked up on reload
+  ASSERT_TRUE(string_dict.hasSortedRanks());
+  ASSERT_EQ(3, string_dict.getOrAdd("banana"));
+  const auto sorted_ranks = string_dict.getSortedRanks();
+  ASSERT_EQ(std::vector<int32_t>({3, 0, 2, 1}), *sorted_ranks);
+  const auto less_ids = string_dict.getCompare("c", "<", 4);
+  ASSERT_EQ(std::vector<int32_t>({1, 3}), less_ids);
+}
+
+TEST(StringDictionary, GetOrAddBulk) {
+  StringDictionary string_dict(BASE_PATH, true, false);
+  ASSERT_EQ(0, string_dict.getOrAdd("0"));
+  // large enough to be looked up by several threads, with repeats and strings added by other calls
+  std::vector<std::string> strings;
+  for (int i = 0; i < g_op_count; ++i) {
+    strings.push_back(i % 10 ? std::to_string(i / 2) : "");
+  }
+  std::vector<int32_t> ids(strings.size());
+  string_dict.getOrAddBulk(strings, ids.data());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    if (strings[i].empty()) {
+      ASSERT_EQ(std::numeric_limits<int32_t>::min(), ids[i]);
+    } else {
+      ASSERT_EQ(strings[i], string_dict.getString(ids[i]));
+    }
+  }
+  // new strings get ids in the order they come in, whichever thread looked them up
+  for (const int i : {1, 2, 6, 12345, g_op_count / 2 - 1}) {
+    ASSERT_EQ(i, string_dict.getIdOfString(std::to_string(i)));
+  }
+  std::vector<int32_t> again(strings.size());
+  string_dict.getOrAddBulk(strings, again.data());
+  ASSERT_EQ(ids, again);
+  std::vector<uint8_t> narrow(strings.size());
+  string_dict.getOrAddBulk(strings, narrow.data());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    // the ids which don't fit are stored as NULL
+    const int32_t expected = ids[i] >= 0 && ids[i] < 255 ? ids[i] : 255;
+    ASSERT_EQ(expected, static_cast<int32_t>(narrow[i]));
+  }
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   auto err = RUN_ALL_TESTS();
@@ -16,8 +16,14 @@
 
 #include "../Utils/StringLike.h"
 #include "../Utils/Regexp.h"
+#include "../Shared/LatencyHistogram.h"
+#include "../Shared/PrewarmQueue.h"
+#include "../Shared/QueryAdmission.h"
 #include "gtest/gtest.h"
 
+#include <future>
+#include <thread>
+
 TEST(Utils, StringLike) {
   ASSERT_TRUE(string_like("abc", 3, "abc", 3, '\\'));
   ASSERT_FALSE(string_like("abc", 3, "ABC", 3, '\\'));
@@ -43,6 +49,80 @@ TEST(Utils, Regexp) {
   ASSERT_TRUE(regexp_like("hello [", 7, ".*\\[.*", 6, '\\'));
 }
 
+TEST(Utils, LatencyHistogram) {
+  LatencyHistogram histogram;
+  const auto& upper_bounds = LatencyHistogram::bucketUpperBounds();
+  ASSERT_TRUE(std::is_sorted(upper_bounds.begin(), upper_bounds.end()));
+  histogram.record(0);
+  histogram.record(1);
+  histogram.record(2);
+  histogram.record(7);
+  histogram.record(upper_bounds.back() + 1);
+  const auto counts = histogram.getBucketCounts();
+  ASSERT_EQ(upper_bounds.size() + 1, counts.size());
+  ASSERT_EQ(2, counts[0]);
+  ASSERT_EQ(1, counts[1]);
+  ASSERT_EQ(0, counts[2]);
+  ASSERT_EQ(1, counts[3]);
+  ASSERT_EQ(1, counts.back());
+  ASSERT_EQ(5, histogram.getCount());
+  ASSERT_EQ(10 + upper_bounds.back() + 1, histogram.getTotalMs());
+}
+
+TEST(Utils, PrewarmQueue) {
+  std::vector<int> done;
+  std::promise<void> first_started;
+  std::promise<void> promoted;
+  auto promoted_future = promoted.get_future().share();
+  PrewarmQueue queue(
+      [&](const int key) {
+        if (done.empty()) {
+          first_started.set_value();
+          promoted_future.wait();
+        }
+        done.push_back(key);
+      },
+      {1, 2, 3, 4, 5, 3},
+      1);
+  first_started.get_future().wait();
+  ASSERT_EQ(size_t(4), queue.size());
+  // 1 is running, 6 was never queued
+  queue.promote({5, 1, 6, 4});
+  promoted.set_value();
+  queue.join();
+  ASSERT_EQ(std::vector<int>({1, 5, 4, 2, 3}), done);
+  ASSERT_EQ(size_t(0), queue.size());
+}
+
+TEST(Utils, QueryAdmission) {
+  QueryAdmission admission(1, 1);
+  auto running = admission.admit();
+  {
+    // nested queries of a running one don't wait for it
+    const auto nested = admission.admit();
+    ASSERT_EQ(size_t(1), admission.getRunningCount());
+  }
+  std::promise<void> waiter_admitted;
+  std::thread waiter([&admission, &waiter_admitted] {
+    const auto slot = admission.admit();
+    waiter_admitted.set_value();
+  });
+  while (admission.getQueuedCount() < 1) {
+    std::this_thread::yield();
+  }
+  // one running and one waiting, the next one is turned away
+  std::thread rejected([&admission] { ASSERT_THROW(admission.admit(), std::runtime_error); });
+  rejected.join();
+  ASSERT_EQ(1, admission.getRejectedCount());
+  auto admitted_future = waiter_admitted.get_future();
+  ASSERT_EQ(std::future_status::timeout, admitted_future.wait_for(std::chrono::milliseconds(50)));
+  running = QueryAdmission::Slot();
+  admitted_future.wait();
+  waiter.join();
+  ASSERT_EQ(size_t(0), admission.getRunningCount());
+  ASSERT_EQ(size_t(0), admission.getQueuedCount());
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -57,6 +57,7 @@
 #include "QueryEngine/ExtensionFunctionsWhitelist.h"
 #include "QueryEngine/GpuMemUtils.h"
 #include "QueryEngine/JsonAccessors.h"
+#include "Shared/MapDException.h"
 #include "Shared/MapDParameters.h"
 #include "Shared/StringTransform.h"
 #include "Shared/geosupport.h"
@@ -103,11 +104,9 @@ using namespace Lock_Namespace;
 
 #define INVALID_SESSION_ID ""
 
-#define THROW_MAPD_EXCEPTION(errstr) \
-  TMapDException ex;                 \
-  ex.error_msg = errstr;             \
-  LOG(ERROR) << ex.error_msg;        \
-  throw ex;
+extern bool g_leaf;
+
+size_t g_query_result_cache_bytes{0};
 
 std::string generate_random_string(const size_t len);
 
@@ -186,6 +185,10 @@ MapDHandler::MapDHandler(const std::vector<LeafHostInfo>& db_leaves,
                              calcite_session_prefix));
   ExtensionFunctionsWhitelist::add(calcite_->getExtensionFunctionWhitelist());
 
+  if (g_query_result_cache_bytes) {
+    query_result_cache_.reset(new QueryResultCache(g_query_result_cache_bytes));
+  }
+
   if (!data_mgr_->gpusPresent()) {
     executor_device_type_ = ExecutorDeviceType::CPU;
     LOG(ERROR) << "No GPUs detected, falling back to CPU mode";
@@ -206,6 +209,18 @@ MapDHandler::MapDHandler(const std::vector<LeafHostInfo>& db_leaves,
   import_path_ = boost::filesystem::path(base_data_path_) / "mapd_import";
   start_time_ = std::time(nullptr);
 
+  if (mapd_parameters_.lazy_table_activation) {
+    // Tables become queryable right away, their storage gets loaded by the prewarm threads or by the first query.
+    for (const auto& db_meta : SysCatalog::instance().getAllDBMetadata()) {
+      auto cat = Catalog::get(db_meta.dbName);
+      if (cat == nullptr) {
+        cat = std::make_shared<Catalog>(base_data_path_, db_meta, data_mgr_, string_leaves_, calcite_);
+        Catalog::set(db_meta.dbName, cat);
+      }
+      cat->startTablePrewarm(mapd_parameters_.table_prewarm_threads);
+    }
+  }
+
   if (enable_rendering) {
     try {
       render_handler_.reset(new MapDRenderHandler(this, render_mem_bytes, num_gpus, start_gpu));
@@ -220,7 +235,7 @@ MapDHandler::MapDHandler(const std::vector<LeafHostInfo>& db_leaves,
     } catch (const std::exception& e) {
       LOG(ERROR) << "Distributed aggregator support disabled: " << e.what();
     }
-  } else if (g_cluster) {
+  } else if (g_leaf) {
     try {
       leaf_handler_.reset(new MapDLeafHandler(this));
     } catch (const std::exception& e) {
@@ -334,6 +349,9 @@ void MapDHandler::disconnect(const TSessionId& session) {
   if (render_handler_) {
     render_handler_->disconnect(session);
   }
+  if (leaf_handler_) {
+    leaf_handler_->clear_pending_queries(session);
+  }
   auto session_it = MapDHandler::get_session_it(session);
   const auto dbname = session_it->second->get_catalog().get_currentDB().dbName;
   LOG(INFO) << "User " << session_it->second->get_currentUser().userName << " disconnected from database " << dbname
@@ -430,6 +448,45 @@ void MapDHandler::get_hardware_info(TClusterHardwareInfo& _return, const TSessio
   }
 }
 
+namespace {
+
+TLatencyHistogram latency_histogram_to_thrift(const std::string& endpoint, const LatencyHistogram& histogram) {
+  TLatencyHistogram thrift_histogram;
+  thrift_histogram.endpoint = endpoint;
+  thrift_histogram.count = histogram.getCount();
+  thrift_histogram.total_ms = histogram.getTotalMs();
+  thrift_histogram.bucket_upper_bounds_ms = LatencyHistogram::bucketUpperBounds();
+  thrift_histogram.bucket_counts = histogram.getBucketCounts();
+  return thrift_histogram;
+}
+
+}  // namespace
+
+void MapDHandler::get_server_metrics(TServerMetrics& _return, const TSessionId& session) {
+  get_session(session);
+  for (const auto& request_queue : request_queues_) {
+    const auto& thread_manager = request_queue.second;
+    TRequestQueueStatus queue_status;
+    queue_status.transport = request_queue.first;
+    queue_status.worker_count = thread_manager->workerCount();
+    queue_status.idle_worker_count = thread_manager->idleWorkerCount();
+    queue_status.queue_depth = thread_manager->pendingTaskCount();
+    queue_status.max_queue_depth = thread_manager->pendingTaskCountMax();
+    _return.request_queues.push_back(queue_status);
+  }
+  if (query_admission_) {
+    _return.__isset.query_queue = true;
+    _return.query_queue.max_running = query_admission_->getMaxRunning();
+    _return.query_queue.running = query_admission_->getRunningCount();
+    _return.query_queue.max_queued = query_admission_->getMaxQueued();
+    _return.query_queue.queued = query_admission_->getQueuedCount();
+    _return.query_queue.rejected = query_admission_->getRejectedCount();
+  }
+  _return.latencies.push_back(latency_histogram_to_thrift("sql_execute", sql_execute_latency_));
+  _return.latencies.push_back(latency_histogram_to_thrift("render_vega", render_vega_latency_));
+  _return.latencies.push_back(latency_histogram_to_thrift("load_table_binary", load_table_binary_latency_));
+}
+
 void MapDHandler::value_to_thrift_column(const TargetValue& tv, const SQLTypeInfo& ti, TColumn& column) {
   if (ti.is_array()) {
     const auto list_tv = boost::get<std::vector<ScalarTargetValue>>(&tv);
@@ -623,11 +680,14 @@ void MapDHandler::sql_execute(TQueryResult& _return,
                               const std::string& nonce,
                               const int32_t first_n,
                               const int32_t at_most_n) {
+  const auto request_start = timer_start();
+  ScopeGuard record_latency = [&] { sql_execute_latency_.record(timer_stop(request_start)); };
   ScopeGuard reset_was_geo_copy_from = [&] { _was_geo_copy_from = false; };
   if (first_n >= 0 && at_most_n >= 0) {
     THROW_MAPD_EXCEPTION(std::string("At most one of first_n and at_most_n can be set"));
   }
   const auto session_info = MapDHandler::get_session(session);
+  const auto query_slot = admit_query();
   LOG(INFO) << "sql_execute :" << session << ":query_str:" << hide_sensitive_data(query_str);
   if (leaf_aggregator_.leafCount() > 0) {
     if (!agg_handler_) {
@@ -691,6 +751,7 @@ void MapDHandler::sql_execute_df(TDataFrame& _return,
                                  const int32_t device_id,
                                  const int32_t first_n) {
   const auto session_info = MapDHandler::get_session(session);
+  const auto query_slot = admit_query();
   int64_t execution_time_ms = 0;
   if (device_type == TDeviceType::GPU) {
     const auto executor_device_type = session_info.get_executor_device_type();
@@ -1479,6 +1540,28 @@ TSessionId MapDHandler::getInvalidSessionId() const {
   return INVALID_SESSION_ID;
 }
 
+void MapDHandler::registerRequestQueue(const std::string& transport,
+                                       mapd::shared_ptr<apache::thrift::concurrency::ThreadManager> thread_manager) {
+  CHECK(thread_manager);
+  request_queues_.emplace_back(transport, thread_manager);
+}
+
+void MapDHandler::limitConcurrentQueries(const size_t max_running, const size_t max_queued) {
+  query_admission_.reset(new QueryAdmission(max_running, max_queued));
+}
+
+// Connections are served by a thread each and may sit idle, only the queries they run count against the limit.
+QueryAdmission::Slot MapDHandler::admit_query() {
+  if (!query_admission_) {
+    return QueryAdmission::Slot();
+  }
+  try {
+    return query_admission_->admit();
+  } catch (const std::runtime_error& e) {
+    THROW_MAPD_EXCEPTION(e.what());
+  }
+}
+
 void MapDHandler::get_memory(std::vector<TNodeMemoryInfo>& _return,
                              const TSessionId& session,
                              const std::string& memory_level) {
@@ -1580,15 +1663,25 @@ void check_table_not_sharded(const Catalog& cat, const std::string& table_name)
   }
 }
 
+// Only the refreshes write to the table of a materialized view.
+void check_not_materialized_view(const Catalog& cat, const std::string& table_name) {
+  const auto td = cat.getMetadataForTable(table_name, false);
+  if (td && cat.getMaterializedView(td->tableId)) {
+    throw std::runtime_error(table_name + " is a materialized view.  Use REFRESH MATERIALIZED VIEW.");
+  }
+}
+
 }  // namespace
 
 void MapDHandler::load_table_binary(const TSessionId& session,
                                     const std::string& table_name,
                                     const std::vector<TRow>& rows) {
+  const auto request_start = timer_start();
+  ScopeGuard record_latency = [&] { load_table_binary_latency_.record(timer_stop(request_start)); };
   check_read_only("load_table_binary");
   const auto session_info = get_session(session);
   auto& cat = session_info.get_catalog();
-  if (g_cluster && !leaf_aggregator_.leafCount()) {
+  if (g_leaf) {
     // Sharded table rows need to be routed to the leaf by an aggregator.
     check_table_not_sharded(cat, table_name);
   }
@@ -1639,7 +1732,7 @@ void MapDHandler::prepare_columnar_loader(
     std::unique_ptr<Importer_NS::Loader>* loader,
     std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>* import_buffers) {
   auto& cat = session_info.get_catalog();
-  if (g_cluster && !leaf_aggregator_.leafCount()) {
+  if (g_leaf) {
     // Sharded table rows need to be routed to the leaf by an aggregator.
     check_table_not_sharded(cat, table_name);
   }
@@ -1751,25 +1844,28 @@ void MapDHandler::load_table_binary_arrow(const TSessionId& session,
 
   RecordBatchVector batches = loadArrowStream(arrow_stream);
 
-  // Assuming have one batch for now
-  if (batches.size() != 1) {
-    THROW_MAPD_EXCEPTION("Expected a single Arrow record batch. Import aborted");
+  if (batches.empty()) {
+    THROW_MAPD_EXCEPTION("Expected at least one Arrow record batch. Import aborted");
   }
 
-  std::shared_ptr<arrow::RecordBatch> batch = batches[0];
-
   std::unique_ptr<Importer_NS::Loader> loader;
   std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>> import_buffers;
   const auto session_info = get_session(session);
   prepare_columnar_loader(
-      session_info, table_name, static_cast<size_t>(batch->num_columns()), &loader, &import_buffers);
+      session_info, table_name, static_cast<size_t>(batches.front()->num_columns()), &loader, &import_buffers);
 
+  // the batches of a stream share its schema, streaming clients send several per call
   size_t numRows = 0;
   size_t col_idx = 0;
   try {
-    for (auto cd : loader->get_column_descs()) {
-      numRows = import_buffers[col_idx]->add_arrow_values(cd, *batch->column(col_idx));
-      col_idx++;
+    for (const auto& batch : batches) {
+      size_t batchRows = 0;
+      col_idx = 0;
+      for (auto cd : loader->get_column_descs()) {
+        batchRows = import_buffers[col_idx]->add_arrow_values(cd, *batch->column(col_idx));
+        col_idx++;
+      }
+      numRows += batchRows;
     }
   } catch (const std::exception& e) {
     LOG(ERROR) << "Input exception thrown: " << e.what() << ". Issue at column : " << (col_idx + 1)
@@ -1786,7 +1882,7 @@ void MapDHandler::load_table(const TSessionId& session,
   check_read_only("load_table");
   const auto session_info = get_session(session);
   auto& cat = session_info.get_catalog();
-  if (g_cluster && !leaf_aggregator_.leafCount()) {
+  if (g_leaf) {
     // Sharded table rows need to be routed to the leaf by an aggregator.
     check_table_not_sharded(cat, table_name);
   }
@@ -2267,11 +2363,14 @@ void MapDHandler::render_vega(TRenderResult& _return,
                               const std::string& vega_json,
                               const int compression_level,
                               const std::string& nonce) {
+  const auto request_start = timer_start();
+  ScopeGuard record_latency = [&] { render_vega_latency_.record(timer_stop(request_start)); };
   if (!render_handler_) {
     THROW_MAPD_EXCEPTION("Backend rendering is disabled.");
   }
 
   const auto session_info = MapDHandler::get_session(session);
+  const auto query_slot = admit_query();
   LOG(INFO) << "render_vega :" << session << ":widget_id:" << widget_id << ":compression_level:" << compression_level
             << ":vega_json:" << vega_json << ":nonce:" << nonce;
 
@@ -3045,6 +3144,11 @@ void MapDHandler::check_table_load_privileges(const Catalog_Namespace::SessionIn
                            " has no insert privileges for table " + table_name + ".");
     }
   }
+  try {
+    check_not_materialized_view(cat, table_name);
+  } catch (const std::exception& e) {
+    THROW_MAPD_EXCEPTION(e.what());
+  }
 }
 
 void MapDHandler::check_table_load_privileges(const TSessionId& session, const std::string& table_name) {
@@ -3361,6 +3465,39 @@ void check_table_not_sharded(const Catalog& cat, const int table_id) {
   }
 }
 
+// Describes the state of the tables a query reads, empty if its results can't be cached.
+std::string get_table_versions(const Catalog& cat, const std::map<std::string, bool>& tableNames) {
+  std::string table_versions;
+  for (const auto& table : tableNames) {
+    const auto td = cat.getMetadataForTable(table.first);
+    if (!td || td->isView) {
+      return "";
+    }
+    table_versions += std::to_string(td->tableId) + ":" +
+                      std::to_string(cat.getTableEpoch(cat.get_currentDB().dbId, td->tableId)) + ":" +
+                      std::to_string(cat.getTableDataVersion(td->tableId)) + ";";
+  }
+  return table_versions;
+}
+
+bool is_time_dependent(const std::string& query_ra) {
+  return query_ra.find("\"NOW\"") != std::string::npos || query_ra.find("\"DATETIME\"") != std::string::npos;
+}
+
+// Rows still in the delta store of a table can't be updated or deleted where they are. The statement doesn't see
+// the ones loaded after this merge, its locks don't keep the loads out.
+void merge_delta_stores(const Catalog& cat, const std::string& table_name) {
+  const auto td = cat.getMetadataForTable(table_name, false);
+  if (!td || td->isView) {
+    return;
+  }
+  for (const auto physical_td : cat.getPhysicalTablesDescriptors(td)) {
+    if (physical_td->fragmenter) {
+      physical_td->fragmenter->mergeDeltaStore();
+    }
+  }
+}
+
 }  // namespace
 
 void MapDHandler::sql_execute_impl(TQueryResult& _return,
@@ -3391,7 +3528,7 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
                   INSERT_SELECT: CheckpointLock >> read UpdateDeleteLock [ >> write UpdateDeleteLock ]
                   COPY_TO/SELECT: read UpdateDeleteLock
                   COPY_FROM:  CheckpointLock [ >> write UpdateDeleteLock ]
-                  DROP/TRUNC: CheckpointLock >> write UpdateDeleteLock
+                  DROP/TRUNC/OPTIMIZE: CheckpointLock >> write UpdateDeleteLock
                   DELETE/UPDATE: CheckpointLock >> write UpdateDeleteLock
   */
   mapd_unique_lock<mapd_shared_mutex> chkptlLock;
@@ -3427,6 +3564,33 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
         return;
       }
 
+      // fold rows appended since the last refresh into the materialized views a SELECT may be answered from
+      const bool is_select = std::none_of(tableNames.begin(),
+                                          tableNames.end(),
+                                          [](const std::pair<const std::string, bool>& table) { return table.second; });
+      if (!read_only_ && is_select) {
+        std::vector<std::string> table_names;
+        for (const auto& table : tableNames) {
+          table_names.push_back(table.first);
+        }
+        _return.execution_time_ms +=
+            measure<>::execution([&]() { Parser::refresh_materialized_views(session_info, table_names); });
+      }
+
+      for (const auto& table : tableNames) {
+        if (table.second) {
+          check_not_materialized_view(session_info.get_catalog(), table.first);
+        }
+      }
+
+      if (g_enable_delta_store) {
+        for (const auto& table : tableNames) {
+          if (table.second) {
+            merge_delta_stores(session_info.get_catalog(), table.first);
+          }
+        }
+      }
+
       // UPDATE/DELETE needs to get a checkpoint lock as the first lock
       for (const auto& table : tableNames)
         if (table.second)
@@ -3436,6 +3600,19 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
       executeReadLock =
           mapd_shared_lock<mapd_shared_mutex>(*LockMgr<mapd_shared_mutex, bool>::getMutex(ExecutorOuterLock, true));
       getTableLocks<mapd_shared_mutex>(session_info.get_catalog(), tableNames, upddelLocks, LockType::UpdateDeleteLock);
+      std::string plan_key;
+      std::string table_versions;
+      if (query_result_cache_ && is_select && !pw.is_select_explain) {
+        table_versions = get_table_versions(session_info.get_catalog(), tableNames);
+        if (!table_versions.empty() && !is_time_dependent(query_ra)) {
+          plan_key = std::to_string(session_info.get_catalog().get_currentDB().dbId) + ":" +
+                     std::to_string(column_format) + ":" + std::to_string(first_n) + ":" +
+                     std::to_string(at_most_n) + ":" + query_ra;
+          if (query_result_cache_->get(_return.row_set, plan_key, table_versions)) {
+            return;
+          }
+        }
+      }
       execute_rel_alg(_return,
                       query_ra,
                       column_format,
@@ -3445,6 +3622,10 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
                       at_most_n,
                       pw.is_select_explain,
                       false);
+      // appends only take the checkpoint lock, don't cache rows which may have raced with one
+      if (!plan_key.empty() && get_table_versions(session_info.get_catalog(), tableNames) == table_versions) {
+        query_result_cache_->put(plan_key, table_versions, _return.row_set);
+      }
       return;
     }
     LOG(INFO) << "passing query to legacy processor";
@@ -3501,7 +3682,7 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
           upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
               session_info.get_catalog(), *stmtp->get_table(), LockType::UpdateDeleteLock);
         }
-        if (g_cluster && copy_stmt && !leaf_aggregator_.leafCount()) {
+        if (g_leaf && copy_stmt) {
           // Sharded table rows need to be routed to the leaf by an aggregator.
           check_table_not_sharded(cat, copy_stmt->get_table());
         }
@@ -3551,6 +3732,8 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
           // following lock back to here!!!
         } else if (auto stmtp = dynamic_cast<Parser::InsertValuesStmt*>(stmt.get())) {
           // INSERT_VALUES: CheckpointLock >> write ExecutorOuterLock [ >> write UpdateDeleteLocks ]
+          // Both are held until the insert returns, so with --enable-insert-wal they are held across the fsync
+          // of the log too: an INSERT VALUES doesn't share the fsync with other statements, it waits for its own.
           chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
               session_info.get_catalog(), *stmtp->get_table(), LockType::CheckpointLock);
           executeWriteLock =
@@ -3558,7 +3741,7 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
           // [ write UpdateDeleteLocks ] lock is deferred in InsertOrderFragmenter::deleteFragments
         }
 
-        if (g_cluster && plan_ptr->get_stmt_type() == kINSERT) {
+        if (g_leaf && plan_ptr->get_stmt_type() == kINSERT) {
           check_table_not_sharded(session_info.get_catalog(), plan_ptr->get_result_table_id());
         }
         if (explain_stmt != nullptr) {
@@ -3642,7 +3825,8 @@ void MapDHandler::execute_first_step(TStepResult& _return, const TPendingQuery&
     try {
       leaf_handler_->execute_first_step(_return, pending_query);
     } catch (std::exception& e) {
-      THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+      const auto mapd_exception = dynamic_cast<const TMapDException*>(&e);
+      THROW_MAPD_EXCEPTION(mapd_exception ? mapd_exception->error_msg : (std::string("Exception: ") + e.what()));
     }
   });
   LOG(INFO) << "execute_first_step-COMPLETED " << time_ms << "ms";
@@ -3660,7 +3844,8 @@ void MapDHandler::start_query(TPendingQuery& _return,
     try {
       leaf_handler_->start_query(_return, session, query_ra, just_explain);
     } catch (std::exception& e) {
-      THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+      const auto mapd_exception = dynamic_cast<const TMapDException*>(&e);
+      THROW_MAPD_EXCEPTION(mapd_exception ? mapd_exception->error_msg : (std::string("Exception: ") + e.what()));
     }
   });
   LOG(INFO) << "start_query-COMPLETED " << time_ms << "ms "
@@ -3678,12 +3863,44 @@ void MapDHandler::broadcast_serialized_rows(const std::string& serialized_rows,
     try {
       leaf_handler_->broadcast_serialized_rows(serialized_rows, row_desc, query_id);
     } catch (std::exception& e) {
-      THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+      const auto mapd_exception = dynamic_cast<const TMapDException*>(&e);
+      THROW_MAPD_EXCEPTION(mapd_exception ? mapd_exception->error_msg : (std::string("Exception: ") + e.what()));
     }
   });
   LOG(INFO) << "BROADCAST-SERIALIZED-ROWS COMPLETED " << time_ms << "ms";
 }
 
+namespace {
+
+// Encodes the strings sent by an aggregator with the dictionary of this node.
+void encode_dict_strings(std::vector<int8_t>& encoded_strings,
+                         const std::vector<TVarLen>& var_len_data,
+                         const SQLTypeInfo& ti,
+                         StringDictionary* string_dict) {
+  CHECK(string_dict);
+  std::vector<std::string> strings;
+  strings.reserve(var_len_data.size());
+  for (const auto& varlen_str : var_len_data) {
+    strings.push_back(varlen_str.is_null ? std::string() : varlen_str.payload);
+  }
+  encoded_strings.resize(strings.size() * ti.get_size());
+  switch (ti.get_size()) {
+    case 1:
+      string_dict->getOrAddBulk(strings, reinterpret_cast<uint8_t*>(encoded_strings.data()));
+      break;
+    case 2:
+      string_dict->getOrAddBulk(strings, reinterpret_cast<uint16_t*>(encoded_strings.data()));
+      break;
+    case 4:
+      string_dict->getOrAddBulk(strings, reinterpret_cast<int32_t*>(encoded_strings.data()));
+      break;
+    default:
+      CHECK(false);
+  }
+}
+
+}  // namespace
+
 void MapDHandler::insert_data(const TSessionId& session, const TInsertData& thrift_insert_data) {
   static std::mutex insert_mutex;  // TODO: split lock, make it per table
   CHECK_EQ(thrift_insert_data.column_ids.size(), thrift_insert_data.data.size());
@@ -3695,6 +3912,7 @@ void MapDHandler::insert_data(const TSessionId& session, const TInsertData& thri
   insert_data.columnIds = thrift_insert_data.column_ids;
   std::vector<std::unique_ptr<std::vector<std::string>>> none_encoded_string_columns;
   std::vector<std::unique_ptr<std::vector<ArrayDatum>>> array_columns;
+  std::vector<std::unique_ptr<std::vector<int8_t>>> dict_encoded_columns;
   for (size_t col_idx = 0; col_idx < insert_data.columnIds.size(); ++col_idx) {
     const int column_id = insert_data.columnIds[col_idx];
     DataBlockPtr p;
@@ -3705,7 +3923,20 @@ void MapDHandler::insert_data(const TSessionId& session, const TInsertData& thri
       p.numbersPtr = (int8_t*)thrift_insert_data.data[col_idx].fixed_len_data.data();
     } else if (ti.is_string()) {
       if (ti.get_compression() == kENCODING_DICT) {
-        p.numbersPtr = (int8_t*)thrift_insert_data.data[col_idx].fixed_len_data.data();
+        if (thrift_insert_data.data[col_idx].__isset.var_len_data) {
+          CHECK_EQ(static_cast<size_t>(thrift_insert_data.num_rows),
+                   thrift_insert_data.data[col_idx].var_len_data.size());
+          dict_encoded_columns.emplace_back(new std::vector<int8_t>());
+          const auto dd = cat.getMetadataForDict(ti.get_comp_param());
+          CHECK(dd);
+          encode_dict_strings(*dict_encoded_columns.back(),
+                              thrift_insert_data.data[col_idx].var_len_data,
+                              ti,
+                              dd->stringDict.get());
+          p.numbersPtr = dict_encoded_columns.back()->data();
+        } else {
+          p.numbersPtr = (int8_t*)thrift_insert_data.data[col_idx].fixed_len_data.data();
+        }
       } else {
         CHECK_EQ(kENCODING_NONE, ti.get_compression());
         none_encoded_string_columns.emplace_back(new std::vector<std::string>());
@@ -3794,7 +4025,22 @@ void MapDHandler::execute_next_render_step(TRenderStepResult& _return,
 void MapDHandler::checkpoint(const TSessionId& session, const int32_t db_id, const int32_t table_id) {
   const auto session_info = get_session(session);
   auto& cat = session_info.get_catalog();
-  cat.get_dataMgr().checkpoint(db_id, table_id);
+  const auto td = cat.getMetadataForTable(table_id);
+  if (!td || db_id != cat.get_currentDB().dbId) {
+    cat.get_dataMgr().checkpoint(db_id, table_id);
+    return;
+  }
+  // Strings inserted through insert_data grow the dictionaries of this node, persist them with the table.
+  for (const auto cd : cat.getAllColumnMetadataForTable(table_id, false, false, true)) {
+    if (cd->columnType.is_string() && cd->columnType.get_compression() == kENCODING_DICT) {
+      const auto dd = cat.getMetadataForDict(cd->columnType.get_comp_param());
+      CHECK(dd && dd->stringDict);
+      if (!dd->stringDict->checkpoint()) {
+        THROW_MAPD_EXCEPTION("Failed to checkpoint dictionary of column " + cd->columnName);
+      }
+    }
+  }
+  cat.checkpoint(table_id);
 }
 
 // check and reset epoch if a request has been made
@@ -25,6 +25,7 @@
 #define MAPDHANDLER_H
 
 #include "LeafAggregator.h"
+#include "QueryResultCache.h"
 #ifdef HAVE_PROFILER
 #include <gperftools/heap-profiler.h>
 #endif  // HAVE_PROFILER
@@ -62,6 +63,8 @@
 #include "Shared/measure.h"
 #include "Shared/scope.h"
 #include "Shared/ConfigResolve.h"
+#include "Shared/LatencyHistogram.h"
+#include "Shared/QueryAdmission.h"
 
 #include <fcntl.h>
 #include <glog/logging.h>
@@ -135,6 +138,7 @@ class MapDHandler : public MapDIf {
   void get_server_status(TServerStatus& _return, const TSessionId& session);
   void get_status(std::vector<TServerStatus>& _return, const TSessionId& session);
   void get_hardware_info(TClusterHardwareInfo& _return, const TSessionId& session);
+  void get_server_metrics(TServerMetrics& _return, const TSessionId& session);
 
   bool hasTableAccessPrivileges(const TableDescriptor* td, const TSessionId& session);
   void get_tables(std::vector<std::string>& _return, const TSessionId& session);
@@ -339,6 +343,13 @@ class MapDHandler : public MapDIf {
 
   TSessionId getInvalidSessionId() const;
 
+  // Must be called before the servers start accepting connections.
+  void registerRequestQueue(const std::string& transport,
+                            mapd::shared_ptr<apache::thrift::concurrency::ThreadManager> thread_manager);
+
+  // Must be called before the servers start accepting connections. Queries aren't limited otherwise.
+  void limitConcurrentQueries(const size_t max_running, const size_t max_queued);
+
   void internal_connect(TSessionId& session, const std::string& user, const std::string& dbname);
   void connectImpl(TSessionId& session,
                    const std::string& user,
@@ -370,7 +381,14 @@ class MapDHandler : public MapDIf {
   std::unique_ptr<MapDLeafHandler> leaf_handler_;
   std::shared_ptr<Calcite> calcite_;
   const bool legacy_syntax_;
+  std::vector<std::pair<std::string, mapd::shared_ptr<apache::thrift::concurrency::ThreadManager>>> request_queues_;
+  std::unique_ptr<QueryAdmission> query_admission_;
+  LatencyHistogram sql_execute_latency_;
+  LatencyHistogram render_vega_latency_;
+  LatencyHistogram load_table_binary_latency_;
+  std::unique_ptr<QueryResultCache> query_result_cache_;
   Catalog_Namespace::SessionInfo get_session(const TSessionId& session);
+  QueryAdmission::Slot admit_query();
 
  private:
   void check_table_load_privileges(const TSessionId& session, const std::string& table_name);
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QueryResultCache.h"
+#include "Shared/mapd_shared_ptr.h"
+
+#include <glog/logging.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+#include <iterator>
+
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::transport;
+
+bool QueryResultCache::get(TRowSet& row_set, const std::string& plan_key, const std::string& table_versions) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(plan_key);
+  if (it == entries_.end()) {
+    return false;
+  }
+  if (it->second->table_versions != table_versions) {
+    evict(it->second);
+    return false;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second);
+  const auto& serialized_rows = it->second->serialized_rows;
+  auto buffer = mapd::make_shared<TMemoryBuffer>(
+      reinterpret_cast<uint8_t*>(const_cast<char*>(serialized_rows.data())), serialized_rows.size());
+  TBinaryProtocol protocol(buffer);
+  row_set.read(&protocol);
+  return true;
+}
+
+void QueryResultCache::put(const std::string& plan_key, const std::string& table_versions, const TRowSet& row_set) {
+  auto buffer = mapd::make_shared<TMemoryBuffer>();
+  TBinaryProtocol protocol(buffer);
+  row_set.write(&protocol);
+  auto serialized_rows = buffer->getBufferAsString();
+  const size_t entry_bytes = plan_key.size() + table_versions.size() + serialized_rows.size();
+  if (entry_bytes > max_bytes_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(plan_key);
+  if (it != entries_.end()) {
+    evict(it->second);
+  }
+  while (bytes_ + entry_bytes > max_bytes_) {
+    CHECK(!lru_.empty());
+    evict(std::prev(lru_.end()));
+  }
+  lru_.push_front(Entry{plan_key, table_versions, std::move(serialized_rows)});
+  entries_.emplace(plan_key, lru_.begin());
+  bytes_ += entry_bytes;
+}
+
+void QueryResultCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  lru_.clear();
+  entries_.clear();
+  bytes_ = 0;
+}
+
+void QueryResultCache::evict(std::list<Entry>::iterator it) {
+  bytes_ -= it->plan_key.size() + it->table_versions.size() + it->serialized_rows.size();
+  entries_.erase(it->plan_key);
+  lru_.erase(it);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    QueryResultCache.h
+ * @brief   LRU cache of serialized SELECT results.
+ *
+ * Entries are keyed by the query plan and tagged with the versions of the tables the plan reads. A lookup with
+ * different versions drops the entry, so results never outlive a change to the data they were computed from.
+ */
+
+#ifndef THRIFTHANDLER_QUERYRESULTCACHE_H
+#define THRIFTHANDLER_QUERYRESULTCACHE_H
+
+#include "gen-cpp/MapD.h"
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class QueryResultCache {
+ public:
+  QueryResultCache(const size_t max_bytes) : max_bytes_(max_bytes), bytes_(0) {}
+
+  bool get(TRowSet& row_set, const std::string& plan_key, const std::string& table_versions);
+
+  void put(const std::string& plan_key, const std::string& table_versions, const TRowSet& row_set);
+
+  void clear();
+
+ private:
+  struct Entry {
+    std::string plan_key;
+    std::string table_versions;
+    std::string serialized_rows;
+  };
+
+  void evict(std::list<Entry>::iterator it);
+
+  const size_t max_bytes_;
+  size_t bytes_;
+  std::list<Entry> lru_;  // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+  std::mutex mutex_;
+};
+
+#endif  // THRIFTHANDLER_QUERYRESULTCACHE_H
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2017 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MapDDistributedHandler.h"
+#include "DistributedLoader.h"
+
+#include "Analyzer/Analyzer.h"
+#include "DataMgr/LockMgr.h"
+#include "Parser/ParserNode.h"
+#include "Parser/ParserWrapper.h"
+#include "Parser/parser.h"
+#include "Shared/MapDException.h"
+#include "Shared/measure.h"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
+
+using namespace Lock_Namespace;
+using namespace apache::thrift::protocol;
+using namespace apache::thrift::transport;
+
+namespace {
+
+const Analyzer::Constant* get_constant(const Analyzer::Expr* expr) {
+  const auto constant = dynamic_cast<const Analyzer::Constant*>(expr);
+  if (constant) {
+    return constant;
+  }
+  // String literals inserted into dictionary encoded columns keep the cast.
+  const auto uoper = dynamic_cast<const Analyzer::UOper*>(expr);
+  if (uoper && uoper->get_optype() == kCAST && uoper->get_type_info().is_string()) {
+    return dynamic_cast<const Analyzer::Constant*>(uoper->get_operand());
+  }
+  return nullptr;
+}
+
+TDatum constant_to_thrift(const Analyzer::Constant* constant) {
+  TDatum datum;
+  datum.is_null = constant->get_is_null();
+  if (datum.is_null) {
+    return datum;
+  }
+  const auto& ti = constant->get_type_info();
+  const auto constval = constant->get_constval();
+  if (ti.is_decimal()) {
+    datum.val.int_val = constval.bigintval;
+    return datum;
+  }
+  switch (ti.get_type()) {
+    case kBOOLEAN:
+      datum.val.int_val = constval.boolval;
+      break;
+    case kTINYINT:
+      datum.val.int_val = constval.tinyintval;
+      break;
+    case kSMALLINT:
+      datum.val.int_val = constval.smallintval;
+      break;
+    case kINT:
+      datum.val.int_val = constval.intval;
+      break;
+    case kBIGINT:
+      datum.val.int_val = constval.bigintval;
+      break;
+    case kFLOAT:
+      datum.val.real_val = constval.floatval;
+      break;
+    case kDOUBLE:
+      datum.val.real_val = constval.doubleval;
+      break;
+    case kTEXT:
+    case kVARCHAR:
+    case kCHAR:
+      CHECK(constval.stringval);
+      datum.val.str_val = *constval.stringval;
+      break;
+    case kTIME:
+    case kTIMESTAMP:
+    case kDATE:
+      datum.val.int_val = constval.timeval;
+      break;
+    case kARRAY:
+      for (const auto& elem : constant->get_value_list()) {
+        const auto elem_constant = get_constant(elem.get());
+        if (!elem_constant) {
+          THROW_MAPD_EXCEPTION("Only literal array elements can be inserted in distributed mode");
+        }
+        datum.val.arr_val.push_back(constant_to_thrift(elem_constant));
+      }
+      break;
+    default: {
+      THROW_MAPD_EXCEPTION("Distributed insert of " + ti.get_type_name() + " values not supported");
+    }
+  }
+  return datum;
+}
+
+size_t column_size(const TColumn& column) {
+  return column.nulls.size();
+}
+
+TDatum column_value_to_thrift(const TColumn& column, const size_t row) {
+  TDatum datum;
+  datum.is_null = column.nulls[row];
+  if (!column.data.int_col.empty()) {
+    datum.val.int_val = column.data.int_col[row];
+  } else if (!column.data.real_col.empty()) {
+    datum.val.real_val = column.data.real_col[row];
+  } else if (!column.data.str_col.empty()) {
+    datum.val.str_val = column.data.str_col[row];
+  } else {
+    CHECK_LT(row, column.data.arr_col.size());
+    const auto& elems = column.data.arr_col[row];
+    for (size_t i = 0; i < column_size(elems); ++i) {
+      datum.val.arr_val.push_back(column_value_to_thrift(elems, i));
+    }
+  }
+  return datum;
+}
+
+void truncate_column(TColumn& column, const size_t row_count) {
+  column.nulls.resize(std::min(column.nulls.size(), row_count));
+  column.data.int_col.resize(std::min(column.data.int_col.size(), row_count));
+  column.data.real_col.resize(std::min(column.data.real_col.size(), row_count));
+  column.data.str_col.resize(std::min(column.data.str_col.size(), row_count));
+  column.data.arr_col.resize(std::min(column.data.arr_col.size(), row_count));
+}
+
+// Applies first_n / at_most_n to the merged, columnar result and converts it to rows if needed.
+void convert_merged_rows(TQueryResult& _return,
+                         TRowSet& row_set,
+                         const bool column_format,
+                         const int32_t first_n,
+                         const int32_t at_most_n) {
+  const size_t row_count = row_set.columns.empty() ? 0 : column_size(row_set.columns.front());
+  if (at_most_n >= 0 && row_count > static_cast<size_t>(at_most_n)) {
+    THROW_MAPD_EXCEPTION("The result contains more rows than the specified cap of " + std::to_string(at_most_n));
+  }
+  const size_t fetched = first_n >= 0 ? std::min(row_count, static_cast<size_t>(first_n)) : row_count;
+  _return.row_set.row_desc = row_set.row_desc;
+  _return.row_set.is_columnar = column_format;
+  if (column_format) {
+    for (auto& column : row_set.columns) {
+      truncate_column(column, fetched);
+    }
+    _return.row_set.columns.swap(row_set.columns);
+    return;
+  }
+  for (size_t row = 0; row < fetched; ++row) {
+    TRow trow;
+    trow.cols.reserve(row_set.columns.size());
+    for (const auto& column : row_set.columns) {
+      trow.cols.push_back(column_value_to_thrift(column, row));
+    }
+    _return.row_set.rows.push_back(trow);
+  }
+}
+
+}  // namespace
+
+MapDAggHandler::MapDAggHandler(MapDHandler* mapd_handler) : mapd_handler_(mapd_handler) {
+  CHECK(mapd_handler_);
+}
+
+void MapDAggHandler::cluster_execute(TQueryResult& _return,
+                                     const Catalog_Namespace::SessionInfo& session_info,
+                                     const std::string& query_str,
+                                     const bool column_format,
+                                     const std::string& nonce,
+                                     const int32_t first_n,
+                                     const int32_t at_most_n) {
+  auto& leaf_aggregator = mapd_handler_->leaf_aggregator_;
+  ParserWrapper pw{query_str};
+  if (pw.is_sqlplus_cmd || pw.is_other_explain || pw.is_select_explain || pw.is_select_calcite_explain) {
+    // Only needs the catalog, which the aggregator shares with the leaves.
+    mapd_handler_->sql_execute_impl(_return,
+                                    session_info,
+                                    query_str,
+                                    column_format,
+                                    nonce,
+                                    session_info.get_executor_device_type(),
+                                    first_n,
+                                    at_most_n);
+    return;
+  }
+  if (pw.is_ddl) {
+    // COPY FROM loads through a DistributedLoader and SHOW only reads the catalog, everything
+    // else must also run on the leaves to keep their catalogs (and table ids) in sync.
+    const bool forward_to_leaves = !pw.is_copy && !boost::istarts_with(query_str, "SHOW");
+    mapd_handler_->sql_execute_impl(_return,
+                                    session_info,
+                                    query_str,
+                                    column_format,
+                                    nonce,
+                                    session_info.get_executor_device_type(),
+                                    first_n,
+                                    at_most_n);
+    if (forward_to_leaves) {
+      _return.execution_time_ms +=
+          measure<>::execution([&]() { leaf_aggregator.forwardQueryToLeaves(session_info, query_str); });
+    }
+    return;
+  }
+  if (pw.is_update_dml) {
+    mapd_handler_->check_read_only("Non-SELECT statements");
+    if (pw.getDMLType() == ParserWrapper::DMLType::Insert) {
+      SQLParser parser;
+      std::list<std::unique_ptr<Parser::Stmt>> parse_trees;
+      std::string last_parsed;
+      if (parser.parse(query_str, parse_trees, last_parsed) > 0) {
+        THROW_MAPD_EXCEPTION("Syntax error at: " + last_parsed);
+      }
+      _return.execution_time_ms += measure<>::execution([&]() {
+        for (const auto& stmt : parse_trees) {
+          const auto insert_values_stmt = dynamic_cast<const Parser::InsertValuesStmt*>(stmt.get());
+          if (!insert_values_stmt) {
+            THROW_MAPD_EXCEPTION("INSERT INTO ... SELECT not supported in distributed mode");
+          }
+          insert_values(session_info, *insert_values_stmt);
+        }
+      });
+      return;
+    }
+    // Every leaf updates or deletes its own rows.
+    _return.execution_time_ms +=
+        measure<>::execution([&]() { leaf_aggregator.forwardQueryToLeaves(session_info, query_str); });
+    return;
+  }
+  std::string query_ra;
+  _return.execution_time_ms += measure<>::execution([&]() { query_ra = mapd_handler_->parse_to_ra(query_str, session_info); });
+  TRowSet row_set;
+  _return.execution_time_ms += measure<>::execution([&]() { row_set = leaf_aggregator.execute(session_info, query_ra, false); });
+  convert_merged_rows(_return, row_set, column_format, first_n, at_most_n);
+}
+
+void MapDAggHandler::insert_values(const Catalog_Namespace::SessionInfo& session_info,
+                                   const Parser::InsertValuesStmt& insert_stmt) {
+  auto& cat = session_info.get_catalog();
+  // INSERT_VALUES: CheckpointLock, the leaves take their own locks when the rows arrive
+  const auto chkptlLock =
+      getTableLock<mapd_shared_mutex, mapd_unique_lock>(cat, *insert_stmt.get_table(), LockType::CheckpointLock);
+  Analyzer::Query query;
+  insert_stmt.analyze(cat, query);
+  const auto td = cat.getMetadataForTable(query.get_result_table_id());
+  CHECK(td);
+  mapd_handler_->check_table_load_privileges(session_info, td->tableName);
+  DistributedLoader loader(session_info, td, &mapd_handler_->leaf_aggregator_);
+  const auto& col_ids = query.get_result_col_list();
+  const auto& targets = query.get_targetlist();
+  CHECK_EQ(col_ids.size(), targets.size());
+  std::unordered_map<int, const Analyzer::Expr*> column_values;
+  auto target_it = targets.begin();
+  for (const auto col_id : col_ids) {
+    column_values.emplace(col_id, (*target_it)->get_expr());
+    ++target_it;
+  }
+  std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>> import_buffers;
+  for (const auto cd : loader.get_column_descs()) {
+    if (cd->columnType.is_geometry()) {
+      THROW_MAPD_EXCEPTION("Distributed insert into geo columns not supported");
+    }
+    const auto value_it = column_values.find(cd->columnId);
+    CHECK(value_it != column_values.end());
+    const auto constant = get_constant(value_it->second);
+    if (!constant || constant->get_type_info().get_type() != cd->columnType.get_type()) {
+      THROW_MAPD_EXCEPTION("Only literal values can be inserted in distributed mode, check column " +
+                               cd->columnName);
+    }
+    import_buffers.emplace_back(new Importer_NS::TypedImportBuffer(cd, loader.get_string_dict(cd)));
+    import_buffers.back()->add_value(cd, constant_to_thrift(constant), constant->get_is_null());
+  }
+  if (!loader.load(import_buffers, 1)) {
+    THROW_MAPD_EXCEPTION("Failed to insert into table " + td->tableName);
+  }
+}
+
+MapDLeafHandler::MapDLeafHandler(MapDHandler* mapd_handler) : mapd_handler_(mapd_handler), next_query_id_(0) {
+  CHECK(mapd_handler_);
+}
+
+void MapDLeafHandler::start_query(TPendingQuery& _return,
+                                  const TSessionId& session,
+                                  const std::string& query_ra,
+                                  const bool just_explain) {
+  const auto session_info = mapd_handler_->get_session(session);
+  _return.id = next_query_id_++;
+  std::lock_guard<std::mutex> lock(pending_queries_mutex_);
+  pending_queries_.emplace(_return.id, std::unique_ptr<PendingQuery>(new PendingQuery{session_info, query_ra, just_explain}));
+}
+
+void MapDLeafHandler::execute_first_step(TStepResult& _return, const TPendingQuery& pending_query) {
+  std::unique_ptr<PendingQuery> query;
+  {
+    std::lock_guard<std::mutex> lock(pending_queries_mutex_);
+    const auto it = pending_queries_.find(pending_query.id);
+    if (it == pending_queries_.end()) {
+      THROW_MAPD_EXCEPTION("Unknown query id " + std::to_string(pending_query.id));
+    }
+    query = std::move(it->second);
+    pending_queries_.erase(it);
+  }
+  const auto& session_info = query->session_info;
+  TQueryResult result;
+  {
+    // Same locks as a local SELECT: read ExecutorOuterLock >> read UpdateDeleteLocks
+    mapd_shared_lock<mapd_shared_mutex> executeReadLock(
+        *LockMgr<mapd_shared_mutex, bool>::getMutex(ExecutorOuterLock, true));
+    std::vector<std::shared_ptr<VLock>> upddelLocks;
+    getTableLocks<mapd_shared_mutex>(
+        session_info.get_catalog(), query->query_ra, upddelLocks, LockType::UpdateDeleteLock);
+    mapd_handler_->execute_rel_alg(result,
+                                   query->query_ra,
+                                   true,
+                                   session_info,
+                                   session_info.get_executor_device_type(),
+                                   -1,
+                                   -1,
+                                   query->just_explain,
+                                   false);
+  }
+  auto buffer = mapd::make_shared<TMemoryBuffer>();
+  TBinaryProtocol protocol(buffer);
+  result.row_set.write(&protocol);
+  _return.serialized_rows = buffer->getBufferAsString();
+  _return.row_desc = result.row_set.row_desc;
+  _return.execution_finished = true;
+  _return.merge_type = TMergeType::UNION;
+  _return.sharded = true;
+}
+
+void MapDLeafHandler::broadcast_serialized_rows(const std::string& serialized_rows,
+                                                const TRowDescriptor& row_desc,
+                                                const TQueryId query_id) {
+  THROW_MAPD_EXCEPTION("Multi-step distributed queries not supported");
+}
+
+void MapDLeafHandler::flush_queue() {}
+
+void MapDLeafHandler::clear_pending_queries(const TSessionId& session) {
+  std::lock_guard<std::mutex> lock(pending_queries_mutex_);
+  for (auto it = pending_queries_.begin(); it != pending_queries_.end();) {
+    if (it->second->session_info.get_session_id() == session) {
+      it = pending_queries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
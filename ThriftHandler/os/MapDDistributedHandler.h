@@ -26,22 +26,33 @@
 
 #include "../MapDHandler.h"
 
+#include <atomic>
+
+namespace Parser {
+class InsertValuesStmt;
+}  // namespace Parser
+
 class MapDAggHandler {
  public:
   ~MapDAggHandler() {}
 
  private:
-  MapDAggHandler(MapDHandler* mapd_handler) { CHECK(false); }
+  MapDAggHandler(MapDHandler* mapd_handler);
 
+  // SELECT runs on the leaves, DDL runs on the aggregator and on every leaf so that catalogs stay
+  // in sync, UPDATE and DELETE run on every leaf and INSERT rows are routed to the owning leaf.
   void cluster_execute(TQueryResult& _return,
                        const Catalog_Namespace::SessionInfo& session_info,
                        const std::string& query_str,
                        const bool column_format,
                        const std::string& nonce,
                        const int32_t first_n,
-                       const int32_t at_most_n) {
-    CHECK(false);
-  }
+                       const int32_t at_most_n);
+
+  void insert_values(const Catalog_Namespace::SessionInfo& session_info, const Parser::InsertValuesStmt& insert_stmt);
+
+  MapDHandler* mapd_handler_;
+
   friend class MapDHandler;
 };
 
@@ -50,24 +61,35 @@ class MapDLeafHandler {
   ~MapDLeafHandler() {}
 
  private:
-  MapDLeafHandler(MapDHandler* mapd_handler) { CHECK(false); }
+  MapDLeafHandler(MapDHandler* mapd_handler);
 
   void start_query(TPendingQuery& _return,
                    const TSessionId& session,
                    const std::string& query_ra,
-                   const bool just_explain) {
-    CHECK(false);
-  }
+                   const bool just_explain);
 
-  void execute_first_step(TStepResult& _return, const TPendingQuery& pending_query) { CHECK(false); }
+  void execute_first_step(TStepResult& _return, const TPendingQuery& pending_query);
 
   void broadcast_serialized_rows(const std::string& serialized_rows,
                                  const TRowDescriptor& row_desc,
-                                 const TQueryId query_id) {
-    CHECK(false);
-  }
+                                 const TQueryId query_id);
+
+  void flush_queue();
+
+  // Drops the queries started by a session which never got to execute, e.g. because the
+  // aggregator lost its connection between start_query and execute_first_step.
+  void clear_pending_queries(const TSessionId& session);
+
+  struct PendingQuery {
+    const Catalog_Namespace::SessionInfo session_info;
+    const std::string query_ra;
+    const bool just_explain;
+  };
 
-  void flush_queue() { CHECK(false); }
+  MapDHandler* mapd_handler_;
+  std::atomic<TQueryId> next_query_id_;
+  std::unordered_map<TQueryId, std::unique_ptr<PendingQuery>> pending_queries_;
+  std::mutex pending_queries_mutex_;
 
   friend class MapDHandler;
 };
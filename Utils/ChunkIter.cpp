@@ -102,6 +102,24 @@ DEVICE static void decompress(const SQLTypeInfo& ti, int8_t* compressed, VarlenD
         case kENCODING_FIXED:
           datum->timeval = (time_t) * (int32_t*)compressed;
           break;
+        case kENCODING_DATE_IN_DAYS: {
+          int64_t days{0};
+          bool is_null{false};
+          switch (ti.get_comp_param()) {
+            case 16:
+              days = *(int16_t*)compressed;
+              is_null = days == NULL_SMALLINT;
+              break;
+            case 32:
+              days = *(int32_t*)compressed;
+              is_null = days == NULL_INT;
+              break;
+            default:
+              assert(false);
+          }
+          datum->timeval = is_null ? NULL_BIGINT : get_epoch_seconds_from_days(days);
+          break;
+        }
         case kENCODING_RL:
         case kENCODING_DIFF:
         case kENCODING_DICT:
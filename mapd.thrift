@@ -32,7 +32,8 @@ enum TEncodingType {
   DIFF,
   DICT,
   SPARSE,
-  GEOINT
+  GEOINT,
+  DATE_IN_DAYS
 }
 
 enum TExecuteMode {
@@ -228,6 +229,36 @@ struct TServerStatus {
   7: bool poly_rendering_enabled
 }
 
+struct TRequestQueueStatus {
+  1: string transport
+  2: i64 worker_count
+  3: i64 idle_worker_count
+  4: i64 queue_depth
+  5: i64 max_queue_depth
+}
+
+struct TQueryQueueStatus {
+  1: i64 max_running
+  2: i64 running
+  3: i64 max_queued
+  4: i64 queued
+  5: i64 rejected
+}
+
+struct TLatencyHistogram {
+  1: string endpoint
+  2: i64 count
+  3: i64 total_ms
+  4: list<i64> bucket_upper_bounds_ms
+  5: list<i64> bucket_counts
+}
+
+struct TServerMetrics {
+  1: list<TRequestQueueStatus> request_queues
+  2: list<TLatencyHistogram> latencies
+  3: optional TQueryQueueStatus query_queue
+}
+
 struct TPixel {
   1: i64 x
   2: i64 y
@@ -474,6 +505,7 @@ service MapD {
   TServerStatus get_server_status(1: TSessionId session) throws (1: TMapDException e)
   list<TServerStatus> get_status(1: TSessionId session) throws (1: TMapDException e)
   TClusterHardwareInfo get_hardware_info(1: TSessionId session) throws (1: TMapDException e)
+  TServerMetrics get_server_metrics(1: TSessionId session) throws (1: TMapDException e)
   list<string> get_tables(1: TSessionId session) throws (1: TMapDException e)
   list<string> get_physical_tables(1: TSessionId session) throws (1: TMapDException e)
   list<string> get_views(1: TSessionId session) throws (1: TMapDException e)